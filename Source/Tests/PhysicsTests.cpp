@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef URHO3D_PHYSICS
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsEvents.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#endif
+
+#include "Tests.h"
+
+#include <Urho3D/DebugNew.h>
+
+#ifdef URHO3D_PHYSICS
+
+/// Physics steps per second.
+static const int PHYSICS_FPS = 60;
+/// Simulated time in seconds after which to stop waiting for the body to fall asleep.
+static const float MAX_SIMULATED_TIME = 10.0f;
+
+static void TestSubsteps(Context* context, unsigned substepsPerFrame, bool interpolation)
+{
+    String name = ToString("%u substeps per frame%s", substepsPerFrame, interpolation ? "" : " without interpolation");
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* world = scene->CreateComponent<PhysicsWorld>();
+    world->SetFps(PHYSICS_FPS);
+    world->SetGravity(Vector3::ZERO);
+    world->SetInterpolation(interpolation);
+
+    // A body moving slower than its sleeping threshold falls asleep after the deactivation time. It may do so in any
+    // substep of a frame, depending on the number of substeps
+    Node* node = scene->CreateChild();
+    node->CreateComponent<CollisionShape>()->SetSphere(1.0f);
+    auto* body = node->CreateComponent<RigidBody>();
+    body->SetMass(1.0f);
+    body->SetLinearVelocity(Vector3(0.5f, 0.0f, 0.0f));
+
+    // The interpolated transform is extrapolated by the velocity of the previous step, which the first step does not have
+    float frameTime = (float)substepsPerFrame / PHYSICS_FPS;
+    world->Update(frameTime);
+
+    // While the body moves, every substep must see the node moved by the one before. Between frames the interpolated
+    // transform may step back, as it is extrapolated by the time left over from the frame
+    float lastX = -M_INFINITY;
+    unsigned numStaleSteps = 0;
+    scene->SubscribeToEvent(world, E_PHYSICSPRESTEP, [&](StringHash /*eventType*/, VariantMap& /*eventData*/)
+    {
+        float x = node->GetPosition().x_;
+        if (body->IsActive() && x <= lastX)
+            ++numStaleSteps;
+        lastX = x;
+    });
+
+    for (float time = frameTime; time < MAX_SIMULATED_TIME && body->IsActive(); time += frameTime)
+    {
+        lastX = -M_INFINITY;
+        world->Update(frameTime);
+    }
+
+    Check(!body->IsActive(), name + ": body falls asleep");
+    Check(!numStaleSteps, name + ": substeps see the node transforms of the previous substep");
+    Check(node->GetWorldPosition().Equals(body->GetPosition()) && node->GetWorldRotation().Equals(body->GetRotation()),
+        name + ": sleeping body has its final node transform");
+}
+
+void RunPhysicsTests(Context* context)
+{
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    for (unsigned substeps = 1; substeps <= 5; ++substeps)
+    {
+        TestSubsteps(context, substeps, true);
+        TestSubsteps(context, substeps, false);
+    }
+}
+
+#else
+
+void RunPhysicsTests(Context* context)
+{
+    PrintLine("Physics support is disabled, skipping");
+}
+
+#endif
@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "Tests.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Test suite description.
+struct TestSuite
+{
+    /// Name used on the command line.
+    const char* name_;
+    /// Entry point.
+    TestFunction function_;
+    /// Short description.
+    const char* description_;
+};
+
+static const TestSuite suites[] =
+{
+    {"physics", RunPhysicsTests, "Rigid body transforms applied to the scene nodes during and after stepping"},
+    {"tilemap", RunTileMapTests, "Tile map layer sprite changes"},
+};
+
+/// Number of failed checks.
+static unsigned numFailed = 0;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Check(bool condition, const String& description)
+{
+    if (condition)
+        return;
+
+    PrintLine("FAILED: " + description, true);
+    ++numFailed;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Empty())
+    {
+        String usage = "Usage: Tests <suite>\n\nSuites:\n";
+        for (const TestSuite& suite : suites)
+            usage += String(suite.name_) + " - " + suite.description_ + "\n";
+        ErrorExit(usage);
+    }
+
+    // Options following the suite name, such as the -timeout added by the test runner, are ignored
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new Log(context));
+    context->RegisterSubsystem(new ResourceCache(context));
+    context->RegisterSubsystem(new Time(context));
+    context->GetSubsystem<Log>()->SetLevel(LOG_WARNING);
+
+    for (const TestSuite& suite : suites)
+    {
+        if (arguments[0] == suite.name_)
+        {
+            suite.function_(context);
+            if (numFailed)
+                ErrorExit(ToString("%s: %u checks failed", suite.name_, numFailed));
+            PrintLine(ToString("%s: all checks passed", suite.name_));
+            return;
+        }
+    }
+
+    ErrorExit("Unknown test suite " + arguments[0]);
+}
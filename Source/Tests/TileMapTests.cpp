@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef URHO3D_URHO2D
+#include <Urho3D/Urho2D/TileMap2D.h>
+#include <Urho3D/Urho2D/TileMapChunk2D.h>
+#include <Urho3D/Urho2D/TileMapLayer2D.h>
+#include <Urho3D/Urho2D/TmxFile2D.h>
+#include <Urho3D/Urho2D/Urho2D.h>
+#endif
+
+#include "Tests.h"
+
+#include <Urho3D/DebugNew.h>
+
+#ifdef URHO3D_URHO2D
+
+/// Map of two cells, of which only the first has a tile.
+static const char* TMX_DATA =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<map version=\"1.0\" orientation=\"orthogonal\" width=\"2\" height=\"1\" tilewidth=\"32\" tileheight=\"32\">\n"
+    " <tileset firstgid=\"1\" name=\"Tiles\" tilewidth=\"32\" tileheight=\"32\">\n"
+    "  <image source=\"Tiles.png\" width=\"64\" height=\"32\"/>\n"
+    " </tileset>\n"
+    " <layer name=\"Layer\" width=\"2\" height=\"1\">\n"
+    "  <data encoding=\"csv\">1,0</data>\n"
+    " </layer>\n"
+    "</map>\n";
+
+static void TestSpriteOnEmptyCell(Context* context)
+{
+    // The tileset texture only needs a size, so create it instead of loading an image
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    SharedPtr<Texture2D> texture(new Texture2D(context));
+    texture->SetName("Tests/Tiles.png");
+    texture->SetSize(64, 32, Graphics::GetRGBAFormat());
+    cache->AddManualResource(texture);
+
+    SharedPtr<TmxFile2D> tmxFile(new TmxFile2D(context));
+    tmxFile->SetName("Tests/Map.tmx");
+    MemoryBuffer buffer(TMX_DATA, String::CStringLength(TMX_DATA));
+    Check(tmxFile->Load(buffer), "map loads");
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* tileMap = scene->CreateChild()->CreateComponent<TileMap2D>();
+    tileMap->SetTmxFile(tmxFile);
+    TileMapLayer2D* layer = tileMap->GetNumLayers() ? tileMap->GetLayer(0) : nullptr;
+    Check(layer && layer->GetTile(0, 0) && !layer->GetTile(1, 0), "only the first cell has a tile");
+    if (!layer || !layer->GetTile(0, 0))
+        return;
+
+    TileMapChunk2D* chunk = layer->GetChunk(0);
+    float width = chunk->GetWorldBoundingBox().Size().x_;
+
+    // A sprite set to the empty cell is drawn there
+    Sprite2D* sprite = layer->GetTile(0, 0)->GetSprite();
+    layer->SetTileSprite(1, 0, sprite);
+    Check(layer->GetTileSprite(1, 0) == sprite, "empty cell has the sprite");
+    Check(chunk->GetWorldBoundingBox().Size().x_ > width * 1.5f, "sprite on the empty cell is drawn");
+
+    layer->SetTileSprite(1, 0, nullptr);
+    Check(Equals(chunk->GetWorldBoundingBox().Size().x_, width), "cleared sprite on the empty cell is no longer drawn");
+}
+
+void RunTileMapTests(Context* context)
+{
+    // Without a window and resource directories the graphics subsystem, the textures and the materials report errors
+    // that do not matter for the tests. Silence them
+    auto* log = context->GetSubsystem<Log>();
+    int logLevel = log->GetLevel();
+    log->SetLevel(LOG_NONE);
+
+    if (!context->GetSubsystem<Graphics>())
+        context->RegisterSubsystem(new Graphics(context));
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+    RegisterUrho2DLibrary(context);
+
+    TestSpriteOnEmptyCell(context);
+
+    log->SetLevel(logLevel);
+}
+
+#else
+
+void RunTileMapTests(Context* context)
+{
+    PrintLine("Urho2D support is disabled, skipping");
+}
+
+#endif
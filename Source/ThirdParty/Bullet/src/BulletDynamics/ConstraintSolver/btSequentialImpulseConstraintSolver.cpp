@@ -724,6 +724,8 @@ btSolverConstraint&	btSequentialImpulseConstraintSolver::addTorsionalFrictionCon
 
 int	btSequentialImpulseConstraintSolver::getOrInitSolverBody(btCollisionObject& body,btScalar timeStep)
 {
+// Urho3D: Bullet is built with BT_THREADSAFE, so this path is used also when stepping on one thread. It creates the solver
+// bodies of rigid bodies in the same order as the path below, so the results are the same
 #if BT_THREADSAFE
     int solverBodyId = -1;
     if ( !body.isStaticOrKinematicObject() )
@@ -733,13 +735,12 @@ int	btSequentialImpulseConstraintSolver::getOrInitSolverBody(btCollisionObject&
         solverBodyId = body.getCompanionId();
         if ( solverBodyId < 0 )
         {
-            if ( btRigidBody* rb = btRigidBody::upcast( &body ) )
-            {
-                solverBodyId = m_tmpSolverBodyPool.size();
-                btSolverBody& solverBody = m_tmpSolverBodyPool.expand();
-                initSolverBody( &solverBody, &body, timeStep );
-                body.setCompanionId( solverBodyId );
-            }
+            // Urho3D: dynamic objects which are not rigid bodies (e.g. ghost objects) get a solver body with infinite mass
+            // instead of an invalid id, like the fixed body they get when not threadsafe
+            solverBodyId = m_tmpSolverBodyPool.size();
+            btSolverBody& solverBody = m_tmpSolverBodyPool.expand();
+            initSolverBody( &solverBody, &body, timeStep );
+            body.setCompanionId( solverBodyId );
         }
     }
     else if (body.isKinematicObject())
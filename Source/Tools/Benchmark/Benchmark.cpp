@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+/// Benchmark suite description.
+struct BenchmarkSuite
+{
+    /// Name used on the command line.
+    const char* name_;
+    /// Entry point.
+    BenchmarkFunction function_;
+    /// Short description.
+    const char* description_;
+};
+
+static const BenchmarkSuite suites[] =
+{
+    {"compress", RunCompressBenchmark, "DXT1, DXT5 and ETC1 runtime compression throughput and quality"},
+    {"decompress", RunDecompressBenchmark, "DXT, ETC1 and PVRTC decompression throughput"},
+    {"mix", RunMixBenchmark, "Sound source mixing throughput for all channel and interpolation combinations"},
+    {"particles", RunParticleBenchmark, "3D and 2D particle emitter update throughput"},
+    {"physics", RunPhysicsBenchmark, "Rigid body simulation step time, serial and multithreaded"},
+    {"replication", RunReplicationBenchmark, "Scene replication to simulated clients over the loopback transport"},
+    {"resample", RunResampleBenchmark, "Mip level generation, image resizing and pixel readback throughput"},
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+String FormatString(const char* formatString, ...)
+{
+    char buffer[1024];
+    va_list args;
+    va_start(args, formatString);
+    vsnprintf(buffer, sizeof buffer, formatString, args);
+    va_end(args);
+    return String(buffer);
+}
+
+void PrintThroughput(const String& name, double units, const String& unitName, long long usec)
+{
+    double seconds = Max((double)usec, 1.0) / 1000000.0;
+    PrintLine(FormatString("%-32s %10.2f ms %12.2f %s/sec", name.CString(), usec / 1000.0, units / seconds, unitName.CString()));
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Empty())
+    {
+        String usage = "Usage: Benchmark <suite> [options]\n\nSuites:\n";
+        for (const BenchmarkSuite& suite : suites)
+            usage += FormatString("%-12s %s\n", suite.name_, suite.description_);
+        usage += "\nOptions common to all suites:\n"
+            "-t<n>        Number of worker threads, default is the number of logical CPUs minus one\n";
+        ErrorExit(usage);
+    }
+
+    unsigned numThreads = GetNumLogicalCPUs() > 1 ? GetNumLogicalCPUs() - 1 : 0;
+    Vector<String> suiteArguments;
+    for (unsigned i = 1; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-t"))
+            numThreads = ToUInt(arguments[i].Substring(2));
+        else
+            suiteArguments.Push(arguments[i]);
+    }
+
+    SharedPtr<Context> context(new Context());
+    context->RegisterSubsystem(new FileSystem(context));
+    context->RegisterSubsystem(new Log(context));
+    // Time initializes the high-resolution timer frequency
+    context->RegisterSubsystem(new Time(context));
+    context->RegisterSubsystem(new WorkQueue(context));
+    context->GetSubsystem<Log>()->SetLevel(LOG_WARNING);
+    if (numThreads)
+        context->GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+
+    for (const BenchmarkSuite& suite : suites)
+    {
+        if (arguments[0] == suite.name_)
+        {
+            PrintLine(ToString("Running %s with %u worker threads", suite.name_, numThreads));
+            suite.function_(context, suiteArguments);
+            return;
+        }
+    }
+
+    ErrorExit("Unknown benchmark suite " + arguments[0]);
+}
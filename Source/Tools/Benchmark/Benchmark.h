@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+
+namespace Urho3D
+{
+
+class Context;
+
+}
+
+using namespace Urho3D;
+
+/// Benchmark suite entry point. Receives the command line arguments following the suite name.
+using BenchmarkFunction = void (*)(Context* context, const Vector<String>& arguments);
+
+/// Format a string with printf syntax. Unlike ToString(), supports field widths and precision.
+String FormatString(const char* formatString, ...);
+/// Print a throughput result line.
+void PrintThroughput(const String& name, double units, const String& unitName, long long usec);
+
+/// Compression throughput and quality of runtime DXT and ETC1 encoding.
+void RunCompressBenchmark(Context* context, const Vector<String>& arguments);
+/// Decompression throughput of the compressed image formats.
+void RunDecompressBenchmark(Context* context, const Vector<String>& arguments);
+/// Sound source mixing throughput in voices mixed per millisecond.
+void RunMixBenchmark(Context* context, const Vector<String>& arguments);
+/// Particle emitter update throughput in particles per second.
+void RunParticleBenchmark(Context* context, const Vector<String>& arguments);
+/// Rigid body simulation step time, serial and on the work queue threads.
+void RunPhysicsBenchmark(Context* context, const Vector<String>& arguments);
+/// Scene replication to simulated clients over the loopback transport.
+void RunReplicationBenchmark(Context* context, const Vector<String>& arguments);
+/// Mip level generation, resizing and pixel readback throughput.
+void RunResampleBenchmark(Context* context, const Vector<String>& arguments);
@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Resource/Image.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Create a smooth procedural test image, resembling generated splat maps more than random noise would.
+static SharedPtr<Image> CreateProceduralImage(Context* context, int size)
+{
+    SharedPtr<Image> image(new Image(context));
+    image->SetSize(size, size, 4);
+    unsigned char* data = image->GetData();
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            unsigned char* pixel = data + (y * size + x) * 4;
+            pixel[0] = (unsigned char)(127.5f + 127.5f * Sin(x * 40.0f));
+            pixel[1] = (unsigned char)(127.5f + 127.5f * Cos(y * 30.0f + x * 10.0f));
+            pixel[2] = (unsigned char)((x ^ y) & 0xff);
+            pixel[3] = (unsigned char)(y * 255 / size);
+        }
+    }
+    return image;
+}
+
+/// Return the peak signal to noise ratio between the first levels of two RGBA images.
+static float GetPSNR(const Image* a, const Image* b, bool alpha)
+{
+    const unsigned char* dataA = a->GetData();
+    const unsigned char* dataB = b->GetData();
+    unsigned count = (unsigned)(a->GetWidth() * a->GetHeight());
+    double error = 0.0;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        for (unsigned j = alpha ? 3 : 0; j < (alpha ? 4U : 3U); ++j)
+        {
+            double delta = (double)dataA[i * 4 + j] - dataB[i * 4 + j];
+            error += delta * delta;
+        }
+    }
+    error /= count * (alpha ? 1 : 3);
+    return error > 0.0 ? (float)(10.0 * log10(255.0 * 255.0 / error)) : 99.0f;
+}
+
+void RunCompressBenchmark(Context* context, const Vector<String>& arguments)
+{
+    int size = 1024;
+    unsigned iterations = 5;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-s"))
+            size = NextPowerOfTwo(Max(ToUInt(arguments[i].Substring(2)), 4U));
+        else if (arguments[i].StartsWith("-i"))
+            iterations = Max(ToUInt(arguments[i].Substring(2)), 1U);
+    }
+
+    PrintLine(ToString("Compressing %dx%d images with mip levels %u times (options: -s<size> -i<iterations>)", size, size, iterations));
+
+    SharedPtr<Image> image = CreateProceduralImage(context, size);
+    image->PrecalculateLevels();
+
+    double chainPixels = 0.0;
+    for (int levelSize = size; levelSize >= 1; levelSize /= 2)
+        chainPixels += (double)levelSize * levelSize;
+    chainPixels *= iterations;
+
+    const CompressedFormat formats[] = {CF_DXT1, CF_DXT5, CF_ETC1};
+    const char* names[] = {"DXT1", "DXT5", "ETC1"};
+    HiresTimer timer;
+
+    for (unsigned f = 0; f < 3; ++f)
+    {
+        SharedPtr<Image> compressed;
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+            compressed = image->GetCompressedImage(formats[f]);
+        long long usec = timer.GetUSec(false);
+        if (!compressed)
+        {
+            PrintLine(String("Could not compress to ") + names[f], true);
+            continue;
+        }
+
+        SharedPtr<Image> decompressed = compressed->GetDecompressedImage();
+        String name = FormatString("%s (RGB %.1f dB", names[f], GetPSNR(image, decompressed, false));
+        if (formats[f] == CF_DXT5)
+            name += FormatString(", A %.1f dB", GetPSNR(image, decompressed, true));
+        PrintThroughput(name + ")", chainPixels / 1000000.0, "MPixels", usec);
+    }
+}
@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/Decompress.h>
+#include <Urho3D/Resource/Image.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Fill a buffer with random bytes. Any bit pattern is a valid DXT, ETC1 or PVRTC block.
+static void FillRandom(PODVector<unsigned char>& data, unsigned size)
+{
+    data.Resize(size);
+    for (unsigned i = 0; i < size; ++i)
+        data[i] = (unsigned char)Rand();
+}
+
+/// Build an in-memory DDS image with a full mip chain of random blocks.
+static SharedPtr<Image> CreateDDSImage(Context* context, int size, bool dxt5)
+{
+    unsigned numLevels = 0;
+    unsigned dataSize = 0;
+    for (int levelSize = size; levelSize >= 1; levelSize /= 2)
+    {
+        int blocks = Max((levelSize + 3) / 4, 1);
+        dataSize += blocks * blocks * (dxt5 ? 16 : 8);
+        ++numLevels;
+    }
+
+    // DDS_HEADER as 31 little-endian words, see the DDSurfaceDesc2 structure in Image.cpp
+    unsigned header[31] = {};
+    header[0] = sizeof(header);
+    header[1] = 0x00000001 /*DDSD_CAPS*/ | 0x00000002 /*DDSD_HEIGHT*/ | 0x00000004 /*DDSD_WIDTH*/ | 0x00001000 /*DDSD_PIXELFORMAT*/ |
+        0x00020000 /*DDSD_MIPMAPCOUNT*/;
+    header[2] = (unsigned)size;
+    header[3] = (unsigned)size;
+    header[6] = numLevels;
+    header[18] = 32;
+    header[19] = 0x00000004 /*DDPF_FOURCC*/;
+    header[20] = dxt5 ? 0x35545844 /*DXT5*/ : 0x31545844 /*DXT1*/;
+    header[26] = 0x00001000 /*DDSCAPS_TEXTURE*/ | 0x00400000 /*DDSCAPS_MIPMAP*/ | 0x00000008 /*DDSCAPS_COMPLEX*/;
+
+    PODVector<unsigned char> data;
+    FillRandom(data, dataSize);
+
+    VectorBuffer buffer;
+    buffer.WriteFileID("DDS ");
+    buffer.Write(header, sizeof(header));
+    buffer.Write(data.Buffer(), data.Size());
+    buffer.Seek(0);
+
+    SharedPtr<Image> image(new Image(context));
+    if (!image->Load(buffer))
+        return SharedPtr<Image>();
+    return image;
+}
+
+void RunDecompressBenchmark(Context* context, const Vector<String>& arguments)
+{
+    int size = 1024;
+    unsigned iterations = 20;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-s"))
+            size = NextPowerOfTwo(Max(ToUInt(arguments[i].Substring(2)), 4U));
+        else if (arguments[i].StartsWith("-i"))
+            iterations = Max(ToUInt(arguments[i].Substring(2)), 1U);
+    }
+
+    PrintLine(ToString("Decompressing %dx%d images %u times (options: -s<size> -i<iterations>)", size, size, iterations));
+
+    double pixels = (double)size * size * iterations;
+    PODVector<unsigned char> rgba(size * size * 4);
+    PODVector<unsigned char> blocks;
+    HiresTimer timer;
+
+    // Single level decompression on the calling thread
+    const CompressedFormat dxtFormats[] = {CF_DXT1, CF_DXT3, CF_DXT5};
+    const char* dxtNames[] = {"DXT1", "DXT3", "DXT5"};
+    for (unsigned f = 0; f < 3; ++f)
+    {
+        FillRandom(blocks, (size / 4) * (size / 4) * (dxtFormats[f] == CF_DXT1 ? 8 : 16));
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+            DecompressImageDXT(rgba.Buffer(), blocks.Buffer(), size, size, 1, dxtFormats[f]);
+        PrintThroughput(dxtNames[f], pixels / 1000000.0, "MPixels", timer.GetUSec(false));
+    }
+
+    FillRandom(blocks, (size / 4) * (size / 4) * 8);
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+        DecompressImageETC(rgba.Buffer(), blocks.Buffer(), size, size);
+    PrintThroughput("ETC1", pixels / 1000000.0, "MPixels", timer.GetUSec(false));
+
+    FillRandom(blocks, size * size / 2);
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+        DecompressImagePVRTC(rgba.Buffer(), blocks.Buffer(), size, size, CF_PVRTC_RGBA_4BPP);
+    PrintThroughput("PVRTC 4bpp", pixels / 1000000.0, "MPixels", timer.GetUSec(false));
+
+    // Whole mip chain through the Image API, which splits the work between worker threads
+    double chainPixels = 0.0;
+    for (int levelSize = size; levelSize >= 1; levelSize /= 2)
+        chainPixels += (double)levelSize * levelSize;
+    chainPixels *= iterations;
+
+    for (unsigned f = 0; f < 2; ++f)
+    {
+        bool dxt5 = f == 1;
+        SharedPtr<Image> image = CreateDDSImage(context, size, dxt5);
+        if (!image)
+        {
+            PrintLine("Could not create DDS image", true);
+            return;
+        }
+
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+            image->GetDecompressedImage();
+        PrintThroughput(String(dxt5 ? "DXT5" : "DXT1") + " mip chain (threaded)", chainPixels / 1000000.0, "MPixels",
+            timer.GetUSec(false));
+    }
+}
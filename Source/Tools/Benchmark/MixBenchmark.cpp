@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Audio/Audio.h>
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Audio/SoundSource.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Output rate to mix at.
+static const int MIX_RATE = 44100;
+/// Samples per mix call, matching the audio thread's fragment size at the mix rate.
+static const unsigned MIX_FRAGMENT = 1024;
+
+static SharedPtr<Sound> CreateNoiseSound(Context* context, bool stereo)
+{
+    // One second of looped noise
+    PODVector<short> data((unsigned)(stereo ? MIX_RATE * 2 : MIX_RATE));
+    for (unsigned i = 0; i < data.Size(); ++i)
+        data[i] = (short)(Rand() - 16384);
+
+    SharedPtr<Sound> sound(new Sound(context));
+    sound->SetData(&data[0], data.Size() * sizeof(short));
+    sound->SetFormat(MIX_RATE, true, stereo);
+    sound->SetLooped(true);
+    return sound;
+}
+
+void RunMixBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numVoices = 64;
+    unsigned milliseconds = 2000;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-v"))
+            numVoices = Max(ToUInt(arguments[i].Substring(2)), 1U);
+        else if (arguments[i].StartsWith("-m"))
+            milliseconds = Max(ToUInt(arguments[i].Substring(2)), 100U);
+    }
+
+    PrintLine(ToString("Mixing %u voices for %u ms of audio at %d Hz (options: -v<voices> -m<milliseconds>)", numVoices,
+        milliseconds, MIX_RATE));
+
+    // Without an audio device the subsystem applies sound source commands immediately, so the sources can be mixed
+    // directly from this thread. Silence the error about a missing device on headless machines
+    if (!context->GetSubsystem<Audio>())
+    {
+        auto* log = context->GetSubsystem<Log>();
+        int logLevel = log->GetLevel();
+        log->SetLevel(LOG_NONE);
+        context->RegisterSubsystem(new Audio(context));
+        log->SetLevel(logLevel);
+    }
+
+    SharedPtr<Scene> scene(new Scene(context));
+    SharedPtr<Sound> sounds[] = {CreateNoiseSound(context, false), CreateNoiseSound(context, true)};
+    PODVector<float> buffer(MIX_FRAGMENT * 2);
+    unsigned fragments = (unsigned)((unsigned long long)milliseconds * MIX_RATE / 1000 / MIX_FRAGMENT);
+    double voiceMilliseconds = (double)numVoices * fragments * MIX_FRAGMENT * 1000.0 / MIX_RATE;
+    HiresTimer timer;
+
+    for (unsigned test = 0; test < 8; ++test)
+    {
+        bool stereoSound = (test & 4u) != 0;
+        bool stereoOutput = (test & 2u) != 0;
+        bool interpolation = (test & 1u) != 0;
+
+        // Detune the voices so that every one is resampled
+        PODVector<SoundSource*> sources;
+        for (unsigned i = 0; i < numVoices; ++i)
+        {
+            auto* source = scene->CreateChild()->CreateComponent<SoundSource>();
+            source->Play(sounds[stereoSound ? 1 : 0], MIX_RATE * Random(0.8f, 1.2f), 0.05f, Random(-1.0f, 1.0f));
+            sources.Push(source);
+        }
+
+        timer.Reset();
+        for (unsigned i = 0; i < fragments; ++i)
+        {
+            memset(&buffer[0], 0, buffer.Size() * sizeof(float));
+            for (unsigned j = 0; j < sources.Size(); ++j)
+                sources[j]->Mix(&buffer[0], MIX_FRAGMENT, MIX_RATE, stereoOutput, interpolation);
+        }
+        long long usec = timer.GetUSec(false);
+
+        String name = FormatString("%s to %s%s", stereoSound ? "Stereo" : "Mono", stereoOutput ? "stereo" : "mono",
+            interpolation ? " interpolated" : "");
+        // Milliseconds of voice output mixed per millisecond of CPU time, i.e. how many voices could play in real time
+        PrintLine(FormatString("%-32s %10.2f ms %12.2f voices/ms", name.CString(), usec / 1000.0,
+            voiceMilliseconds * 1000.0 / Max((double)usec, 1.0)));
+
+        scene->RemoveAllChildren();
+    }
+}
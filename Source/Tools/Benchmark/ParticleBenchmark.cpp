@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/ParticleEffect.h>
+#include <Urho3D/Graphics/ParticleEmitter.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef URHO3D_URHO2D
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/ParticleEmitter2D.h>
+#include <Urho3D/Urho2D/Urho2D.h>
+#endif
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Simulation timestep.
+static const float TIME_STEP = 1.0f / 60.0f;
+
+static SharedPtr<ParticleEffect> CreateEffect(Context* context, unsigned numParticles, bool allFeatures)
+{
+    // Particles live for the whole benchmark, so that the emitter stays full once warmed up
+    SharedPtr<ParticleEffect> effect(new ParticleEffect(context));
+    effect->SetNumParticles(numParticles);
+    effect->SetUpdateInvisible(true);
+    effect->SetMinEmissionRate(100000.0f);
+    effect->SetMaxEmissionRate(100000.0f);
+    effect->SetMinTimeToLive(10000.0f);
+    effect->SetMaxTimeToLive(10000.0f);
+    effect->SetMinVelocity(1.0f);
+    effect->SetMaxVelocity(4.0f);
+    effect->SetMinRotationSpeed(-90.0f);
+    effect->SetMaxRotationSpeed(90.0f);
+    effect->SetEmitterSize(Vector3(10.0f, 10.0f, 10.0f));
+
+    if (allFeatures)
+    {
+        effect->SetConstantForce(Vector3(0.0f, -9.81f, 0.0f));
+        effect->SetDampingForce(0.5f);
+        effect->SetSizeAdd(0.1f);
+        effect->SetSizeMul(1.01f);
+
+        Vector<ColorFrame> colorFrames;
+        colorFrames.Push(ColorFrame(Color::WHITE, 0.0f));
+        colorFrames.Push(ColorFrame(Color::YELLOW, 5000.0f));
+        colorFrames.Push(ColorFrame(Color::RED, 10000.0f));
+        effect->SetColorFrames(colorFrames);
+
+        Vector<TextureFrame> textureFrames;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            TextureFrame frame;
+            frame.uv_ = Rect(i * 0.25f, 0.0f, (i + 1) * 0.25f, 1.0f);
+            frame.time_ = i * 2500.0f;
+            textureFrames.Push(frame);
+        }
+        effect->SetTextureFrames(textureFrames);
+    }
+
+    return effect;
+}
+
+static void RunEmitterTest(Context* context, const String& name, unsigned numParticles, unsigned numFrames, bool allFeatures)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    auto* emitter = scene->CreateChild()->CreateComponent<ParticleEmitter>();
+    emitter->SetEffect(CreateEffect(context, numParticles, allFeatures));
+
+    FrameInfo frame;
+    frame.timeStep_ = TIME_STEP;
+    frame.camera_ = nullptr;
+    frame.viewSize_ = IntVector2(1, 1);
+
+    // Emission is limited per frame, so it takes a while to fill the emitter. Free particles are taken in order, so the
+    // emitter is full when the last billboard is enabled
+    unsigned frameNumber = 0;
+    while (!emitter->GetBillboards().Back().enabled_)
+    {
+        frame.frameNumber_ = ++frameNumber;
+        scene->Update(TIME_STEP);
+        octree->Update(frame);
+    }
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        frame.frameNumber_ = ++frameNumber;
+        scene->Update(TIME_STEP);
+        octree->Update(frame);
+    }
+    PrintThroughput(name, (double)numParticles * numFrames, "particles", timer.GetUSec(false));
+}
+
+#ifdef URHO3D_URHO2D
+static void RunEmitter2DTest(Context* context, const String& name, unsigned numParticles, unsigned numFrames,
+    EmitterType2D emitterType)
+{
+    SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context));
+    effect->SetMaxParticles(numParticles);
+    effect->SetDuration(M_LARGE_VALUE);
+    effect->SetParticleLifeSpan(5.0f);
+    effect->SetSpeed(100.0f);
+    effect->SetSpeedVariance(30.0f);
+    effect->SetAngleVariance(180.0f);
+    effect->SetGravity(Vector2(0.0f, -100.0f));
+    effect->SetRadialAcceleration(-20.0f);
+    effect->SetTangentialAcceleration(30.0f);
+    effect->SetStartParticleSize(20.0f);
+    effect->SetFinishParticleSize(5.0f);
+    effect->SetRotationEnd(360.0f);
+    effect->SetMaxRadius(100.0f);
+    effect->SetMinRadius(10.0f);
+    effect->SetRotatePerSecond(90.0f);
+    effect->SetEmitterType(emitterType);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<Octree>();
+    auto* emitter = scene->CreateChild()->CreateComponent<ParticleEmitter2D>();
+    emitter->SetEffect(effect);
+
+    // Expired particles are replaced continuously once the emitter has run for a lifespan
+    for (float time = 0.0f; time < effect->GetParticleLifeSpan(); time += TIME_STEP)
+        scene->Update(TIME_STEP);
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numFrames; ++i)
+        scene->Update(TIME_STEP);
+    PrintThroughput(name, (double)numParticles * numFrames, "particles", timer.GetUSec(false));
+}
+#endif
+
+void RunParticleBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numParticles = 100000;
+    unsigned numFrames = 300;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-p"))
+            numParticles = Max(ToUInt(arguments[i].Substring(2)), 1U);
+        else if (arguments[i].StartsWith("-f"))
+            numFrames = Max(ToUInt(arguments[i].Substring(2)), 1U);
+    }
+
+    PrintLine(ToString("Updating %u particles per emitter for %u frames (options: -p<particles> -f<frames>)", numParticles,
+        numFrames));
+
+    if (!context->GetSubsystem<ResourceCache>())
+        context->RegisterSubsystem(new ResourceCache(context));
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+
+    // There are no resource directories, so materials can not load their default technique. Silence the errors
+    auto* log = context->GetSubsystem<Log>();
+    int logLevel = log->GetLevel();
+    log->SetLevel(LOG_NONE);
+
+    RunEmitterTest(context, "Emitter", numParticles, numFrames, false);
+    RunEmitterTest(context, "Emitter all features", numParticles, numFrames, true);
+
+#ifdef URHO3D_URHO2D
+    RegisterUrho2DLibrary(context);
+
+    RunEmitter2DTest(context, "Emitter2D gravity", numParticles, numFrames, EMITTER_TYPE_GRAVITY);
+    RunEmitter2DTest(context, "Emitter2D radial", numParticles, numFrames, EMITTER_TYPE_RADIAL);
+#endif
+
+    log->SetLevel(logLevel);
+}
@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Math/Ray.h>
+#include <Urho3D/Scene/Scene.h>
+
+#ifdef URHO3D_PHYSICS
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#endif
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+#ifdef URHO3D_PHYSICS
+
+/// Simulation timestep, one physics step per frame.
+static const float TIME_STEP = 1.0f / 60.0f;
+/// Bodies per stack.
+static const unsigned STACK_HEIGHT = 5;
+/// Distance between the stacks.
+static const float STACK_SPACING = 3.0f;
+/// Frames simulated before measuring, so that the stacks have landed and settled.
+static const unsigned WARMUP_FRAMES = 60;
+
+/// Maximum distance of the benchmark queries.
+static const float QUERY_DISTANCE = 50.0f;
+
+/// Return the number of stacks per side of the square they are placed in.
+static unsigned GetNumStacksPerSide(unsigned numBodies)
+{
+    unsigned numStacks = (numBodies + STACK_HEIGHT - 1) / STACK_HEIGHT;
+    return (unsigned)ceilf(sqrtf((float)numStacks));
+}
+
+static SharedPtr<Scene> CreateScene(Context* context, unsigned numBodies)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    scene->CreateComponent<PhysicsWorld>()->SetFps(60);
+
+    // Each stack is a simulation island of its own, which is what the threads solve in parallel
+    unsigned side = GetNumStacksPerSide(numBodies);
+    float extent = side * STACK_SPACING;
+
+    Node* groundNode = scene->CreateChild();
+    groundNode->SetPosition(Vector3(0.0f, -0.5f, 0.0f));
+    groundNode->CreateComponent<RigidBody>();
+    groundNode->CreateComponent<CollisionShape>()->SetBox(Vector3(extent, 1.0f, extent));
+
+    for (unsigned i = 0; i < numBodies; ++i)
+    {
+        unsigned stack = i / STACK_HEIGHT;
+        unsigned level = i % STACK_HEIGHT;
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3((stack % side + 0.5f) * STACK_SPACING - extent * 0.5f, level * 1.1f + 0.6f,
+            (stack / side + 0.5f) * STACK_SPACING - extent * 0.5f));
+        node->SetRotation(Quaternion(level * 7.0f, Vector3::UP));
+
+        // Keep the bodies awake, otherwise the settled stacks would cost nothing
+        auto* body = node->CreateComponent<RigidBody>();
+        body->SetMass(1.0f);
+        body->SetFriction(0.6f);
+        body->SetLinearRestThreshold(0.0f);
+        body->SetAngularRestThreshold(0.0f);
+
+        auto* shape = node->CreateComponent<CollisionShape>();
+        if (level == STACK_HEIGHT - 1)
+            shape->SetSphere(1.0f);
+        else
+            shape->SetBox(Vector3::ONE);
+    }
+
+    return scene;
+}
+
+static void RunPhysicsTest(Context* context, const String& name, unsigned numBodies, unsigned numFrames, bool multiThreaded,
+    bool deterministic)
+{
+    SharedPtr<Scene> scene = CreateScene(context, numBodies);
+    auto* world = scene->GetComponent<PhysicsWorld>();
+    world->SetMultiThreaded(multiThreaded);
+    world->SetDeterministic(deterministic);
+
+    for (unsigned i = 0; i < WARMUP_FRAMES; ++i)
+        scene->Update(TIME_STEP);
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numFrames; ++i)
+        scene->Update(TIME_STEP);
+    long long usec = timer.GetUSec(false);
+    PrintLine(FormatString("%-32s %10.2f ms per step %10.2f bodies/ms", name.CString(), usec / 1000.0 / numFrames,
+        (double)numBodies * numFrames * 1000.0 / Max(usec, 1LL)));
+}
+
+static void RunQueryTests(Context* context, unsigned numBodies, unsigned numQueries)
+{
+    SharedPtr<Scene> scene = CreateScene(context, numBodies);
+    auto* world = scene->GetComponent<PhysicsWorld>();
+    for (unsigned i = 0; i < WARMUP_FRAMES; ++i)
+        scene->Update(TIME_STEP);
+
+    // Rays from above the stacks in random downward directions, so that most of them hit
+    float halfExtent = GetNumStacksPerSide(numBodies) * STACK_SPACING * 0.5f;
+    SetRandomSeed(1);
+    PODVector<Ray> rays(numQueries);
+    for (unsigned i = 0; i < numQueries; ++i)
+    {
+        rays[i].Define(Vector3(Random(-halfExtent, halfExtent), 10.0f, Random(-halfExtent, halfExtent)),
+            Vector3(Random(-1.0f, 1.0f), -1.0f, Random(-1.0f, 1.0f)));
+    }
+
+    PODVector<PhysicsRaycastResult> results(numQueries);
+    HiresTimer timer;
+    for (unsigned i = 0; i < numQueries; ++i)
+        world->RaycastSingle(results[i], rays[i], QUERY_DISTANCE);
+    PrintThroughput("RaycastSingle", numQueries, "queries", timer.GetUSec(true));
+    world->RaycastSingleBatch(results, rays, QUERY_DISTANCE);
+    PrintThroughput("RaycastSingleBatch", numQueries, "queries", timer.GetUSec(true));
+    for (unsigned i = 0; i < numQueries; ++i)
+        world->SphereCast(results[i], rays[i], 0.5f, QUERY_DISTANCE);
+    PrintThroughput("SphereCast", numQueries, "queries", timer.GetUSec(true));
+    world->SphereCastBatch(results, rays, 0.5f, QUERY_DISTANCE);
+    PrintThroughput("SphereCastBatch", numQueries, "queries", timer.GetUSec(true));
+}
+
+void RunPhysicsBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numBodies = 5000;
+    unsigned numFrames = 300;
+    unsigned numQueries = 100000;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-b"))
+            numBodies = Max(ToUInt(arguments[i].Substring(2)), 1U);
+        else if (arguments[i].StartsWith("-f"))
+            numFrames = Max(ToUInt(arguments[i].Substring(2)), 1U);
+        else if (arguments[i].StartsWith("-q"))
+            numQueries = Max(ToUInt(arguments[i].Substring(2)), 1U);
+    }
+
+    PrintLine(ToString("Stepping %u dynamic bodies for %u frames, then %u queries of each type "
+        "(options: -b<bodies> -f<frames> -q<queries>)", numBodies, numFrames, numQueries));
+
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    RunPhysicsTest(context, "Serial", numBodies, numFrames, false, true);
+    RunPhysicsTest(context, "Multithreaded", numBodies, numFrames, true, true);
+    RunPhysicsTest(context, "Multithreaded nondeterministic", numBodies, numFrames, true, false);
+    RunQueryTests(context, numBodies, numQueries);
+}
+
+#else
+
+void RunPhysicsBenchmark(Context* context, const Vector<String>& arguments)
+{
+    ErrorExit("Physics support is disabled");
+}
+
+#endif
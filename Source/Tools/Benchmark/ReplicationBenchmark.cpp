@@ -0,0 +1,361 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SmoothedTransform.h>
+
+#ifdef URHO3D_NETWORK
+#include <Urho3D/Network/Network.h>
+#include <Urho3D/Network/NetworkEvents.h>
+#endif
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+#ifdef URHO3D_NETWORK
+
+/// Height step of the nodes per server tick. Clients recover the tick from the replicated positions to measure latency, so it is a multiple of the position quantization.
+static const float TICK_HEIGHT = 0.01f;
+/// Radius of the circles the nodes move on.
+static const float MOVE_RADIUS = 2.0f;
+/// Frames per second. Higher than the network update rate, so that latency is measured at a finer resolution.
+static const int FRAME_RATE = 240;
+/// Time in microseconds from all clients having loaded the scene until measuring begins.
+static const long long WARMUP_USEC = 1000000;
+/// Time in microseconds to wait for the clients to load the scene.
+static const long long CONNECT_TIMEOUT_USEC = 30000000;
+
+/// Simulated client with its own context and network subsystem.
+struct LoadTestClient
+{
+    /// Client context.
+    SharedPtr<Context> context_;
+    /// Client scene.
+    SharedPtr<Scene> scene_;
+    /// Client network subsystem.
+    Network* network_;
+    /// Latest server tick received per node ID, or -1 if none.
+    PODVector<int> nodeTicks_;
+};
+
+/// Server side of the replication load test. Moves the nodes on each network update and measures the time spent replicating them.
+class ReplicationLoadTest : public Object
+{
+    URHO3D_OBJECT(ReplicationLoadTest, Object);
+
+public:
+    /// Construct.
+    ReplicationLoadTest(Context* context, HiresTimer& clock) :
+        Object(context),
+        clock_(clock),
+        measuring_(false)
+    {
+        auto* network = GetSubsystem<Network>();
+        SubscribeToEvent(network, E_NETWORKUPDATE, URHO3D_HANDLER(ReplicationLoadTest, HandleNetworkUpdate));
+        SubscribeToEvent(network, E_NETWORKUPDATESENT, URHO3D_HANDLER(ReplicationLoadTest, HandleNetworkUpdateSent));
+    }
+
+    /// Add a node moving around a center point.
+    void AddNode(Node* node, const Vector3& center, float phase)
+    {
+        nodes_.Push(node);
+        centers_.Push(center);
+        phases_.Push(phase);
+    }
+
+    /// Set whether to record the replication time.
+    void SetMeasuring(bool enable) { measuring_ = enable; }
+
+    /// Return number of ticks sent.
+    unsigned GetNumTicks() const { return tickTimes_.Size(); }
+
+    /// Return the time in microseconds when a tick was sent, or -1 if unknown.
+    long long GetTickTime(int tick) const { return tick >= 0 && tick < (int)tickTimes_.Size() ? tickTimes_[tick] : -1; }
+
+    /// Return the recorded replication times in milliseconds.
+    PODVector<float>& GetReplicationTimes() { return replicationTimes_; }
+
+private:
+    /// Handle network update about to be sent. Encode the tick in the node positions.
+    void HandleNetworkUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle network update sent.
+    void HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData);
+
+    /// Clock shared with the clients.
+    HiresTimer& clock_;
+    /// Moving nodes.
+    PODVector<Node*> nodes_;
+    /// Center points of the nodes.
+    PODVector<Vector3> centers_;
+    /// Movement phases of the nodes.
+    PODVector<float> phases_;
+    /// Send time of each tick in microseconds.
+    PODVector<long long> tickTimes_;
+    /// Replication time of each tick while measuring.
+    PODVector<float> replicationTimes_;
+    /// Timer for the replication time.
+    HiresTimer replicationTimer_;
+    /// Whether to record the replication time.
+    bool measuring_;
+};
+
+void ReplicationLoadTest::HandleNetworkUpdate(StringHash eventType, VariantMap& eventData)
+{
+    int tick = tickTimes_.Size();
+    tickTimes_.Push(clock_.GetUSec(false));
+
+    float angle = tick * 0.1f;
+    for (unsigned i = 0; i < nodes_.Size(); ++i)
+    {
+        float nodeAngle = (angle + phases_[i]) * M_RADTODEG;
+        nodes_[i]->SetPosition(centers_[i] + Vector3(Cos(nodeAngle) * MOVE_RADIUS, tick * TICK_HEIGHT, Sin(nodeAngle) * MOVE_RADIUS));
+    }
+
+    replicationTimer_.Reset();
+}
+
+void ReplicationLoadTest::HandleNetworkUpdateSent(StringHash eventType, VariantMap& eventData)
+{
+    if (measuring_)
+        replicationTimes_.Push(replicationTimer_.GetUSec(false) / 1000.0f);
+}
+
+static float GetPercentile(const PODVector<float>& sorted, float fraction)
+{
+    if (sorted.Empty())
+        return 0.0f;
+    return sorted[Min((unsigned)(fraction * sorted.Size()), sorted.Size() - 1)];
+}
+
+static void PrintStatistics(const String& name, PODVector<float>& values, const String& unitName)
+{
+    Sort(values.Begin(), values.End());
+    float sum = 0.0f;
+    for (unsigned i = 0; i < values.Size(); ++i)
+        sum += values[i];
+    float average = values.Size() ? sum / values.Size() : 0.0f;
+    PrintLine(FormatString("%-32s avg %9.3f  p50 %9.3f  p95 %9.3f  p99 %9.3f %s (%u samples)", name.CString(), average,
+        GetPercentile(values, 0.5f), GetPercentile(values, 0.95f), GetPercentile(values, 0.99f), unitName.CString(), values.Size()));
+}
+
+void RunReplicationBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numClients = 16;
+    unsigned numNodes = 1000;
+    unsigned duration = 10;
+    int latency = 50;
+    float packetLoss = 0.0f;
+    unsigned bandwidth = 0;
+    float interestRadius = 0.0f;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-c"))
+            numClients = Max(ToUInt(arguments[i].Substring(2)), 1U);
+        else if (arguments[i].StartsWith("-n"))
+            numNodes = Max(ToUInt(arguments[i].Substring(2)), 1U);
+        else if (arguments[i].StartsWith("-d"))
+            duration = Max(ToUInt(arguments[i].Substring(2)), 1U);
+        else if (arguments[i].StartsWith("-l"))
+            latency = ToInt(arguments[i].Substring(2));
+        else if (arguments[i].StartsWith("-p"))
+            packetLoss = ToFloat(arguments[i].Substring(2)) / 100.0f;
+        else if (arguments[i].StartsWith("-b"))
+            bandwidth = ToUInt(arguments[i].Substring(2)) * 1000;
+        else if (arguments[i].StartsWith("-r"))
+            interestRadius = ToFloat(arguments[i].Substring(2));
+    }
+
+    PrintLine(FormatString("Replicating %u nodes to %u clients for %u seconds, latency %d ms, packet loss %.1f%%, bandwidth %u KB/s, "
+        "interest radius %.1f\n(options: -c<clients> -n<nodes> -d<seconds> -l<latency ms> -p<loss percent> -b<KB/s> -r<radius>)",
+        numNodes, numClients, duration, latency, packetLoss * 100.0f, bandwidth / 1000, interestRadius));
+
+    RegisterSceneLibrary(context);
+    auto* serverNetwork = new Network(context);
+    context->RegisterSubsystem(serverNetwork);
+    serverNetwork->SetSimulatedLatency(latency);
+    serverNetwork->SetSimulatedPacketLoss(packetLoss);
+    serverNetwork->SetSimulatedBandwidth(bandwidth);
+    serverNetwork->StartLoopbackServer();
+
+    // Spread the nodes so that an interest radius covers about a tenth of them
+    HiresTimer clock;
+    SharedPtr<ReplicationLoadTest> test(new ReplicationLoadTest(context, clock));
+    SharedPtr<Scene> serverScene(new Scene(context));
+    float halfSize = interestRadius > 0.0f ? interestRadius * 2.8f : 100.0f;
+    for (unsigned i = 0; i < numNodes; ++i)
+        test->AddNode(serverScene->CreateChild(), Vector3(Random(-halfSize, halfSize), 0.0f, Random(-halfSize, halfSize)), Random(M_PI * 2.0f));
+
+    Vector<LoadTestClient> clients(numClients);
+    for (unsigned i = 0; i < numClients; ++i)
+    {
+        LoadTestClient& client = clients[i];
+        client.context_ = new Context();
+        client.context_->RegisterSubsystem(new FileSystem(client.context_));
+        client.context_->RegisterSubsystem(new ResourceCache(client.context_));
+        client.network_ = new Network(client.context_);
+        client.context_->RegisterSubsystem(client.network_);
+        RegisterSceneLibrary(client.context_);
+
+        client.network_->SetSimulatedLatency(latency);
+        client.network_->SetSimulatedPacketLoss(packetLoss);
+        client.network_->SetSimulatedBandwidth(bandwidth);
+        client.scene_ = new Scene(client.context_);
+        if (!client.network_->ConnectLoopback(serverNetwork, client.scene_))
+            ErrorExit("Failed to connect client");
+        client.network_->GetServerConnection()->SetPosition(Vector3(Random(-halfSize, halfSize), 0.0f, Random(-halfSize, halfSize)));
+    }
+
+    Vector<SharedPtr<Connection> > connections = serverNetwork->GetClientConnections();
+    for (unsigned i = 0; i < connections.Size(); ++i)
+    {
+        connections[i]->SetScene(serverScene);
+        connections[i]->SetInterestRadius(interestRadius);
+    }
+
+    const float timeStep = 1.0f / FRAME_RATE;
+    const long long frameUSec = 1000000 / FRAME_RATE;
+    long long nextFrame = 0;
+    long long measureStart = -1;
+    long long nextSample = 0;
+    double receiveUSec = 0.0;
+    unsigned startTick = 0;
+    PODVector<float> latencies;
+    PODVector<float> bytesDown;
+    PODVector<float> bytesUp;
+    HiresTimer receiveTimer;
+
+    for (;;)
+    {
+        long long time = clock.GetUSec(false);
+        if (measureStart >= 0 && time >= measureStart + duration * 1000000LL)
+            break;
+
+        receiveTimer.Reset();
+        serverNetwork->Update(timeStep);
+        if (measureStart >= 0)
+            receiveUSec += receiveTimer.GetUSec(false);
+
+        bool allLoaded = true;
+        for (unsigned i = 0; i < numClients; ++i)
+        {
+            LoadTestClient& client = clients[i];
+            client.network_->Update(timeStep);
+            Connection* serverConnection = client.network_->GetServerConnection();
+            if (!serverConnection)
+                ErrorExit("Client disconnected");
+            allLoaded &= serverConnection->IsSceneLoaded();
+
+            // Take a latency sample whenever a node position from a newer tick arrives. Client nodes are smoothed towards the
+            // received position, but the scenes are not updated, so read the smoothing target
+            long long receiveTime = clock.GetUSec(false);
+            const Vector<SharedPtr<Node> >& nodes = client.scene_->GetChildren();
+            for (unsigned j = 0; j < nodes.Size(); ++j)
+            {
+                unsigned id = nodes[j]->GetID();
+                while (client.nodeTicks_.Size() <= id)
+                    client.nodeTicks_.Push(-1);
+
+                auto* transform = nodes[j]->GetComponent<SmoothedTransform>();
+                const Vector3& position = transform ? transform->GetTargetPosition() : nodes[j]->GetPosition();
+                int tick = RoundToInt(position.y_ / TICK_HEIGHT);
+                if (tick > client.nodeTicks_[id])
+                {
+                    client.nodeTicks_[id] = tick;
+                    long long tickTime = test->GetTickTime(tick);
+                    if (measureStart >= 0 && tickTime >= measureStart)
+                        latencies.Push((receiveTime - tickTime) / 1000.0f);
+                }
+            }
+        }
+
+        serverNetwork->PostUpdate(timeStep);
+        for (unsigned i = 0; i < numClients; ++i)
+            clients[i].network_->PostUpdate(timeStep);
+
+        time = clock.GetUSec(false);
+        if (measureStart < 0)
+        {
+            if (!allLoaded)
+            {
+                if (time > CONNECT_TIMEOUT_USEC)
+                    ErrorExit("Clients failed to load the scene");
+                nextSample = time + WARMUP_USEC;
+            }
+            else if (time >= nextSample)
+            {
+                measureStart = time;
+                nextSample = time + 1000000;
+                startTick = test->GetNumTicks();
+                test->SetMeasuring(true);
+            }
+        }
+        else if (time >= nextSample)
+        {
+            // Connections count their traffic over one second intervals
+            nextSample += 1000000;
+            for (unsigned i = 0; i < connections.Size(); ++i)
+            {
+                bytesDown.Push(connections[i]->GetBytesOutPerSec());
+                bytesUp.Push(connections[i]->GetBytesInPerSec());
+            }
+        }
+
+        // Run in real time, as the loopback transport delivers messages by the system clock
+        nextFrame += frameUSec;
+        long long wait = nextFrame - clock.GetUSec(false);
+        if (wait > 0)
+            Time::Sleep((unsigned)(wait / 1000));
+        else if (wait < -frameUSec)
+            nextFrame = clock.GetUSec(false);
+    }
+
+    unsigned numTicks = test->GetNumTicks() - startTick;
+    PrintLine(FormatString("%-32s %u (%.1f/sec)", "Server ticks", numTicks, (float)numTicks / duration));
+    PrintLine(FormatString("%-32s %9.3f ms", "Server receive per tick", numTicks ? receiveUSec / numTicks / 1000.0 : 0.0));
+    PrintStatistics("Server replication per tick", test->GetReplicationTimes(), "ms");
+    PrintStatistics("Bytes per client per sec down", bytesDown, "B");
+    PrintStatistics("Bytes per client per sec up", bytesUp, "B");
+    PrintStatistics("Replication latency", latencies, "ms");
+
+    serverNetwork->StopServer();
+    clients.Clear();
+    context->RemoveSubsystem<Network>();
+}
+
+#else
+
+void RunReplicationBenchmark(Context* context, const Vector<String>& arguments)
+{
+    ErrorExit("Networking support is disabled");
+}
+
+#endif
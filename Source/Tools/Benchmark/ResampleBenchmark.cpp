@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/Image.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+static SharedPtr<Image> CreateRandomImage(Context* context, int size, unsigned components)
+{
+    SharedPtr<Image> image(new Image(context));
+    image->SetSize(size, size, components);
+    unsigned char* data = image->GetData();
+    for (unsigned i = 0; i < (unsigned)(size * size) * components; ++i)
+        data[i] = (unsigned char)Rand();
+    return image;
+}
+
+void RunResampleBenchmark(Context* context, const Vector<String>& arguments)
+{
+    int size = 2048;
+    unsigned iterations = 5;
+    for (unsigned i = 0; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].StartsWith("-s"))
+            size = NextPowerOfTwo(Max(ToUInt(arguments[i].Substring(2)), 4U));
+        else if (arguments[i].StartsWith("-i"))
+            iterations = Max(ToUInt(arguments[i].Substring(2)), 1U);
+    }
+
+    PrintLine(ToString("Resampling %dx%d images %u times (options: -s<size> -i<iterations>)", size, size, iterations));
+
+    SharedPtr<Image> image = CreateRandomImage(context, size, 4);
+    double pixels = (double)size * size * iterations / 1000000.0;
+    HiresTimer timer;
+
+    struct MipTest
+    {
+        const char* name_;
+        ResampleFilter filter_;
+        bool gammaCorrect_;
+    };
+    const MipTest mipTests[] =
+    {
+        {"Mip chain box", RESAMPLE_BOX, false},
+        {"Mip chain box sRGB", RESAMPLE_BOX, true},
+        {"Mip chain Kaiser", RESAMPLE_KAISER, false},
+        {"Mip chain Kaiser sRGB", RESAMPLE_KAISER, true},
+    };
+
+    for (const MipTest& test : mipTests)
+    {
+        timer.Reset();
+        for (unsigned i = 0; i < iterations; ++i)
+            image->PrecalculateLevels(test.filter_, test.gammaCorrect_);
+        PrintThroughput(test.name_, pixels, "MPixels", timer.GetUSec(false));
+    }
+    image->CleanupLevels();
+
+    const IntVector2 resizeSizes[] = {IntVector2(size / 3, size / 3), IntVector2(size * 3 / 2, size * 3 / 2)};
+    for (const IntVector2& resizeSize : resizeSizes)
+    {
+        // Resize modifies the image, so exclude creating the copies from the time
+        long long usec = 0;
+        for (unsigned i = 0; i < iterations; ++i)
+        {
+            SharedPtr<Image> copy = CreateRandomImage(context, size, 4);
+            timer.Reset();
+            copy->Resize(resizeSize.x_, resizeSize.y_);
+            usec += timer.GetUSec(false);
+        }
+        PrintThroughput(ToString("Resize to %dx%d", resizeSize.x_, resizeSize.y_), pixels, "MPixels", usec);
+    }
+
+    // Per-pixel readback against reading whole rows
+    PODVector<unsigned> row(size);
+    unsigned checksum = 0;
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+                checksum += image->GetPixel(x, y).ToUInt();
+        }
+    }
+    PrintThroughput("GetPixel", pixels, "MPixels", timer.GetUSec(false));
+
+    timer.Reset();
+    for (unsigned i = 0; i < iterations; ++i)
+    {
+        for (int y = 0; y < size; ++y)
+        {
+            image->GetPixelsInt(0, y, size, &row[0]);
+            for (int x = 0; x < size; ++x)
+                checksum += row[x];
+        }
+    }
+    PrintThroughput("GetPixelsInt", pixels, "MPixels", timer.GetUSec(false));
+
+    PrintLine(ToString("Checksum %u", checksum));
+}
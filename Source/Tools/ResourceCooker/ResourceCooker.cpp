@@ -0,0 +1,259 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/JSONFile.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+using namespace Urho3D;
+
+SharedPtr<Context> context_(new Context());
+Vector<String> fileNames_;
+Vector<String> benchmarkFileNames_;
+bool benchmark_ = false;
+unsigned iterations_ = 100;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+bool LoadFile(ResourceCache* cache, const String& fileName);
+void CollectMaterialSet(ResourceCache* cache);
+long long BenchmarkFiles(ResourceCache* cache);
+String FormatString(const char* formatString, ...);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+#ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+#else
+    arguments = ParseArguments(argc, argv);
+#endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 2)
+        ErrorExit(
+            "Usage: ResourceCooker <resource directories> <cooked resource directory> [options]\n"
+            "\n"
+            "Cooks all XML and JSON files in the resource directories, separated by ';' (for example materials,\n"
+            "techniques, renderpaths, particle effects and UI layouts) into the cooked resource directory.\n"
+            "\n"
+            "Options:\n"
+            "-b      Benchmark loading the material set (the materials in the Materials subdirectories and the\n"
+            "        techniques they refer to) from text versus from cooked data after cooking\n"
+            "-i<n>   Number of benchmark iterations over all files, default 100\n"
+        );
+
+    for (unsigned i = 2; i < arguments.Size(); ++i)
+    {
+        if (arguments[i].Length() > 1 && arguments[i][0] == '-')
+        {
+            switch (arguments[i][1])
+            {
+            case 'b':
+                benchmark_ = true;
+                break;
+
+            case 'i':
+                iterations_ = Max(ToUInt(arguments[i].Substring(2)), 1U);
+                break;
+
+            default:
+                ErrorExit("Unrecognized option");
+            }
+        }
+    }
+
+    context_->RegisterSubsystem(new FileSystem(context_));
+    context_->RegisterSubsystem(new Log(context_));
+    context_->RegisterSubsystem(new ResourceCache(context_));
+    // The Time subsystem initializes the high-resolution timer frequency used by the benchmark
+    context_->RegisterSubsystem(new Time(context_));
+    auto* fileSystem = context_->GetSubsystem<FileSystem>();
+    auto* cache = context_->GetSubsystem<ResourceCache>();
+    context_->GetSubsystem<Log>()->SetLevel(LOG_WARNING);
+
+    Vector<String> resourceDirs = arguments[0].Split(';');
+    for (unsigned i = 0; i < resourceDirs.Size(); ++i)
+    {
+        String resourceDir = AddTrailingSlash(resourceDirs[i]);
+        if (!fileSystem->DirExists(resourceDir))
+            ErrorExit("Resource directory " + resourceDir + " not found");
+        cache->AddResourceDir(resourceDir);
+
+        // The same file in several resource directories is cooked once, from the directory the cache would load it from
+        Vector<String> xmlFiles;
+        Vector<String> jsonFiles;
+        fileSystem->ScanDir(xmlFiles, resourceDir, "*.xml", SCAN_FILES, true);
+        fileSystem->ScanDir(jsonFiles, resourceDir, "*.json", SCAN_FILES, true);
+        for (unsigned j = 0; j < xmlFiles.Size(); ++j)
+        {
+            if (!fileNames_.Contains(xmlFiles[j]))
+                fileNames_.Push(xmlFiles[j]);
+        }
+        for (unsigned j = 0; j < jsonFiles.Size(); ++j)
+        {
+            if (!fileNames_.Contains(jsonFiles[j]))
+                fileNames_.Push(jsonFiles[j]);
+        }
+    }
+
+    cache->SetCookedResourceDir(arguments[1]);
+    cache->SetAutoCookResources(true);
+
+    unsigned numCooked = 0;
+    for (unsigned i = 0; i < fileNames_.Size(); ++i)
+    {
+        if (LoadFile(cache, fileNames_[i]))
+            ++numCooked;
+        else
+            PrintLine("Could not cook " + fileNames_[i], true);
+    }
+    PrintLine("Cooked " + String(numCooked) + " of " + String(fileNames_.Size()) + " files into " + cache->GetCookedResourceDir());
+
+    if (!benchmark_)
+        return;
+
+    CollectMaterialSet(cache);
+    if (benchmarkFileNames_.Empty())
+        ErrorExit("No materials found for benchmarking");
+
+    cache->SetAutoCookResources(false);
+    String cookedDir = cache->GetCookedResourceDir();
+
+    cache->SetCookedResourceDir(String::EMPTY);
+    long long textTime = BenchmarkFiles(cache);
+    cache->SetCookedResourceDir(cookedDir);
+    long long cookedTime = BenchmarkFiles(cache);
+
+    unsigned numLoads = benchmarkFileNames_.Size() * iterations_;
+    PrintLine("Loaded " + String(benchmarkFileNames_.Size()) + " material and technique files " + String(iterations_) + " times");
+    PrintLine(FormatString("Text:   %.2f ms total, %.2f us per file", textTime / 1000.0, (double)textTime / numLoads));
+    PrintLine(FormatString("Cooked: %.2f ms total, %.2f us per file", cookedTime / 1000.0, (double)cookedTime / numLoads));
+    if (cookedTime > 0)
+        PrintLine(FormatString("Speedup: %.2fx", (double)textTime / cookedTime));
+}
+
+bool LoadFile(ResourceCache* cache, const String& fileName)
+{
+    SharedPtr<File> file = cache->GetFile(fileName);
+    if (!file)
+        return false;
+
+    // Load the document directly instead of through the resource cache so that nothing is left cached between loads
+    if (GetExtension(fileName) == ".json")
+    {
+        SharedPtr<JSONFile> json(new JSONFile(context_));
+        return json->Load(*file);
+    }
+    else
+    {
+        SharedPtr<XMLFile> xml(new XMLFile(context_));
+        return xml->Load(*file);
+    }
+}
+
+void CollectMaterialSet(ResourceCache* cache)
+{
+    // Loading a material parses its definition and the definitions of its techniques. Techniques shared between materials
+    // are loaded only once by the resource cache, so they are included once
+    for (unsigned i = 0; i < fileNames_.Size(); ++i)
+    {
+        const String& fileName = fileNames_[i];
+        if (!fileName.StartsWith("Materials/", false))
+            continue;
+        SharedPtr<File> file = cache->GetFile(fileName);
+        if (!file)
+            continue;
+
+        benchmarkFileNames_.Push(fileName);
+        Vector<String> techniqueNames;
+        if (GetExtension(fileName) == ".json")
+        {
+            JSONFile json(context_);
+            if (!json.Load(*file))
+                continue;
+            const JSONArray& techniques = json.GetRoot().Get("techniques").GetArray();
+            for (unsigned j = 0; j < techniques.Size(); ++j)
+                techniqueNames.Push(techniques[j].Get("name").GetString());
+        }
+        else
+        {
+            XMLFile xml(context_);
+            if (!xml.Load(*file))
+                continue;
+            for (XMLElement techniqueElem = xml.GetRoot().GetChild("technique"); techniqueElem;
+                 techniqueElem = techniqueElem.GetNext("technique"))
+                techniqueNames.Push(techniqueElem.GetAttribute("name"));
+        }
+
+        for (unsigned j = 0; j < techniqueNames.Size(); ++j)
+        {
+            String techniqueName = cache->SanitateResourceName(techniqueNames[j]);
+            if (!benchmarkFileNames_.Contains(techniqueName) && cache->Exists(techniqueName))
+                benchmarkFileNames_.Push(techniqueName);
+        }
+    }
+}
+
+long long BenchmarkFiles(ResourceCache* cache)
+{
+    HiresTimer timer;
+    for (unsigned i = 0; i < iterations_; ++i)
+    {
+        for (unsigned j = 0; j < benchmarkFileNames_.Size(); ++j)
+            LoadFile(cache, benchmarkFileNames_[j]);
+    }
+    return timer.GetUSec(false);
+}
+
+String FormatString(const char* formatString, ...)
+{
+    // String::AppendWithFormat() does not support precision, so format with the C library
+    char buffer[256];
+    va_list args;
+    va_start(args, formatString);
+    vsnprintf(buffer, sizeof buffer, formatString, args);
+    va_end(args);
+    return String(buffer);
+}
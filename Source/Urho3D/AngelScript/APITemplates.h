@@ -938,6 +938,10 @@ template <class T> void RegisterSoundSource(asIScriptEngine* engine, const char*
     engine->RegisterObjectMethod(className, "void set_autoRemoveMode(AutoRemoveMode)", asMETHOD(T, SetAutoRemoveMode), asCALL_THISCALL);
     engine->RegisterObjectMethod(className, "AutoRemoveMode get_autoRemoveMode() const", asMETHOD(T, GetAutoRemoveMode), asCALL_THISCALL);
     engine->RegisterObjectMethod(className, "bool get_playing() const", asMETHOD(T, IsPlaying), asCALL_THISCALL);
+    engine->RegisterObjectMethod(className, "void set_priority(int)", asMETHOD(T, SetPriority), asCALL_THISCALL);
+    engine->RegisterObjectMethod(className, "int get_priority() const", asMETHOD(T, GetPriority), asCALL_THISCALL);
+    engine->RegisterObjectMethod(className, "float get_audibility() const", asMETHOD(T, GetAudibility), asCALL_THISCALL);
+    engine->RegisterObjectMethod(className, "bool get_virtual() const", asMETHOD(T, IsVirtual), asCALL_THISCALL);
 }
 
 /// Template function for registering a class derived from Texture.
@@ -101,6 +101,15 @@ void RegisterAudio(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Audio", "bool get_interpolation() const", asMETHOD(Audio, GetInterpolation), asCALL_THISCALL);
     engine->RegisterObjectMethod("Audio", "bool get_playing() const", asMETHOD(Audio, IsPlaying), asCALL_THISCALL);
     engine->RegisterObjectMethod("Audio", "bool get_initialized() const", asMETHOD(Audio, IsInitialized), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "void set_maxVoices(uint)", asMETHOD(Audio, SetMaxVoices), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_maxVoices() const", asMETHOD(Audio, GetMaxVoices), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_numRealVoices() const", asMETHOD(Audio, GetNumRealVoices), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_numVirtualVoices() const", asMETHOD(Audio, GetNumVirtualVoices), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "void set_decodeCacheSize(uint)", asMETHOD(Audio, SetDecodeCacheSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_decodeCacheSize() const", asMETHOD(Audio, GetDecodeCacheSize), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "void set_decodeCacheMaxLength(float)", asMETHOD(Audio, SetDecodeCacheMaxLength), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "float get_decodeCacheMaxLength() const", asMETHOD(Audio, GetDecodeCacheMaxLength), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Audio", "uint get_decodeCacheMemoryUse() const", asMETHOD(Audio, GetDecodeCacheMemoryUse), asCALL_THISCALL);
     engine->RegisterGlobalFunction("Audio@+ get_audio()", asFUNCTION(GetAudio), asCALL_CDECL);
 }
 
@@ -25,6 +25,7 @@
 #include "../Precompiled.h"
 
 #include "../AngelScript/APITemplates.h"
+#include "../Math/Ray.h"
 #include "../Physics/CollisionShape.h"
 #include "../Physics/Constraint.h"
 #include "../Physics/PhysicsWorld.h"
@@ -267,6 +268,30 @@ static PhysicsRaycastResult PhysicsWorldConvexCast(CollisionShape* shape, const
     return result;
 }
 
+static CScriptArray* PhysicsWorldRaycastSingleBatch(CScriptArray* rays, float maxDistance, unsigned collisionMask, PhysicsWorld* ptr)
+{
+    PODVector<PhysicsRaycastResult> result;
+    ptr->RaycastSingleBatch(result, ArrayToPODVector<Ray>(rays), maxDistance, collisionMask);
+    return VectorToArray<PhysicsRaycastResult>(result, "Array<PhysicsRaycastResult>");
+}
+
+static CScriptArray* PhysicsWorldSphereCastBatch(CScriptArray* rays, float radius, float maxDistance, unsigned collisionMask, PhysicsWorld* ptr)
+{
+    PODVector<PhysicsRaycastResult> result;
+    ptr->SphereCastBatch(result, ArrayToPODVector<Ray>(rays), radius, maxDistance, collisionMask);
+    return VectorToArray<PhysicsRaycastResult>(result, "Array<PhysicsRaycastResult>");
+}
+
+static CScriptArray* PhysicsWorldConvexCastBatch(CollisionShape* shape, CScriptArray* rays, const Quaternion& rotation, float maxDistance, unsigned collisionMask, PhysicsWorld* ptr)
+{
+    PODVector<PhysicsRaycastResult> result;
+    ptr->ConvexCastBatch(result, shape, ArrayToPODVector<Ray>(rays), rotation, maxDistance, collisionMask);
+    // Release extra ref manually due to not using an auto handle, as with ConvexCast
+    if (shape)
+        shape->ReleaseRef();
+    return VectorToArray<PhysicsRaycastResult>(result, "Array<PhysicsRaycastResult>");
+}
+
 static CScriptArray* PhysicsWorldGetRigidBodiesSphere(const Sphere& sphere, unsigned collisionMask, PhysicsWorld* ptr)
 {
     PODVector<RigidBody*> result;
@@ -317,6 +342,9 @@ static void RegisterPhysicsWorld(asIScriptEngine* engine)
     // There seems to be a bug in AngelScript resulting in a crash if we use an auto handle with this function.
     // Work around by manually releasing the CollisionShape handle
     engine->RegisterObjectMethod("PhysicsWorld", "PhysicsRaycastResult ConvexCast(CollisionShape@, const Vector3&in, const Quaternion&in, const Vector3&in, const Quaternion&in, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldConvexCast), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("PhysicsWorld", "Array<PhysicsRaycastResult>@ RaycastSingleBatch(Array<Ray>@+, float, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldRaycastSingleBatch), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("PhysicsWorld", "Array<PhysicsRaycastResult>@ SphereCastBatch(Array<Ray>@+, float, float, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldSphereCastBatch), asCALL_CDECL_OBJLAST);
+    engine->RegisterObjectMethod("PhysicsWorld", "Array<PhysicsRaycastResult>@ ConvexCastBatch(CollisionShape@, Array<Ray>@+, const Quaternion&in, float, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldConvexCastBatch), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("PhysicsWorld", "Array<RigidBody@>@ GetRigidBodies(const Sphere&in, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldGetRigidBodiesSphere), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("PhysicsWorld", "Array<RigidBody@>@ GetRigidBodies(const BoundingBox&in, uint collisionMask = 0xffff)", asFUNCTION(PhysicsWorldGetRigidBodiesBox), asCALL_CDECL_OBJLAST);
     engine->RegisterObjectMethod("PhysicsWorld", "Array<RigidBody@>@ GetRigidBodies(RigidBody@+)", asFUNCTION(PhysicsWorldGetRigidBodiesBody), asCALL_CDECL_OBJLAST);
@@ -339,6 +367,10 @@ static void RegisterPhysicsWorld(asIScriptEngine* engine)
     engine->RegisterObjectMethod("PhysicsWorld", "bool get_internalEdge() const", asMETHOD(PhysicsWorld, GetInternalEdge), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld", "void set_splitImpulse(bool)", asMETHOD(PhysicsWorld, SetSplitImpulse), asCALL_THISCALL);
     engine->RegisterObjectMethod("PhysicsWorld", "bool get_splitImpulse() const", asMETHOD(PhysicsWorld, GetSplitImpulse), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "void set_multiThreaded(bool)", asMETHOD(PhysicsWorld, SetMultiThreaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "bool get_multiThreaded() const", asMETHOD(PhysicsWorld, IsMultiThreaded), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "void set_deterministic(bool)", asMETHOD(PhysicsWorld, SetDeterministic), asCALL_THISCALL);
+    engine->RegisterObjectMethod("PhysicsWorld", "bool get_deterministic() const", asMETHOD(PhysicsWorld, IsDeterministic), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "PhysicsWorld@+ get_physicsWorld() const", asFUNCTION(SceneGetPhysicsWorld), asCALL_CDECL_OBJLAST);
     engine->RegisterGlobalFunction("PhysicsWorld@+ get_physicsWorld()", asFUNCTION(GetPhysicsWorld), asCALL_CDECL);
 }
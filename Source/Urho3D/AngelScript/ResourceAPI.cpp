@@ -183,6 +183,10 @@ static void RegisterResourceCache(asIScriptEngine* engine)
     engine->RegisterObjectMethod("ResourceCache", "bool get_returnFailedResources() const", asMETHOD(ResourceCache, GetReturnFailedResources), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "void set_finishBackgroundResourcesMs(int)", asMETHOD(ResourceCache, SetFinishBackgroundResourcesMs), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "int get_finishBackgroundResourcesMs() const", asMETHOD(ResourceCache, GetFinishBackgroundResourcesMs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "void set_cookedResourceDir(const String&in)", asMETHOD(ResourceCache, SetCookedResourceDir), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "String get_cookedResourceDir() const", asMETHOD(ResourceCache, GetCookedResourceDir), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "void set_autoCookResources(bool)", asMETHOD(ResourceCache, SetAutoCookResources), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ResourceCache", "bool get_autoCookResources() const", asMETHOD(ResourceCache, GetAutoCookResources), asCALL_THISCALL);
     engine->RegisterObjectMethod("ResourceCache", "uint get_numBackgroundLoadResources() const", asMETHOD(ResourceCache, GetNumBackgroundLoadResources), asCALL_THISCALL);
     engine->RegisterGlobalFunction("ResourceCache@+ get_resourceCache()", asFUNCTION(GetResourceCache), asCALL_CDECL);
     engine->RegisterGlobalFunction("ResourceCache@+ get_cache()", asFUNCTION(GetResourceCache), asCALL_CDECL);
@@ -306,6 +306,8 @@ static void RegisterSmoothedTransform(asIScriptEngine* engine)
     engine->RegisterObjectMethod("SmoothedTransform", "void set_targetWorldRotation(const Quaternion&in)", asMETHOD(SmoothedTransform, SetTargetWorldRotation), asCALL_THISCALL);
     engine->RegisterObjectMethod("SmoothedTransform", "Quaternion get_targetWorldRotation() const", asMETHOD(SmoothedTransform, GetTargetWorldRotation), asCALL_THISCALL);
     engine->RegisterObjectMethod("SmoothedTransform", "bool get_inProgress() const", asMETHOD(SmoothedTransform, IsInProgress), asCALL_THISCALL);
+    engine->RegisterObjectMethod("SmoothedTransform", "void set_predicted(bool)", asMETHOD(SmoothedTransform, SetPredicted), asCALL_THISCALL);
+    engine->RegisterObjectMethod("SmoothedTransform", "bool get_predicted() const", asMETHOD(SmoothedTransform, IsPredicted), asCALL_THISCALL);
 }
 
 static void RegisterSplinePath(asIScriptEngine* engine)
@@ -392,6 +394,8 @@ static void RegisterScene(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Scene", "float get_smoothingConstant() const", asMETHOD(Scene, GetSmoothingConstant), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "void set_snapThreshold(float)", asMETHOD(Scene, SetSnapThreshold), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "float get_snapThreshold() const", asMETHOD(Scene, GetSnapThreshold), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "void set_interpolationDelay(float)", asMETHOD(Scene, SetInterpolationDelay), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Scene", "float get_interpolationDelay() const", asMETHOD(Scene, GetInterpolationDelay), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "bool get_asyncLoading() const", asMETHOD(Scene, IsAsyncLoading), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "float get_asyncProgress() const", asMETHOD(Scene, GetAsyncProgress), asCALL_THISCALL);
     engine->RegisterObjectMethod("Scene", "LoadMode get_asyncLoadMode() const", asMETHOD(Scene, GetAsyncLoadMode), asCALL_THISCALL);
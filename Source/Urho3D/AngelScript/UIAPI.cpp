@@ -381,6 +381,14 @@ static void RegisterListView(asIScriptEngine* engine)
     engine->RegisterObjectMethod("ListView", "bool get_clearSelectionOnDefocus() const", asMETHOD(ListView, GetClearSelectionOnDefocus), asCALL_THISCALL);
     engine->RegisterObjectMethod("ListView", "void set_selectOnClickEnd(bool)", asMETHOD(ListView, SetSelectOnClickEnd), asCALL_THISCALL);
     engine->RegisterObjectMethod("ListView", "bool get_selectOnClickEnd() const", asMETHOD(ListView, GetSelectOnClickEnd), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void SetVirtualItemCount(uint)", asMETHOD(ListView, SetVirtualItemCount), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void RefreshVirtualItems()", asMETHOD(ListView, RefreshVirtualItems), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void set_virtualMode(bool)", asMETHOD(ListView, SetVirtualMode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "bool get_virtualMode() const", asMETHOD(ListView, GetVirtualMode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void set_virtualItemHeight(int)", asMETHOD(ListView, SetVirtualItemHeight), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "int get_virtualItemHeight() const", asMETHOD(ListView, GetVirtualItemHeight), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "void set_virtualItemType(StringHash)", asMETHOD(ListView, SetVirtualItemType), asCALL_THISCALL);
+    engine->RegisterObjectMethod("ListView", "StringHash get_virtualItemType() const", asMETHOD(ListView, GetVirtualItemType), asCALL_THISCALL);
 }
 
 static void RegisterText(asIScriptEngine* engine)
@@ -395,6 +403,7 @@ static void RegisterText(asIScriptEngine* engine)
     engine->RegisterObjectMethod("Text", "bool SetFont(Font@+, float)", asMETHODPR(Text, SetFont, (Font*, float), bool), asCALL_THISCALL);
     engine->RegisterObjectMethod("Text", "void SetSelection(uint, uint arg1 = M_MAX_UNSIGNED)", asMETHOD(Text, SetSelection), asCALL_THISCALL);
     engine->RegisterObjectMethod("Text", "void ClearSelection()", asMETHOD(Text, ClearSelection), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Text", "void AppendText(const String&in)", asMETHOD(Text, AppendText), asCALL_THISCALL);
     engine->RegisterObjectMethod("Text", "Font@+ get_font() const", asMETHOD(Text, GetFont), asCALL_THISCALL);
     engine->RegisterObjectMethod("Text", "bool set_fontSize(float)", asMETHOD(Text, SetFontSize), asCALL_THISCALL);
     engine->RegisterObjectMethod("Text", "float get_fontSize() const", asMETHOD(Text, GetFontSize), asCALL_THISCALL);
@@ -798,6 +807,8 @@ static void RegisterUI(asIScriptEngine* engine)
     engine->RegisterObjectMethod("UI", "bool get_useScreenKeyboard() const", asMETHOD(UI, GetUseScreenKeyboard), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_useMutableGlyphs(bool)", asMETHOD(UI, SetUseMutableGlyphs), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "bool get_useMutableGlyphs() const", asMETHOD(UI, GetUseMutableGlyphs), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "void set_useBatchCache(bool)", asMETHOD(UI, SetUseBatchCache), asCALL_THISCALL);
+    engine->RegisterObjectMethod("UI", "bool get_useBatchCache() const", asMETHOD(UI, GetUseBatchCache), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_forceAutoHint(bool)", asMETHOD(UI, SetForceAutoHint), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "bool get_forceAutoHint() const", asMETHOD(UI, GetForceAutoHint), asCALL_THISCALL);
     engine->RegisterObjectMethod("UI", "void set_fontHintLevel(FontHintLevel)", asMETHOD(UI, SetFontHintLevel), asCALL_THISCALL);
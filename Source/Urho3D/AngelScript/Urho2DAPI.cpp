@@ -312,7 +312,9 @@ static void RegisterTileMapLayer2D(asIScriptEngine* engine)
     engine->RegisterObjectMethod("TileMapLayer2D", "int get_width() const", asMETHOD(TileMapLayer2D, GetWidth), asCALL_THISCALL);
     engine->RegisterObjectMethod("TileMapLayer2D", "int get_height() const", asMETHOD(TileMapLayer2D, GetHeight), asCALL_THISCALL);
     engine->RegisterObjectMethod("TileMapLayer2D", "Tile2D@+ GetTile(int, int) const", asMETHOD(TileMapLayer2D, GetTile), asCALL_THISCALL);
-    engine->RegisterObjectMethod("TileMapLayer2D", "Node@+ GetTileNode(int, int) const", asMETHOD(TileMapLayer2D, GetTileNode), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TileMapLayer2D", "void SetTileSprite(int, int, Sprite2D@+)", asMETHOD(TileMapLayer2D, SetTileSprite), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TileMapLayer2D", "Sprite2D@+ GetTileSprite(int, int) const", asMETHOD(TileMapLayer2D, GetTileSprite), asCALL_THISCALL);
+    engine->RegisterObjectMethod("TileMapLayer2D", "uint get_numChunks() const", asMETHOD(TileMapLayer2D, GetNumChunks), asCALL_THISCALL);
 
     // For object group only
     engine->RegisterObjectMethod("TileMapLayer2D", "uint get_numObjects() const", asMETHOD(TileMapLayer2D, GetNumObjects), asCALL_THISCALL);
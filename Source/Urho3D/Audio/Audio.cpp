@@ -26,13 +26,25 @@
 #include "../Audio/Sound.h"
 #include "../Audio/SoundListener.h"
 #include "../Audio/SoundSource3D.h"
+#include "../Audio/SoundStream.h"
+#include "../Container/Sort.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 
 #include <SDL/SDL.h>
+#ifndef STB_VORBIS_HEADER_ONLY
+#define STB_VORBIS_HEADER_ONLY
+#endif
+#include <STB/stb_vorbis.h>
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
 
 #include "../DebugNew.h"
 
@@ -49,17 +61,77 @@ static const int MIN_BUFFERLENGTH = 20;
 static const int MIN_MIXRATE = 11025;
 static const int MAX_MIXRATE = 48000;
 static const StringHash SOUND_MASTER_HASH("Master");
+/// Mixer command queue size. Must be a power of two.
+static const unsigned COMMAND_QUEUE_SIZE = 1024;
+/// Audibility below which playing sound sources are always virtualized, the smallest gain that changes 16-bit output.
+static const float MIN_AUDIBILITY = 0.5f / 32768.0f;
+static const unsigned DEFAULT_DECODE_CACHE_SIZE = 16 * 1024 * 1024;
+static const float DEFAULT_DECODE_CACHE_MAX_LENGTH = 2.0f;
+/// Work queue priority of decoding ahead of stream playback, above filling the decode cache.
+static const unsigned DECODE_AHEAD_PRIORITY = 1;
+static const unsigned DECODE_CACHE_PRIORITY = 0;
+
+/// Decode cache entry of a short compressed sound.
+struct DecodedSound : public RefCounted
+{
+    /// Compressed sound.
+    WeakPtr<Sound> sound_;
+    /// Compressed sound data, read by the decode work item. Also identifies a reloaded sound.
+    SharedArrayPtr<signed char> data_;
+    /// Compressed sound data size in bytes.
+    unsigned dataSize_{};
+    /// Whether to decode to stereo.
+    bool stereo_{};
+    /// Decoded data written by the decode work item.
+    SharedArrayPtr<signed char> decodedData_;
+    /// Decoded data size in bytes.
+    unsigned decodedSize_{};
+    /// Decoded sound. Null until decoding has completed, or if it failed.
+    SharedPtr<Sound> decodedSound_;
+    /// Decode work item. Null once completed.
+    SharedPtr<WorkItem> item_;
+    /// Decode cache use counter value of the last play.
+    unsigned lastUse_{};
+};
+
+static void DecodeAheadWork(const WorkItem* item, unsigned threadIndex)
+{
+    static_cast<SoundStream*>(item->start_)->DecodeAhead();
+}
+
+static void DecodeSoundWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* entry = static_cast<DecodedSound*>(item->start_);
+
+    int error;
+    stb_vorbis* vorbis = stb_vorbis_open_memory((unsigned char*)entry->data_.Get(), entry->dataSize_, &error, nullptr);
+    if (!vorbis)
+        return;
+
+    unsigned channels = entry->stereo_ ? 2 : 1;
+    unsigned maxSamples = stb_vorbis_stream_length_in_samples(vorbis) * channels;
+    auto* decoded = new signed char[maxSamples * sizeof(short)];
+    auto outFrames = (unsigned)stb_vorbis_get_samples_short_interleaved(vorbis, channels, (short*)decoded, maxSamples);
+    stb_vorbis_close(vorbis);
+
+    entry->decodedData_ = decoded;
+    entry->decodedSize_ = outFrames * channels * sizeof(short);
+}
 
 static void SDLAudioCallback(void* userdata, Uint8* stream, int len);
 
 Audio::Audio(Context* context) :
-    Object(context)
+    Object(context),
+    decodeCacheSize_(DEFAULT_DECODE_CACHE_SIZE),
+    decodeCacheMaxLength_(DEFAULT_DECODE_CACHE_MAX_LENGTH)
 {
     context_->RequireSDL(SDL_INIT_AUDIO);
 
     // Set the master to the default value
     masterGain_[SOUND_MASTER_HASH] = 1.0f;
 
+    commands_.Resize(COMMAND_QUEUE_SIZE);
+
     // Register Audio library object factories
     RegisterAudioLibrary(context_);
 
@@ -69,6 +141,7 @@ Audio::Audio(Context* context) :
 Audio::~Audio()
 {
     Release();
+    CompleteDecoding();
     context_->ReleaseSDL();
 }
 
@@ -118,7 +191,7 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
     fragmentSize_ = Min(NextPowerOfTwo((unsigned)mixRate >> 6u), (unsigned)obtained.samples);
     mixRate_ = obtained.freq;
     interpolation_ = interpolation;
-    clipBuffer_ = new int[stereo ? fragmentSize_ << 1u : fragmentSize_];
+    mixBuffer_ = new float[stereo ? fragmentSize_ << 1u : fragmentSize_];
 
     URHO3D_LOGINFO("Set audio mode " + String(mixRate_) + " Hz " + (stereo_ ? "stereo" : "mono") + " " +
             (interpolation_ ? "interpolated" : ""));
@@ -128,6 +201,9 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, bool stereo, bool interpo
 
 void Audio::Update(float timeStep)
 {
+    UpdateReleases();
+    UpdateDecodeCache();
+
     if (!playing_)
         return;
 
@@ -169,24 +245,53 @@ void Audio::SetMasterGain(const String& type, float gain)
 
 void Audio::PauseSoundType(const String& type)
 {
-    MutexLock lock(audioMutex_);
-    pausedSoundTypes_.Insert(type);
+    StringHash typeHash(type);
+    pausedSoundTypes_.Insert(typeHash);
+
+    AudioCommand command;
+    command.type_ = AC_PAUSETYPE;
+    command.value_ = typeHash.Value();
+    QueueCommand(command);
 }
 
 void Audio::ResumeSoundType(const String& type)
 {
-    MutexLock lock(audioMutex_);
-    pausedSoundTypes_.Erase(type);
-    // Update sound sources before resuming playback to make sure 3D positions are up to date
-    // Done under mutex to ensure no mixing happens before we are ready
+    StringHash typeHash(type);
+    pausedSoundTypes_.Erase(typeHash);
+    // Update sound sources before resuming playback to make sure 3D positions are up to date. The mixer keeps
+    // the type paused until it applies the resume command, which is queued after the update
     UpdateInternal(0.0f);
+
+    AudioCommand command;
+    command.type_ = AC_RESUMETYPE;
+    command.value_ = typeHash.Value();
+    QueueCommand(command);
 }
 
 void Audio::ResumeAll()
 {
-    MutexLock lock(audioMutex_);
     pausedSoundTypes_.Clear();
     UpdateInternal(0.0f);
+
+    AudioCommand command;
+    command.type_ = AC_RESUMEALL;
+    QueueCommand(command);
+}
+
+void Audio::SetMaxVoices(unsigned voices)
+{
+    maxVoices_ = voices;
+}
+
+void Audio::SetDecodeCacheSize(unsigned size)
+{
+    decodeCacheSize_ = size;
+    UpdateDecodeCache();
+}
+
+void Audio::SetDecodeCacheMaxLength(float length)
+{
+    decodeCacheMaxLength_ = Max(length, 0.0f);
 }
 
 void Audio::SetListener(SoundListener* listener)
@@ -225,8 +330,12 @@ SoundListener* Audio::GetListener() const
 
 void Audio::AddSoundSource(SoundSource* soundSource)
 {
-    MutexLock lock(audioMutex_);
     soundSources_.Push(soundSource);
+
+    AudioCommand command;
+    command.type_ = AC_ADDSOURCE;
+    command.source_ = soundSource;
+    QueueCommand(command);
 }
 
 void Audio::RemoveSoundSource(SoundSource* soundSource)
@@ -234,9 +343,48 @@ void Audio::RemoveSoundSource(SoundSource* soundSource)
     PODVector<SoundSource*>::Iterator i = soundSources_.Find(soundSource);
     if (i != soundSources_.End())
     {
-        MutexLock lock(audioMutex_);
         soundSources_.Erase(i);
+
+        AudioCommand command;
+        command.type_ = AC_REMOVESOURCE;
+        command.source_ = soundSource;
+        unsigned sequence = QueueCommand(command);
+
+        // The sound source is about to be destroyed. If the mixer is idle, its next mix applies the removal before
+        // touching any source; otherwise wait for the ongoing mix to finish
+        while (mixing_ && IsCommandPending(sequence))
+            Time::Sleep(0);
+    }
+}
+
+unsigned Audio::QueueCommand(const AudioCommand& command)
+{
+    unsigned queued = commandsQueued_.load();
+
+    // If the mixer has stalled, for example because the device was paused by the OS, drain the queue with the
+    // audio device locked so that the callback can not run meanwhile
+    if (queued - commandsApplied_.load() >= COMMAND_QUEUE_SIZE)
+    {
+        SDL_LockAudioDevice(deviceID_);
+        ProcessCommands();
+        SDL_UnlockAudioDevice(deviceID_);
     }
+
+    commands_[queued & (COMMAND_QUEUE_SIZE - 1)] = command;
+    commandsQueued_.store(++queued);
+
+    // Without audio output there is no mixer thread, so apply immediately
+    if (!deviceID_)
+        ProcessCommands();
+
+    return queued;
+}
+
+void Audio::ReleaseAfterMix(RefCounted* object)
+{
+    unsigned queued = commandsQueued_.load();
+    if (object && IsCommandPending(queued))
+        releases_.Push(MakePair(queued, SharedPtr<RefCounted>(object)));
 }
 
 float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
@@ -257,53 +405,67 @@ float Audio::GetSoundSourceMasterGain(StringHash typeHash) const
 void SDLAudioCallback(void* userdata, Uint8* stream, int len)
 {
     auto* audio = static_cast<Audio*>(userdata);
-    {
-        MutexLock Lock(audio->GetMutex());
-        audio->MixOutput(stream, len / audio->GetSampleSize());
-    }
+    audio->MixOutput(stream, len / audio->GetSampleSize());
 }
 
 void Audio::MixOutput(void* dest, unsigned samples)
 {
-    if (!playing_ || !clipBuffer_)
+    mixing_ = true;
+    ProcessCommands();
+
+    if (!playing_ || !mixBuffer_)
     {
         memset(dest, 0, samples * (size_t)sampleSize_);
+        mixing_ = false;
         return;
     }
 
     while (samples)
     {
-        // If sample count exceeds the fragment (clip buffer) size, split the work
+        // If sample count exceeds the fragment (mix bus) size, split the work
         unsigned workSamples = Min(samples, fragmentSize_);
-        unsigned clipSamples = workSamples;
+        unsigned busSamples = workSamples;
         if (stereo_)
-            clipSamples <<= 1;
+            busSamples <<= 1;
 
-        // Clear clip buffer
-        int* clipPtr = clipBuffer_.Get();
-        memset(clipPtr, 0, clipSamples * sizeof(int));
+        // Clear mix bus
+        float* busPtr = mixBuffer_.Get();
+        memset(busPtr, 0, busSamples * sizeof(float));
 
-        // Mix samples to clip buffer
-        for (PODVector<SoundSource*>::Iterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+        // Mix samples to mix bus
+        for (PODVector<SoundSource*>::Iterator i = mixSources_.Begin(); i != mixSources_.End(); ++i)
         {
             SoundSource* source = *i;
 
             // Check for pause if necessary
-            if (!pausedSoundTypes_.Empty())
+            if (!mixPausedTypes_.Empty())
             {
-                if (pausedSoundTypes_.Contains(source->GetSoundType()))
+                if (mixPausedTypes_.Contains(source->GetSoundTypeHash()))
                     continue;
             }
 
-            source->Mix(clipPtr, workSamples, mixRate_, stereo_, interpolation_);
+            source->Mix(busPtr, workSamples, mixRate_, stereo_, interpolation_);
         }
-        // Copy output from clip buffer to destination
+        // Clip and convert output from mix bus to destination
         auto* destPtr = (short*)dest;
-        while (clipSamples--)
-            *destPtr++ = (short)Clamp(*clipPtr++, -32768, 32767);
+        unsigned i = 0;
+#ifdef URHO3D_SSE
+        __m128 minValue = _mm_set1_ps(-32768.0f);
+        __m128 maxValue = _mm_set1_ps(32767.0f);
+        for (; i + 8 <= busSamples; i += 8)
+        {
+            __m128i low = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(busPtr + i), minValue), maxValue));
+            __m128i high = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(busPtr + i + 4), minValue), maxValue));
+            _mm_storeu_si128((__m128i*)(destPtr + i), _mm_packs_epi32(low, high));
+        }
+#endif
+        for (; i < busSamples; ++i)
+            destPtr[i] = (short)RoundToInt(Clamp(busPtr[i], -32768.0f, 32767.0f));
         samples -= workSamples;
         ((unsigned char*&)dest) += sampleSize_ * workSamples;
     }
+
+    mixing_ = false;
 }
 
 void Audio::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
@@ -321,7 +483,11 @@ void Audio::Release()
     {
         SDL_CloseAudioDevice(deviceID_);
         deviceID_ = 0;
-        clipBuffer_.Reset();
+        mixBuffer_.Reset();
+
+        // The audio thread has exited; apply what it left unprocessed
+        ProcessCommands();
+        UpdateReleases();
     }
 }
 
@@ -337,12 +503,314 @@ void Audio::UpdateInternal(float timeStep)
         // Check for pause if necessary; do not update paused sound sources
         if (!pausedSoundTypes_.Empty())
         {
-            if (pausedSoundTypes_.Contains(source->GetSoundType()))
+            if (pausedSoundTypes_.Contains(source->GetSoundTypeHash()))
                 continue;
         }
 
         source->Update(timeStep);
     }
+
+    UpdateVoices();
+    UpdateDecodeAhead();
+}
+
+void Audio::UpdateVoices()
+{
+    URHO3D_PROFILE(UpdateAudioVoices);
+
+    voices_.Clear();
+    numVirtualVoices_ = 0;
+
+    for (PODVector<SoundSource*>::ConstIterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+    {
+        SoundSource* source = *i;
+        // Paused sources are not mixed anyway, so keep their state as is
+        if (!source->IsPlaying() || pausedSoundTypes_.Contains(source->GetSoundTypeHash()))
+            continue;
+
+        if (source->GetAudibility() < MIN_AUDIBILITY)
+        {
+            source->SetVirtual(true);
+            ++numVirtualVoices_;
+        }
+        else
+            voices_.Push(source);
+    }
+
+    // Higher priority first, then louder first
+    if (maxVoices_ && voices_.Size() > maxVoices_)
+    {
+        Sort(voices_.Begin(), voices_.End(), [](SoundSource* lhs, SoundSource* rhs)
+        {
+            if (lhs->GetPriority() != rhs->GetPriority())
+                return lhs->GetPriority() > rhs->GetPriority();
+            return lhs->GetAudibility() > rhs->GetAudibility();
+        });
+    }
+
+    numRealVoices_ = maxVoices_ ? Min(voices_.Size(), maxVoices_) : voices_.Size();
+    numVirtualVoices_ += voices_.Size() - numRealVoices_;
+    for (unsigned i = 0; i < voices_.Size(); ++i)
+        voices_[i]->SetVirtual(i >= numRealVoices_);
+}
+
+void Audio::ProcessCommands()
+{
+    unsigned applied = commandsApplied_.load();
+    unsigned queued = commandsQueued_.load();
+
+    while (applied != queued)
+        ApplyCommand(commands_[applied++ & (COMMAND_QUEUE_SIZE - 1)]);
+
+    commandsApplied_.store(applied);
+}
+
+void Audio::ApplyCommand(const AudioCommand& command)
+{
+    switch (command.type_)
+    {
+    case AC_ADDSOURCE:
+        mixSources_.Push(command.source_);
+        break;
+
+    case AC_REMOVESOURCE:
+        mixSources_.Remove(command.source_);
+        break;
+
+    case AC_PLAY:
+        command.source_->PlayLockless(command.sound_, command.stream_, command.streamBuffer_);
+        break;
+
+    case AC_STOP:
+        command.source_->StopLockless();
+        break;
+
+    case AC_SETPOSITION:
+        command.source_->SetPlayPositionLockless(command.sound_, command.value_);
+        break;
+
+    case AC_SEEK:
+        command.source_->SeekLockless(command.value_);
+        break;
+
+    case AC_SETVIRTUAL:
+        command.source_->SetVirtualLockless(command.value_ != 0);
+        break;
+
+    case AC_PAUSETYPE:
+        mixPausedTypes_.Insert(StringHash(command.value_));
+        break;
+
+    case AC_RESUMETYPE:
+        mixPausedTypes_.Erase(StringHash(command.value_));
+        break;
+
+    case AC_RESUMEALL:
+        mixPausedTypes_.Clear();
+        break;
+    }
+}
+
+SharedPtr<Sound> Audio::GetDecodedSound(Sound* sound)
+{
+    if (!sound || !sound->IsCompressed() || sound->GetLength() > decodeCacheMaxLength_)
+        return SharedPtr<Sound>();
+
+    // A sound that would not fit the memory budget would be evicted as soon as decoded
+    if (sound->GetLength() * sound->GetFrequency() * sound->GetSampleSize() > (float)decodeCacheSize_)
+        return SharedPtr<Sound>();
+
+    HashMap<Sound*, SharedPtr<DecodedSound> >::Iterator i = decodedSounds_.Find(sound);
+    if (i != decodedSounds_.End())
+    {
+        DecodedSound* entry = i->second_;
+        if (entry->sound_.Get() == sound && entry->data_ == sound->GetData())
+        {
+            entry->lastUse_ = ++decodeCacheUses_;
+
+            // The decoded sound may be playing, so a loop mode change needs a new copy
+            Sound* decodedSound = entry->decodedSound_;
+            if (decodedSound && decodedSound->IsLooped() != sound->IsLooped())
+            {
+                entry->decodedSound_ = new Sound(context_);
+                entry->decodedSound_->SetData(decodedSound->GetStart(), decodedSound->GetDataSize());
+                entry->decodedSound_->SetFormat(sound->GetIntFrequency(), true, sound->IsStereo());
+                entry->decodedSound_->SetLooped(sound->IsLooped());
+            }
+
+            return entry->decodedSound_;
+        }
+
+        // The entry is for a sound since destroyed or reloaded. Replace it unless still decoding
+        if (entry->item_)
+            return SharedPtr<Sound>();
+        if (entry->decodedSound_)
+            decodeCacheMemoryUse_ -= entry->decodedSound_->GetDataSize();
+        decodedSounds_.Erase(i);
+    }
+
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (!queue)
+        return SharedPtr<Sound>();
+
+    // Decode in the background and play through a decoder stream meanwhile
+    SharedPtr<DecodedSound> entry(new DecodedSound());
+    entry->sound_ = sound;
+    entry->data_ = sound->GetData();
+    entry->dataSize_ = sound->GetDataSize();
+    entry->stereo_ = sound->IsStereo();
+    entry->lastUse_ = ++decodeCacheUses_;
+    // Not taken from the work queue pool, so that the completed flag stays valid until checked
+    entry->item_ = new WorkItem();
+    entry->item_->priority_ = DECODE_CACHE_PRIORITY;
+    entry->item_->workFunction_ = DecodeSoundWork;
+    entry->item_->start_ = entry.Get();
+    queue->AddWorkItem(entry->item_);
+    decodedSounds_[sound] = entry;
+
+    return SharedPtr<Sound>();
+}
+
+void Audio::UpdateDecodeAhead()
+{
+    // Forget completed work
+    for (unsigned i = decodeAheadItems_.Size() - 1; i < decodeAheadItems_.Size(); --i)
+    {
+        if (decodeAheadItems_[i].first_->completed_)
+            decodeAheadItems_.Erase(i);
+    }
+
+    // Without worker threads the mixer decodes on demand instead
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (!queue || !queue->GetNumThreads())
+        return;
+
+    URHO3D_PROFILE(UpdateAudioDecodeAhead);
+
+    for (PODVector<SoundSource*>::ConstIterator i = soundSources_.Begin(); i != soundSources_.End(); ++i)
+    {
+        SoundStream* stream = (*i)->GetSoundStream();
+        if (!stream || !stream->NeedsDecodeAhead())
+            continue;
+
+        bool queued = false;
+        for (unsigned j = 0; j < decodeAheadItems_.Size(); ++j)
+        {
+            if (decodeAheadItems_[j].second_ == stream)
+            {
+                queued = true;
+                break;
+            }
+        }
+        if (queued)
+            continue;
+
+        SharedPtr<WorkItem> item(new WorkItem());
+        item->priority_ = DECODE_AHEAD_PRIORITY;
+        item->workFunction_ = DecodeAheadWork;
+        item->start_ = stream;
+        queue->AddWorkItem(item);
+        decodeAheadItems_.Push(MakePair(item, SharedPtr<SoundStream>(stream)));
+    }
+}
+
+void Audio::UpdateDecodeCache()
+{
+    if (decodedSounds_.Empty())
+        return;
+
+    for (HashMap<Sound*, SharedPtr<DecodedSound> >::Iterator i = decodedSounds_.Begin(); i != decodedSounds_.End();)
+    {
+        DecodedSound* entry = i->second_;
+        if (entry->item_)
+        {
+            if (!entry->item_->completed_)
+            {
+                ++i;
+                continue;
+            }
+
+            entry->item_.Reset();
+            if (entry->decodedSize_ && entry->sound_)
+            {
+                entry->decodedSound_ = new Sound(context_);
+                entry->decodedSound_->SetData(entry->decodedData_.Get(), entry->decodedSize_);
+                entry->decodedSound_->SetFormat(entry->sound_->GetIntFrequency(), true, entry->stereo_);
+                entry->decodedSound_->SetLooped(entry->sound_->IsLooped());
+                decodeCacheMemoryUse_ += entry->decodedSound_->GetDataSize();
+            }
+            else if (entry->sound_)
+                URHO3D_LOGERROR("Could not decode sound " + entry->sound_->GetName());
+            entry->decodedData_.Reset();
+        }
+
+        // Drop entries of destroyed sounds
+        if (!entry->sound_)
+        {
+            if (entry->decodedSound_)
+                decodeCacheMemoryUse_ -= entry->decodedSound_->GetDataSize();
+            i = decodedSounds_.Erase(i);
+        }
+        else
+            ++i;
+    }
+
+    // Evict least recently played sounds. Sound sources playing them keep their own references
+    while (decodeCacheMemoryUse_ > decodeCacheSize_)
+    {
+        HashMap<Sound*, SharedPtr<DecodedSound> >::Iterator oldest = decodedSounds_.End();
+        for (HashMap<Sound*, SharedPtr<DecodedSound> >::Iterator i = decodedSounds_.Begin(); i != decodedSounds_.End(); ++i)
+        {
+            if (i->second_->decodedSound_ && (oldest == decodedSounds_.End() || i->second_->lastUse_ < oldest->second_->lastUse_))
+                oldest = i;
+        }
+        if (oldest == decodedSounds_.End())
+            break;
+
+        decodeCacheMemoryUse_ -= oldest->second_->decodedSound_->GetDataSize();
+        decodedSounds_.Erase(oldest);
+    }
+}
+
+void Audio::CompleteDecoding()
+{
+    // Work not yet started is cancelled, work in progress is waited for
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (queue)
+    {
+        for (unsigned i = 0; i < decodeAheadItems_.Size(); ++i)
+        {
+            WorkItem* item = decodeAheadItems_[i].first_;
+            if (!queue->RemoveWorkItem(SharedPtr<WorkItem>(item)))
+            {
+                while (!item->completed_)
+                    Time::Sleep(0);
+            }
+        }
+        for (HashMap<Sound*, SharedPtr<DecodedSound> >::Iterator i = decodedSounds_.Begin(); i != decodedSounds_.End(); ++i)
+        {
+            WorkItem* item = i->second_->item_;
+            if (item && !queue->RemoveWorkItem(SharedPtr<WorkItem>(item)))
+            {
+                while (!item->completed_)
+                    Time::Sleep(0);
+            }
+        }
+    }
+
+    decodeAheadItems_.Clear();
+    decodedSounds_.Clear();
+    decodeCacheMemoryUse_ = 0;
+}
+
+void Audio::UpdateReleases()
+{
+    unsigned count = 0;
+    while (count < releases_.Size() && !IsCommandPending(releases_[count].first_))
+        ++count;
+
+    if (count)
+        releases_.Erase(0, count);
 }
 
 void RegisterAudioLibrary(Context* context)
@@ -25,16 +25,52 @@
 #include "../Audio/AudioDefs.h"
 #include "../Container/ArrayPtr.h"
 #include "../Container/HashSet.h"
-#include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
 class AudioImpl;
 class Sound;
+struct DecodedSound;
+struct WorkItem;
 class SoundListener;
 class SoundSource;
+class SoundStream;
+
+/// Sound source state change type for the mixer command queue.
+enum AudioCommandType
+{
+    AC_ADDSOURCE = 0,
+    AC_REMOVESOURCE,
+    AC_PLAY,
+    AC_STOP,
+    AC_SETPOSITION,
+    AC_SEEK,
+    AC_SETVIRTUAL,
+    AC_PAUSETYPE,
+    AC_RESUMETYPE,
+    AC_RESUMEALL
+};
+
+/// Sound source state change queued by the main thread and applied by the mixer before mixing. Objects are referenced by raw pointers; the main thread keeps them alive until the command has been applied.
+struct AudioCommand
+{
+    /// Command type.
+    AudioCommandType type_{};
+    /// Sound source.
+    SoundSource* source_{};
+    /// Sound to play or set position in.
+    Sound* sound_{};
+    /// Sound stream to play.
+    SoundStream* stream_{};
+    /// Decode buffer of the sound stream.
+    Sound* streamBuffer_{};
+    /// Byte offset for set position, sample for seek, virtual flag or sound type hash for pause and resume.
+    unsigned value_{};
+};
 
 /// %Audio subsystem.
 class URHO3D_API Audio : public Object
@@ -67,6 +103,12 @@ public:
     void SetListener(SoundListener* listener);
     /// Stop any sound source playing a certain sound clip.
     void StopSound(Sound* sound);
+    /// Set maximum number of sound sources mixed for real. Playing sound sources are ranked by priority and audibility; the rest are virtualized, advancing their playback position without being mixed. Inaudible sound sources are always virtualized. 0 (default) is unlimited.
+    void SetMaxVoices(unsigned voices);
+    /// Set memory budget in bytes of the decode cache, which keeps decoded copies of short compressed sounds so that they need not be decoded on every play. Least recently played sounds are evicted first. 0 disables the cache.
+    void SetDecodeCacheSize(unsigned size);
+    /// Set maximum length in seconds of a compressed sound to keep in the decode cache.
+    void SetDecodeCacheMaxLength(float length);
 
     /// Return byte size of one sample.
     unsigned GetSampleSize() const { return sampleSize_; }
@@ -95,6 +137,24 @@ public:
     /// Return active sound listener.
     SoundListener* GetListener() const;
 
+    /// Return maximum number of sound sources mixed for real.
+    unsigned GetMaxVoices() const { return maxVoices_; }
+
+    /// Return number of sound sources mixed for real on the last update.
+    unsigned GetNumRealVoices() const { return numRealVoices_; }
+
+    /// Return number of playing sound sources virtualized on the last update.
+    unsigned GetNumVirtualVoices() const { return numVirtualVoices_; }
+
+    /// Return decode cache memory budget in bytes.
+    unsigned GetDecodeCacheSize() const { return decodeCacheSize_; }
+
+    /// Return maximum length in seconds of a compressed sound kept in the decode cache.
+    float GetDecodeCacheMaxLength() const { return decodeCacheMaxLength_; }
+
+    /// Return memory use in bytes of the decode cache.
+    unsigned GetDecodeCacheMemoryUse() const { return decodeCacheMemoryUse_; }
+
     /// Return all sound sources.
     const PODVector<SoundSource*>& GetSoundSources() const { return soundSources_; }
 
@@ -106,13 +166,21 @@ public:
     /// Remove a sound source. Called by SoundSource.
     void RemoveSoundSource(SoundSource* soundSource);
 
-    /// Return audio thread mutex.
-    Mutex& GetMutex() { return audioMutex_; }
+    /// Queue a sound source state change to the mixer and return its sequence number. Applied immediately when there is no audio output. Called by SoundSource.
+    unsigned QueueCommand(const AudioCommand& command);
+    /// Keep an object alive until the mixer has applied all currently queued commands. Called by SoundSource when replacing the sound or stream it plays.
+    void ReleaseAfterMix(RefCounted* object);
+
+    /// Return whether a queued command has not yet been applied by the mixer.
+    bool IsCommandPending(unsigned sequence) const { return (int)(sequence - commandsApplied_.load()) > 0; }
+
+    /// Return the decoded copy of a short compressed sound from the decode cache, or null if it is not available yet. Decoding starts in a worker thread on the first request. Called by SoundSource.
+    SharedPtr<Sound> GetDecodedSound(Sound* sound);
 
     /// Return sound type specific gain multiplied by master gain.
     float GetSoundSourceMasterGain(StringHash typeHash) const;
 
-    /// Mix sound sources into the buffer.
+    /// Mix sound sources into the buffer. Called from the audio thread; applies queued commands first.
     void MixOutput(void* dest, unsigned samples);
 
 private:
@@ -122,16 +190,28 @@ private:
     void Release();
     /// Actually update sound sources with the specific timestep. Called internally.
     void UpdateInternal(float timeStep);
+    /// Apply queued commands to the mixer state. Called only by the consumer of the command queue.
+    void ProcessCommands();
+    /// Apply a single command to the mixer state.
+    void ApplyCommand(const AudioCommand& command);
+    /// Free objects released after mixing once the mixer no longer references them.
+    void UpdateReleases();
+    /// Rank playing sound sources and virtualize those that do not fit the voice limit.
+    void UpdateVoices();
+    /// Queue decoding ahead of playback for sound streams that are running low on decoded data.
+    void UpdateDecodeAhead();
+    /// Add finished decodes to the decode cache and evict least recently played sounds over the memory budget.
+    void UpdateDecodeCache();
+    /// Wait for or cancel all queued decoding work.
+    void CompleteDecoding();
 
-    /// Clipping buffer for mixing.
-    SharedArrayPtr<int> clipBuffer_;
-    /// Audio thread mutex.
-    Mutex audioMutex_;
+    /// Float mix bus. Clipped and converted to 16-bit output once all sound sources have been mixed.
+    SharedArrayPtr<float> mixBuffer_;
     /// SDL audio device ID.
     unsigned deviceID_{};
     /// Sample size.
     unsigned sampleSize_{};
-    /// Clip buffer size in samples.
+    /// Mix bus size in samples.
     unsigned fragmentSize_{};
     /// Mixing rate.
     int mixRate_{};
@@ -149,6 +229,40 @@ private:
     PODVector<SoundSource*> soundSources_;
     /// Sound listener.
     WeakPtr<SoundListener> listener_;
+    /// Maximum number of sound sources mixed for real, 0 for unlimited.
+    unsigned maxVoices_{};
+    /// Number of sound sources mixed for real on the last update.
+    unsigned numRealVoices_{};
+    /// Number of playing sound sources virtualized on the last update.
+    unsigned numVirtualVoices_{};
+    /// Audible playing sound sources, ranked on update.
+    PODVector<SoundSource*> voices_;
+    /// Decode ahead work items and the sound streams they decode, kept alive until the work has completed.
+    Vector<Pair<SharedPtr<WorkItem>, SharedPtr<SoundStream> > > decodeAheadItems_;
+    /// Decode cache entries by compressed sound.
+    HashMap<Sound*, SharedPtr<DecodedSound> > decodedSounds_;
+    /// Decode cache memory budget in bytes.
+    unsigned decodeCacheSize_;
+    /// Maximum length in seconds of a compressed sound kept in the decode cache.
+    float decodeCacheMaxLength_;
+    /// Decode cache memory use in bytes.
+    unsigned decodeCacheMemoryUse_{};
+    /// Decode cache use counter for least recently used eviction.
+    unsigned decodeCacheUses_{};
+    /// Command queue ring buffer. Written only by the main thread and read only by the mixer.
+    PODVector<AudioCommand> commands_;
+    /// Number of commands queued. Stored by the main thread.
+    std::atomic<unsigned> commandsQueued_{};
+    /// Number of commands applied. Stored by the mixer.
+    std::atomic<unsigned> commandsApplied_{};
+    /// Whether the mixer is inside MixOutput.
+    std::atomic<bool> mixing_{};
+    /// Objects to free once the command with the paired sequence number has been applied.
+    Vector<Pair<unsigned, SharedPtr<RefCounted> > > releases_;
+    /// Sound sources as seen by the mixer.
+    PODVector<SoundSource*> mixSources_;
+    /// Paused sound types as seen by the mixer.
+    HashSet<StringHash> mixPausedTypes_;
 };
 
 /// Register Audio library objects.
@@ -24,6 +24,7 @@
 
 #include "../Audio/OggVorbisSoundStream.h"
 #include "../Audio/Sound.h"
+#include "../Core/Timer.h"
 
 #include <STB/stb_vorbis.h>
 
@@ -32,7 +33,17 @@
 namespace Urho3D
 {
 
-OggVorbisSoundStream::OggVorbisSoundStream(const Sound* sound)
+/// Length of data decoded ahead of playback in milliseconds. Rounded up to a power of two ring buffer size.
+static const unsigned DECODE_AHEAD_LENGTH = 250;
+/// Maximum bytes decoded ahead while holding the decoder, to bound how long the mixer may wait for it.
+static const unsigned DECODE_AHEAD_CHUNK = 16384;
+
+OggVorbisSoundStream::OggVorbisSoundStream(const Sound* sound) :
+    ringSize_(0),
+    ringRead_(0),
+    ringWrite_(0),
+    decoderBusy_(false),
+    decodeEnd_(false)
 {
     assert(sound && sound->IsCompressed());
 
@@ -45,6 +56,12 @@ OggVorbisSoundStream::OggVorbisSoundStream(const Sound* sound)
     dataSize_ = sound->GetDataSize();
     int error;
     decoder_ = stb_vorbis_open_memory((unsigned char*)data_.Get(), dataSize_, &error, nullptr);
+
+    if (decoder_)
+    {
+        ringSize_ = NextPowerOfTwo(GetSampleSize() * frequency_ * DECODE_AHEAD_LENGTH / 1000);
+        ring_ = new signed char[ringSize_];
+    }
 }
 
 OggVorbisSoundStream::~OggVorbisSoundStream()
@@ -64,9 +81,19 @@ bool OggVorbisSoundStream::Seek(unsigned sample_number)
     if (!decoder_)
         return false;
 
+    // A worker thread holds the decoder for at most one chunk
+    while (!TryAcquireDecoder())
+        Time::Sleep(0);
+
     auto* vorbis = static_cast<stb_vorbis*>(decoder_);
 
-    return stb_vorbis_seek(vorbis, sample_number) == 1;
+    // Discard data decoded ahead from the old position
+    ringRead_.store(ringWrite_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    decodeEnd_.store(false, std::memory_order_relaxed);
+    bool success = stb_vorbis_seek(vorbis, sample_number) == 1;
+
+    ReleaseDecoder();
+    return success;
 }
 
 unsigned OggVorbisSoundStream::GetData(signed char* dest, unsigned numBytes)
@@ -74,6 +101,74 @@ unsigned OggVorbisSoundStream::GetData(signed char* dest, unsigned numBytes)
     if (!decoder_)
         return 0;
 
+    unsigned outBytes = ReadRing(dest, numBytes);
+    if (outBytes == numBytes || decodeEnd_.load(std::memory_order_acquire))
+        return outBytes;
+
+    // Not enough was decoded ahead in time. Wait for a worker thread to finish its chunk, then decode the rest here
+    while (!TryAcquireDecoder())
+        Time::Sleep(0);
+
+    outBytes += ReadRing(dest + outBytes, numBytes - outBytes);
+    if (outBytes < numBytes && !decodeEnd_.load(std::memory_order_relaxed))
+        outBytes += Decode(dest + outBytes, numBytes - outBytes);
+
+    ReleaseDecoder();
+    return outBytes;
+}
+
+void OggVorbisSoundStream::DecodeAhead()
+{
+    if (!decoder_)
+        return;
+
+    unsigned frameSize = GetSampleSize();
+
+    for (;;)
+    {
+        if (!TryAcquireDecoder())
+            return;
+
+        unsigned decoded = 0;
+        while (decoded < DECODE_AHEAD_CHUNK && !decodeEnd_.load(std::memory_order_relaxed))
+        {
+            unsigned write = ringWrite_.load(std::memory_order_relaxed);
+            unsigned free = ringSize_ - (write - ringRead_.load(std::memory_order_acquire));
+            unsigned offset = write & (ringSize_ - 1);
+            unsigned numBytes = Min(Min(free, ringSize_ - offset), DECODE_AHEAD_CHUNK - decoded);
+            numBytes -= numBytes % frameSize;
+            if (!numBytes)
+                break;
+
+            unsigned outBytes = Decode(ring_.Get() + offset, numBytes);
+            if (!outBytes)
+            {
+                decodeEnd_.store(true, std::memory_order_release);
+                break;
+            }
+
+            ringWrite_.store(write + outBytes, std::memory_order_release);
+            decoded += outBytes;
+        }
+
+        ReleaseDecoder();
+
+        if (decoded < DECODE_AHEAD_CHUNK)
+            return;
+    }
+}
+
+bool OggVorbisSoundStream::NeedsDecodeAhead() const
+{
+    if (!decoder_ || decodeEnd_.load(std::memory_order_relaxed))
+        return false;
+
+    unsigned buffered = ringWrite_.load(std::memory_order_relaxed) - ringRead_.load(std::memory_order_relaxed);
+    return buffered < ringSize_ / 2;
+}
+
+unsigned OggVorbisSoundStream::Decode(signed char* dest, unsigned numBytes)
+{
     auto* vorbis = static_cast<stb_vorbis*>(decoder_);
 
     unsigned channels = stereo_ ? 2 : 1;
@@ -93,4 +188,22 @@ unsigned OggVorbisSoundStream::GetData(signed char* dest, unsigned numBytes)
     return outBytes;
 }
 
+unsigned OggVorbisSoundStream::ReadRing(signed char* dest, unsigned numBytes)
+{
+    unsigned read = ringRead_.load(std::memory_order_relaxed);
+    unsigned available = ringWrite_.load(std::memory_order_acquire) - read;
+    numBytes = Min(numBytes, available);
+    if (!numBytes)
+        return 0;
+
+    unsigned offset = read & (ringSize_ - 1);
+    unsigned firstBytes = Min(numBytes, ringSize_ - offset);
+    memcpy(dest, ring_.Get() + offset, firstBytes);
+    if (firstBytes < numBytes)
+        memcpy(dest + firstBytes, ring_.Get(), numBytes - firstBytes);
+
+    ringRead_.store(read + numBytes, std::memory_order_release);
+    return numBytes;
+}
+
 }
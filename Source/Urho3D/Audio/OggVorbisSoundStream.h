@@ -25,6 +25,8 @@
 #include "../Audio/SoundStream.h"
 #include "../Container/ArrayPtr.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
@@ -41,17 +43,44 @@ public:
 
     /// Seek to sample number. Return true on success.
     bool Seek(unsigned sample_number) override;
+    /// Return whether seeking is supported.
+    bool IsSeekable() const override { return true; }
 
     /// Produce sound data into destination. Return number of bytes produced. Called by SoundSource from the mixing thread.
     unsigned GetData(signed char* dest, unsigned numBytes) override;
+    /// Decode data ahead of playback into the ring buffer until it is full. Called by Audio from a worker thread.
+    void DecodeAhead() override;
+    /// Return whether the ring buffer is less than half full.
+    bool NeedsDecodeAhead() const override;
 
 protected:
+    /// Decode directly into destination, rewinding if looped. Return number of bytes produced. The decoder must be acquired.
+    unsigned Decode(signed char* dest, unsigned numBytes);
+    /// Copy pre-decoded data from the ring buffer into destination. Return number of bytes copied.
+    unsigned ReadRing(signed char* dest, unsigned numBytes);
+    /// Try to acquire exclusive use of the decoder. Return true on success.
+    bool TryAcquireDecoder() { return !decoderBusy_.exchange(true, std::memory_order_acquire); }
+    /// Release the decoder.
+    void ReleaseDecoder() { decoderBusy_.store(false, std::memory_order_release); }
+
     /// Decoder state.
     void* decoder_;
     /// Compressed sound data.
     SharedArrayPtr<signed char> data_;
     /// Compressed sound data size in bytes.
     unsigned dataSize_;
+    /// Ring buffer of data decoded ahead of playback. Written by the thread holding the decoder and read by the mixer.
+    SharedArrayPtr<signed char> ring_;
+    /// Ring buffer size in bytes. Power of two.
+    unsigned ringSize_;
+    /// Bytes read from the ring buffer, free running.
+    std::atomic<unsigned> ringRead_;
+    /// Bytes written to the ring buffer, free running.
+    std::atomic<unsigned> ringWrite_;
+    /// Decoder in use flag.
+    std::atomic<bool> decoderBusy_;
+    /// End of a non-looped sound reached by decoding ahead.
+    std::atomic<bool> decodeEnd_;
 };
 
 }
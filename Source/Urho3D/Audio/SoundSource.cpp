@@ -33,82 +33,197 @@
 #include "../Scene/Node.h"
 #include "../Scene/ReplicationState.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
-#define INC_POS_LOOPED() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_ONESHOT() \
-    pos += intAdd; \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        ++pos; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define INC_POS_STEREO_LOOPED() \
-    pos += ((unsigned)intAdd << 1u); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    while (pos >= end) \
-        pos -= (end - repeat); \
-
-#define INC_POS_STEREO_ONESHOT() \
-    pos += ((unsigned)intAdd << 1u); \
-    fractPos += fractAdd; \
-    if (fractPos > 65535) \
-    { \
-        fractPos &= 65535; \
-        pos += 2; \
-    } \
-    if (pos >= end) \
-    { \
-        pos = 0; \
-        break; \
-    } \
-
-#define GET_IP_SAMPLE() (((((int)pos[1] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_LEFT() (((((int)pos[2] - (int)pos[0]) * fractPos) / 65536) + (int)pos[0])
-
-#define GET_IP_SAMPLE_RIGHT() (((((int)pos[3] - (int)pos[1]) * fractPos) / 65536) + (int)pos[1])
-
 static const int STREAM_SAFETY_SAMPLES = 4;
+/// Number of frames fetched and mixed at a time.
+static const unsigned MIX_BLOCK_FRAMES = 128;
+/// Gain below which a sound source only advances its position.
+static const float MIN_MIX_GAIN = 0.5f / 256.0f;
 
 extern const char* AUDIO_CATEGORY;
 
 extern const char* autoRemoveModeNames[];
 
+/// Fetch resampled frames of sound data as floats for mixing, stepping a 16.16 fixed point position. The caller guarantees that the frames do not cross the end of the sound. Stereo data is fetched interleaved, or downmixed when DOWNMIX is set.
+template <class T, unsigned CHANNELS, bool DOWNMIX, bool INTERPOLATE> static void FetchFrames(const T* pos, unsigned fractPos,
+    unsigned step, float scale, unsigned frames, float* dest)
+{
+    const float downmixScale = 0.5f * scale;
+    const float fractScale = 1.0f / 65536.0f;
+
+    for (unsigned i = 0; i < frames; ++i)
+    {
+        unsigned acc = fractPos + i * step;
+        const T* p = pos + (acc >> 16u) * CHANNELS;
+
+        if (CHANNELS == 1)
+        {
+            float s = p[0] * scale;
+            if (INTERPOLATE)
+                s += (p[1] * scale - s) * ((acc & 65535u) * fractScale);
+            dest[i] = s;
+        }
+        else if (DOWNMIX)
+        {
+            float s = ((int)p[0] + (int)p[1]) * downmixScale;
+            if (INTERPOLATE)
+                s += (((int)p[2] + (int)p[3]) * downmixScale - s) * ((acc & 65535u) * fractScale);
+            dest[i] = s;
+        }
+#ifdef URHO3D_SSE
+        else if (INTERPOLATE && sizeof(T) == sizeof(short))
+        {
+            // Convert both 16-bit frames at once and interpolate the channels together
+            __m128i raw = _mm_loadl_epi64((const __m128i*)p);
+            __m128 frame = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16));
+            __m128 f = _mm_set1_ps((acc & 65535u) * fractScale);
+            frame = _mm_add_ps(frame, _mm_mul_ps(_mm_sub_ps(_mm_movehl_ps(frame, frame), frame), f));
+            _mm_storel_pi((__m64*)(dest + i * 2), frame);
+        }
+#endif
+        else
+        {
+            float left = p[0] * scale;
+            float right = p[1] * scale;
+            if (INTERPOLATE)
+            {
+                float f = (acc & 65535u) * fractScale;
+                left += (p[2] * scale - left) * f;
+                right += (p[3] * scale - right) * f;
+            }
+            dest[i * 2] = left;
+            dest[i * 2 + 1] = right;
+        }
+    }
+}
+
+/// Accumulate values to the mix bus with gain.
+static void MixBlock(float* dest, const float* src, unsigned count, float gain)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+#endif
+    for (; i < count; ++i)
+        dest[i] += src[i] * gain;
+}
+
+/// Accumulate mono values to an interleaved stereo mix bus with separate left and right gains.
+static void MixBlockToStereo(float* dest, const float* src, unsigned frames, float leftGain, float rightGain)
+{
+    unsigned i = 0;
+#ifdef URHO3D_SSE
+    __m128 g = _mm_setr_ps(leftGain, rightGain, leftGain, rightGain);
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128 s = _mm_loadu_ps(src + i);
+        float* d = dest + i * 2;
+        _mm_storeu_ps(d, _mm_add_ps(_mm_loadu_ps(d), _mm_mul_ps(_mm_unpacklo_ps(s, s), g)));
+        _mm_storeu_ps(d + 4, _mm_add_ps(_mm_loadu_ps(d + 4), _mm_mul_ps(_mm_unpackhi_ps(s, s), g)));
+    }
+#endif
+    for (; i < frames; ++i)
+    {
+        dest[i * 2] += src[i] * leftGain;
+        dest[i * 2 + 1] += src[i] * rightGain;
+    }
+}
+
+/// Resample and mix sound data of a specific sample type to the mix bus. Advance the position, or set it null if a one-shot sound ends.
+template <class T> static void MixSamples(Sound* sound, T*& pos, int& fractPos, float add, float* dest, unsigned samples,
+    bool stereo, bool interpolation, float leftGain, float rightGain, float scale)
+{
+    using FetchFunction = void (*)(const T*, unsigned, unsigned, float, unsigned, float*);
+
+    // Choose the fetch routine once per mix, so that the per-frame loop has no channel or interpolation branches
+    FetchFunction fetch;
+    unsigned channels = sound->IsStereo() ? 2 : 1;
+    unsigned valuesPerFrame = 1;
+    if (channels == 1)
+        fetch = interpolation ? FetchFrames<T, 1, false, true> : FetchFrames<T, 1, false, false>;
+    else if (!stereo)
+        fetch = interpolation ? FetchFrames<T, 2, true, true> : FetchFrames<T, 2, true, false>;
+    else
+    {
+        fetch = interpolation ? FetchFrames<T, 2, false, true> : FetchFrames<T, 2, false, false>;
+        valuesPerFrame = 2;
+    }
+
+    auto intAdd = (unsigned)add;
+    auto fractAdd = (unsigned)((add - floorf(add)) * 65536.0f);
+    unsigned step = (intAdd << 16u) | fractAdd;
+    auto* end = (T*)sound->GetEnd();
+    auto* repeat = (T*)sound->GetRepeat();
+    bool looped = sound->IsLooped();
+    bool pan = stereo && !sound->IsStereo();
+
+    float block[MIX_BLOCK_FRAMES * 2];
+
+    while (samples && pos)
+    {
+        // Fetch at most up to the frame that crosses the end of the sound, so that the block needs no end checks
+        unsigned frames = Min(samples, MIX_BLOCK_FRAMES);
+        if (step)
+        {
+            unsigned long long remaining = ((unsigned long long)(end - pos) / channels << 16u) - (unsigned)fractPos;
+            frames = (unsigned)Min((unsigned long long)frames, (remaining + step - 1) / step);
+        }
+
+        fetch(pos, (unsigned)fractPos, step, scale, frames, block);
+        if (pan)
+            MixBlockToStereo(dest, block, frames, leftGain, rightGain);
+        else
+            MixBlock(dest, block, frames * valuesPerFrame, leftGain);
+
+        dest += stereo ? frames * 2 : frames;
+        samples -= frames;
+
+        unsigned acc = (unsigned)fractPos + frames * step;
+        pos += (acc >> 16u) * channels;
+        fractPos = acc & 65535u;
+        if (pos >= end)
+        {
+            if (!looped)
+                pos = nullptr;
+            else
+            {
+                while (pos >= end)
+                    pos -= (end - repeat);
+            }
+        }
+    }
+}
+
+
 SoundSource::SoundSource(Context* context) :
     Component(context),
     soundType_(SOUND_EFFECT),
+    soundTypeHash_(SOUND_EFFECT),
     frequency_(0.0f),
     gain_(1.0f),
     attenuation_(1.0f),
     panning_(0.0f),
     sendFinishedEvent_(false),
     autoRemove_(REMOVE_DISABLED),
+    priority_(0),
+    mixSound_(nullptr),
+    mixStream_(nullptr),
+    mixStreamBuffer_(nullptr),
+    lastCommand_(0),
+    playRequested_(false),
+    virtual_(false),
+    mixVirtual_(false),
+    mixStreamSeek_(false),
     position_(nullptr),
     fractPosition_(0),
     timePosition_(0.0f),
@@ -141,6 +256,7 @@ void SoundSource::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Panning", float, panning_, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Is Playing", IsPlaying, SetPlayingAttr, bool, false, AM_DEFAULT);
     URHO3D_ENUM_ATTRIBUTE("Autoremove Mode", autoRemove_, autoRemoveModeNames, REMOVE_DISABLED, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Priority", int, priority_, 0, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Play Position", GetPositionAttr, SetPositionAttr, int, 0, AM_FILE);
 }
 
@@ -155,16 +271,17 @@ void SoundSource::Seek(float seekTime)
 
     if (!soundStream_)
     {
-        // Raw or wav format
-        SetPositionAttr((int)(seekTime * (sound_->GetSampleSize() * sound_->GetFrequency())));
+        // Raw or wav format, or a compressed sound mixed from its decoded copy
+        Sound* sound = GetMixedSound();
+        SetPlayPosition(sound->GetStart() + (int)(seekTime * (sound->GetSampleSize() * sound->GetFrequency())));
     }
     else
     {
-        // Ogg format
-        if (soundStream_->Seek((unsigned)(seekTime * soundStream_->GetFrequency())))
-        {
-            timePosition_ = seekTime;
-        }
+        // Ogg format. The decoder is owned by the mixer while playing
+        AudioCommand command;
+        command.type_ = AC_SEEK;
+        command.value_ = (unsigned)(seekTime * soundStream_->GetFrequency());
+        QueueCommand(command);
     }
 }
 
@@ -177,14 +294,26 @@ void SoundSource::Play(Sound* sound)
     if (frequency_ == 0.0f && sound)
         SetFrequency(sound->GetFrequency());
 
-    // If sound source is currently playing, have to lock the audio mutex
-    if (position_)
+    SharedPtr<SoundStream> stream;
+    SharedPtr<Sound> decodedSound;
+    if (sound)
     {
-        MutexLock lock(audio_->GetMutex());
-        PlayLockless(sound);
+        // Compressed sounds play from the decode cache or through a decoder stream, uncompressed sounds need data
+        if (sound->IsCompressed())
+        {
+            decodedSound = audio_->GetDecodedSound(sound);
+            if (!decodedSound)
+            {
+                stream = sound->GetDecoderStream();
+                if (!stream)
+                    sound = nullptr;
+            }
+        }
+        else if (!sound->GetStart())
+            sound = nullptr;
     }
-    else
-        PlayLockless(sound);
+
+    StartPlayback(sound, stream, decodedSound);
 
     // Forget the Sound & Is Playing attribute previous values so that they will be sent again, triggering
     // the sound correctly on network clients even after the initial playback
@@ -235,19 +364,8 @@ void SoundSource::Play(SoundStream* stream)
 
     SharedPtr<SoundStream> streamPtr(stream);
 
-    // If sound source is currently playing, have to lock the audio mutex. When stream playback is explicitly
-    // requested, clear the existing sound if any
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        sound_.Reset();
-        PlayLockless(streamPtr);
-    }
-    else
-    {
-        sound_.Reset();
-        PlayLockless(streamPtr);
-    }
+    // When stream playback is explicitly requested, clear the existing sound if any
+    StartPlayback(nullptr, streamPtr);
 
     // Stream playback is not supported for network replication, no need to mark network dirty
 }
@@ -257,14 +375,7 @@ void SoundSource::Stop()
     if (!audio_)
         return;
 
-    // If sound source is currently playing, have to lock the audio mutex
-    if (position_)
-    {
-        MutexLock lock(audio_->GetMutex());
-        StopLockless();
-    }
-    else
-        StopLockless();
+    StopPlayback();
 
     MarkNetworkUpdate();
 }
@@ -311,19 +422,37 @@ void SoundSource::SetAutoRemoveMode(AutoRemoveMode mode)
     MarkNetworkUpdate();
 }
 
+void SoundSource::SetPriority(int priority)
+{
+    priority_ = priority;
+    MarkNetworkUpdate();
+}
+
 bool SoundSource::IsPlaying() const
 {
-    return (sound_ || soundStream_) && position_ != nullptr;
+    if (!sound_ && !soundStream_)
+        return false;
+
+    // Until the mixer has caught up, report the requested state
+    if (IsCommandPending())
+        return playRequested_;
+
+    return position_ != nullptr;
 }
 
 void SoundSource::SetPlayPosition(signed char* pos)
 {
     // Setting play position on a stream is not supported
-    if (!audio_ || !sound_ || soundStream_)
+    Sound* sound = GetMixedSound();
+    if (!audio_ || !sound || sound->IsCompressed() || soundStream_)
         return;
 
-    MutexLock lock(audio_->GetMutex());
-    SetPlayPositionLockless(pos);
+    AudioCommand command;
+    command.type_ = AC_SETPOSITION;
+    command.sound_ = sound;
+    command.value_ = (unsigned)Max((int)(pos - sound->GetStart()), 0);
+    QueueCommand(command);
+    playRequested_ = true;
 }
 
 void SoundSource::Update(float timeStep)
@@ -335,12 +464,12 @@ void SoundSource::Update(float timeStep)
     if (!audio_->IsInitialized())
         MixNull(timeStep);
 
-    // Free the stream if playback has stopped
-    if (soundStream_ && !position_)
-        StopLockless();
-
     bool playing = IsPlaying();
 
+    // Free the stream if playback has stopped
+    if (soundStream_ && !playing)
+        StopPlayback();
+
     if (!playing && sendFinishedEvent_)
     {
         sendFinishedEvent_ = false;
@@ -363,30 +492,37 @@ void SoundSource::Update(float timeStep)
     }
 }
 
-void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
+void SoundSource::Mix(float* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
 {
-    if (!position_ || (!sound_ && !soundStream_) || !IsEnabledEffective())
+    if (!position_ || (!mixSound_ && !mixStream_) || !IsEnabledEffective())
         return;
 
+    // A virtualized seekable stream is not decoded; it seeks to the time position once mixed for real again
+    if (mixVirtual_ && mixStream_ && mixStream_->IsSeekable())
+    {
+        MixVirtualStream(samples, mixRate);
+        return;
+    }
+
     int streamFilledSize, outBytes;
 
-    if (soundStream_ && streamBuffer_)
+    if (mixStream_ && mixStreamBuffer_)
     {
-        int streamBufferSize = streamBuffer_->GetDataSize();
+        int streamBufferSize = mixStreamBuffer_->GetDataSize();
         // Calculate how many bytes of stream sound data is needed
         auto neededSize = (int)((float)samples * frequency_ / (float)mixRate);
         // Add a little safety buffer. Subtract previous unused data
         neededSize += STREAM_SAFETY_SAMPLES;
-        neededSize *= soundStream_->GetSampleSize();
+        neededSize *= mixStream_->GetSampleSize();
         neededSize -= unusedStreamSize_;
         neededSize = Clamp(neededSize, 0, streamBufferSize - unusedStreamSize_);
 
         // Always start play position at the beginning of the stream buffer
-        position_ = streamBuffer_->GetStart();
+        position_ = mixStreamBuffer_->GetStart();
 
         // Request new data from the stream
-        signed char* destination = streamBuffer_->GetStart() + unusedStreamSize_;
-        outBytes = neededSize ? soundStream_->GetData(destination, (unsigned)neededSize) : 0;
+        signed char* destination = mixStreamBuffer_->GetStart() + unusedStreamSize_;
+        outBytes = neededSize ? mixStream_->GetData(destination, (unsigned)neededSize) : 0;
         destination += outBytes;
         // Zero-fill rest if stream did not produce enough data
         if (outBytes < neededSize)
@@ -397,64 +533,33 @@ void SoundSource::Mix(int* dest, unsigned samples, int mixRate, bool stereo, boo
     }
 
     // If streaming, play the stream buffer. Otherwise play the original sound
-    Sound* sound = soundStream_ ? streamBuffer_ : sound_;
+    Sound* sound = mixStream_ ? mixStreamBuffer_ : mixSound_;
     if (!sound)
         return;
 
-    // Choose the correct mixing routine
-    if (!sound->IsStereo())
-    {
-        if (interpolation)
-        {
-            if (stereo)
-                MixMonoToStereoIP(sound, dest, samples, mixRate);
-            else
-                MixMonoToMonoIP(sound, dest, samples, mixRate);
-        }
-        else
-        {
-            if (stereo)
-                MixMonoToStereo(sound, dest, samples, mixRate);
-            else
-                MixMonoToMono(sound, dest, samples, mixRate);
-        }
-    }
+    if (mixVirtual_)
+        MixZeroVolume(sound, samples, mixRate);
     else
-    {
-        if (interpolation)
-        {
-            if (stereo)
-                MixStereoToStereoIP(sound, dest, samples, mixRate);
-            else
-                MixStereoToMonoIP(sound, dest, samples, mixRate);
-        }
-        else
-        {
-            if (stereo)
-                MixStereoToStereo(sound, dest, samples, mixRate);
-            else
-                MixStereoToMono(sound, dest, samples, mixRate);
-        }
-    }
+        MixSound(sound, dest, samples, mixRate, stereo, interpolation);
 
     // Update the time position. In stream mode, copy unused data back to the beginning of the stream buffer
-    if (soundStream_)
+    if (mixStream_)
     {
-        timePosition_ += ((float)samples / (float)mixRate) * frequency_ / soundStream_->GetFrequency();
+        timePosition_ += ((float)samples / (float)mixRate) * frequency_ / mixStream_->GetFrequency();
 
-        unusedStreamSize_ = Max(streamFilledSize - (int)(size_t)(position_ - streamBuffer_->GetStart()), 0);
+        unusedStreamSize_ = Max(streamFilledSize - (int)(size_t)(position_ - mixStreamBuffer_->GetStart()), 0);
         if (unusedStreamSize_)
-            memcpy(streamBuffer_->GetStart(), (const void*)position_, (size_t)unusedStreamSize_);
+            memcpy(mixStreamBuffer_->GetStart(), (const void*)position_, (size_t)unusedStreamSize_);
 
         // If stream did not produce any data, stop if applicable
-        if (!outBytes && soundStream_->GetStopAtEnd())
+        if (!outBytes && mixStream_->GetStopAtEnd())
         {
             position_ = nullptr;
             return;
         }
     }
-    else if (sound_)
-        timePosition_ = ((float)(int)(size_t)(position_ - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
+    else if (mixSound_)
+        timePosition_ = ((float)(int)(size_t)(position_ - mixSound_->GetStart())) / (mixSound_->GetSampleSize() * mixSound_->GetFrequency());
 }
 
 void SoundSource::UpdateMasterGain()
@@ -463,6 +568,19 @@ void SoundSource::UpdateMasterGain()
         masterGain_ = audio_->GetSoundSourceMasterGain(soundType_);
 }
 
+void SoundSource::SetVirtual(bool enable)
+{
+    if (enable == virtual_)
+        return;
+
+    virtual_ = enable;
+
+    AudioCommand command;
+    command.type_ = AC_SETVIRTUAL;
+    command.value_ = enable ? 1 : 0;
+    QueueCommand(command);
+}
+
 void SoundSource::SetSoundAttr(const ResourceRef& value)
 {
     auto* cache = GetSubsystem<ResourceCache>();
@@ -472,8 +590,8 @@ void SoundSource::SetSoundAttr(const ResourceRef& value)
     else
     {
         // When changing the sound and not playing, free previous sound stream and stream buffer (if any)
-        soundStream_.Reset();
-        streamBuffer_.Reset();
+        StopPlayback();
+        ReleaseSound();
         sound_ = newSound;
     }
 }
@@ -491,8 +609,8 @@ void SoundSource::SetPlayingAttr(bool value)
 
 void SoundSource::SetPositionAttr(int value)
 {
-    if (sound_)
-        SetPlayPosition(sound_->GetStart() + value);
+    if (Sound* sound = GetMixedSound())
+        SetPlayPosition(sound->GetStart() + value);
 }
 
 ResourceRef SoundSource::GetSoundAttr() const
@@ -502,730 +620,196 @@ ResourceRef SoundSource::GetSoundAttr() const
 
 int SoundSource::GetPositionAttr() const
 {
-    if (sound_ && position_)
-        return (int)(GetPlayPosition() - sound_->GetStart());
+    Sound* sound = GetMixedSound();
+    if (sound && !soundStream_ && position_ && !IsCommandPending())
+        return (int)(GetPlayPosition() - sound->GetStart());
     else
         return 0;
 }
 
-void SoundSource::PlayLockless(Sound* sound)
-{
-    // Reset the time position in any case
-    timePosition_ = 0.0f;
-
-    if (sound)
-    {
-        if (!sound->IsCompressed())
-        {
-            // Uncompressed sound start
-            signed char* start = sound->GetStart();
-            if (start)
-            {
-                // Free existing stream & stream buffer if any
-                soundStream_.Reset();
-                streamBuffer_.Reset();
-                sound_ = sound;
-                position_ = start;
-                fractPosition_ = 0;
-                sendFinishedEvent_ = true;
-                return;
-            }
-        }
-        else
-        {
-            // Compressed sound start
-            PlayLockless(sound->GetDecoderStream());
-            sound_ = sound;
-            return;
-        }
-    }
-
-    // If sound pointer is null or if sound has no data, stop playback
-    StopLockless();
-    sound_.Reset();
-}
-
-void SoundSource::PlayLockless(const SharedPtr<SoundStream>& stream)
+void SoundSource::PlayLockless(Sound* sound, SoundStream* stream, Sound* streamBuffer)
 {
-    // Reset the time position in any case
+    mixSound_ = sound;
+    mixStream_ = stream;
+    mixStreamBuffer_ = streamBuffer;
+    unusedStreamSize_ = 0;
+    position_ = stream ? streamBuffer->GetStart() : sound->GetStart();
+    fractPosition_ = 0;
     timePosition_ = 0.0f;
-
-    if (stream)
-    {
-        // Setup the stream buffer
-        unsigned sampleSize = stream->GetSampleSize();
-        unsigned streamBufferSize = sampleSize * stream->GetIntFrequency() * STREAM_BUFFER_LENGTH / 1000;
-
-        streamBuffer_ = new Sound(context_);
-        streamBuffer_->SetSize(streamBufferSize);
-        streamBuffer_->SetFormat(stream->GetIntFrequency(), stream->IsSixteenBit(), stream->IsStereo());
-        streamBuffer_->SetLooped(true);
-
-        soundStream_ = stream;
-        unusedStreamSize_ = 0;
-        position_ = streamBuffer_->GetStart();
-        fractPosition_ = 0;
-        sendFinishedEvent_ = true;
-        return;
-    }
-
-    // If stream pointer is null, stop playback
-    StopLockless();
+    mixStreamSeek_ = false;
 }
 
 void SoundSource::StopLockless()
 {
     position_ = nullptr;
     timePosition_ = 0.0f;
+    mixStreamSeek_ = false;
 
-    // Free the sound stream and decode buffer if a stream was playing
-    soundStream_.Reset();
-    streamBuffer_.Reset();
+    mixSound_ = nullptr;
+    mixStream_ = nullptr;
+    mixStreamBuffer_ = nullptr;
 }
 
-void SoundSource::SetPlayPositionLockless(signed char* pos)
+void SoundSource::SetPlayPositionLockless(Sound* sound, unsigned offset)
 {
-    // Setting position on a stream is not supported
-    if (!sound_ || soundStream_)
-        return;
+    // The main thread only sets position when not streaming, so any previous stream is already released
+    mixSound_ = sound;
+    mixStream_ = nullptr;
+    mixStreamBuffer_ = nullptr;
 
-    signed char* start = sound_->GetStart();
-    signed char* end = sound_->GetEnd();
-    if (pos < start)
-        pos = start;
-    if (sound_->IsSixteenBit() && (pos - start) & 1u)
+    signed char* start = sound->GetStart();
+    signed char* end = sound->GetEnd();
+    signed char* pos = start + offset;
+    if (sound->IsSixteenBit() && (pos - start) & 1u)
         ++pos;
     if (pos > end)
         pos = end;
 
     position_ = pos;
-    timePosition_ = ((float)(int)(size_t)(pos - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
+    timePosition_ = ((float)(int)(size_t)(pos - start)) / (sound->GetSampleSize() * sound->GetFrequency());
 }
 
-void SoundSource::MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::SeekLockless(unsigned sample)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-    fractPosition_ = fractPos;
+    if (mixStream_ && mixStream_->Seek(sample))
+        timePosition_ = (float)sample / mixStream_->GetFrequency();
 }
 
-void SoundSource::MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::SetVirtualLockless(bool enable)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    auto rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    if (!leftVol && !rightVol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
+    mixVirtual_ = enable;
 
-    if (sound->IsSixteenBit())
+    // Resume a stream that was not decoded while virtualized from its current time position
+    if (!enable && mixStreamSeek_)
     {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
+        mixStreamSeek_ = false;
+        if (position_ && mixStream_ && mixStreamBuffer_)
         {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (*pos * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (*pos * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
+            mixStream_->Seek((unsigned)(timePosition_ * mixStream_->GetFrequency()));
+            position_ = mixStreamBuffer_->GetStart();
+            fractPosition_ = 0;
+            unusedStreamSize_ = 0;
         }
     }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + *pos * leftVol;
-                ++dest;
-                *dest = *dest + *pos * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
 }
 
-void SoundSource::MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::StartPlayback(Sound* sound, SoundStream* stream, Sound* decodedSound)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
+    // If sound pointer is null or if sound has no data, stop playback
+    if (!sound && !stream)
     {
-        MixZeroVolume(sound, samples, mixRate);
+        StopPlayback();
+        ReleaseSound();
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
+    SharedPtr<Sound> streamBuffer;
+    if (stream)
     {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
+        // Setup the stream buffer
+        unsigned sampleSize = stream->GetSampleSize();
+        unsigned streamBufferSize = sampleSize * stream->GetIntFrequency() * STREAM_BUFFER_LENGTH / 1000;
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE() * vol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
+        streamBuffer = new Sound(context_);
+        streamBuffer->SetSize(streamBufferSize);
+        streamBuffer->SetFormat(stream->GetIntFrequency(), stream->IsSixteenBit(), stream->IsStereo());
+        streamBuffer->SetLooped(true);
     }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE() * vol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
+    AudioCommand command;
+    command.type_ = AC_PLAY;
+    command.sound_ = decodedSound ? decodedSound : sound;
+    command.stream_ = stream;
+    command.streamBuffer_ = streamBuffer;
+    QueueCommand(command);
 
-    fractPosition_ = fractPos;
+    // The mixer keeps reading the previous sound, stream and decode buffer until it applies the command
+    ReleaseSound();
+    ReleaseAfterMix(soundStream_);
+    ReleaseAfterMix(streamBuffer_);
+    sound_ = sound;
+    decodedSound_ = decodedSound;
+    soundStream_ = stream;
+    streamBuffer_ = streamBuffer;
+    playRequested_ = true;
+    sendFinishedEvent_ = true;
 }
 
-void SoundSource::MixMonoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::StopPlayback()
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto leftVol = (int)((-panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    auto rightVol = (int)((panning_ + 1.0f) * (256.0f * totalGain + 0.5f));
-    if (!leftVol && !rightVol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
+    AudioCommand command;
+    command.type_ = AC_STOP;
+    QueueCommand(command);
+    playRequested_ = false;
 
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + (s * leftVol) / 256;
-                ++dest;
-                *dest = *dest + (s * rightVol) / 256;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = GET_IP_SAMPLE();
-                *dest = *dest + s * leftVol;
-                ++dest;
-                *dest = *dest + s * rightVol;
-                ++dest;
-                INC_POS_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    // Free the sound stream and decode buffer if a stream was playing
+    ReleaseAfterMix(soundStream_);
+    ReleaseAfterMix(streamBuffer_);
+    soundStream_.Reset();
+    streamBuffer_.Reset();
 }
 
-void SoundSource::MixStereoToMono(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::ReleaseSound()
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
-    }
-
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = ((int)pos[0] + (int)pos[1]) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
+    ReleaseAfterMix(sound_);
+    ReleaseAfterMix(decodedSound_);
+    sound_.Reset();
+    decodedSound_.Reset();
 }
 
-void SoundSource::MixStereoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::QueueCommand(AudioCommand& command)
 {
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
-    {
-        MixZeroVolume(sound, samples, mixRate);
+    if (!audio_)
         return;
-    }
 
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (pos[0] * vol) / 256;
-                ++dest;
-                *dest = *dest + (pos[1] * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
+    command.source_ = this;
+    lastCommand_ = audio_->QueueCommand(command);
+}
 
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + pos[0] * vol;
-                ++dest;
-                *dest = *dest + pos[1] * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
+void SoundSource::ReleaseAfterMix(RefCounted* object)
+{
+    if (audio_)
+        audio_->ReleaseAfterMix(object);
+}
 
-    fractPosition_ = fractPos;
+bool SoundSource::IsCommandPending() const
+{
+    return audio_ && audio_->IsCommandPending(lastCommand_);
 }
 
-void SoundSource::MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
+void SoundSource::MixSound(Sound* sound, float* dest, unsigned samples, int mixRate, bool stereo, bool interpolation)
 {
     float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
+    if (totalGain < MIN_MIX_GAIN)
     {
         MixZeroVolume(sound, samples, mixRate);
         return;
     }
 
-    float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
-    int fractPos = fractPosition_;
-
-    if (sound->IsSixteenBit())
-    {
-        auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + (s * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
-    }
-    else
-    {
-        auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                int s = (GET_IP_SAMPLE_LEFT() + GET_IP_SAMPLE_RIGHT()) / 2;
-                *dest = *dest + s * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
-    }
-
-    fractPosition_ = fractPos;
-}
-
-void SoundSource::MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate)
-{
-    float totalGain = masterGain_ * attenuation_ * gain_;
-    auto vol = RoundToInt(256.0f * totalGain);
-    if (!vol)
+    // Mono sounds are panned when mixing to stereo
+    float leftGain = totalGain;
+    float rightGain = totalGain;
+    if (stereo && !sound->IsStereo())
     {
-        MixZeroVolume(sound, samples, mixRate);
-        return;
+        leftGain *= 1.0f - panning_;
+        rightGain *= 1.0f + panning_;
     }
 
     float add = frequency_ / (float)mixRate;
-    auto intAdd = (int)add;
-    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
     int fractPos = fractPosition_;
 
+    // 8-bit data is scaled to the 16-bit range of the mix bus
     if (sound->IsSixteenBit())
     {
         auto* pos = (short*)position_;
-        auto* end = (short*)sound->GetEnd();
-        auto* repeat = (short*)sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = (signed char*)pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + (GET_IP_SAMPLE_LEFT() * vol) / 256;
-                ++dest;
-                *dest = *dest + (GET_IP_SAMPLE_RIGHT() * vol) / 256;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = (signed char*)pos;
-        }
+        MixSamples(sound, pos, fractPos, add, dest, samples, stereo, interpolation, leftGain, rightGain, 1.0f);
+        position_ = (signed char*)pos;
     }
     else
     {
         auto* pos = (signed char*)position_;
-        signed char* end = sound->GetEnd();
-        signed char* repeat = sound->GetRepeat();
-
-        if (sound->IsLooped())
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_LOOPED();
-            }
-            position_ = pos;
-        }
-        else
-        {
-            while (samples--)
-            {
-                *dest = *dest + GET_IP_SAMPLE_LEFT() * vol;
-                ++dest;
-                *dest = *dest + GET_IP_SAMPLE_RIGHT() * vol;
-                ++dest;
-                INC_POS_STEREO_ONESHOT();
-            }
-            position_ = pos;
-        }
+        MixSamples(sound, pos, fractPos, add, dest, samples, stereo, interpolation, leftGain, rightGain, 256.0f);
+        position_ = pos;
     }
 
     fractPosition_ = fractPos;
@@ -1260,23 +844,45 @@ void SoundSource::MixZeroVolume(Sound* sound, unsigned samples, int mixRate)
     }
 }
 
+void SoundSource::MixVirtualStream(unsigned samples, int mixRate)
+{
+    timePosition_ += ((float)samples / (float)mixRate) * frequency_ / mixStream_->GetFrequency();
+    mixStreamSeek_ = true;
+
+    // A compressed sound's decoder stream rewinds at end if looped, otherwise stops
+    if (mixSound_)
+    {
+        float length = mixSound_->GetLength();
+        if (length > 0.0f && timePosition_ >= length)
+        {
+            if (mixSound_->IsLooped())
+                timePosition_ = fmodf(timePosition_, length);
+            else
+            {
+                position_ = nullptr;
+                mixStreamSeek_ = false;
+            }
+        }
+    }
+}
+
 void SoundSource::MixNull(float timeStep)
 {
-    if (!position_ || !sound_ || !IsEnabledEffective())
+    if (!position_ || !mixSound_ || !IsEnabledEffective())
         return;
 
     // Advance only the time position
-    timePosition_ += timeStep * frequency_ / sound_->GetFrequency();
+    timePosition_ += timeStep * frequency_ / mixSound_->GetFrequency();
 
-    if (sound_->IsLooped())
+    if (mixSound_->IsLooped())
     {
         // For simulated playback, simply reset the time position to zero when the sound loops
-        if (timePosition_ >= sound_->GetLength())
-            timePosition_ -= sound_->GetLength();
+        if (timePosition_ >= mixSound_->GetLength())
+            timePosition_ -= mixSound_->GetLength();
     }
     else
     {
-        if (timePosition_ >= sound_->GetLength())
+        if (timePosition_ >= mixSound_->GetLength())
         {
             position_ = nullptr;
             timePosition_ = 0.0f;
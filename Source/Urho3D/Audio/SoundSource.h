@@ -30,6 +30,7 @@ namespace Urho3D
 
 class Audio;
 class Sound;
+struct AudioCommand;
 class SoundStream;
 
 /// Compressed audio decode buffer length in milliseconds.
@@ -76,16 +77,24 @@ public:
     void SetAutoRemoveMode(AutoRemoveMode mode);
     /// Set new playback position.
     void SetPlayPosition(signed char* pos);
+    /// Set priority for voice limiting. Higher priority sound sources are mixed before lower priority ones regardless of audibility. Default 0.
+    void SetPriority(int priority);
 
     /// Return sound.
     Sound* GetSound() const { return sound_; }
 
+    /// Return sound stream being played, including the decoder stream of a compressed sound.
+    SoundStream* GetSoundStream() const { return soundStream_; }
+
     /// Return playback position.
     volatile signed char* GetPlayPosition() const { return position_; }
 
     /// Return sound type, determines the master gain group.
     String GetSoundType() const { return soundType_; }
 
+    /// Return sound type hash.
+    StringHash GetSoundTypeHash() const { return soundTypeHash_; }
+
     /// Return playback time position.
     float GetTimePosition() const { return timePosition_; }
 
@@ -104,15 +113,36 @@ public:
     /// Return automatic removal mode on sound playback completion.
     AutoRemoveMode GetAutoRemoveMode() const { return autoRemove_; }
 
+    /// Return priority for voice limiting.
+    int GetPriority() const { return priority_; }
+
+    /// Return audibility as the product of master gain, attenuation and gain.
+    float GetAudibility() const { return masterGain_ * attenuation_ * gain_; }
+
+    /// Return whether is virtualized by the voice limit: playback advances without being mixed.
+    bool IsVirtual() const { return virtual_; }
+
     /// Return whether is playing.
     bool IsPlaying() const;
 
     /// Update the sound source. Perform subclass specific operations. Called by Audio.
     virtual void Update(float timeStep);
-    /// Mix sound source output to a 32-bit clipping buffer. Called by Audio.
-    void Mix(int* dest, unsigned samples, int mixRate, bool stereo, bool interpolation);
+    /// Mix sound source output to a float mix bus. Called by Audio.
+    void Mix(float* dest, unsigned samples, int mixRate, bool stereo, bool interpolation);
     /// Update the effective master gain. Called internally and by Audio when the master gain changes.
     void UpdateMasterGain();
+    /// Set whether is virtualized. Called by Audio when ranking voices.
+    void SetVirtual(bool enable);
+    /// Start playing a sound or a sound stream with its decode buffer. Called by Audio from the mixer.
+    void PlayLockless(Sound* sound, SoundStream* stream, Sound* streamBuffer);
+    /// Stop playback. Called by Audio from the mixer.
+    void StopLockless();
+    /// Set new playback position as a byte offset into a sound. Called by Audio from the mixer.
+    void SetPlayPositionLockless(Sound* sound, unsigned offset);
+    /// Seek the sound stream to a sample. Called by Audio from the mixer.
+    void SeekLockless(unsigned sample);
+    /// Set whether is virtualized. Called by Audio from the mixer.
+    void SetVirtualLockless(bool enable);
 
     /// Set sound attribute.
     void SetSoundAttr(const ResourceRef& value);
@@ -146,49 +176,63 @@ protected:
     bool sendFinishedEvent_;
     /// Automatic removal mode.
     AutoRemoveMode autoRemove_;
+    /// Priority for voice limiting.
+    int priority_;
 
 private:
-    /// Play a sound without locking the audio mutex. Called internally.
-    void PlayLockless(Sound* sound);
-    /// Play a sound stream without locking the audio mutex. Called internally.
-    void PlayLockless(const SharedPtr<SoundStream>& stream);
-    /// Stop sound without locking the audio mutex. Called internally.
-    void StopLockless();
-    /// Set new playback position without locking the audio mutex. Called internally.
-    void SetPlayPositionLockless(signed char* pos);
-    /// Mix mono sample to mono buffer.
-    void MixMonoToMono(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix mono sample to stereo buffer.
-    void MixMonoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix mono sample to mono buffer interpolated.
-    void MixMonoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix mono sample to stereo buffer interpolated.
-    void MixMonoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to mono buffer.
-    void MixStereoToMono(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to stereo buffer.
-    void MixStereoToStereo(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to mono buffer interpolated.
-    void MixStereoToMonoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
-    /// Mix stereo sample to stereo buffer interpolated.
-    void MixStereoToStereoIP(Sound* sound, int* dest, unsigned samples, int mixRate);
+    /// Queue playback of a sound or a sound stream to the mixer. A compressed sound may instead be mixed from its decoded copy. Stop if sound and stream are null.
+    void StartPlayback(Sound* sound, SoundStream* stream, Sound* decodedSound = nullptr);
+    /// Release the sound and its decoded copy.
+    void ReleaseSound();
+    /// Return the sound the mixer reads: the decoded copy of a compressed sound if there is one.
+    Sound* GetMixedSound() const { return decodedSound_ ? decodedSound_.Get() : sound_.Get(); }
+    /// Queue stop to the mixer and release the sound stream and decode buffer.
+    void StopPlayback();
+    /// Queue a state change of this sound source to the mixer.
+    void QueueCommand(AudioCommand& command);
+    /// Keep an object the mixer may still reference alive until the mixer has applied the queued commands.
+    void ReleaseAfterMix(RefCounted* object);
+    /// Return whether the mixer has not yet applied all commands queued by this sound source.
+    bool IsCommandPending() const;
+    /// Resample and mix sound data to a float mix bus with the current gain and panning.
+    void MixSound(Sound* sound, float* dest, unsigned samples, int mixRate, bool stereo, bool interpolation);
     /// Advance playback pointer without producing audible output.
     void MixZeroVolume(Sound* sound, unsigned samples, int mixRate);
+    /// Advance the time position of a virtualized seekable stream without decoding.
+    void MixVirtualStream(unsigned samples, int mixRate);
     /// Advance playback pointer to simulate audio playback in headless mode.
     void MixNull(float timeStep);
 
     /// Sound that is being played.
     SharedPtr<Sound> sound_;
+    /// Decoded copy of a compressed sound from the audio decode cache.
+    SharedPtr<Sound> decodedSound_;
     /// Sound stream that is being played.
     SharedPtr<SoundStream> soundStream_;
+    /// Decode buffer.
+    SharedPtr<Sound> streamBuffer_;
+    /// Sound as seen by the mixer.
+    Sound* mixSound_;
+    /// Sound stream as seen by the mixer.
+    SoundStream* mixStream_;
+    /// Decode buffer as seen by the mixer.
+    Sound* mixStreamBuffer_;
+    /// Sequence number of the last command queued to the mixer.
+    unsigned lastCommand_;
+    /// Whether playback was last requested to start or stop. Reported by IsPlaying() until the mixer applies it.
+    bool playRequested_;
+    /// Virtualized flag.
+    bool virtual_;
+    /// Virtualized flag as seen by the mixer.
+    bool mixVirtual_;
+    /// Whether the mixer skipped decoding the stream while virtualized and must seek before mixing again.
+    bool mixStreamSeek_;
     /// Playback position.
     volatile signed char* position_;
     /// Playback fractional position.
     volatile int fractPosition_;
     /// Playback time position.
     volatile float timePosition_;
-    /// Decode buffer.
-    SharedPtr<Sound> streamBuffer_;
     /// Unused stream bytes from previous frame.
     int unusedStreamSize_;
 };
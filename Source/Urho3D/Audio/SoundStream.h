@@ -38,9 +38,15 @@ public:
 
     /// Seek to sample number. Return true on success. Need not be implemented by all streams.
     virtual bool Seek(unsigned sample_number);
+    /// Return whether seeking is supported. Virtualized sound sources skip decoding seekable streams and seek when they become audible again.
+    virtual bool IsSeekable() const { return false; }
 
     /// Produce sound data into destination. Return number of bytes produced. Called by SoundSource from the mixing thread.
     virtual unsigned GetData(signed char* dest, unsigned numBytes) = 0;
+    /// Decode data ahead of playback into an internal buffer. Called by Audio from a worker thread. Need not be implemented by all streams.
+    virtual void DecodeAhead() { }
+    /// Return whether data should be decoded ahead of playback now.
+    virtual bool NeedsDecodeAhead() const { return false; }
 
     /// Set sound data format.
     void SetFormat(unsigned frequency, bool sixteenBit, bool stereo);
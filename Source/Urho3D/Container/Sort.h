@@ -141,4 +141,63 @@ template <class T, class U> void Sort(RandomAccessIterator<T> begin, RandomAcces
     InsertionSort(begin, end, compare);
 }
 
+/// Perform a stable radix sort of values by unsigned integer keys in ascending order, 8 bits per pass. Temporary arrays of the same size must be provided. Passes where all keys have the same digit are skipped.
+template <class K, class T> void RadixSort(K* keys, T* values, unsigned count, K* tempKeys, T* tempValues)
+{
+    static const unsigned NUM_DIGITS = sizeof(K);
+
+    if (count < 2)
+        return;
+
+    // Count the occurrences of all digits in one pass over the keys
+    unsigned counts[NUM_DIGITS][256] = {};
+    for (unsigned i = 0; i < count; ++i)
+    {
+        K key = keys[i];
+        for (unsigned d = 0; d < NUM_DIGITS; ++d)
+            ++counts[d][(key >> (d * 8)) & 0xff];
+    }
+
+    K* srcKeys = keys;
+    T* srcValues = values;
+    K* destKeys = tempKeys;
+    T* destValues = tempValues;
+
+    for (unsigned d = 0; d < NUM_DIGITS; ++d)
+    {
+        unsigned* digitCounts = counts[d];
+        unsigned shift = d * 8;
+        if (digitCounts[(srcKeys[0] >> shift) & 0xff] == count)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned j = 0; j < 256; ++j)
+        {
+            unsigned digitCount = digitCounts[j];
+            digitCounts[j] = offset;
+            offset += digitCount;
+        }
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            unsigned index = digitCounts[(srcKeys[i] >> shift) & 0xff]++;
+            destKeys[index] = srcKeys[i];
+            destValues[index] = srcValues[i];
+        }
+
+        Swap(srcKeys, destKeys);
+        Swap(srcValues, destValues);
+    }
+
+    // Copy back if the last pass was written to the temporary arrays
+    if (srcKeys != keys)
+    {
+        for (unsigned i = 0; i < count; ++i)
+        {
+            keys[i] = srcKeys[i];
+            values[i] = srcValues[i];
+        }
+    }
+}
+
 }
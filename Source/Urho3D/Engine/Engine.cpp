@@ -223,6 +223,12 @@ bool Engine::Initialize(const VariantMap& parameters)
     auto* cache = GetSubsystem<ResourceCache>();
     auto* fileSystem = GetSubsystem<FileSystem>();
 
+    if (HasParameter(parameters, EP_COOKED_RESOURCE_DIR))
+    {
+        cache->SetCookedResourceDir(GetParameter(parameters, EP_COOKED_RESOURCE_DIR).GetString());
+        cache->SetAutoCookResources(GetParameter(parameters, EP_AUTO_COOK_RESOURCES, false).GetBool());
+    }
+
     // Initialize graphics & audio output
     if (!headless_)
     {
@@ -26,8 +26,10 @@ namespace Urho3D
 {
 
 // Engine parameters
+static const String EP_AUTO_COOK_RESOURCES = "AutoCookResources";
 static const String EP_AUTOLOAD_PATHS = "AutoloadPaths";
 static const String EP_BORDERLESS = "Borderless";
+static const String EP_COOKED_RESOURCE_DIR = "CookedResourceDir";
 static const String EP_DUMP_SHADERS = "DumpShaders";
 static const String EP_EVENT_PROFILER = "EventProfiler";
 static const String EP_EXTERNAL_WINDOW = "ExternalWindow";
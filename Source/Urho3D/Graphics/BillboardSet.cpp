@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/BillboardSet.h"
 #include "../Graphics/Camera.h"
@@ -69,11 +70,323 @@ static const StringVector billboardsStructureElementNames =
     "   Is Enabled"
 };
 
-inline bool CompareBillboards(Billboard* lhs, Billboard* rhs)
+/// Minimum number of billboards processed per work item.
+static const unsigned MIN_BILLBOARDS_PER_WORK_ITEM = 4096;
+
+struct BillboardUpdateRange;
+
+/// Parameters shared by the work items of a billboard vertex buffer update.
+struct BillboardUpdateParams
+{
+    /// Enabled billboards. Points to the sorted billboards once sorted.
+    Billboard** billboards_;
+    /// Sort keys of the enabled billboards.
+    unsigned* sortKeys_;
+    /// Billboards read by a radix sort pass.
+    Billboard** srcBillboards_;
+    /// Sort keys read by a radix sort pass.
+    unsigned* srcSortKeys_;
+    /// Billboards written by a radix sort pass.
+    Billboard** destBillboards_;
+    /// Sort keys written by a radix sort pass.
+    unsigned* destSortKeys_;
+    /// Digit shift of a radix sort pass.
+    unsigned shift_;
+    /// Billboard positioning transform.
+    Matrix3x4 billboardTransform_;
+    /// Camera view transform.
+    Matrix3x4 cameraView_;
+    /// Camera world position.
+    Vector3 cameraPosition_;
+    /// Orthographic camera flag.
+    bool orthographic_;
+    /// Billboard size scale.
+    Vector3 billboardScale_;
+    /// Fixed screen size flag.
+    bool fixedScreenSize_;
+    /// Direction billboard vertex format flag.
+    bool direction_;
+    /// Vertex buffer data.
+    float* vertexData_;
+    /// Function run for each range by the work items.
+    void (*rangeFunction_)(BillboardUpdateRange& range);
+};
+
+/// Billboard index range of one work item.
+struct BillboardUpdateRange
+{
+    /// Shared parameters.
+    const BillboardUpdateParams* params_;
+    /// First billboard index.
+    unsigned start_;
+    /// Billboard index end, exclusive.
+    unsigned end_;
+    /// Radix digit counts of the range, converted to the range's scatter offsets before scattering.
+    unsigned digitCounts_[256];
+};
+
+/// Return a sort key which orders squared distances descending.
+static inline unsigned GetDistanceSortKey(float distanceSquared)
+{
+    // Map negative zero to positive, so that they compare equal
+    if (distanceSquared == 0.0f)
+        distanceSquared = 0.0f;
+
+    // Non-negative floats order as their bits, so inverting the bits orders them descending
+    unsigned bits;
+    memcpy(&bits, &distanceSquared, sizeof bits);
+    return ~bits;
+}
+
+/// Calculate the sort distances and keys of a billboard range.
+static void CalculateSortKeys(BillboardUpdateRange& range)
+{
+    const BillboardUpdateParams& params = *range.params_;
+
+    for (unsigned i = range.start_; i < range.end_; ++i)
+    {
+        Billboard& billboard = *params.billboards_[i];
+        Vector3 worldPos = params.billboardTransform_ * billboard.position_;
+
+        // Same as Camera::GetDistanceSquared(), which can not be called from several threads as it may update the view
+        if (!params.orthographic_)
+            billboard.sortDistance_ = (worldPos - params.cameraPosition_).LengthSquared();
+        else
+        {
+            float distance = (params.cameraView_ * worldPos).z_;
+            billboard.sortDistance_ = distance * distance;
+        }
+
+        params.sortKeys_[i] = GetDistanceSortKey(billboard.sortDistance_);
+    }
+}
+
+/// Count the radix digits of a billboard range for a sort pass.
+static void CountDigits(BillboardUpdateRange& range)
+{
+    const BillboardUpdateParams& params = *range.params_;
+    unsigned shift = params.shift_;
+
+    memset(range.digitCounts_, 0, sizeof range.digitCounts_);
+    for (unsigned i = range.start_; i < range.end_; ++i)
+        ++range.digitCounts_[(params.srcSortKeys_[i] >> shift) & 0xff];
+}
+
+/// Scatter a billboard range to its digits' offsets for a sort pass.
+static void ScatterDigits(BillboardUpdateRange& range)
+{
+    const BillboardUpdateParams& params = *range.params_;
+    unsigned shift = params.shift_;
+
+    for (unsigned i = range.start_; i < range.end_; ++i)
+    {
+        unsigned key = params.srcSortKeys_[i];
+        unsigned index = range.digitCounts_[(key >> shift) & 0xff]++;
+        params.destSortKeys_[index] = key;
+        params.destBillboards_[index] = params.srcBillboards_[i];
+    }
+}
+
+/// Write the vertices of a billboard range.
+static void WriteVertices(BillboardUpdateRange& range)
+{
+    const BillboardUpdateParams& params = *range.params_;
+    const Vector3& billboardScale = params.billboardScale_;
+
+    if (!params.direction_)
+    {
+        float* dest = params.vertexData_ + range.start_ * 32;
+
+        for (unsigned i = range.start_; i < range.end_; ++i)
+        {
+            Billboard& billboard = *params.billboards_[i];
+
+            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
+            unsigned color = billboard.color_.ToUInt();
+            if (params.fixedScreenSize_)
+                size *= billboard.screenScaleFactor_;
+
+            float rotationMatrix[2][2];
+            SinCos(billboard.rotation_, rotationMatrix[0][1], rotationMatrix[0][0]);
+            rotationMatrix[1][0] = -rotationMatrix[0][1];
+            rotationMatrix[1][1] = rotationMatrix[0][0];
+
+            dest[0] = billboard.position_.x_;
+            dest[1] = billboard.position_.y_;
+            dest[2] = billboard.position_.z_;
+            ((unsigned&)dest[3]) = color;
+            dest[4] = billboard.uv_.min_.x_;
+            dest[5] = billboard.uv_.min_.y_;
+            dest[6] = -size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
+            dest[7] = -size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
+
+            dest[8] = billboard.position_.x_;
+            dest[9] = billboard.position_.y_;
+            dest[10] = billboard.position_.z_;
+            ((unsigned&)dest[11]) = color;
+            dest[12] = billboard.uv_.max_.x_;
+            dest[13] = billboard.uv_.min_.y_;
+            dest[14] = size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
+            dest[15] = size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
+
+            dest[16] = billboard.position_.x_;
+            dest[17] = billboard.position_.y_;
+            dest[18] = billboard.position_.z_;
+            ((unsigned&)dest[19]) = color;
+            dest[20] = billboard.uv_.max_.x_;
+            dest[21] = billboard.uv_.max_.y_;
+            dest[22] = size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
+            dest[23] = size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
+
+            dest[24] = billboard.position_.x_;
+            dest[25] = billboard.position_.y_;
+            dest[26] = billboard.position_.z_;
+            ((unsigned&)dest[27]) = color;
+            dest[28] = billboard.uv_.min_.x_;
+            dest[29] = billboard.uv_.max_.y_;
+            dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
+            dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
+
+            dest += 32;
+        }
+    }
+    else
+    {
+        float* dest = params.vertexData_ + range.start_ * 44;
+
+        for (unsigned i = range.start_; i < range.end_; ++i)
+        {
+            Billboard& billboard = *params.billboards_[i];
+
+            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
+            unsigned color = billboard.color_.ToUInt();
+            if (params.fixedScreenSize_)
+                size *= billboard.screenScaleFactor_;
+
+            float rot2D[2][2];
+            SinCos(billboard.rotation_, rot2D[0][1], rot2D[0][0]);
+            rot2D[1][0] = -rot2D[0][1];
+            rot2D[1][1] = rot2D[0][0];
+
+            dest[0] = billboard.position_.x_;
+            dest[1] = billboard.position_.y_;
+            dest[2] = billboard.position_.z_;
+            dest[3] = billboard.direction_.x_;
+            dest[4] = billboard.direction_.y_;
+            dest[5] = billboard.direction_.z_;
+            ((unsigned&)dest[6]) = color;
+            dest[7] = billboard.uv_.min_.x_;
+            dest[8] = billboard.uv_.min_.y_;
+            dest[9] = -size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
+            dest[10] = -size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
+
+            dest[11] = billboard.position_.x_;
+            dest[12] = billboard.position_.y_;
+            dest[13] = billboard.position_.z_;
+            dest[14] = billboard.direction_.x_;
+            dest[15] = billboard.direction_.y_;
+            dest[16] = billboard.direction_.z_;
+            ((unsigned&)dest[17]) = color;
+            dest[18] = billboard.uv_.max_.x_;
+            dest[19] = billboard.uv_.min_.y_;
+            dest[20] = size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
+            dest[21] = size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
+
+            dest[22] = billboard.position_.x_;
+            dest[23] = billboard.position_.y_;
+            dest[24] = billboard.position_.z_;
+            dest[25] = billboard.direction_.x_;
+            dest[26] = billboard.direction_.y_;
+            dest[27] = billboard.direction_.z_;
+            ((unsigned&)dest[28]) = color;
+            dest[29] = billboard.uv_.max_.x_;
+            dest[30] = billboard.uv_.max_.y_;
+            dest[31] = size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
+            dest[32] = size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
+
+            dest[33] = billboard.position_.x_;
+            dest[34] = billboard.position_.y_;
+            dest[35] = billboard.position_.z_;
+            dest[36] = billboard.direction_.x_;
+            dest[37] = billboard.direction_.y_;
+            dest[38] = billboard.direction_.z_;
+            ((unsigned&)dest[39]) = color;
+            dest[40] = billboard.uv_.min_.x_;
+            dest[41] = billboard.uv_.max_.y_;
+            dest[42] = -size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
+            dest[43] = -size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
+
+            dest += 44;
+        }
+    }
+}
+
+/// Billboard range work function.
+static void BillboardRangeWork(const WorkItem* item, unsigned /*threadIndex*/)
 {
-    return lhs->sortDistance_ > rhs->sortDistance_;
+    auto* range = reinterpret_cast<BillboardUpdateRange*>(item->aux_);
+    range->params_->rangeFunction_(*range);
 }
 
+/// Run a function for all billboard ranges and wait for it to finish. A single range is run directly.
+static void RunBillboardWork(WorkQueue* queue, PODVector<BillboardUpdateRange>& ranges, BillboardUpdateParams& params,
+    void (*rangeFunction)(BillboardUpdateRange& range))
+{
+    if (ranges.Size() == 1)
+    {
+        rangeFunction(ranges[0]);
+        return;
+    }
+
+    params.rangeFunction_ = rangeFunction;
+    for (unsigned i = 0; i < ranges.Size(); ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = BillboardRangeWork;
+        item->aux_ = &ranges[i];
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+/// Sort the source billboards by key with a parallel LSD radix sort. Each pass counts the digits of all ranges in parallel,
+/// then scatters all ranges in parallel, each range after the same digits of the ranges before it, which keeps it stable.
+/// Leave the sorted billboards and keys in the source arrays.
+static void ParallelRadixSort(WorkQueue* queue, PODVector<BillboardUpdateRange>& ranges, BillboardUpdateParams& params,
+    unsigned count)
+{
+    for (unsigned shift = 0; shift < 32; shift += 8)
+    {
+        params.shift_ = shift;
+        RunBillboardWork(queue, ranges, params, CountDigits);
+
+        // Skip the pass if all keys have the same digit
+        unsigned firstDigit = (params.srcSortKeys_[0] >> shift) & 0xff;
+        unsigned firstDigitCount = 0;
+        for (unsigned r = 0; r < ranges.Size(); ++r)
+            firstDigitCount += ranges[r].digitCounts_[firstDigit];
+        if (firstDigitCount == count)
+            continue;
+
+        unsigned offset = 0;
+        for (unsigned j = 0; j < 256; ++j)
+        {
+            for (unsigned r = 0; r < ranges.Size(); ++r)
+            {
+                unsigned digitCount = ranges[r].digitCounts_[j];
+                ranges[r].digitCounts_[j] = offset;
+                offset += digitCount;
+            }
+        }
+
+        RunBillboardWork(queue, ranges, params, ScatterDigits);
+        Swap(params.srcBillboards_, params.destBillboards_);
+        Swap(params.srcSortKeys_, params.destSortKeys_);
+    }
+}
+
+
 BillboardSet::BillboardSet(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY),
     animationLodBias_(1.0f),
@@ -470,28 +783,34 @@ const PODVector<unsigned char>& BillboardSet::GetNetBillboardsAttr() const
 
 void BillboardSet::OnWorldBoundingBoxUpdate()
 {
-    unsigned enabledBillboards = 0;
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
-    Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
     Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
-    BoundingBox worldBox;
+    // Accumulate the extents in locals rather than merging a box per billboard, as large particle emitters spend much of
+    // their update here
+    Vector3 minPoint(M_INFINITY, M_INFINITY, M_INFINITY);
+    Vector3 maxPoint(-M_INFINITY, -M_INFINITY, -M_INFINITY);
 
     for (unsigned i = 0; i < billboards_.Size(); ++i)
     {
-        if (!billboards_[i].enabled_)
+        const Billboard& billboard = billboards_[i];
+        if (!billboard.enabled_)
             continue;
 
-        float size = INV_SQRT_TWO * (billboards_[i].size_.x_ * billboardScale.x_ + billboards_[i].size_.y_ * billboardScale.y_);
+        float size = INV_SQRT_TWO * (billboard.size_.x_ * billboardScale.x_ + billboard.size_.y_ * billboardScale.y_);
         if (fixedScreenSize_)
-            size *= billboards_[i].screenScaleFactor_;
-
-        Vector3 center = billboardTransform * billboards_[i].position_;
-        Vector3 edge = Vector3::ONE * size;
-        worldBox.Merge(BoundingBox(center - edge, center + edge));
-
-        ++enabledBillboards;
+            size *= billboard.screenScaleFactor_;
+
+        Vector3 center = relative_ ? worldTransform * billboard.position_ : billboard.position_;
+        minPoint.x_ = Min(minPoint.x_, center.x_ - size);
+        minPoint.y_ = Min(minPoint.y_, center.y_ - size);
+        minPoint.z_ = Min(minPoint.z_, center.z_ - size);
+        maxPoint.x_ = Max(maxPoint.x_, center.x_ + size);
+        maxPoint.y_ = Max(maxPoint.y_, center.y_ + size);
+        maxPoint.z_ = Max(maxPoint.z_, center.z_ + size);
     }
 
+    BoundingBox worldBox(minPoint, maxPoint);
+
     // Always merge the node's own position to ensure particle emitter updates continue when the relative mode is switched
     worldBox.Merge(node_->GetWorldPosition());
 
@@ -593,30 +912,14 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     unsigned numBillboards = billboards_.Size();
     unsigned enabledBillboards = 0;
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
-    Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
-    Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
 
-    // First check number of enabled billboards
+    sortedBillboards_.Resize(numBillboards);
     for (unsigned i = 0; i < numBillboards; ++i)
     {
         if (billboards_[i].enabled_)
-            ++enabledBillboards;
+            sortedBillboards_[enabledBillboards++] = &billboards_[i];
     }
-
     sortedBillboards_.Resize(enabledBillboards);
-    unsigned index = 0;
-
-    // Then set initial sort order and distances
-    for (unsigned i = 0; i < numBillboards; ++i)
-    {
-        Billboard& billboard = billboards_[i];
-        if (billboard.enabled_)
-        {
-            sortedBillboards_[index++] = &billboard;
-            if (sorted_)
-                billboard.sortDistance_ = frame.camera_->GetDistanceSquared(billboardTransform * billboards_[i].position_);
-        }
-    }
 
     batches_[0].geometry_->SetDrawRange(TRIANGLE_LIST, 0, enabledBillboards * 6, false);
 
@@ -625,140 +928,65 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     if (!enabledBillboards)
         return;
 
-    if (sorted_)
+    BillboardUpdateParams params;
+    params.billboards_ = sortedBillboards_.Buffer();
+    params.billboardTransform_ = relative_ ? worldTransform : Matrix3x4::IDENTITY;
+    params.billboardScale_ = scaled_ ? worldTransform.Scale() : Vector3::ONE;
+    params.fixedScreenSize_ = fixedScreenSize_;
+    params.direction_ = faceCameraMode_ == FC_DIRECTION;
+
+    // Split large billboard sets into ranges processed in parallel
+    auto* queue = GetSubsystem<WorkQueue>();
+    unsigned numRanges = Clamp(enabledBillboards / MIN_BILLBOARDS_PER_WORK_ITEM, 1u, queue->GetNumThreads() + 1);
+    PODVector<BillboardUpdateRange> ranges(numRanges);
+    for (unsigned i = 0; i < numRanges; ++i)
     {
-        Sort(sortedBillboards_.Begin(), sortedBillboards_.End(), CompareBillboards);
-        Vector3 worldPos = node_->GetWorldPosition();
-        // Store the "last sorted position" now
-        previousOffset_ = (worldPos - frame.camera_->GetNode()->GetWorldPosition());
+        ranges[i].params_ = &params;
+        ranges[i].start_ = (unsigned)((unsigned long long)enabledBillboards * i / numRanges);
+        ranges[i].end_ = (unsigned)((unsigned long long)enabledBillboards * (i + 1) / numRanges);
     }
 
-    auto* dest = (float*)vertexBuffer_->Lock(0, enabledBillboards * 4, true);
-    if (!dest)
-        return;
-
-    if (faceCameraMode_ != FC_DIRECTION)
+    if (sorted_)
     {
-        for (unsigned i = 0; i < enabledBillboards; ++i)
-        {
-            Billboard& billboard = *sortedBillboards_[i];
-
-            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
-            unsigned color = billboard.color_.ToUInt();
-            if (fixedScreenSize_)
-                size *= billboard.screenScaleFactor_;
+        URHO3D_PROFILE(SortBillboards);
 
-            float rotationMatrix[2][2];
-            SinCos(billboard.rotation_, rotationMatrix[0][1], rotationMatrix[0][0]);
-            rotationMatrix[1][0] = -rotationMatrix[0][1];
-            rotationMatrix[1][1] = rotationMatrix[0][0];
+        sortKeys_.Resize(enabledBillboards);
+        tempSortKeys_.Resize(enabledBillboards);
+        tempSortedBillboards_.Resize(enabledBillboards);
 
-            dest[0] = billboard.position_.x_;
-            dest[1] = billboard.position_.y_;
-            dest[2] = billboard.position_.z_;
-            ((unsigned&)dest[3]) = color;
-            dest[4] = billboard.uv_.min_.x_;
-            dest[5] = billboard.uv_.min_.y_;
-            dest[6] = -size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-            dest[7] = -size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
+        Camera* camera = frame.camera_;
+        params.sortKeys_ = sortKeys_.Buffer();
+        params.orthographic_ = camera->IsOrthographic();
+        params.cameraView_ = params.orthographic_ ? camera->GetView() : Matrix3x4::IDENTITY;
+        params.cameraPosition_ = camera->GetNode() ? camera->GetNode()->GetWorldPosition() : Vector3::ZERO;
 
-            dest[8] = billboard.position_.x_;
-            dest[9] = billboard.position_.y_;
-            dest[10] = billboard.position_.z_;
-            ((unsigned&)dest[11]) = color;
-            dest[12] = billboard.uv_.max_.x_;
-            dest[13] = billboard.uv_.min_.y_;
-            dest[14] = size.x_ * rotationMatrix[0][0] + size.y_ * rotationMatrix[0][1];
-            dest[15] = size.x_ * rotationMatrix[1][0] + size.y_ * rotationMatrix[1][1];
-
-            dest[16] = billboard.position_.x_;
-            dest[17] = billboard.position_.y_;
-            dest[18] = billboard.position_.z_;
-            ((unsigned&)dest[19]) = color;
-            dest[20] = billboard.uv_.max_.x_;
-            dest[21] = billboard.uv_.max_.y_;
-            dest[22] = size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-            dest[23] = size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-
-            dest[24] = billboard.position_.x_;
-            dest[25] = billboard.position_.y_;
-            dest[26] = billboard.position_.z_;
-            ((unsigned&)dest[27]) = color;
-            dest[28] = billboard.uv_.min_.x_;
-            dest[29] = billboard.uv_.max_.y_;
-            dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
-            dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
-
-            dest += 32;
+        RunBillboardWork(queue, ranges, params, CalculateSortKeys);
+        if (numRanges > 1)
+        {
+            params.srcBillboards_ = sortedBillboards_.Buffer();
+            params.srcSortKeys_ = sortKeys_.Buffer();
+            params.destBillboards_ = tempSortedBillboards_.Buffer();
+            params.destSortKeys_ = tempSortKeys_.Buffer();
+            ParallelRadixSort(queue, ranges, params, enabledBillboards);
+            params.billboards_ = params.srcBillboards_;
         }
-    }
-    else
-    {
-        for (unsigned i = 0; i < enabledBillboards; ++i)
+        else
         {
-            Billboard& billboard = *sortedBillboards_[i];
-
-            Vector2 size(billboard.size_.x_ * billboardScale.x_, billboard.size_.y_ * billboardScale.y_);
-            unsigned color = billboard.color_.ToUInt();
-            if (fixedScreenSize_)
-                size *= billboard.screenScaleFactor_;
-
-            float rot2D[2][2];
-            SinCos(billboard.rotation_, rot2D[0][1], rot2D[0][0]);
-            rot2D[1][0] = -rot2D[0][1];
-            rot2D[1][1] = rot2D[0][0];
-
-            dest[0] = billboard.position_.x_;
-            dest[1] = billboard.position_.y_;
-            dest[2] = billboard.position_.z_;
-            dest[3] = billboard.direction_.x_;
-            dest[4] = billboard.direction_.y_;
-            dest[5] = billboard.direction_.z_;
-            ((unsigned&)dest[6]) = color;
-            dest[7] = billboard.uv_.min_.x_;
-            dest[8] = billboard.uv_.min_.y_;
-            dest[9] = -size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
-            dest[10] = -size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
-
-            dest[11] = billboard.position_.x_;
-            dest[12] = billboard.position_.y_;
-            dest[13] = billboard.position_.z_;
-            dest[14] = billboard.direction_.x_;
-            dest[15] = billboard.direction_.y_;
-            dest[16] = billboard.direction_.z_;
-            ((unsigned&)dest[17]) = color;
-            dest[18] = billboard.uv_.max_.x_;
-            dest[19] = billboard.uv_.min_.y_;
-            dest[20] = size.x_ * rot2D[0][0] + size.y_ * rot2D[0][1];
-            dest[21] = size.x_ * rot2D[1][0] + size.y_ * rot2D[1][1];
+            RadixSort(sortKeys_.Buffer(), sortedBillboards_.Buffer(), enabledBillboards, tempSortKeys_.Buffer(),
+                tempSortedBillboards_.Buffer());
+        }
 
-            dest[22] = billboard.position_.x_;
-            dest[23] = billboard.position_.y_;
-            dest[24] = billboard.position_.z_;
-            dest[25] = billboard.direction_.x_;
-            dest[26] = billboard.direction_.y_;
-            dest[27] = billboard.direction_.z_;
-            ((unsigned&)dest[28]) = color;
-            dest[29] = billboard.uv_.max_.x_;
-            dest[30] = billboard.uv_.max_.y_;
-            dest[31] = size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
-            dest[32] = size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
+        Vector3 worldPos = node_->GetWorldPosition();
+        // Store the "last sorted position" now
+        previousOffset_ = (worldPos - frame.camera_->GetNode()->GetWorldPosition());
+    }
 
-            dest[33] = billboard.position_.x_;
-            dest[34] = billboard.position_.y_;
-            dest[35] = billboard.position_.z_;
-            dest[36] = billboard.direction_.x_;
-            dest[37] = billboard.direction_.y_;
-            dest[38] = billboard.direction_.z_;
-            ((unsigned&)dest[39]) = color;
-            dest[40] = billboard.uv_.min_.x_;
-            dest[41] = billboard.uv_.max_.y_;
-            dest[42] = -size.x_ * rot2D[0][0] - size.y_ * rot2D[0][1];
-            dest[43] = -size.x_ * rot2D[1][0] - size.y_ * rot2D[1][1];
+    params.vertexData_ = (float*)vertexBuffer_->Lock(0, enabledBillboards * 4, true);
+    if (!params.vertexData_)
+        return;
 
-            dest += 44;
-        }
-    }
+    // The ranges write disjoint parts of the locked vertex data
+    RunBillboardWork(queue, ranges, params, WriteVertices);
 
     vertexBuffer_->Unlock();
     vertexBuffer_->ClearDataLost();
@@ -204,7 +204,13 @@ private:
     /// Previous offset to camera for determining whether sorting is necessary.
     Vector3 previousOffset_;
     /// Billboard pointers for sorting.
-    Vector<Billboard*> sortedBillboards_;
+    PODVector<Billboard*> sortedBillboards_;
+    /// Temporary billboard pointers for sorting.
+    PODVector<Billboard*> tempSortedBillboards_;
+    /// Billboard sort keys.
+    PODVector<unsigned> sortKeys_;
+    /// Temporary billboard sort keys.
+    PODVector<unsigned> tempSortKeys_;
     /// Attribute buffer for network replication.
     mutable VectorBuffer attrBuffer_;
 };
@@ -24,6 +24,7 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DrawableEvents.h"
 #include "../Graphics/ParticleEffect.h"
 #include "../Graphics/ParticleEmitter.h"
@@ -32,6 +33,10 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -40,9 +45,287 @@ namespace Urho3D
 extern const char* GEOMETRY_CATEGORY;
 extern const char* faceCameraModeNames[];
 static const unsigned MAX_PARTICLES_IN_FRAME = 100;
+/// Minimum number of particles updated per work item.
+static const unsigned MIN_PARTICLES_PER_WORK_ITEM = 4096;
+/// Number of particles updated per block, first in the particle arrays and then in the billboards.
+static const unsigned PARTICLE_BLOCK_SIZE = 64;
 
 extern const char* autoRemoveModeNames[];
 
+/// Per-frame particle update values, resolved from the particle effect once instead of per particle.
+struct ParticleUpdateParams
+{
+    /// Timestep.
+    float timeStep_;
+    /// Constant force in the space of the billboards.
+    Vector3 constantForce_;
+    /// Damping force.
+    float dampingForce_;
+    /// Scale of the position update.
+    Vector3 scaleVector_;
+    /// Size add per second.
+    float sizeAdd_;
+    /// Size multiplier applied during the timestep.
+    float sizeMulStep_;
+    /// Color frames.
+    const Vector<ColorFrame>* colorFrames_;
+    /// Texture frames.
+    const Vector<TextureFrame>* textureFrames_;
+    /// Whether constant force is applied.
+    bool constantForceEnabled_;
+    /// Whether damping is applied.
+    bool dampingEnabled_;
+    /// Whether the size is animated.
+    bool scalingEnabled_;
+    /// Whether the size multiplier is applied.
+    bool sizeMulEnabled_;
+};
+
+/// Particle index range updated by one work item.
+struct ParticleUpdateRange
+{
+    /// Particles.
+    ParticleData* particles_;
+    /// Billboards.
+    Billboard* billboards_;
+    /// Update values.
+    const ParticleUpdateParams* params_;
+    /// Start index.
+    unsigned start_;
+    /// End index.
+    unsigned end_;
+    /// Whether any particle in the range was active.
+    bool active_;
+};
+
+#ifdef URHO3D_SSE
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+/// Update a range of particles and their billboards. Return true if any particle was active.
+static bool UpdateParticleRange(ParticleData& particles, Billboard* billboards, const ParticleUpdateParams& params,
+    unsigned start, unsigned end)
+{
+    float* velocityX = particles.velocityX_.Buffer();
+    float* velocityY = particles.velocityY_.Buffer();
+    float* velocityZ = particles.velocityZ_.Buffer();
+    float* timer = particles.timer_.Buffer();
+    float* scale = particles.scale_.Buffer();
+    const float* sizeX = particles.sizeX_.Buffer();
+    const float* sizeY = particles.sizeY_.Buffer();
+    const float* timeToLive = particles.timeToLive_.Buffer();
+    const float* rotationSpeed = particles.rotationSpeed_.Buffer();
+    unsigned* colorIndices = particles.colorIndex_.Buffer();
+    unsigned* texIndices = particles.texIndex_.Buffer();
+    const Vector<ColorFrame>& colorFrames = *params.colorFrames_;
+    const Vector<TextureFrame>& textureFrames = *params.textureFrames_;
+    const float timeStep = params.timeStep_;
+    const Vector3& force = params.constantForce_;
+    const Vector3& scaleVector = params.scaleVector_;
+    const float negDamping = -params.dampingForce_;
+    bool active = false;
+
+    // Alive flags, position changes and directions of a block are calculated from the particle arrays before writing the
+    // billboards
+    bool alive[PARTICLE_BLOCK_SIZE];
+    float deltaX[PARTICLE_BLOCK_SIZE];
+    float deltaY[PARTICLE_BLOCK_SIZE];
+    float deltaZ[PARTICLE_BLOCK_SIZE];
+    float directionX[PARTICLE_BLOCK_SIZE];
+    float directionY[PARTICLE_BLOCK_SIZE];
+    float directionZ[PARTICLE_BLOCK_SIZE];
+
+    for (unsigned blockStart = start; blockStart < end; blockStart += PARTICLE_BLOCK_SIZE)
+    {
+        unsigned blockEnd = Min(blockStart + PARTICLE_BLOCK_SIZE, end);
+        unsigned i = blockStart;
+
+#ifdef URHO3D_SSE
+        const __m128 dt = _mm_set1_ps(timeStep);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 epsilon = _mm_set1_ps(std::numeric_limits<float>::epsilon());
+        for (; i + 4 <= blockEnd; i += 4)
+        {
+            unsigned j = i - blockStart;
+            const Billboard* b = billboards + i;
+            __m128 enabled = _mm_castsi128_ps(_mm_setr_epi32(-(int)b[0].enabled_, -(int)b[1].enabled_, -(int)b[2].enabled_,
+                -(int)b[3].enabled_));
+            __m128 t = _mm_loadu_ps(timer + i);
+            __m128 mask = _mm_and_ps(enabled, _mm_cmpnge_ps(t, _mm_loadu_ps(timeToLive + i)));
+            int aliveBits = _mm_movemask_ps(mask);
+            active |= _mm_movemask_ps(enabled) != 0;
+            alive[j] = (aliveBits & 1) != 0;
+            alive[j + 1] = (aliveBits & 2) != 0;
+            alive[j + 2] = (aliveBits & 4) != 0;
+            alive[j + 3] = (aliveBits & 8) != 0;
+            if (!aliveBits)
+                continue;
+
+            _mm_storeu_ps(timer + i, Select(mask, _mm_add_ps(t, dt), t));
+
+            __m128 vx = _mm_loadu_ps(velocityX + i);
+            __m128 vy = _mm_loadu_ps(velocityY + i);
+            __m128 vz = _mm_loadu_ps(velocityZ + i);
+            __m128 newVx = vx;
+            __m128 newVy = vy;
+            __m128 newVz = vz;
+            if (params.constantForceEnabled_)
+            {
+                newVx = _mm_add_ps(newVx, _mm_mul_ps(dt, _mm_set1_ps(force.x_)));
+                newVy = _mm_add_ps(newVy, _mm_mul_ps(dt, _mm_set1_ps(force.y_)));
+                newVz = _mm_add_ps(newVz, _mm_mul_ps(dt, _mm_set1_ps(force.z_)));
+            }
+            if (params.dampingEnabled_)
+            {
+                __m128 d = _mm_set1_ps(negDamping);
+                newVx = _mm_add_ps(newVx, _mm_mul_ps(dt, _mm_mul_ps(d, newVx)));
+                newVy = _mm_add_ps(newVy, _mm_mul_ps(dt, _mm_mul_ps(d, newVy)));
+                newVz = _mm_add_ps(newVz, _mm_mul_ps(dt, _mm_mul_ps(d, newVz)));
+            }
+            _mm_storeu_ps(velocityX + i, Select(mask, newVx, vx));
+            _mm_storeu_ps(velocityY + i, Select(mask, newVy, vy));
+            _mm_storeu_ps(velocityZ + i, Select(mask, newVz, vz));
+            _mm_storeu_ps(deltaX + j, _mm_mul_ps(_mm_mul_ps(dt, newVx), _mm_set1_ps(scaleVector.x_)));
+            _mm_storeu_ps(deltaY + j, _mm_mul_ps(_mm_mul_ps(dt, newVy), _mm_set1_ps(scaleVector.y_)));
+            _mm_storeu_ps(deltaZ + j, _mm_mul_ps(_mm_mul_ps(dt, newVz), _mm_set1_ps(scaleVector.z_)));
+
+            // Normalize as Vector3::Normalized() does, leaving unit length and zero vectors as is
+            __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(newVx, newVx), _mm_mul_ps(newVy, newVy)),
+                _mm_mul_ps(newVz, newVz));
+            __m128 unitLength = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(lengthSquared, epsilon), one),
+                _mm_cmple_ps(_mm_sub_ps(lengthSquared, epsilon), one));
+            __m128 normalize = _mm_andnot_ps(unitLength, _mm_cmpgt_ps(lengthSquared, zero));
+            __m128 invLength = Select(normalize, _mm_div_ps(one, _mm_sqrt_ps(lengthSquared)), one);
+            _mm_storeu_ps(directionX + j, Select(normalize, _mm_mul_ps(newVx, invLength), newVx));
+            _mm_storeu_ps(directionY + j, Select(normalize, _mm_mul_ps(newVy, invLength), newVy));
+            _mm_storeu_ps(directionZ + j, Select(normalize, _mm_mul_ps(newVz, invLength), newVz));
+
+            if (params.scalingEnabled_)
+            {
+                __m128 s = _mm_loadu_ps(scale + i);
+                // Max with zero as the first operand keeps NaN and negative zero as the scalar comparison does
+                __m128 newS = _mm_max_ps(zero, _mm_add_ps(s, _mm_mul_ps(dt, _mm_set1_ps(params.sizeAdd_))));
+                if (params.sizeMulEnabled_)
+                    newS = _mm_mul_ps(newS, _mm_set1_ps(params.sizeMulStep_));
+                _mm_storeu_ps(scale + i, Select(mask, newS, s));
+            }
+        }
+#endif
+
+        for (; i < blockEnd; ++i)
+        {
+            unsigned j = i - blockStart;
+            bool enabled = billboards[i].enabled_;
+            active |= enabled;
+            alive[j] = enabled && !(timer[i] >= timeToLive[i]);
+            if (!alive[j])
+                continue;
+
+            timer[i] += timeStep;
+
+            if (params.constantForceEnabled_)
+            {
+                velocityX[i] += timeStep * force.x_;
+                velocityY[i] += timeStep * force.y_;
+                velocityZ[i] += timeStep * force.z_;
+            }
+            if (params.dampingEnabled_)
+            {
+                velocityX[i] += timeStep * (negDamping * velocityX[i]);
+                velocityY[i] += timeStep * (negDamping * velocityY[i]);
+                velocityZ[i] += timeStep * (negDamping * velocityZ[i]);
+            }
+            deltaX[j] = timeStep * velocityX[i] * scaleVector.x_;
+            deltaY[j] = timeStep * velocityY[i] * scaleVector.y_;
+            deltaZ[j] = timeStep * velocityZ[i] * scaleVector.z_;
+
+            Vector3 direction = Vector3(velocityX[i], velocityY[i], velocityZ[i]).Normalized();
+            directionX[j] = direction.x_;
+            directionY[j] = direction.y_;
+            directionZ[j] = direction.z_;
+
+            if (params.scalingEnabled_)
+            {
+                scale[i] += timeStep * params.sizeAdd_;
+                if (scale[i] < 0.0f)
+                    scale[i] = 0.0f;
+                if (params.sizeMulEnabled_)
+                    scale[i] *= params.sizeMulStep_;
+            }
+        }
+
+        for (i = blockStart; i < blockEnd; ++i)
+        {
+            unsigned j = i - blockStart;
+            Billboard& billboard = billboards[i];
+            if (!alive[j])
+            {
+                billboard.enabled_ = false;
+                continue;
+            }
+
+            billboard.position_ += Vector3(deltaX[j], deltaY[j], deltaZ[j]);
+            billboard.direction_ = Vector3(directionX[j], directionY[j], directionZ[j]);
+            billboard.rotation_ += timeStep * rotationSpeed[i];
+            if (params.scalingEnabled_)
+                billboard.size_ = Vector2(sizeX[i], sizeY[i]) * scale[i];
+
+            // Color interpolation
+            unsigned& index = colorIndices[i];
+            if (index < colorFrames.Size())
+            {
+                if (index < colorFrames.Size() - 1)
+                {
+                    if (timer[i] >= colorFrames[index + 1].time_)
+                        ++index;
+                }
+                if (index < colorFrames.Size() - 1)
+                    billboard.color_ = colorFrames[index].Interpolate(colorFrames[index + 1], timer[i]);
+                else
+                    billboard.color_ = colorFrames[index].color_;
+            }
+
+            // Texture animation
+            unsigned& texIndex = texIndices[i];
+            if (textureFrames.Size() && texIndex < textureFrames.Size() - 1)
+            {
+                if (timer[i] >= textureFrames[texIndex + 1].time_)
+                {
+                    billboard.uv_ = textureFrames[texIndex + 1].uv_;
+                    ++texIndex;
+                }
+            }
+        }
+    }
+
+    return active;
+}
+
+static void UpdateParticlesWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* range = reinterpret_cast<ParticleUpdateRange*>(item->aux_);
+    range->active_ = UpdateParticleRange(*range->particles_, range->billboards_, *range->params_, range->start_, range->end_);
+}
+
+void ParticleData::Resize(unsigned num)
+{
+    velocityX_.Resize(num);
+    velocityY_.Resize(num);
+    velocityZ_.Resize(num);
+    sizeX_.Resize(num);
+    sizeY_.Resize(num);
+    timer_.Resize(num);
+    timeToLive_.Resize(num);
+    scale_.Resize(num);
+    rotationSpeed_.Resize(num);
+    colorIndex_.Resize(num);
+    texIndex_.Resize(num);
+}
+
 ParticleEmitter::ParticleEmitter(Context* context) :
     BillboardSet(context),
     periodTimer_(0.0f),
@@ -51,6 +334,8 @@ ParticleEmitter::ParticleEmitter(Context* context) :
     lastUpdateFrameNumber_(M_MAX_UNSIGNED),
     emitting_(true),
     needUpdate_(false),
+    threadedUpdatePending_(false),
+    threadedUpdateCommit_(false),
     serializeParticles_(true),
     sendFinishedEvent_(true),
     autoRemove_(REMOVE_DISABLED)
@@ -92,9 +377,16 @@ void ParticleEmitter::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
+        {
             SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleEmitter, HandleScenePostUpdate));
+            SubscribeToEvent(scene, E_SCENEDRAWABLEUPDATEFINISHED,
+                URHO3D_HANDLER(ParticleEmitter, HandleSceneDrawableUpdateFinished));
+        }
         else
+        {
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
+            UnsubscribeFromEvent(scene, E_SCENEDRAWABLEUPDATEFINISHED);
+        }
     }
 }
 
@@ -165,99 +457,81 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         }
     }
 
-    // Update existing particles
-    Vector3 relativeConstantForce = node_->GetWorldRotation().Inverse() * effect_->GetConstantForce();
-    // If billboards are not relative, apply scaling to the position update
-    Vector3 scaleVector = Vector3::ONE;
-    if (scaled_ && !relative_)
-        scaleVector = node_->GetWorldScale();
-
-    for (unsigned i = 0; i < particles_.Size(); ++i)
+    // Update existing particles. Large emitters are updated in parallel once all drawables have been updated, as the
+    // work queue can only be used from the main thread
+    auto* queue = GetSubsystem<WorkQueue>();
+    if (particles_.Size() >= MIN_PARTICLES_PER_WORK_ITEM * 2 && queue && queue->GetNumThreads())
     {
-        Particle& particle = particles_[i];
-        Billboard& billboard = billboards_[i];
-
-        if (billboard.enabled_)
-        {
-            needCommit = true;
-
-            // Time to live
-            if (particle.timer_ >= particle.timeToLive_)
-            {
-                billboard.enabled_ = false;
-                continue;
-            }
-            particle.timer_ += lastTimeStep_;
-
-            // Velocity & position
-            const Vector3& constantForce = effect_->GetConstantForce();
-            if (constantForce != Vector3::ZERO)
-            {
-                if (relative_)
-                    particle.velocity_ += lastTimeStep_ * relativeConstantForce;
-                else
-                    particle.velocity_ += lastTimeStep_ * constantForce;
-            }
-
-            float dampingForce = effect_->GetDampingForce();
-            if (dampingForce != 0.0f)
-            {
-                Vector3 force = -dampingForce * particle.velocity_;
-                particle.velocity_ += lastTimeStep_ * force;
-            }
-            billboard.position_ += lastTimeStep_ * particle.velocity_ * scaleVector;
-            billboard.direction_ = particle.velocity_.Normalized();
+        threadedUpdatePending_ = true;
+        threadedUpdateCommit_ = needCommit;
+        needUpdate_ = false;
+        return;
+    }
 
-            // Rotation
-            billboard.rotation_ += lastTimeStep_ * particle.rotationSpeed_;
+    if (UpdateParticles(false))
+        needCommit = true;
 
-            // Scaling
-            float sizeAdd = effect_->GetSizeAdd();
-            float sizeMul = effect_->GetSizeMul();
-            if (sizeAdd != 0.0f || sizeMul != 1.0f)
-            {
-                particle.scale_ += lastTimeStep_ * sizeAdd;
-                if (particle.scale_ < 0.0f)
-                    particle.scale_ = 0.0f;
-                if (sizeMul != 1.0f)
-                    particle.scale_ *= (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
-                billboard.size_ = particle.size_ * particle.scale_;
-            }
+    if (needCommit)
+        Commit();
 
-            // Color interpolation
-            unsigned& index = particle.colorIndex_;
-            const Vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
-            if (index < colorFrames_.Size())
-            {
-                if (index < colorFrames_.Size() - 1)
-                {
-                    if (particle.timer_ >= colorFrames_[index + 1].time_)
-                        ++index;
-                }
-                if (index < colorFrames_.Size() - 1)
-                    billboard.color_ = colorFrames_[index].Interpolate(colorFrames_[index + 1], particle.timer_);
-                else
-                    billboard.color_ = colorFrames_[index].color_;
-            }
+    needUpdate_ = false;
+}
 
-            // Texture animation
-            unsigned& texIndex = particle.texIndex_;
-            const Vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
-            if (textureFrames_.Size() && texIndex < textureFrames_.Size() - 1)
-            {
-                if (particle.timer_ >= textureFrames_[texIndex + 1].time_)
-                {
-                    billboard.uv_ = textureFrames_[texIndex + 1].uv_;
-                    ++texIndex;
-                }
-            }
-        }
+bool ParticleEmitter::UpdateParticles(bool threaded)
+{
+    ParticleUpdateParams params;
+    params.timeStep_ = lastTimeStep_;
+    const Vector3& constantForce = effect_->GetConstantForce();
+    params.constantForceEnabled_ = constantForce != Vector3::ZERO;
+    params.constantForce_ = relative_ ? node_->GetWorldRotation().Inverse() * constantForce : constantForce;
+    params.dampingForce_ = effect_->GetDampingForce();
+    params.dampingEnabled_ = params.dampingForce_ != 0.0f;
+    // If billboards are not relative, apply scaling to the position update
+    params.scaleVector_ = scaled_ && !relative_ ? node_->GetWorldScale() : Vector3::ONE;
+    params.sizeAdd_ = effect_->GetSizeAdd();
+    float sizeMul = effect_->GetSizeMul();
+    params.sizeMulStep_ = (lastTimeStep_ * (sizeMul - 1.0f)) + 1.0f;
+    params.sizeMulEnabled_ = sizeMul != 1.0f;
+    params.scalingEnabled_ = params.sizeAdd_ != 0.0f || params.sizeMulEnabled_;
+    params.colorFrames_ = &effect_->GetColorFrames();
+    params.textureFrames_ = &effect_->GetTextureFrames();
+
+    unsigned numParticles = Min(particles_.Size(), billboards_.Size());
+    if (!threaded)
+        return UpdateParticleRange(particles_, billboards_.Buffer(), params, 0, numParticles);
+
+    URHO3D_PROFILE(UpdateParticles);
+
+    // Split into whole blocks so that the work items do not share cache lines of the particle arrays
+    auto* queue = GetSubsystem<WorkQueue>();
+    unsigned numWorkItems = Clamp(numParticles / MIN_PARTICLES_PER_WORK_ITEM, 1U, queue->GetNumThreads() + 1);
+    unsigned particlesPerItem = (numParticles + numWorkItems - 1) / numWorkItems;
+    particlesPerItem = (particlesPerItem + PARTICLE_BLOCK_SIZE - 1) / PARTICLE_BLOCK_SIZE * PARTICLE_BLOCK_SIZE;
+
+    PODVector<ParticleUpdateRange> ranges(numWorkItems);
+    for (unsigned i = 0; i < numWorkItems; ++i)
+    {
+        ParticleUpdateRange& range = ranges[i];
+        range.particles_ = &particles_;
+        range.billboards_ = billboards_.Buffer();
+        range.params_ = &params;
+        range.start_ = Min(i * particlesPerItem, numParticles);
+        range.end_ = Min(range.start_ + particlesPerItem, numParticles);
+        range.active_ = false;
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = UpdateParticlesWork;
+        item->aux_ = &range;
+        queue->AddWorkItem(item);
     }
 
-    if (needCommit)
-        Commit();
+    queue->Complete(M_MAX_UNSIGNED);
 
-    needUpdate_ = false;
+    bool active = false;
+    for (unsigned i = 0; i < numWorkItems; ++i)
+        active |= ranges[i].active_;
+    return active;
 }
 
 void ParticleEmitter::SetEffect(ParticleEffect* effect)
@@ -371,16 +645,21 @@ void ParticleEmitter::SetParticlesAttr(const VariantVector& value)
     unsigned index = 0;
     SetNumParticles(index < value.Size() ? value[index++].GetUInt() : 0);
 
-    for (PODVector<Particle>::Iterator i = particles_.Begin(); i != particles_.End() && index < value.Size(); ++i)
+    for (unsigned i = 0; i < particles_.Size() && index < value.Size(); ++i)
     {
-        i->velocity_ = value[index++].GetVector3();
-        i->size_ = value[index++].GetVector2();
-        i->timer_ = value[index++].GetFloat();
-        i->timeToLive_ = value[index++].GetFloat();
-        i->scale_ = value[index++].GetFloat();
-        i->rotationSpeed_ = value[index++].GetFloat();
-        i->colorIndex_ = (unsigned)value[index++].GetInt();
-        i->texIndex_ = (unsigned)value[index++].GetInt();
+        const Vector3& velocity = value[index++].GetVector3();
+        particles_.velocityX_[i] = velocity.x_;
+        particles_.velocityY_[i] = velocity.y_;
+        particles_.velocityZ_[i] = velocity.z_;
+        const Vector2& size = value[index++].GetVector2();
+        particles_.sizeX_[i] = size.x_;
+        particles_.sizeY_[i] = size.y_;
+        particles_.timer_[i] = value[index++].GetFloat();
+        particles_.timeToLive_[i] = value[index++].GetFloat();
+        particles_.scale_[i] = value[index++].GetFloat();
+        particles_.rotationSpeed_[i] = value[index++].GetFloat();
+        particles_.colorIndex_[i] = (unsigned)value[index++].GetInt();
+        particles_.texIndex_[i] = (unsigned)value[index++].GetInt();
     }
 }
 
@@ -395,16 +674,16 @@ VariantVector ParticleEmitter::GetParticlesAttr() const
 
     ret.Reserve(particles_.Size() * 8 + 1);
     ret.Push(particles_.Size());
-    for (PODVector<Particle>::ConstIterator i = particles_.Begin(); i != particles_.End(); ++i)
+    for (unsigned i = 0; i < particles_.Size(); ++i)
     {
-        ret.Push(i->velocity_);
-        ret.Push(i->size_);
-        ret.Push(i->timer_);
-        ret.Push(i->timeToLive_);
-        ret.Push(i->scale_);
-        ret.Push(i->rotationSpeed_);
-        ret.Push(i->colorIndex_);
-        ret.Push(i->texIndex_);
+        ret.Push(Vector3(particles_.velocityX_[i], particles_.velocityY_[i], particles_.velocityZ_[i]));
+        ret.Push(Vector2(particles_.sizeX_[i], particles_.sizeY_[i]));
+        ret.Push(particles_.timer_[i]);
+        ret.Push(particles_.timeToLive_[i]);
+        ret.Push(particles_.scale_[i]);
+        ret.Push(particles_.rotationSpeed_[i]);
+        ret.Push(particles_.colorIndex_[i]);
+        ret.Push(particles_.texIndex_[i]);
     }
     return ret;
 }
@@ -440,9 +719,16 @@ void ParticleEmitter::OnSceneSet(Scene* scene)
     BillboardSet::OnSceneSet(scene);
 
     if (scene && IsEnabledEffective())
+    {
         SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleEmitter, HandleScenePostUpdate));
+        SubscribeToEvent(scene, E_SCENEDRAWABLEUPDATEFINISHED,
+            URHO3D_HANDLER(ParticleEmitter, HandleSceneDrawableUpdateFinished));
+    }
     else if (!scene)
-         UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+    {
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        UnsubscribeFromEvent(E_SCENEDRAWABLEUPDATEFINISHED);
+    }
 }
 
 bool ParticleEmitter::EmitNewParticle()
@@ -451,7 +737,6 @@ bool ParticleEmitter::EmitNewParticle()
     if (index == M_MAX_UNSIGNED)
         return false;
     assert(index < particles_.Size());
-    Particle& particle = particles_[index];
     Billboard& billboard = billboards_[index];
 
     Vector3 startDir;
@@ -513,17 +798,19 @@ bool ParticleEmitter::EmitNewParticle()
         break;
     }
 
-    particle.size_ = effect_->GetRandomSize();
-    particle.timer_ = 0.0f;
-    particle.timeToLive_ = effect_->GetRandomTimeToLive();
-    particle.scale_ = 1.0f;
-    particle.rotationSpeed_ = effect_->GetRandomRotationSpeed();
-    particle.colorIndex_ = 0;
-    particle.texIndex_ = 0;
+    Vector2 size = effect_->GetRandomSize();
+    particles_.sizeX_[index] = size.x_;
+    particles_.sizeY_[index] = size.y_;
+    particles_.timer_[index] = 0.0f;
+    particles_.timeToLive_[index] = effect_->GetRandomTimeToLive();
+    particles_.scale_[index] = 1.0f;
+    particles_.rotationSpeed_[index] = effect_->GetRandomRotationSpeed();
+    particles_.colorIndex_[index] = 0;
+    particles_.texIndex_[index] = 0;
 
     if (faceCameraMode_ == FC_DIRECTION)
     {
-        startPos += startDir * particle.size_.y_;
+        startPos += startDir * size.y_;
     }
 
     if (!relative_)
@@ -532,10 +819,13 @@ bool ParticleEmitter::EmitNewParticle()
         startDir = node_->GetWorldRotation() * startDir;
     };
 
-    particle.velocity_ = effect_->GetRandomVelocity() * startDir;
+    Vector3 velocity = effect_->GetRandomVelocity() * startDir;
+    particles_.velocityX_[index] = velocity.x_;
+    particles_.velocityY_[index] = velocity.y_;
+    particles_.velocityZ_[index] = velocity.z_;
 
     billboard.position_ = startPos;
-    billboard.size_ = particles_[index].size_;
+    billboard.size_ = size;
     const Vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
     billboard.uv_ = textureFrames_.Size() ? textureFrames_[0].uv_ : Rect::POSITIVE;
     billboard.rotation_ = effect_->GetRandomRotation();
@@ -610,6 +900,16 @@ void ParticleEmitter::HandleScenePostUpdate(StringHash eventType, VariantMap& ev
     }
 }
 
+void ParticleEmitter::HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData)
+{
+    if (!threadedUpdatePending_)
+        return;
+
+    threadedUpdatePending_ = false;
+    if (effect_ && (UpdateParticles(true) || threadedUpdateCommit_))
+        Commit();
+}
+
 void ParticleEmitter::HandleEffectReloadFinished(StringHash eventType, VariantMap& eventData)
 {
     // When particle effect file is live-edited, remove existing particles and reapply the effect parameters
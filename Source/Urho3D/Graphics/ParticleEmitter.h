@@ -29,25 +29,38 @@ namespace Urho3D
 
 class ParticleEffect;
 
-/// One particle in the particle system.
-struct Particle
+/// Particles of a particle emitter, stored as a structure of arrays so that several particles can be updated at once.
+/// Indices match the billboards of the emitter.
+struct URHO3D_API ParticleData
 {
-    /// Velocity.
-    Vector3 velocity_;
-    /// Original billboard size.
-    Vector2 size_;
+    /// Resize all arrays.
+    void Resize(unsigned num);
+
+    /// Return number of particles.
+    unsigned Size() const { return timer_.Size(); }
+
+    /// Velocity X.
+    PODVector<float> velocityX_;
+    /// Velocity Y.
+    PODVector<float> velocityY_;
+    /// Velocity Z.
+    PODVector<float> velocityZ_;
+    /// Original billboard width.
+    PODVector<float> sizeX_;
+    /// Original billboard height.
+    PODVector<float> sizeY_;
     /// Time elapsed from creation.
-    float timer_;
+    PODVector<float> timer_;
     /// Lifetime.
-    float timeToLive_;
+    PODVector<float> timeToLive_;
     /// Size scaling value.
-    float scale_;
+    PODVector<float> scale_;
     /// Rotation speed.
-    float rotationSpeed_;
+    PODVector<float> rotationSpeed_;
     /// Current color animation index.
-    unsigned colorIndex_;
+    PODVector<unsigned> colorIndex_;
     /// Current texture animation index.
-    unsigned texIndex_;
+    PODVector<unsigned> texIndex_;
 };
 
 /// %Particle emitter component.
@@ -123,17 +136,21 @@ protected:
     unsigned GetFreeParticle() const;
     /// Return whether has active particles.
     bool CheckActiveParticles() const;
+    /// Update the existing particles and their billboards, on the work queue if threaded. Return true if any particle was active.
+    bool UpdateParticles(bool threaded);
 
 private:
     /// Handle scene post-update event.
     void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle scene drawable update finished event. Update particles which were left to be updated in parallel.
+    void HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData);
     /// Handle live reload of the particle effect.
     void HandleEffectReloadFinished(StringHash eventType, VariantMap& eventData);
 
     /// Particle effect.
     SharedPtr<ParticleEffect> effect_;
     /// Particles.
-    PODVector<Particle> particles_;
+    ParticleData particles_;
     /// Active/inactive period timer.
     float periodTimer_;
     /// New particle emission timer.
@@ -146,6 +163,10 @@ private:
     bool emitting_;
     /// Need update flag.
     bool needUpdate_;
+    /// Threaded particle update pending flag.
+    bool threadedUpdatePending_;
+    /// Commit needed after the threaded particle update flag.
+    bool threadedUpdateCommit_;
     /// Serialize particles flag.
     bool serializeParticles_;
     /// Ready to send effect finish event flag.
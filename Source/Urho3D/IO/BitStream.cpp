@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../IO/BitStream.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+void BitWriter::WriteBits(unsigned value, unsigned numBits)
+{
+    if (!numBits)
+        return;
+    if (numBits < 32)
+        value &= (1u << numBits) - 1;
+
+    unsigned oldSize = buffer_.Size();
+    unsigned newSize = (numBits_ + numBits + 7) >> 3u;
+    if (oldSize < newSize)
+    {
+        buffer_.Resize(newSize);
+        memset(buffer_.Begin().ptr_ + oldSize, 0, newSize - oldSize);
+    }
+
+    // Bits are stored least significant first
+    unsigned char* dest = buffer_.Begin().ptr_;
+    while (numBits)
+    {
+        unsigned bitOffset = numBits_ & 7u;
+        unsigned count = Min(8 - bitOffset, numBits);
+        dest[numBits_ >> 3u] |= (unsigned char)((value & ((1u << count) - 1)) << bitOffset);
+        value >>= count;
+        numBits -= count;
+        numBits_ += count;
+    }
+}
+
+void BitWriter::WriteVarUInt(unsigned value, unsigned groupBits)
+{
+    for (;;)
+    {
+        unsigned rest = groupBits < 32 ? value >> groupBits : 0;
+        WriteBits(value, groupBits);
+        WriteBool(rest != 0);
+        if (!rest)
+            break;
+        value = rest;
+    }
+}
+
+void BitWriter::WriteFloat(float value)
+{
+    unsigned bits;
+    memcpy(&bits, &value, sizeof bits);
+    WriteBits(bits, 32);
+}
+
+void BitWriter::WriteBytes(const void* data, unsigned size)
+{
+    AlignToByte();
+    if (!size)
+        return;
+
+    unsigned oldSize = numBits_ >> 3u;
+    buffer_.Resize(oldSize + size);
+    memcpy(buffer_.Begin().ptr_ + oldSize, data, size);
+    numBits_ += size << 3u;
+}
+
+void BitWriter::Clear()
+{
+    buffer_.Clear();
+    numBits_ = 0;
+}
+
+BitReader::BitReader(const void* data, unsigned size) :
+    data_((const unsigned char*)data),
+    size_(data ? size : 0)
+{
+}
+
+unsigned BitReader::ReadBits(unsigned numBits)
+{
+    if (position_ + numBits > size_ << 3u)
+    {
+        overflow_ = true;
+        position_ = size_ << 3u;
+        return 0;
+    }
+
+    unsigned value = 0;
+    unsigned shift = 0;
+    while (numBits)
+    {
+        unsigned bitOffset = position_ & 7u;
+        unsigned count = Min(8 - bitOffset, numBits);
+        value |= ((unsigned)(data_[position_ >> 3u] >> bitOffset) & ((1u << count) - 1)) << shift;
+        shift += count;
+        numBits -= count;
+        position_ += count;
+    }
+    return value;
+}
+
+unsigned BitReader::ReadVarUInt(unsigned groupBits)
+{
+    unsigned value = 0;
+    for (unsigned shift = 0; shift < 32; shift += groupBits)
+    {
+        value |= ReadBits(groupBits) << shift;
+        if (!ReadBool())
+            return value;
+    }
+
+    // Malformed data: more groups than fit in 32 bits
+    overflow_ = true;
+    return value;
+}
+
+float BitReader::ReadFloat()
+{
+    unsigned bits = ReadBits(32);
+    float value;
+    memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+unsigned BitReader::ReadBytes(void* dest, unsigned size)
+{
+    AlignToByte();
+    unsigned bytePosition = GetBytePosition();
+    if (size > size_ - bytePosition)
+    {
+        overflow_ = true;
+        size = size_ - bytePosition;
+    }
+
+    memcpy(dest, data_ + bytePosition, size);
+    position_ = (bytePosition + size) << 3u;
+    return size;
+}
+
+void BitReader::SkipBytes(unsigned size)
+{
+    AlignToByte();
+    unsigned bytePosition = GetBytePosition();
+    if (size > size_ - bytePosition)
+    {
+        overflow_ = true;
+        size = size_ - bytePosition;
+    }
+    position_ = (bytePosition + size) << 3u;
+}
+
+}
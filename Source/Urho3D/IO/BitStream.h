@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Vector.h"
+#include "../Math/MathDefs.h"
+
+namespace Urho3D
+{
+
+/// Bit-granular output stream, used for compact network replication data.
+class URHO3D_API BitWriter
+{
+public:
+    /// Write up to 32 low bits of a value.
+    void WriteBits(unsigned value, unsigned numBits);
+    /// Write a single bit.
+    void WriteBool(bool value) { WriteBits(value ? 1u : 0u, 1); }
+    /// Write an unsigned integer as variable-length groups of bits, each followed by a continuation bit. Small values take fewer bits.
+    void WriteVarUInt(unsigned value, unsigned groupBits = 4);
+    /// Write a signed integer zigzag-encoded as variable-length groups of bits.
+    void WriteVarInt(int value, unsigned groupBits = 4) { WriteVarUInt(((unsigned)value << 1u) ^ (unsigned)(value >> 31), groupBits); }
+    /// Write a float as 32 raw bits.
+    void WriteFloat(float value);
+    /// Pad to the next byte boundary with zero bits.
+    void AlignToByte() { numBits_ = (numBits_ + 7) & ~7u; }
+    /// Align to the next byte boundary and write bytes.
+    void WriteBytes(const void* data, unsigned size);
+    /// Clear the stream.
+    void Clear();
+
+    /// Return data.
+    const unsigned char* GetData() const { return buffer_.Begin().ptr_; }
+    /// Return size in bytes, including a possible partial last byte.
+    unsigned GetSize() const { return (numBits_ + 7) >> 3u; }
+    /// Return number of bits written.
+    unsigned GetNumBits() const { return numBits_; }
+
+private:
+    /// Data buffer, always holding whole bytes.
+    PODVector<unsigned char> buffer_;
+    /// Number of bits written.
+    unsigned numBits_{};
+};
+
+/// Bit-granular input stream, reading data written by BitWriter. Reading past the end returns zero bits and sets the overflow flag.
+class URHO3D_API BitReader
+{
+public:
+    /// Construct with a pointer and size in bytes.
+    BitReader(const void* data, unsigned size);
+
+    /// Read up to 32 bits.
+    unsigned ReadBits(unsigned numBits);
+    /// Read a single bit.
+    bool ReadBool() { return ReadBits(1) != 0; }
+    /// Read a variable-length unsigned integer.
+    unsigned ReadVarUInt(unsigned groupBits = 4);
+    /// Read a zigzag-encoded variable-length signed integer.
+    int ReadVarInt(unsigned groupBits = 4)
+    {
+        unsigned value = ReadVarUInt(groupBits);
+        return (int)(value >> 1u) ^ -(int)(value & 1u);
+    }
+    /// Read a float from 32 raw bits.
+    float ReadFloat();
+    /// Skip to the next byte boundary.
+    void AlignToByte() { position_ = (position_ + 7) & ~7u; }
+    /// Align to the next byte boundary and read bytes. Return number of bytes actually read.
+    unsigned ReadBytes(void* dest, unsigned size);
+    /// Align to the next byte boundary and skip bytes.
+    void SkipBytes(unsigned size);
+
+    /// Return pointer to the data at the current byte-aligned position.
+    const unsigned char* GetCurrentData() const { return data_ + GetBytePosition(); }
+    /// Return byte position, rounded up to the next byte boundary.
+    unsigned GetBytePosition() const { return Min((position_ + 7) >> 3u, size_); }
+    /// Return number of whole bytes remaining after the current byte-aligned position.
+    unsigned GetRemainingBytes() const { return size_ - GetBytePosition(); }
+    /// Return whether all data has been read.
+    bool IsEof() const { return position_ >= size_ << 3u; }
+    /// Return whether a read went past the end of the data.
+    bool IsOverflow() const { return overflow_; }
+
+private:
+    /// Data.
+    const unsigned char* data_;
+    /// Data size in bytes.
+    unsigned size_;
+    /// Read position in bits.
+    unsigned position_{};
+    /// Overflow flag.
+    bool overflow_{};
+};
+
+}
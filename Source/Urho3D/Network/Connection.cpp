@@ -28,6 +28,7 @@
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
+#include "../Math/Random.h"
 #include "../Network/Connection.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
@@ -53,6 +54,41 @@ namespace Urho3D
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
+/// Maximum number of sent controls kept for client-side prediction. Must be less than the timestamp range.
+static const unsigned MAX_SENT_CONTROLS = 128;
+/// Interest radius multiplier for removing nodes, to avoid repeatedly removing and recreating nodes near the boundary.
+static const float INTEREST_HYSTERESIS = 1.1f;
+/// Delay in milliseconds on top of the round trip time before a lost reliable loopback message is resent.
+static const unsigned LOOPBACK_RESEND_DELAY = 10;
+
+/// Return world position of a node without updating cached world transforms, so that connections can be processed in parallel.
+static Vector3 GetUncachedWorldPosition(const Node* node)
+{
+    if (!node->IsDirty())
+        return node->GetWorldPosition();
+
+    Vector3 position = node->GetPosition();
+    for (const Node* parent = node->GetParent(); parent; parent = parent->GetParent())
+    {
+        if (!parent->IsDirty())
+            return parent->GetWorldTransform() * position;
+        position = parent->GetTransform() * position;
+    }
+
+    return position;
+}
+
+/// Mark a node and its replicated children dirty.
+static void MarkSubtreeDirty(Node* node, HashSet<unsigned>& dirtyNodes)
+{
+    dirtyNodes.Insert(node->GetID());
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        if (i->Get()->IsReplicated())
+            MarkSubtreeDirty(i->Get(), dirtyNodes);
+    }
+}
 
 PackageDownload::PackageDownload() :
     totalFragments_(0),
@@ -70,13 +106,22 @@ PackageUpload::PackageUpload() :
 Connection::Connection(Context* context, bool isClient, const SLNet::AddressOrGUID& address, SLNet::RakPeerInterface* peer) :
     Object(context),
     timeStamp_(0),
+    updateSequence_(1),
+    interestRadius_(0.0f),
     peer_(peer),
     sendMode_(OPSM_NONE),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
     logStatistics_(false),
-    address_(nullptr)
+    address_(nullptr),
+    loopbackReceipt_(0),
+    loopbackLinkTime_(0.0),
+    loopbackOrderedTime_(0),
+    loopbackRandomSeed_((unsigned)Rand()),
+    simulatedLatency_(0),
+    simulatedPacketLoss_(0.0f),
+    simulatedBandwidth_(0)
 {
     sceneState_.connection_ = this;
     port_ = address.systemAddress.GetPort();
@@ -114,24 +159,204 @@ void Connection::SendMessage(int msgID, bool reliable, bool inOrder, const unsig
         return;
     }
     
-    VectorBuffer buffer;
-    buffer.WriteUByte((unsigned char)msgID);
-    buffer.Write(data, numBytes);
+    // Pass the message ID and payload to the transport separately to avoid an intermediate copy
+    auto id = (unsigned char)msgID;
+    const char* segments[] = { (const char*)&id, (const char*)data };
+    int lengths[] = { 1, (int)numBytes };
     PacketReliability reliability = reliable ? (inOrder ? RELIABLE_ORDERED : RELIABLE) : (inOrder ? UNRELIABLE_SEQUENCED : UNRELIABLE);
-    if (peer_) {
-        peer_->Send((const char *) buffer.GetData(), (int) buffer.GetSize(), HIGH_PRIORITY, reliability, (char) 0, *address_, false);
+    if (peer_)
+        peer_->SendList(segments, lengths, numBytes ? 2 : 1, HIGH_PRIORITY, reliability, (char) 0, *address_, false);
+    else
+        SendLoopbackMessage(msgID, reliable, inOrder, data, numBytes, 0);
+    tempPacketCounter_.y_++;
+}
+
+void Connection::ReconcilePrediction(Node* node)
+{
+    auto* transform = node->GetComponent<SmoothedTransform>();
+    NetworkState* networkState = node->GetNetworkState();
+    if (!transform || !transform->IsReconcilePending() || !networkState)
+        return;
+
+    // Forget the controls the server had received when sending the state
+    unsigned char ackedTimeStamp = networkState->latestDataTimeStamp_;
+    unsigned numAcked = 0;
+    while (numAcked < sentControls_.Size() && (signed char)(sentControls_[numAcked].timeStamp_ - ackedTimeStamp) <= 0)
+        ++numAcked;
+    sentControls_.Erase(0, numAcked);
+
+    transform->ApplyTarget();
+
+    using namespace ReplayControls;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_CONNECTION] = this;
+    eventData[P_NODE] = node;
+    for (unsigned i = 0; i < sentControls_.Size(); ++i)
+    {
+        const SentControls& sent = sentControls_[i];
+        // The newest controls are still in effect
+        float timeStep = i + 1 < sentControls_.Size() ? sent.timeStep_ : sentControlsTimer_.GetMSec(false) * 0.001f;
+        eventData[P_BUTTONS] = sent.controls_.buttons_;
+        eventData[P_YAW] = sent.controls_.yaw_;
+        eventData[P_PITCH] = sent.controls_.pitch_;
+        eventData[P_EXTRADATA] = sent.controls_.extraData_;
+        eventData[P_TIMESTAMP] = (unsigned)sent.timeStamp_;
+        eventData[P_TIMESTEP] = timeStep;
+        SendEvent(E_REPLAYCONTROLS, eventData);
+    }
+}
+
+void Connection::UpdateInterest()
+{
+    if (interestRadius_ <= 0.0f)
+        return;
+
+    const InterestGrid* grid = GetSubsystem<Network>()->GetInterestGrid(scene_);
+    if (!grid)
+        return;
+
+    // Query with the larger removal radius; nodes not yet in interest must be within the actual radius to enter
+    interestQueryResult_.Clear();
+    grid->GetNodes(interestQueryResult_, position_, interestRadius_ * INTEREST_HYSTERESIS);
+
+    float radiusSquared = interestRadius_ * interestRadius_;
+    newInterestNodes_.Clear();
+    for (PODVector<InterestGridEntry>::ConstIterator i = interestQueryResult_.Begin(); i != interestQueryResult_.End(); ++i)
+    {
+        unsigned nodeID = i->node_->GetID();
+        if (!interestNodes_.Contains(nodeID))
+        {
+            float dx = i->position_.x_ - position_.x_;
+            float dz = i->position_.z_ - position_.z_;
+            if (dx * dx + dz * dz > radiusSquared)
+                continue;
+
+            MarkSubtreeDirty(i->node_, sceneState_.dirtyNodes_);
+        }
+
+        newInterestNodes_.Insert(nodeID);
+    }
+
+    // Dirty the nodes that left, so that they get removed from the client
+    for (HashSet<unsigned>::ConstIterator i = interestNodes_.Begin(); i != interestNodes_.End(); ++i)
+    {
+        if (newInterestNodes_.Contains(*i))
+            continue;
+
+        Node* node = scene_->GetNode(*i);
+        if (node)
+            MarkSubtreeDirty(node, sceneState_.dirtyNodes_);
+    }
+
+    interestNodes_.Swap(newInterestNodes_);
+}
+
+bool Connection::IsInInterest(Node* node) const
+{
+    if (interestRadius_ <= 0.0f)
+        return true;
+
+    // Child nodes share the relevance of their top-level ancestor. The scene itself is always relevant
+    Node* parent = node->GetParent();
+    if (!parent)
+        return true;
+    while (parent != scene_)
+    {
+        node = parent;
+        parent = node->GetParent();
+        if (!parent)
+            return true;
+    }
+
+    return node->GetOwner() == this || interestNodes_.Contains(node->GetID());
+}
+
+unsigned Connection::SendMessageWithReceipt(int msgID, const VectorBuffer& msg)
+{
+    if (!peer_)
+    {
+        if (!loopbackPeer_)
+            return 0;
+
+        // Receipt numbers skip zero, which means not sent
+        if (!++loopbackReceipt_)
+            ++loopbackReceipt_;
+        SendLoopbackMessage(msgID, true, false, msg.GetData(), msg.GetSize(), loopbackReceipt_);
         tempPacketCounter_.y_++;
+        return loopbackReceipt_;
+    }
+
+    auto id = (unsigned char)msgID;
+    const char* segments[] = { (const char*)&id, (const char*)msg.GetData() };
+    int lengths[] = { 1, (int)msg.GetSize() };
+    unsigned receipt = peer_->SendList(segments, lengths, msg.GetSize() ? 2 : 1, HIGH_PRIORITY, RELIABLE_WITH_ACK_RECEIPT,
+        (char) 0, *address_, false);
+    tempPacketCounter_.y_++;
+    return receipt;
+}
+
+void Connection::SendLatestData(int msgID, Serializable* serializable, unsigned nodeID, unsigned componentID, NetworkBaseline& baseline)
+{
+    PendingBaseline pending;
+    pending.nodeID_ = nodeID;
+    pending.componentID_ = componentID;
+
+    msg_.Clear();
+    msg_.WriteNetID(componentID ? componentID : nodeID);
+    serializable->WriteLatestDataUpdate(msg_, timeStamp_, updateSequence_, &baseline, &pending.baseline_);
+
+    unsigned receipt = SendMessageWithReceipt(msgID, msg_);
+    if (receipt)
+        pendingBaselines_[receipt] = pending;
+}
+
+bool Connection::ReadLatestData(Serializable* serializable, unsigned nodeID, unsigned componentID, MemoryBuffer& msg)
+{
+    unsigned short missingSequence = 0;
+    bool changed = serializable->ReadLatestDataUpdate(msg, &missingSequence);
+    if (!missingSequence)
+        return changed;
+
+    // Report only the newest undecodable update of each object, as the server ignores reports of updates it sent before
+    // resetting the baseline
+    for (PODVector<MissingBaseline>::Iterator i = missingBaselines_.Begin(); i != missingBaselines_.End(); ++i)
+    {
+        if (i->nodeID_ == nodeID && i->componentID_ == componentID)
+        {
+            if ((short)(missingSequence - i->sequence_) > 0)
+                i->sequence_ = missingSequence;
+            return changed;
+        }
     }
+
+    URHO3D_LOGDEBUG("Missing latest data baseline for node " + String(nodeID) + " component " + String(componentID) +
+        ", requesting absolute values");
+    MissingBaseline missing;
+    missing.nodeID_ = nodeID;
+    missing.componentID_ = componentID;
+    missing.sequence_ = missingSequence;
+    missingBaselines_.Push(missing);
+    return changed;
+}
+
+void Connection::CacheLatestData(HashMap<unsigned, Vector<PODVector<unsigned char> > >& cache, unsigned id, MemoryBuffer& msg)
+{
+    // Keep every update rather than only the newest, as the server may already use any acknowledged one as a delta baseline.
+    // The oldest are dropped beyond the baseline history size: updates that then can not be decoded are reported missing
+    Vector<PODVector<unsigned char> >& updates = cache[id];
+    if (updates.Size() >= NETWORK_BASELINE_HISTORY)
+        updates.Erase(0);
+    updates.Resize(updates.Size() + 1);
+    PODVector<unsigned char>& data = updates.Back();
+    data.Resize(msg.GetSize());
+    memcpy(&data[0], msg.GetData(), msg.GetSize());
 }
 
 void Connection::SendRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData)
 {
-    RemoteEvent queuedEvent;
-    queuedEvent.senderID_ = 0;
-    queuedEvent.eventType_ = eventType;
-    queuedEvent.eventData_ = eventData;
-    queuedEvent.inOrder_ = inOrder;
-    remoteEvents_.Push(queuedEvent);
+    SharedPtr<MessageBuffer> payload = GetSubsystem<Network>()->EncodeRemoteEvent(0, eventType, eventData);
+    QueueRemoteEvent(0, eventType, payload, inOrder);
 }
 
 void Connection::SendRemoteEvent(Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData)
@@ -152,10 +377,16 @@ void Connection::SendRemoteEvent(Node* node, StringHash eventType, bool inOrder,
         return;
     }
 
+    SharedPtr<MessageBuffer> payload = GetSubsystem<Network>()->EncodeRemoteEvent(node->GetID(), eventType, eventData);
+    QueueRemoteEvent(node->GetID(), eventType, payload, inOrder);
+}
+
+void Connection::QueueRemoteEvent(unsigned senderID, StringHash eventType, MessageBuffer* payload, bool inOrder)
+{
     RemoteEvent queuedEvent;
-    queuedEvent.senderID_ = node->GetID();
+    queuedEvent.senderID_ = senderID;
     queuedEvent.eventType_ = eventType;
-    queuedEvent.eventData_ = eventData;
+    queuedEvent.payload_ = payload;
     queuedEvent.inOrder_ = inOrder;
     remoteEvents_.Push(queuedEvent);
 }
@@ -178,6 +409,8 @@ void Connection::SetScene(Scene* newScene)
     if (isClient_)
     {
         sceneState_.Clear();
+        pendingBaselines_.Clear();
+        interestNodes_.Clear();
 
         // When scene is assigned on the server, instruct the client to load it. This may require downloading packages
         const Vector<SharedPtr<PackageFile> >& packages = scene_->GetRequiredPackageFiles();
@@ -196,6 +429,8 @@ void Connection::SetScene(Scene* newScene)
     }
     else
     {
+        sentControls_.Clear();
+
         // Make sure there is no existing async loading
         scene_->StopAsyncLoading();
         SubscribeToEvent(scene_, E_ASYNCLOADFINISHED, URHO3D_HANDLER(Connection, HandleAsyncLoadFinished));
@@ -226,6 +461,22 @@ void Connection::SetRotation(const Quaternion& rotation)
         sendMode_ = OPSM_POSITION_ROTATION;
 }
 
+void Connection::SetInterestRadius(float radius)
+{
+    radius = Max(radius, 0.0f);
+    if (radius == interestRadius_)
+        return;
+
+    // When disabling, dirty all nodes so that the ones outside the interest radius get created on the client
+    if (radius == 0.0f && scene_)
+    {
+        interestNodes_.Clear();
+        MarkSubtreeDirty(scene_, sceneState_.dirtyNodes_);
+    }
+
+    interestRadius_ = radius;
+}
+
 void Connection::SetConnectPending(bool connectPending)
 {
     connectPending_ = connectPending;
@@ -238,10 +489,26 @@ void Connection::SetLogStatistics(bool enable)
 
 void Connection::Disconnect(int waitMSec)
 {
-    peer_->CloseConnection(*address_, true);
+    if (peer_)
+        peer_->CloseConnection(*address_, true);
+    else
+    {
+        // Unpair both ends. Their Networks notice the disconnection on their next update
+        if (loopbackPeer_)
+            loopbackPeer_->loopbackPeer_.Reset();
+        loopbackPeer_.Reset();
+        loopbackInbox_.Clear();
+        loopbackReceipts_.Clear();
+    }
 }
 
 void Connection::SendServerUpdate()
+{
+    ProcessServerUpdate();
+    CommitServerUpdate();
+}
+
+void Connection::ProcessServerUpdate()
 {
     if (!scene_ || !sceneLoaded_)
         return;
@@ -252,6 +519,8 @@ void Connection::SendServerUpdate()
     nodesToProcess_.Insert(sceneID);
     ProcessNode(sceneID);
 
+    UpdateInterest();
+
     // Then go through all dirtied nodes
     nodesToProcess_.Insert(sceneState_.dirtyNodes_);
     nodesToProcess_.Erase(sceneID); // Do not process the root node twice
@@ -261,6 +530,57 @@ void Connection::SendServerUpdate()
         unsigned nodeID = nodesToProcess_.Front();
         ProcessNode(nodeID);
     }
+
+    if (!++updateSequence_)
+        ++updateSequence_;
+}
+
+void Connection::CommitServerUpdate()
+{
+    // Link the replication states created during the update to their objects, and destroy the states of removed objects.
+    // This is deferred, as the objects and their weak reference counts are shared between connections that may have been
+    // processed in parallel
+    for (PODVector<Pair<Node*, NodeReplicationState*> >::ConstIterator i = newNodeStates_.Begin(); i != newNodeStates_.End(); ++i)
+    {
+        i->second_->node_ = i->first_;
+        i->first_->AddReplicationState(i->second_);
+    }
+    for (PODVector<Pair<Component*, ComponentReplicationState*> >::ConstIterator i = newComponentStates_.Begin();
+         i != newComponentStates_.End(); ++i)
+    {
+        i->second_->component_ = i->first_;
+        i->first_->AddReplicationState(i->second_);
+    }
+
+    for (PODVector<Pair<NodeReplicationState*, unsigned> >::ConstIterator i = removedComponentStates_.Begin();
+         i != removedComponentStates_.End(); ++i)
+        i->first_->componentStates_.Erase(i->second_);
+    for (PODVector<unsigned>::ConstIterator i = removedNodeStates_.Begin(); i != removedNodeStates_.End(); ++i)
+    {
+        HashMap<unsigned, NodeReplicationState>::Iterator j = sceneState_.nodeStates_.Find(*i);
+        if (j == sceneState_.nodeStates_.End())
+            continue;
+
+        // Nodes that left the interest radius still exist and refer to the state
+        NodeReplicationState& nodeState = j->second_;
+        if (Node* node = nodeState.node_)
+        {
+            node->RemoveReplicationState(&nodeState);
+            for (HashMap<unsigned, ComponentReplicationState>::Iterator k = nodeState.componentStates_.Begin();
+                 k != nodeState.componentStates_.End(); ++k)
+            {
+                if (Component* component = k->second_.component_)
+                    component->RemoveReplicationState(&k->second_);
+            }
+        }
+
+        sceneState_.nodeStates_.Erase(j);
+    }
+
+    newNodeStates_.Clear();
+    newComponentStates_.Clear();
+    removedComponentStates_.Clear();
+    removedNodeStates_.Clear();
 }
 
 void Connection::SendClientUpdate()
@@ -280,7 +600,34 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    // Remember the controls for replaying them on top of server state
+    if (!sentControls_.Empty())
+        sentControls_.Back().timeStep_ = sentControlsTimer_.GetMSec(false) * 0.001f;
+    sentControlsTimer_.Reset();
+    if (sentControls_.Size() >= MAX_SENT_CONTROLS)
+        sentControls_.Erase(0);
+    SentControls sent;
+    sent.controls_ = controls_;
+    sent.timeStep_ = 0.0f;
+    sent.timeStamp_ = timeStamp_;
+    sentControls_.Push(sent);
+
     ++timeStamp_;
+
+    // Report latest data updates that could not be decoded, so that the server resends absolute values
+    if (!missingBaselines_.Empty())
+    {
+        msg_.Clear();
+        msg_.WriteVLE(missingBaselines_.Size());
+        for (PODVector<MissingBaseline>::ConstIterator i = missingBaselines_.Begin(); i != missingBaselines_.End(); ++i)
+        {
+            msg_.WriteNetID(i->nodeID_);
+            msg_.WriteNetID(i->componentID_);
+            msg_.WriteUShort(i->sequence_);
+        }
+        SendMessage(MSG_MISSINGBASELINES, true, false, msg_);
+        missingBaselines_.Clear();
+    }
 }
 
 void Connection::SendRemoteEvents()
@@ -305,6 +652,8 @@ void Connection::SendRemoteEvents()
         packetCounterTimer_.Reset();
         packetCounter_ = tempPacketCounter_;
         tempPacketCounter_ = IntVector2::ZERO;
+        byteCounter_ = tempByteCounter_;
+        tempByteCounter_ = IntVector2::ZERO;
     }
 
     if (remoteEvents_.Empty())
@@ -312,23 +661,9 @@ void Connection::SendRemoteEvents()
 
     URHO3D_PROFILE(SendRemoteEvents);
 
+    // Releasing the payloads returns them to the message buffer pool, unless still queued for other connections
     for (Vector<RemoteEvent>::ConstIterator i = remoteEvents_.Begin(); i != remoteEvents_.End(); ++i)
-    {
-        msg_.Clear();
-        if (!i->senderID_)
-        {
-            msg_.WriteStringHash(i->eventType_);
-            msg_.WriteVariantMap(i->eventData_);
-            SendMessage(MSG_REMOTEEVENT, true, i->inOrder_, msg_);
-        }
-        else
-        {
-            msg_.WriteNetID(i->senderID_);
-            msg_.WriteStringHash(i->eventType_);
-            msg_.WriteVariantMap(i->eventData_);
-            SendMessage(MSG_REMOTENODEEVENT, true, i->inOrder_, msg_);
-        }
-    }
+        SendMessage(i->senderID_ ? MSG_REMOTENODEEVENT : MSG_REMOTEEVENT, true, i->inOrder_, i->payload_->GetBuffer());
 
     remoteEvents_.Clear();
 }
@@ -366,35 +701,68 @@ void Connection::ProcessPendingLatestData()
         return;
 
     // Iterate through pending node data and see if we can find the nodes now
-    for (HashMap<unsigned, PODVector<unsigned char> >::Iterator i = nodeLatestData_.Begin(); i != nodeLatestData_.End();)
+    for (HashMap<unsigned, Vector<PODVector<unsigned char> > >::Iterator i = nodeLatestData_.Begin(); i != nodeLatestData_.End();)
     {
-        HashMap<unsigned, PODVector<unsigned char> >::Iterator current = i++;
+        HashMap<unsigned, Vector<PODVector<unsigned char> > >::Iterator current = i++;
         Node* node = scene_->GetNode(current->first_);
         if (node)
-        {
-            MemoryBuffer msg(current->second_);
-            msg.ReadNetID(); // Skip the node ID
-            node->ReadLatestDataUpdate(msg);
-            // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
-            // Furthermore it would propagate to components and child nodes, which is not desired in this case
-            nodeLatestData_.Erase(current);
-        }
+            ProcessPendingNodeLatestData(node);
     }
 
     // Iterate through pending component data and see if we can find the components now
-    for (HashMap<unsigned, PODVector<unsigned char> >::Iterator i = componentLatestData_.Begin(); i != componentLatestData_.End();)
+    for (HashMap<unsigned, Vector<PODVector<unsigned char> > >::Iterator i = componentLatestData_.Begin();
+         i != componentLatestData_.End();)
     {
-        HashMap<unsigned, PODVector<unsigned char> >::Iterator current = i++;
+        HashMap<unsigned, Vector<PODVector<unsigned char> > >::Iterator current = i++;
         Component* component = scene_->GetComponent(current->first_);
         if (component)
-        {
-            MemoryBuffer msg(current->second_);
-            msg.ReadNetID(); // Skip the component ID
-            if (component->ReadLatestDataUpdate(msg))
-                component->ApplyAttributes();
-            componentLatestData_.Erase(current);
-        }
+            ProcessPendingComponentLatestData(component);
+    }
+}
+
+void Connection::ProcessPendingNodeLatestData(Node* node)
+{
+    if (!sceneLoaded_)
+        return;
+
+    HashMap<unsigned, Vector<PODVector<unsigned char> > >::Iterator i = nodeLatestData_.Find(node->GetID());
+    if (i == nodeLatestData_.End())
+        return;
+
+    // The updates are read in the order received, which decodes the delta baselines of the later ones first
+    const Vector<PODVector<unsigned char> >& updates = i->second_;
+    for (unsigned j = 0; j < updates.Size(); ++j)
+    {
+        MemoryBuffer msg(updates[j]);
+        msg.ReadNetID(); // Skip the node ID
+        ReadLatestData(node, i->first_, 0, msg);
+    }
+    // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
+    // Furthermore it would propagate to components and child nodes, which is not desired in this case
+    ReconcilePrediction(node);
+    nodeLatestData_.Erase(i);
+}
+
+void Connection::ProcessPendingComponentLatestData(Component* component)
+{
+    if (!sceneLoaded_)
+        return;
+
+    HashMap<unsigned, Vector<PODVector<unsigned char> > >::Iterator i = componentLatestData_.Find(component->GetID());
+    if (i == componentLatestData_.End())
+        return;
+
+    const Vector<PODVector<unsigned char> >& updates = i->second_;
+    bool changed = false;
+    for (unsigned j = 0; j < updates.Size(); ++j)
+    {
+        MemoryBuffer msg(updates[j]);
+        msg.ReadNetID(); // Skip the component ID
+        changed |= ReadLatestData(component, component->GetNode()->GetID(), i->first_, msg);
     }
+    if (changed)
+        component->ApplyAttributes();
+    componentLatestData_.Erase(i);
 }
 
 bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
@@ -451,6 +819,10 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
         ProcessPackageInfo(msgID, msg);
         break;
 
+    case MSG_MISSINGBASELINES:
+        ProcessMissingBaselines(msgID, msg);
+        break;
+
     default:
         processed = false;
         break;
@@ -459,6 +831,150 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& msg)
     return processed;
 }
 
+void Connection::ProcessSendReceipt(unsigned receipt, bool delivered)
+{
+    HashMap<unsigned, PendingBaseline>::Iterator i = pendingBaselines_.Find(receipt);
+    if (i == pendingBaselines_.End())
+        return;
+
+    const PendingBaseline& pending = i->second_;
+    if (delivered)
+    {
+        // Find the replication state the update was sent for. A state created after sending belongs to a new object that
+        // reused the ID, and a state reset after sending has been reported as missing a baseline: neither must use it
+        NetworkBaseline* baseline = nullptr;
+        unsigned short minSequence = 0;
+        HashMap<unsigned, NodeReplicationState>::Iterator j = sceneState_.nodeStates_.Find(pending.nodeID_);
+        if (j != sceneState_.nodeStates_.End())
+        {
+            NodeReplicationState& nodeState = j->second_;
+            if (!pending.componentID_)
+            {
+                baseline = &nodeState.latestDataBaseline_;
+                minSequence = nodeState.minBaselineSequence_;
+            }
+            else
+            {
+                HashMap<unsigned, ComponentReplicationState>::Iterator k = nodeState.componentStates_.Find(pending.componentID_);
+                if (k != nodeState.componentStates_.End())
+                {
+                    baseline = &k->second_.latestDataBaseline_;
+                    minSequence = k->second_.minBaselineSequence_;
+                }
+            }
+        }
+
+        // Receipts of unordered messages may arrive in any order: only move the baseline forward
+        unsigned short sequence = pending.baseline_.sequence_;
+        if (baseline && (short)(sequence - minSequence) >= 0 &&
+            (!baseline->sequence_ || (short)(sequence - baseline->sequence_) > 0))
+            *baseline = pending.baseline_;
+    }
+
+    pendingBaselines_.Erase(i);
+}
+
+void Connection::ConnectLoopback(Connection* first, Connection* second)
+{
+    first->loopbackPeer_ = second;
+    second->loopbackPeer_ = first;
+}
+
+void Connection::ProcessLoopbackReceipts(unsigned time)
+{
+    for (unsigned i = 0; i < loopbackReceipts_.Size();)
+    {
+        if (loopbackReceipts_[i].first_ <= time)
+        {
+            unsigned receipt = loopbackReceipts_[i].second_;
+            loopbackReceipts_.Erase(i);
+            ProcessSendReceipt(receipt, true);
+        }
+        else
+            ++i;
+    }
+}
+
+bool Connection::ReceiveLoopbackMessage(unsigned time, int& msgID, PODVector<unsigned char>& data)
+{
+    if (loopbackInbox_.Empty() || loopbackInbox_.Front().deliveryTime_ > time)
+        return false;
+
+    LoopbackMessage& message = loopbackInbox_.Front();
+    msgID = message.msgID_;
+    data.Swap(message.data_);
+    tempByteCounter_.x_ += data.Size() + 1;
+
+    // The receipt travels back to the sender with this end's latency
+    if (message.receipt_ && loopbackPeer_)
+        loopbackPeer_->loopbackReceipts_.Push(MakePair(time + (unsigned)simulatedLatency_, message.receipt_));
+
+    loopbackInbox_.PopFront();
+    return true;
+}
+
+void Connection::SendLoopbackMessage(int msgID, bool reliable, bool inOrder, const unsigned char* data, unsigned numBytes,
+    unsigned receipt)
+{
+    Connection* peer = loopbackPeer_;
+    if (!peer)
+        return;
+
+    // Messages leave one after another at the simulated bandwidth, then arrive after the latency
+    unsigned time = Time::GetSystemTime();
+    unsigned size = numBytes + 1;
+    tempByteCounter_.y_ += size;
+    loopbackLinkTime_ = Max(loopbackLinkTime_, (double)time);
+    if (simulatedBandwidth_)
+        loopbackLinkTime_ += size * 1000.0 / simulatedBandwidth_;
+    unsigned deliveryTime = (unsigned)loopbackLinkTime_ + (unsigned)simulatedLatency_;
+
+    if (simulatedPacketLoss_ > 0.0f && LoopbackRandom() < simulatedPacketLoss_)
+    {
+        if (!reliable || simulatedPacketLoss_ >= 1.0f)
+            return;
+
+        // Reliable messages are resent after a round trip until they get through
+        do
+            deliveryTime += 2 * (unsigned)simulatedLatency_ + LOOPBACK_RESEND_DELAY;
+        while (LoopbackRandom() < simulatedPacketLoss_);
+    }
+
+    if (inOrder)
+    {
+        deliveryTime = Max(deliveryTime, loopbackOrderedTime_);
+        loopbackOrderedTime_ = deliveryTime;
+    }
+
+    // Keep the receiving inbox sorted by delivery time. Usually the message goes last
+    List<LoopbackMessage>::Iterator i = peer->loopbackInbox_.End();
+    while (i != peer->loopbackInbox_.Begin())
+    {
+        List<LoopbackMessage>::Iterator previous = i;
+        --previous;
+        if (previous->deliveryTime_ <= deliveryTime)
+            break;
+        i = previous;
+    }
+    peer->loopbackInbox_.Insert(i, LoopbackMessage());
+    --i;
+
+    LoopbackMessage& message = *i;
+    message.deliveryTime_ = deliveryTime;
+    message.msgID_ = msgID;
+    message.receipt_ = receipt;
+    message.data_.Resize(numBytes);
+    if (numBytes)
+        memcpy(&message.data_[0], data, numBytes);
+}
+
+float Connection::LoopbackRandom()
+{
+    // Same generator as Rand(), but with per-connection state, as connections send from parallel work items
+    loopbackRandomSeed_ = loopbackRandomSeed_ * 214013 + 2531011;
+    return ((loopbackRandomSeed_ >> 16u) & 32767u) / 32768.0f;
+}
+
 void Connection::Ban()
 {
     if (peer_)
@@ -487,6 +1003,7 @@ void Connection::ProcessLoadScene(int msgID, MemoryBuffer& msg)
     // Clear previous pending latest data and package downloads if any
     nodeLatestData_.Clear();
     componentLatestData_.Clear();
+    missingBaselines_.Clear();
     downloads_.Clear();
 
     // In case we have joined other scenes in this session, remove first all downloaded package files from the resource system
@@ -595,10 +1112,14 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
                     return;
                 }
 
-                // Read initial attributes and apply
+                // Read initial attributes and apply, then the latest data received before the component
                 component->ReadDeltaUpdate(msg);
                 component->ApplyAttributes();
+                ProcessPendingComponentLatestData(component);
             }
+
+            // Apply latest data received before the node
+            ProcessPendingNodeLatestData(node);
         }
         break;
 
@@ -630,16 +1151,15 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             Node* node = scene_->GetNode(nodeID);
             if (node)
             {
-                node->ReadLatestDataUpdate(msg);
+                ReadLatestData(node, nodeID, 0, msg);
                 // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
                 // Furthermore it would propagate to components and child nodes, which is not desired in this case
+                ReconcilePrediction(node);
             }
             else
             {
                 // Latest data messages may be received out-of-order relative to node creation, so cache if necessary
-                PODVector<unsigned char>& data = nodeLatestData_[nodeID];
-                data.Resize(msg.GetSize());
-                memcpy(&data[0], msg.GetData(), msg.GetSize());
+                CacheLatestData(nodeLatestData_, nodeID, msg);
             }
         }
         break;
@@ -682,6 +1202,9 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
                 // Read initial attributes and apply
                 component->ReadDeltaUpdate(msg);
                 component->ApplyAttributes();
+
+                // Apply latest data received before the component
+                ProcessPendingComponentLatestData(component);
             }
             else
                 URHO3D_LOGWARNING("CreateComponent message received for missing node " + String(nodeID));
@@ -708,15 +1231,13 @@ void Connection::ProcessSceneUpdate(int msgID, MemoryBuffer& msg)
             Component* component = scene_->GetComponent(componentID);
             if (component)
             {
-                if (component->ReadLatestDataUpdate(msg))
+                if (ReadLatestData(component, component->GetNode()->GetID(), componentID, msg))
                     component->ApplyAttributes();
             }
             else
             {
                 // Latest data messages may be received out-of-order relative to component creation, so cache if necessary
-                PODVector<unsigned char>& data = componentLatestData_[componentID];
-                data.Resize(msg.GetSize());
-                memcpy(&data[0], msg.GetData(), msg.GetSize());
+                CacheLatestData(componentLatestData_, componentID, msg);
             }
         }
         break;
@@ -1002,6 +1523,74 @@ void Connection::ProcessRemoteEvent(int msgID, MemoryBuffer& msg)
     }
 }
 
+void Connection::ProcessMissingBaselines(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        URHO3D_LOGWARNING("Received unexpected MissingBaselines message from server");
+        return;
+    }
+
+    unsigned numMissing = msg.ReadVLE();
+    while (numMissing-- && !msg.IsEof())
+    {
+        unsigned nodeID = msg.ReadNetID();
+        unsigned componentID = msg.ReadNetID();
+        unsigned short sequence = msg.ReadUShort();
+
+        HashMap<unsigned, NodeReplicationState>::Iterator i = sceneState_.nodeStates_.Find(nodeID);
+        if (i == sceneState_.nodeStates_.End())
+            continue;
+
+        NodeReplicationState& nodeState = i->second_;
+        Serializable* serializable = nullptr;
+        DirtyBits* dirtyAttributes = nullptr;
+        NetworkBaseline* baseline = nullptr;
+        unsigned short* minSequence = nullptr;
+        if (!componentID)
+        {
+            serializable = nodeState.node_;
+            dirtyAttributes = &nodeState.dirtyAttributes_;
+            baseline = &nodeState.latestDataBaseline_;
+            minSequence = &nodeState.minBaselineSequence_;
+        }
+        else
+        {
+            HashMap<unsigned, ComponentReplicationState>::Iterator j = nodeState.componentStates_.Find(componentID);
+            if (j == nodeState.componentStates_.End())
+                continue;
+            ComponentReplicationState& componentState = j->second_;
+            serializable = componentState.component_;
+            dirtyAttributes = &componentState.dirtyAttributes_;
+            baseline = &componentState.latestDataBaseline_;
+            minSequence = &componentState.minBaselineSequence_;
+        }
+
+        // Updates sent before the last reset were delta encoded against the discarded baseline, and fail as well
+        if (!serializable || (short)(sequence - *minSequence) < 0)
+            continue;
+
+        // Send absolute values until an update sent from now on is acknowledged
+        baseline->sequence_ = 0;
+        baseline->values_.Clear();
+        *minSequence = updateSequence_;
+
+        const Vector<AttributeInfo>* attributes = serializable->GetNetworkAttributes();
+        if (!attributes)
+            continue;
+        for (unsigned k = 0; k < attributes->Size(); ++k)
+        {
+            if (attributes->At(k).mode_ & AM_LATESTDATA)
+                dirtyAttributes->Set(k);
+        }
+        if (!nodeState.markedDirty_)
+        {
+            nodeState.markedDirty_ = true;
+            sceneState_.dirtyNodes_.Insert(nodeID);
+        }
+    }
+}
+
 Scene* Connection::GetScene() const
 {
     return scene_;
@@ -1009,17 +1598,19 @@ Scene* Connection::GetScene() const
 
 bool Connection::IsConnected() const
 {
-    return peer_ && peer_->IsActive();
+    if (!peer_)
+        return loopbackPeer_.NotNull();
+    return peer_->IsActive();
 }
 
 float Connection::GetRoundTripTime() const
 {
-    if (peer_)
-    {
-        SLNet::RakNetStatistics stats{};
-        if (peer_->GetStatistics(address_->systemAddress, &stats))
-            return (float)peer_->GetAveragePing(*address_);
-    }
+    if (!peer_)
+        return loopbackPeer_ ? (float)(simulatedLatency_ + loopbackPeer_->simulatedLatency_) : 0.0f;
+
+    SLNet::RakNetStatistics stats{};
+    if (peer_->GetStatistics(address_->systemAddress, &stats))
+        return (float)peer_->GetAveragePing(*address_);
     return 0.0f;
 }
 
@@ -1030,23 +1621,23 @@ unsigned Connection::GetLastHeardTime() const
 
 float Connection::GetBytesInPerSec() const
 {
-    if (peer_)
-    {
-        SLNet::RakNetStatistics stats{};
-        if (peer_->GetStatistics(address_->systemAddress, &stats))
-            return (float)stats.valueOverLastSecond[SLNet::ACTUAL_BYTES_RECEIVED];
-    }
+    if (!peer_)
+        return (float)byteCounter_.x_;
+
+    SLNet::RakNetStatistics stats{};
+    if (peer_->GetStatistics(address_->systemAddress, &stats))
+        return (float)stats.valueOverLastSecond[SLNet::ACTUAL_BYTES_RECEIVED];
     return 0.0f;
 }
 
 float Connection::GetBytesOutPerSec() const
 {
-    if (peer_)
-    {
-        SLNet::RakNetStatistics stats{};
-        if (peer_->GetStatistics(address_->systemAddress, &stats))
-            return (float)stats.valueOverLastSecond[SLNet::ACTUAL_BYTES_SENT];
-    }
+    if (!peer_)
+        return (float)byteCounter_.y_;
+
+    SLNet::RakNetStatistics stats{};
+    if (peer_->GetStatistics(address_->systemAddress, &stats))
+        return (float)stats.valueOverLastSecond[SLNet::ACTUAL_BYTES_SENT];
     return 0.0f;
 }
 
@@ -1115,8 +1706,13 @@ void Connection::SendPackageToClient(PackageFile* package)
     SendMessage(MSG_PACKAGEINFO, true, true, msg_);
 }
 
-void Connection::ConfigureNetworkSimulator(int latencyMs, float packetLoss)
+void Connection::ConfigureNetworkSimulator(int latencyMs, float packetLoss, unsigned bandwidth)
 {
+    simulatedLatency_ = Max(latencyMs, 0);
+    simulatedPacketLoss_ = Clamp(packetLoss, 0.0f, 1.0f);
+    simulatedBandwidth_ = bandwidth;
+
+    // SLikeNet only simulates in debug builds, and has no bandwidth limit
     if (peer_)
         peer_->ApplyNetworkSimulator(packetLoss, latencyMs, 0);
 }
@@ -1145,7 +1741,7 @@ void Connection::ProcessNode(unsigned nodeID)
     {
         // Replication state found: the node is either be existing or removed
         Node* node = i->second_.node_;
-        if (!node)
+        if (!node || !IsInInterest(node))
         {
             msg_.Clear();
             msg_.WriteNetID(nodeID);
@@ -1154,7 +1750,8 @@ void Connection::ProcessNode(unsigned nodeID)
             // would be enough. However, this may be better due to the client not possibly having updated parenting
             // information at the time of receiving this message
             SendMessage(MSG_REMOVENODE, true, true, msg_);
-            sceneState_.nodeStates_.Erase(nodeID);
+            removedNodeStates_.Push(nodeID);
+            sceneState_.dirtyNodes_.Erase(nodeID);
         }
         else
             ProcessExistingNode(node, i->second_);
@@ -1163,11 +1760,12 @@ void Connection::ProcessNode(unsigned nodeID)
     {
         // Replication state not found: this is a new node
         Node* node = scene_->GetNode(nodeID);
-        if (node)
+        if (node && IsInInterest(node))
             ProcessNewNode(node);
         else
         {
-            // Did not find the new node (may have been created, then removed immediately): erase from dirty set.
+            // Did not find the new node (may have been created, then removed immediately), or it is outside the interest
+            // radius: erase from dirty set. Nodes entering the interest radius will be dirtied again
             sceneState_.dirtyNodes_.Erase(nodeID);
         }
     }
@@ -1190,8 +1788,8 @@ void Connection::ProcessNewNode(Node* node)
     NodeReplicationState& nodeState = sceneState_.nodeStates_[node->GetID()];
     nodeState.connection_ = this;
     nodeState.sceneState_ = &sceneState_;
-    nodeState.node_ = node;
-    node->AddReplicationState(&nodeState);
+    nodeState.minBaselineSequence_ = updateSequence_;
+    newNodeStates_.Push(MakePair(node, &nodeState));
 
     // Write node's attributes
     node->WriteInitialDeltaUpdate(msg_, timeStamp_);
@@ -1218,8 +1816,8 @@ void Connection::ProcessNewNode(Node* node)
         ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
         componentState.connection_ = this;
         componentState.nodeState_ = &nodeState;
-        componentState.component_ = component;
-        component->AddReplicationState(&componentState);
+        componentState.minBaselineSequence_ = updateSequence_;
+        newComponentStates_.Push(MakePair(component, &componentState));
 
         msg_.WriteStringHash(component->GetType());
         msg_.WriteNetID(component->GetID());
@@ -1248,7 +1846,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     auto* priority = node->GetComponent<NetworkPriority>();
     if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
     {
-        float distance = (node->GetWorldPosition() - position_).Length();
+        float distance = (GetUncachedWorldPosition(node) - position_).Length();
         if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
             return;
     }
@@ -1272,11 +1870,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         // Send latestdata message if necessary
         if (hasLatestData)
         {
-            msg_.Clear();
-            msg_.WriteNetID(node->GetID());
-            node->WriteLatestDataUpdate(msg_, timeStamp_);
-
-            SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
+            SendLatestData(MSG_NODELATESTDATA, node, node->GetID(), 0, nodeState.latestDataBaseline_);
         }
 
         // Send deltaupdate if remaining dirty bits, or vars have changed
@@ -1314,20 +1908,21 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     }
 
     // Check for removed or changed components
+    unsigned numRemovedComponents = 0;
     for (HashMap<unsigned, ComponentReplicationState>::Iterator i = nodeState.componentStates_.Begin();
-         i != nodeState.componentStates_.End();)
+         i != nodeState.componentStates_.End(); ++i)
     {
-        HashMap<unsigned, ComponentReplicationState>::Iterator current = i++;
-        ComponentReplicationState& componentState = current->second_;
+        ComponentReplicationState& componentState = i->second_;
         Component* component = componentState.component_;
         if (!component)
         {
             // Removed component
             msg_.Clear();
-            msg_.WriteNetID(current->first_);
+            msg_.WriteNetID(i->first_);
 
             SendMessage(MSG_REMOVECOMPONENT, true, true, msg_);
-            nodeState.componentStates_.Erase(current);
+            removedComponentStates_.Push(MakePair(&nodeState, i->first_));
+            ++numRemovedComponents;
         }
         else
         {
@@ -1350,11 +1945,8 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 // Send latestdata message if necessary
                 if (hasLatestData)
                 {
-                    msg_.Clear();
-                    msg_.WriteNetID(component->GetID());
-                    component->WriteLatestDataUpdate(msg_, timeStamp_);
-
-                    SendMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
+                    SendLatestData(MSG_COMPONENTLATESTDATA, component, node->GetID(), component->GetID(),
+                        componentState.latestDataBaseline_);
                 }
 
                 // Send deltaupdate if remaining dirty bits
@@ -1373,7 +1965,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
     }
 
     // Check for new components
-    if (nodeState.componentStates_.Size() != node->GetNumNetworkComponents())
+    if (nodeState.componentStates_.Size() - numRemovedComponents != node->GetNumNetworkComponents())
     {
         const Vector<SharedPtr<Component> >& components = node->GetComponents();
         for (unsigned i = 0; i < components.Size(); ++i)
@@ -1390,8 +1982,8 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
                 componentState.connection_ = this;
                 componentState.nodeState_ = &nodeState;
-                componentState.component_ = component;
-                component->AddReplicationState(&componentState);
+                componentState.minBaselineSequence_ = updateSequence_;
+                newComponentStates_.Push(MakePair(component, &componentState));
 
                 msg_.Clear();
                 msg_.WriteNetID(node->GetID());
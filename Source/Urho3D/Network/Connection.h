@@ -23,10 +23,13 @@
 #pragma once
 
 #include "../Container/HashSet.h"
+#include "../Container/List.h"
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
 #include "../Input/Controls.h"
 #include "../IO/VectorBuffer.h"
+#include "../Network/InterestGrid.h"
+#include "../Network/MessageBuffer.h"
 #include "../Scene/ReplicationState.h"
 
 namespace SLNet
@@ -42,6 +45,7 @@ namespace SLNet
 namespace Urho3D
 {
 
+class Component;
 class File;
 class MemoryBuffer;
 class Node;
@@ -56,8 +60,8 @@ struct RemoteEvent
     unsigned senderID_;
     /// Event type.
     StringHash eventType_;
-    /// Event data.
-    VariantMap eventData_;
+    /// Serialized message, possibly shared with other connections.
+    SharedPtr<MessageBuffer> payload_;
     /// In order flag.
     bool inOrder_;
 };
@@ -96,6 +100,52 @@ struct PackageUpload
     unsigned totalFragments_;
 };
 
+/// Latest data update waiting for a delivery receipt, after which it becomes the delta baseline.
+struct PendingBaseline
+{
+    /// Node ID.
+    unsigned nodeID_;
+    /// Component ID, or 0 for node latest data.
+    unsigned componentID_;
+    /// Sent quantized state.
+    NetworkBaseline baseline_;
+};
+
+/// Latest data update that the client could not decode, to be reported to the server.
+struct MissingBaseline
+{
+    /// Node ID.
+    unsigned nodeID_;
+    /// Component ID, or 0 for node latest data.
+    unsigned componentID_;
+    /// Update sequence number.
+    unsigned short sequence_;
+};
+
+/// Controls sent from the client, kept for client-side prediction until processed by the server.
+struct SentControls
+{
+    /// Controls.
+    Controls controls_;
+    /// Time in seconds until the next controls were sent.
+    float timeStep_;
+    /// Controls timestamp.
+    unsigned char timeStamp_;
+};
+
+/// Message in transit over a loopback connection.
+struct LoopbackMessage
+{
+    /// Simulated delivery time in milliseconds.
+    unsigned deliveryTime_;
+    /// Message ID.
+    int msgID_;
+    /// Delivery receipt number to acknowledge to the sender, or 0 if none.
+    unsigned receipt_;
+    /// Message data.
+    PODVector<unsigned char> data_;
+};
+
 /// Send modes for observer position/rotation. Activated by the client setting either position or rotation.
 enum ObserverPositionSendMode
 {
@@ -110,7 +160,7 @@ class URHO3D_API Connection : public Object
     URHO3D_OBJECT(Connection, Object);
 
 public:
-    /// Construct with context, RakNet connection address and Raknet peer pointer.
+    /// Construct with context, RakNet connection address and Raknet peer pointer. A null peer creates a loopback connection, which is paired with a connection in another Network instance of the same process.
     Connection(Context* context, bool isClient, const SLNet::AddressOrGUID& address, SLNet::RakPeerInterface* peer);
     /// Destruct.
     ~Connection() override;
@@ -123,6 +173,8 @@ public:
     void SendRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
     /// Send a remote event with the specified node as sender.
     void SendRemoteEvent(Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
+    /// Queue a remote event already serialized with Network::EncodeRemoteEvent(). Called by Network.
+    void QueueRemoteEvent(unsigned senderID, StringHash eventType, MessageBuffer* payload, bool inOrder);
     /// Assign scene. On the server, this will cause the client to load it.
     void SetScene(Scene* newScene);
     /// Assign identity. Called by Network.
@@ -133,6 +185,8 @@ public:
     void SetPosition(const Vector3& position);
     /// Set the observer rotation for interest management, to be sent to the server. Note: not used by the NetworkPriority component.
     void SetRotation(const Quaternion& rotation);
+    /// Set the interest radius around the observer position on the XZ plane. Top-level replicated nodes (and their children) outside it are not replicated to the client, and are removed from the client when they move out. Zero (default) replicates all nodes.
+    void SetInterestRadius(float radius);
     /// Set the connection pending status. Called by Network.
     void SetConnectPending(bool connectPending);
     /// Set whether to log data in/out statistics.
@@ -141,6 +195,10 @@ public:
     void Disconnect(int waitMSec = 0);
     /// Send scene update messages. Called by Network.
     void SendServerUpdate();
+    /// Build and send scene update messages without modifying nodes or components. May be called for several connections in parallel, but must be followed by CommitServerUpdate(). Called by Network.
+    void ProcessServerUpdate();
+    /// Register replication states created by ProcessServerUpdate() to their nodes and components, and destroy the states of removed ones. Called by Network.
+    void CommitServerUpdate();
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
     /// Send queued remote events. Called by Network.
@@ -151,6 +209,14 @@ public:
     void ProcessPendingLatestData();
     /// Process a message from the server or client. Called by Network.
     bool ProcessMessage(int msgID, MemoryBuffer& msg);
+    /// Process a delivery receipt of a message sent with a receipt. Called by Network.
+    void ProcessSendReceipt(unsigned receipt, bool delivered);
+    /// Pair two loopback connections with each other. Called by Network.
+    static void ConnectLoopback(Connection* first, Connection* second);
+    /// Process delivery receipts of loopback messages that have reached the sender by the specified time in milliseconds. Called by Network.
+    void ProcessLoopbackReceipts(unsigned time);
+    /// Take the next loopback message that has been delivered by the specified time in milliseconds. Return false if none. Called by Network.
+    bool ReceiveLoopbackMessage(unsigned time, int& msgID, PODVector<unsigned char>& data);
     /// Ban this connections IP address.
     void Ban();
     /// Return the RakNet address/guid.
@@ -176,12 +242,18 @@ public:
     /// Return the observer rotation sent by the client for interest management.
     const Quaternion& GetRotation() const { return rotation_; }
 
+    /// Return interest radius.
+    float GetInterestRadius() const { return interestRadius_; }
+
     /// Return whether is a client connection.
     bool IsClient() const { return isClient_; }
 
     /// Return whether is fully connected.
     bool IsConnected() const;
 
+    /// Return whether is a loopback connection.
+    bool IsLoopback() const { return peer_ == nullptr; }
+
     /// Return whether connection is pending.
     bool IsConnectPending() const { return connectPending_; }
 
@@ -226,8 +298,8 @@ public:
     /// Trigger client connection to download a package file from the server. Can be used to download additional resource packages when client is already joined in a scene. The package must have been added as a requirement to the scene the client is joined in, or else the eventual download will fail.
     void SendPackageToClient(PackageFile* package);
 
-    /// Set network simulation parameters. Called by Network.
-    void ConfigureNetworkSimulator(int latencyMs, float packetLoss);
+    /// Set network simulation parameters. Bandwidth is in bytes per second, zero for unlimited. Loopback connections simulate all parameters in release builds too, while socket connections only support latency and packet loss in debug builds. Called by Network.
+    void ConfigureNetworkSimulator(int latencyMs, float packetLoss, unsigned bandwidth = 0);
 
     /// Current controls.
     Controls controls_;
@@ -255,6 +327,8 @@ private:
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
+    /// Process a MissingBaselines message from the client. Called by Network.
+    void ProcessMissingBaselines(int msgID, MemoryBuffer& msg);
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
     void ProcessNode(unsigned nodeID);
     /// Process a node that the client has not yet received.
@@ -275,6 +349,29 @@ private:
     void OnPackageDownloadFailed(const String& name);
     /// Handle all packages loaded successfully. Also called directly on MSG_LOADSCENE if there are none.
     void OnPackagesReady();
+    /// Send a reliable, unordered message and request a delivery receipt. Return the receipt number, or 0 if not sent.
+    unsigned SendMessageWithReceipt(int msgID, const VectorBuffer& msg);
+    /// Reset a predicted node to the received server state and replay the controls the server has not yet processed.
+    void ReconcilePrediction(Node* node);
+    /// Update the set of top-level nodes within the interest radius, and dirty the nodes entering or leaving it.
+    void UpdateInterest();
+    /// Return whether a node should be replicated to the client according to interest management.
+    bool IsInInterest(Node* node) const;
+    /// Pass a message to the paired loopback connection, simulating latency, packet loss and bandwidth.
+    void SendLoopbackMessage(int msgID, bool reliable, bool inOrder, const unsigned char* data, unsigned numBytes, unsigned receipt);
+    /// Return a random number between 0 and 1 for simulating loopback packet loss.
+    float LoopbackRandom();
+    /// Send a latest data update of a node or component, delta encoded against the last acknowledged state.
+    void SendLatestData(int msgID, Serializable* serializable, unsigned nodeID, unsigned componentID, NetworkBaseline& baseline);
+    /// Read a latest data update of a node or component. Queue a report to the server if its delta baseline is missing.
+    /// Return true if attributes were changed.
+    bool ReadLatestData(Serializable* serializable, unsigned nodeID, unsigned componentID, MemoryBuffer& msg);
+    /// Cache a latest data update received before its node or component.
+    void CacheLatestData(HashMap<unsigned, Vector<PODVector<unsigned char> > >& cache, unsigned id, MemoryBuffer& msg);
+    /// Apply the latest data updates cached for a node before it was created.
+    void ProcessPendingNodeLatestData(Node* node);
+    /// Apply the latest data updates cached for a component before it was created.
+    void ProcessPendingComponentLatestData(Component* component);
 
     /// Scene.
     WeakPtr<Scene> scene_;
@@ -284,16 +381,42 @@ private:
     HashMap<StringHash, PackageDownload> downloads_;
     /// Ongoing package send transfers.
     HashMap<StringHash, PackageUpload> uploads_;
-    /// Pending latest data for not yet received nodes.
-    HashMap<unsigned, PODVector<unsigned char> > nodeLatestData_;
-    /// Pending latest data for not yet received components.
-    HashMap<unsigned, PODVector<unsigned char> > componentLatestData_;
+    /// Pending latest data for not yet received nodes, in the order received.
+    HashMap<unsigned, Vector<PODVector<unsigned char> > > nodeLatestData_;
+    /// Pending latest data for not yet received components, in the order received.
+    HashMap<unsigned, Vector<PODVector<unsigned char> > > componentLatestData_;
+    /// Latest data updates with a missing delta baseline, to be reported to the server.
+    PODVector<MissingBaseline> missingBaselines_;
     /// Node ID's to process during a replication update.
     HashSet<unsigned> nodesToProcess_;
+    /// Node replication states created during the current update, to be registered to their nodes.
+    PODVector<Pair<Node*, NodeReplicationState*> > newNodeStates_;
+    /// Component replication states created during the current update, to be registered to their components.
+    PODVector<Pair<Component*, ComponentReplicationState*> > newComponentStates_;
+    /// IDs of removed nodes whose replication states are to be destroyed after the current update.
+    PODVector<unsigned> removedNodeStates_;
+    /// Component IDs of removed components whose replication states are to be destroyed after the current update.
+    PODVector<Pair<NodeReplicationState*, unsigned> > removedComponentStates_;
+    /// Sent latest data updates by delivery receipt number.
+    HashMap<unsigned, PendingBaseline> pendingBaselines_;
+    /// Latest data update sequence number. Incremented after each server update, skipping zero.
+    unsigned short updateSequence_;
+    /// IDs of top-level nodes within the interest radius.
+    HashSet<unsigned> interestNodes_;
+    /// Interest node IDs being built during the update.
+    HashSet<unsigned> newInterestNodes_;
+    /// Interest grid query result.
+    PODVector<InterestGridEntry> interestQueryResult_;
+    /// Interest radius, or zero if disabled.
+    float interestRadius_;
     /// Reusable message buffer.
     VectorBuffer msg_;
     /// Queued remote events.
     Vector<RemoteEvent> remoteEvents_;
+    /// Sent controls not yet known to be processed by the server, oldest first. Used on the client only.
+    Vector<SentControls> sentControls_;
+    /// Time since the latest controls were sent.
+    Timer sentControlsTimer_;
     /// Scene file to load once all packages (if any) have been downloaded.
     String sceneFileName_;
     /// Statistics timer.
@@ -326,6 +449,30 @@ private:
     Timer packetCounterTimer_;
     /// Last heard timer, resets when new packet is incoming
     Timer lastHeardTimer_;
+    /// Paired connection of a loopback connection. Null when disconnected.
+    WeakPtr<Connection> loopbackPeer_;
+    /// Loopback messages in transit to this connection, ordered by delivery time.
+    List<LoopbackMessage> loopbackInbox_;
+    /// Delivery times and numbers of loopback receipts in transit to this connection.
+    PODVector<Pair<unsigned, unsigned> > loopbackReceipts_;
+    /// Next loopback delivery receipt number.
+    unsigned loopbackReceipt_;
+    /// Time in milliseconds when the simulated loopback link has finished sending the queued messages.
+    double loopbackLinkTime_;
+    /// Delivery time of the latest ordered loopback message, which later ordered messages may not overtake.
+    unsigned loopbackOrderedTime_;
+    /// Random number generator state for simulating loopback packet loss.
+    unsigned loopbackRandomSeed_;
+    /// Temporary variable to hold loopback byte count in the next second, x - bytes in, y - bytes out
+    IntVector2 tempByteCounter_;
+    /// Loopback byte count in the last second, x - bytes in, y - bytes out
+    IntVector2 byteCounter_;
+    /// Simulated latency in milliseconds.
+    int simulatedLatency_;
+    /// Simulated packet loss probability.
+    float simulatedPacketLoss_;
+    /// Simulated bandwidth in bytes per second, or zero if unlimited.
+    unsigned simulatedBandwidth_;
 };
 
 }
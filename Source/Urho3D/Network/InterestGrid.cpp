@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Network/InterestGrid.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+InterestGrid::InterestGrid() :
+    cellSize_(1.0f)
+{
+}
+
+void InterestGrid::Build(Scene* scene, float cellSize)
+{
+    // Keep the per-cell vectors allocated between rebuilds, as most nodes stay in the same cells. Cells that the previous
+    // rebuild left empty are freed, so that the grid does not keep every cell the nodes have passed through
+    for (HashMap<unsigned long long, PODVector<InterestGridEntry> >::Iterator i = cells_.Begin(); i != cells_.End();)
+    {
+        if (i->second_.Empty())
+            i = cells_.Erase(i);
+        else
+        {
+            i->second_.Clear();
+            ++i;
+        }
+    }
+
+    cellSize_ = Max(cellSize, M_EPSILON);
+    float invCellSize = 1.0f / cellSize_;
+
+    const Vector<SharedPtr<Node> >& children = scene->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        Node* node = *i;
+        if (!node->IsReplicated())
+            continue;
+
+        InterestGridEntry entry;
+        entry.node_ = node;
+        entry.position_ = node->GetWorldPosition();
+        int x = FloorToInt(entry.position_.x_ * invCellSize);
+        int z = FloorToInt(entry.position_.z_ * invCellSize);
+        cells_[GetCellKey(x, z)].Push(entry);
+    }
+}
+
+void InterestGrid::GetNodes(PODVector<InterestGridEntry>& dest, const Vector3& position, float radius) const
+{
+    float radiusSquared = radius * radius;
+    float invCellSize = 1.0f / cellSize_;
+    int minX = FloorToInt((position.x_ - radius) * invCellSize);
+    int maxX = FloorToInt((position.x_ + radius) * invCellSize);
+    int minZ = FloorToInt((position.z_ - radius) * invCellSize);
+    int maxZ = FloorToInt((position.z_ + radius) * invCellSize);
+
+    for (int z = minZ; z <= maxZ; ++z)
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            HashMap<unsigned long long, PODVector<InterestGridEntry> >::ConstIterator i = cells_.Find(GetCellKey(x, z));
+            if (i == cells_.End())
+                continue;
+
+            const PODVector<InterestGridEntry>& entries = i->second_;
+            for (PODVector<InterestGridEntry>::ConstIterator j = entries.Begin(); j != entries.End(); ++j)
+            {
+                float dx = j->position_.x_ - position.x_;
+                float dz = j->position_.z_ - position.z_;
+                if (dx * dx + dz * dz <= radiusSquared)
+                    dest.Push(*j);
+            }
+        }
+    }
+}
+
+}
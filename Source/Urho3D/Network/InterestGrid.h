@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Math/Vector3.h"
+
+namespace Urho3D
+{
+
+class Node;
+class Scene;
+
+/// Node entry in the interest grid.
+struct InterestGridEntry
+{
+    /// Top-level replicated node.
+    Node* node_;
+    /// World position at the time of the grid build.
+    Vector3 position_;
+};
+
+/// Uniform grid of replicated top-level scene nodes on the XZ plane, used for network interest management.
+class URHO3D_API InterestGrid
+{
+public:
+    /// Construct.
+    InterestGrid();
+
+    /// Rebuild from the replicated child nodes of a scene.
+    void Build(Scene* scene, float cellSize);
+    /// Append entries within a radius of a position on the XZ plane. Does not access the nodes, so is safe to call from worker threads.
+    void GetNodes(PODVector<InterestGridEntry>& dest, const Vector3& position, float radius) const;
+
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+
+private:
+    /// Return cell key for cell coordinates.
+    static unsigned long long GetCellKey(int x, int z) { return ((unsigned long long)(unsigned)x << 32u) | (unsigned)z; }
+
+    /// Entries by cell key.
+    HashMap<unsigned long long, PODVector<InterestGridEntry> > cells_;
+    /// Cell size.
+    float cellSize_;
+};
+
+}
@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Network/MessageBuffer.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+MessageBufferPool::MessageBufferPool() :
+    nextIndex_(0)
+{
+}
+
+SharedPtr<MessageBuffer> MessageBufferPool::Acquire()
+{
+    // Buffers are usually released in the order they were acquired, so continue the search from the previous one
+    unsigned numBuffers = buffers_.Size();
+    for (unsigned i = 0; i < numBuffers; ++i)
+    {
+        unsigned index = (nextIndex_ + i) % numBuffers;
+        MessageBuffer* buffer = buffers_[index];
+        if (buffer->Refs() == 1)
+        {
+            nextIndex_ = index + 1;
+            buffer->GetBuffer().Clear();
+            return buffers_[index];
+        }
+    }
+
+    SharedPtr<MessageBuffer> buffer(new MessageBuffer());
+    buffers_.Push(buffer);
+    return buffer;
+}
+
+}
@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Container/Vector.h"
+#include "../IO/VectorBuffer.h"
+
+namespace Urho3D
+{
+
+/// Reference counted serialized network message payload. Can be shared between connections so that broadcast messages are encoded only once.
+class URHO3D_API MessageBuffer : public RefCounted
+{
+public:
+    /// Return payload for writing.
+    VectorBuffer& GetBuffer() { return buffer_; }
+
+    /// Return payload.
+    const VectorBuffer& GetBuffer() const { return buffer_; }
+
+private:
+    /// Payload.
+    VectorBuffer buffer_;
+};
+
+/// Pool of reusable message buffers. A buffer returns to the pool once only the pool references it. Not thread-safe.
+class URHO3D_API MessageBufferPool
+{
+public:
+    /// Construct.
+    MessageBufferPool();
+
+    /// Return an unused buffer with an empty payload, allocating one if necessary. The payload memory of reused buffers stays allocated.
+    SharedPtr<MessageBuffer> Acquire();
+
+    /// Return total number of buffers.
+    unsigned GetNumBuffers() const { return buffers_.Size(); }
+
+private:
+    /// All buffers.
+    Vector<SharedPtr<MessageBuffer> > buffers_;
+    /// Index to start searching for an unused buffer from.
+    unsigned nextIndex_;
+};
+
+}
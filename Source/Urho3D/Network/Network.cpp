@@ -25,6 +25,8 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
@@ -192,14 +194,27 @@ static const char* RAKNET_MESSAGEID_STRINGS[] = {
 
 static const int DEFAULT_UPDATE_FPS = 30;
 static const int SERVER_TIMEOUT_TIME = 10000;
+static const float DEFAULT_INTEREST_CELL_SIZE = 50.0f;
+/// High bits of the GUIDs identifying loopback connections.
+static const unsigned long long LOOPBACK_GUID_BASE = 0x4c4f4f5000000000ULL;
+
+/// Build the server update of a client connection in a worker thread.
+static void ProcessServerUpdateWork(const WorkItem* item, unsigned threadIndex)
+{
+    static_cast<Connection*>(item->start_)->ProcessServerUpdate();
+}
 
 Network::Network(Context* context) :
     Object(context),
     updateFps_(DEFAULT_UPDATE_FPS),
     simulatedLatency_(0),
     simulatedPacketLoss_(0.0f),
+    simulatedBandwidth_(0),
+    loopbackConnectionCount_(0),
+    loopbackServer_(false),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
     updateAcc_(0.0f),
+    interestCellSize_(DEFAULT_INTEREST_CELL_SIZE),
     isServer_(false),
     scene_(nullptr),
     natPunchServerAddress_(nullptr),
@@ -298,17 +313,7 @@ void Network::HandleMessage(const SLNet::AddressOrGUID& source, int packetID, in
     if (connection)
     {
         MemoryBuffer msg(data, (unsigned)numBytes);
-        if (connection->ProcessMessage((int)msgID, msg))
-            return;
-
-        // If message was not handled internally, forward as an event
-        using namespace NetworkMessage;
-
-        VariantMap& eventData = GetEventDataMap();
-        eventData[P_CONNECTION] = connection;
-        eventData[P_MESSAGEID] = (int)msgID;
-        eventData[P_DATA].SetBuffer(msg.GetData(), msg.GetSize());
-        connection->SendEvent(E_NETWORKMESSAGE, eventData);
+        HandleConnectionMessage(connection, msgID, msg);
     }
     else
         URHO3D_LOGWARNING("Discarding message from unknown MessageConnection " + String(source.ToString()));
@@ -317,16 +322,7 @@ void Network::HandleMessage(const SLNet::AddressOrGUID& source, int packetID, in
 void Network::NewConnectionEstablished(const SLNet::AddressOrGUID& connection)
 {
     // Create a new client connection corresponding to this MessageConnection
-    SharedPtr<Connection> newConnection(new Connection(context_, true, connection, rakPeer_));
-    newConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
-    clientConnections_[connection] = newConnection;
-    URHO3D_LOGINFO("Client " + newConnection->ToString() + " connected");
-
-    using namespace ClientConnected;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_CONNECTION] = newConnection;
-    newConnection->SendEvent(E_CLIENTCONNECTED, eventData);
+    AddClientConnection(new Connection(context_, true, connection, rakPeer_));
 }
 
 void Network::ClientDisconnected(const SLNet::AddressOrGUID& connection)
@@ -403,13 +399,54 @@ bool Network::Connect(const String& address, unsigned short port, Scene* scene,
         serverConnection_->SetScene(scene);
         serverConnection_->SetIdentity(identity);
         serverConnection_->SetConnectPending(true);
-        serverConnection_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+        serverConnection_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_, simulatedBandwidth_);
 
         URHO3D_LOGINFO("Connecting to server " + address + ":" + String(port) + ", Client: " + serverConnection_->ToString());
         return true;
     }
 }
 
+bool Network::ConnectLoopback(Network* server, Scene* scene, const VariantMap& identity)
+{
+    URHO3D_PROFILE(ConnectLoopback);
+
+    if (!server || !server->IsServerRunning())
+    {
+        URHO3D_LOGERROR("Failed to connect to loopback server, server is not running");
+        SendEvent(E_CONNECTFAILED);
+        return false;
+    }
+
+    if (serverConnection_)
+    {
+        serverConnection_->Disconnect();
+        OnServerDisconnected();
+    }
+
+    // Both ends use a GUID unique within the server. Vary the bits that affect its hash
+    SLNet::RakNetGUID guid(LOOPBACK_GUID_BASE | (unsigned long long)++server->loopbackConnectionCount_ << 9);
+    serverConnection_ = new Connection(context_, false, guid, nullptr);
+    serverConnection_->SetScene(scene);
+    serverConnection_->SetIdentity(identity);
+    serverConnection_->SetConnectPending(true);
+    serverConnection_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_, simulatedBandwidth_);
+
+    // Pair with the server end before it is announced, so that event handlers can already send to the client
+    auto* clientConnection = new Connection(server->context_, true, guid, nullptr);
+    Connection::ConnectLoopback(serverConnection_, clientConnection);
+    server->AddClientConnection(clientConnection);
+
+    // The connection may have been refused by an event handler
+    if (!serverConnection_->IsConnected())
+    {
+        OnServerDisconnected();
+        return false;
+    }
+
+    OnServerConnected(guid);
+    return true;
+}
+
 void Network::Disconnect(int waitMSec)
 {
     if (!serverConnection_)
@@ -419,6 +456,17 @@ void Network::Disconnect(int waitMSec)
     serverConnection_->Disconnect(waitMSec);
 }
 
+bool Network::StartLoopbackServer()
+{
+    if (IsServerRunning())
+        return true;
+
+    URHO3D_LOGINFO("Started loopback server");
+    isServer_ = true;
+    loopbackServer_ = true;
+    return true;
+}
+
 bool Network::StartServer(unsigned short port)
 {
     if (IsServerRunning())
@@ -452,6 +500,14 @@ void Network::StopServer()
 {
     clientConnections_.Clear();
 
+    if (loopbackServer_)
+    {
+        isServer_ = false;
+        loopbackServer_ = false;
+        URHO3D_LOGINFO("Stopped loopback server");
+        return;
+    }
+
     if (!rakPeer_)
         return;
 
@@ -529,29 +585,40 @@ void Network::BroadcastMessage(int msgID, bool reliable, bool inOrder, const uns
         return;
     }
 
-    VectorBuffer msgData;
-    msgData.WriteUByte((unsigned char)msgID);
-    msgData.Write(data, numBytes);
+    // Send once to all connections, passing the message ID and payload to the transport without an intermediate copy
+    auto id = (unsigned char)msgID;
+    const char* segments[] = { (const char*)&id, (const char*)data };
+    int lengths[] = { 1, (int)numBytes };
 
     if (isServer_)
-        rakPeer_->Send((const char*)msgData.GetData(), (int)msgData.GetSize(), HIGH_PRIORITY, RELIABLE, (char)0, SLNet::UNASSIGNED_RAKNET_GUID, true);
+        rakPeer_->SendList(segments, lengths, numBytes ? 2 : 1, HIGH_PRIORITY, RELIABLE, (char)0, SLNet::UNASSIGNED_RAKNET_GUID, true);
     else
         URHO3D_LOGERROR("Server not running, can not broadcast messages");
 }
 
 void Network::BroadcastRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData)
 {
+    if (clientConnections_.Empty())
+        return;
+
+    // Serialize once, and share the payload between the connections
+    SharedPtr<MessageBuffer> payload = EncodeRemoteEvent(0, eventType, eventData);
     for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin(); i != clientConnections_.End(); ++i)
-        i->second_->SendRemoteEvent(eventType, inOrder, eventData);
+        i->second_->QueueRemoteEvent(0, eventType, payload, inOrder);
 }
 
 void Network::BroadcastRemoteEvent(Scene* scene, StringHash eventType, bool inOrder, const VariantMap& eventData)
 {
+    SharedPtr<MessageBuffer> payload;
     for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
          i != clientConnections_.End(); ++i)
     {
         if (i->second_->GetScene() == scene)
-            i->second_->SendRemoteEvent(eventType, inOrder, eventData);
+        {
+            if (!payload)
+                payload = EncodeRemoteEvent(0, eventType, eventData);
+            i->second_->QueueRemoteEvent(0, eventType, payload, inOrder);
+        }
     }
 }
 
@@ -569,14 +636,30 @@ void Network::BroadcastRemoteEvent(Node* node, StringHash eventType, bool inOrde
     }
 
     Scene* scene = node->GetScene();
+    SharedPtr<MessageBuffer> payload;
     for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
          i != clientConnections_.End(); ++i)
     {
         if (i->second_->GetScene() == scene)
-            i->second_->SendRemoteEvent(node, eventType, inOrder, eventData);
+        {
+            if (!payload)
+                payload = EncodeRemoteEvent(node->GetID(), eventType, eventData);
+            i->second_->QueueRemoteEvent(node->GetID(), eventType, payload, inOrder);
+        }
     }
 }
 
+SharedPtr<MessageBuffer> Network::EncodeRemoteEvent(unsigned senderID, StringHash eventType, const VariantMap& eventData)
+{
+    SharedPtr<MessageBuffer> payload = messageBufferPool_.Acquire();
+    VectorBuffer& buffer = payload->GetBuffer();
+    if (senderID)
+        buffer.WriteNetID(senderID);
+    buffer.WriteStringHash(eventType);
+    buffer.WriteVariantMap(eventData);
+    return payload;
+}
+
 void Network::SetUpdateFps(int fps)
 {
     updateFps_ = Max(fps, 1);
@@ -584,6 +667,11 @@ void Network::SetUpdateFps(int fps)
     updateAcc_ = 0.0f;
 }
 
+void Network::SetInterestCellSize(float size)
+{
+    interestCellSize_ = Max(size, M_EPSILON);
+}
+
 void Network::SetSimulatedLatency(int ms)
 {
     simulatedLatency_ = Max(ms, 0);
@@ -596,6 +684,12 @@ void Network::SetSimulatedPacketLoss(float probability)
     ConfigureNetworkSimulator();
 }
 
+void Network::SetSimulatedBandwidth(unsigned bytesPerSec)
+{
+    simulatedBandwidth_ = bytesPerSec;
+    ConfigureNetworkSimulator();
+}
+
 void Network::RegisterRemoteEvent(StringHash eventType)
 {
     if (blacklistedRemoteEvents_.Find(eventType) != blacklistedRemoteEvents_.End())
@@ -672,6 +766,12 @@ Connection* Network::GetConnection(const SLNet::AddressOrGUID& connection) const
     }
 }
 
+const InterestGrid* Network::GetInterestGrid(Scene* scene) const
+{
+    HashMap<Scene*, InterestGrid>::ConstIterator i = interestGrids_.Find(scene);
+    return i != interestGrids_.End() ? &i->second_ : nullptr;
+}
+
 Connection* Network::GetServerConnection() const
 {
     return serverConnection_;
@@ -689,6 +789,8 @@ Vector<SharedPtr<Connection> > Network::GetClientConnections() const
 
 bool Network::IsServerRunning() const
 {
+    if (loopbackServer_)
+        return isServer_;
     if (!rakPeer_)
         return false;
     return rakPeer_->IsActive() && isServer_;
@@ -836,6 +938,17 @@ void Network::HandleIncomingPacket(SLNet::Packet* packet, bool isServer)
     {
         //URHO3D_LOGINFO("101010");
     }
+    else if (packetID == ID_SND_RECEIPT_ACKED || packetID == ID_SND_RECEIPT_LOSS) // Delivery receipt of a sent message
+    {
+        Connection* connection = GetConnection(packet->systemAddress);
+        if (connection && packet->length >= dataStart + sizeof(unsigned))
+        {
+            unsigned receipt;
+            memcpy(&receipt, packet->data + dataStart, sizeof receipt);
+            connection->ProcessSendReceipt(receipt, packetID == ID_SND_RECEIPT_ACKED);
+        }
+        packetHandled = true;
+    }
     else if (packetID == ID_UNCONNECTED_PING)
     {
         packetHandled = true;
@@ -913,6 +1026,33 @@ void Network::Update(float timeStep)
             rakPeerClient_->DeallocatePacket(packet);
         }
     }
+
+    // Deliver the messages of loopback connections that have arrived by now, and detect their disconnection
+    unsigned time = Time::GetSystemTime();
+    if (serverConnection_ && serverConnection_->IsLoopback())
+    {
+        ProcessLoopbackMessages(serverConnection_, time);
+        if (serverConnection_ && serverConnection_->IsLoopback() && !serverConnection_->IsConnected())
+            OnServerDisconnected();
+    }
+
+    for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::ConstIterator i = clientConnections_.Begin();
+         i != clientConnections_.End(); ++i)
+    {
+        if (i->second_->IsLoopback())
+            loopbackConnections_.Push(i->second_);
+    }
+    if (!loopbackConnections_.Empty())
+    {
+        for (unsigned i = 0; i < loopbackConnections_.Size(); ++i)
+            ProcessLoopbackMessages(loopbackConnections_[i], time);
+        for (unsigned i = 0; i < loopbackConnections_.Size(); ++i)
+        {
+            if (!loopbackConnections_[i]->IsConnected())
+                ClientDisconnected(loopbackConnections_[i]->GetAddressOrGUID());
+        }
+        loopbackConnections_.Clear();
+    }
 }
 
 void Network::PostUpdate(float timeStep)
@@ -935,28 +1075,71 @@ void Network::PostUpdate(float timeStep)
                 URHO3D_PROFILE(PrepareServerUpdate);
 
                 networkScenes_.Clear();
+                HashSet<Scene*> interestScenes;
                 for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
                      i != clientConnections_.End(); ++i)
                 {
                     Scene* scene = i->second_->GetScene();
                     if (scene)
+                    {
                         networkScenes_.Insert(scene);
+                        if (i->second_->GetInterestRadius() > 0.0f)
+                            interestScenes.Insert(scene);
+                    }
                 }
 
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
                     (*i)->PrepareNetworkUpdate();
+
+                // Index the scenes spatially for connections that use interest management. Stale grids are removed, as their
+                // scenes may have been destroyed
+                for (HashMap<Scene*, InterestGrid>::Iterator i = interestGrids_.Begin(); i != interestGrids_.End();)
+                {
+                    if (!interestScenes.Contains(i->first_))
+                        i = interestGrids_.Erase(i);
+                    else
+                        ++i;
+                }
+                for (HashSet<Scene*>::ConstIterator i = interestScenes.Begin(); i != interestScenes.End(); ++i)
+                    interestGrids_[*i].Build(*i, interestCellSize_);
             }
 
             {
                 URHO3D_PROFILE(SendServerUpdate);
 
-                // Then send server updates for each client connection
+                // Then build server updates for each client connection. Connections only modify their own replication
+                // state while building, so they can be processed in parallel
+                updateConnections_.Clear();
                 for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
                      i != clientConnections_.End(); ++i)
+                    updateConnections_.Push(i->second_);
+
+                auto* queue = GetSubsystem<WorkQueue>();
+                if (queue && queue->GetNumThreads() && !queue->IsCompleting() && updateConnections_.Size() > 1)
                 {
-                    i->second_->SendServerUpdate();
-                    i->second_->SendRemoteEvents();
-                    i->second_->SendPackages();
+                    for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                    {
+                        SharedPtr<WorkItem> item = queue->GetFreeItem();
+                        item->priority_ = M_MAX_UNSIGNED;
+                        item->workFunction_ = ProcessServerUpdateWork;
+                        item->start_ = updateConnections_[i];
+                        queue->AddWorkItem(item);
+                    }
+                    queue->Complete(M_MAX_UNSIGNED);
+                }
+                else
+                {
+                    for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                        updateConnections_[i]->ProcessServerUpdate();
+                }
+
+                // Register new replication states and send other queued data in a deterministic order
+                for (unsigned i = 0; i < updateConnections_.Size(); ++i)
+                {
+                    Connection* connection = updateConnections_[i];
+                    connection->CommitServerUpdate();
+                    connection->SendRemoteEvents();
+                    connection->SendPackages();
                 }
             }
         }
@@ -1019,14 +1202,56 @@ void Network::OnServerDisconnected()
     }
 }
 
+void Network::AddClientConnection(Connection* newConnection)
+{
+    newConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_, simulatedBandwidth_);
+    clientConnections_[newConnection->GetAddressOrGUID()] = newConnection;
+    URHO3D_LOGINFO("Client " + newConnection->ToString() + " connected");
+
+    using namespace ClientConnected;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_CONNECTION] = newConnection;
+    newConnection->SendEvent(E_CLIENTCONNECTED, eventData);
+}
+
+void Network::HandleConnectionMessage(Connection* connection, int msgID, MemoryBuffer& msg)
+{
+    if (connection->ProcessMessage(msgID, msg))
+        return;
+
+    // If message was not handled internally, forward as an event
+    using namespace NetworkMessage;
+
+    VariantMap& eventData = GetEventDataMap();
+    eventData[P_CONNECTION] = connection;
+    eventData[P_MESSAGEID] = msgID;
+    eventData[P_DATA].SetBuffer(msg.GetData(), msg.GetSize());
+    connection->SendEvent(E_NETWORKMESSAGE, eventData);
+}
+
+void Network::ProcessLoopbackMessages(Connection* connection, unsigned time)
+{
+    // Keep the connection alive, as message handlers may remove it
+    SharedPtr<Connection> connectionPtr(connection);
+    connection->ProcessLoopbackReceipts(time);
+
+    int msgID;
+    while (connection->IsConnected() && connection->ReceiveLoopbackMessage(time, msgID, loopbackData_))
+    {
+        MemoryBuffer msg(loopbackData_);
+        HandleConnectionMessage(connection, msgID, msg);
+    }
+}
+
 void Network::ConfigureNetworkSimulator()
 {
     if (serverConnection_)
-        serverConnection_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+        serverConnection_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_, simulatedBandwidth_);
 
     for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
          i != clientConnections_.End(); ++i)
-        i->second_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+        i->second_->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_, simulatedBandwidth_);
 }
 
 void RegisterNetworkLibrary(Context* context)
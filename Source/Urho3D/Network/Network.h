@@ -26,6 +26,7 @@
 #include "../Core/Object.h"
 #include "../IO/VectorBuffer.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestGrid.h"
 
 namespace Urho3D
 {
@@ -68,6 +69,10 @@ public:
     bool StartServer(unsigned short port);
     /// Stop the server.
     void StopServer();
+    /// Start a server without a socket, which only accepts loopback connections from other Network instances of the same process. Return true if successful.
+    bool StartLoopbackServer();
+    /// Connect to a server Network instance of the same process over a simulated in-process link, which applies the simulated latency, packet loss and bandwidth of each end to its outgoing messages. The server may run in another context, but both Networks must be updated from the same thread. Return true if successful.
+    bool ConnectLoopback(Network* server, Scene* scene, const VariantMap& identity = Variant::emptyVariantMap);
     /// Start NAT punchtrough client to allow remote connections.
     void StartNATClient();
     /// Get local server GUID.
@@ -84,12 +89,18 @@ public:
     void BroadcastRemoteEvent(Scene* scene, StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
     /// Broadcast a remote event with the specified node as a sender. Is sent to all client connections in the node's scene.
     void BroadcastRemoteEvent(Node* node, StringHash eventType, bool inOrder, const VariantMap& eventData = Variant::emptyVariantMap);
+    /// Serialize a remote event into a pooled message buffer, which can be queued to several connections. Sender ID is zero if not a remote node event.
+    SharedPtr<MessageBuffer> EncodeRemoteEvent(unsigned senderID, StringHash eventType, const VariantMap& eventData);
     /// Set network update FPS.
     void SetUpdateFps(int fps);
+    /// Set cell size of the spatial grid used for client connections with an interest radius. Should be in the order of the interest radius. Default 50.
+    void SetInterestCellSize(float size);
     /// Set simulated latency in milliseconds. This adds a fixed delay before sending each packet.
     void SetSimulatedLatency(int ms);
     /// Set simulated packet loss probability between 0.0 - 1.0.
     void SetSimulatedPacketLoss(float probability);
+    /// Set simulated outgoing bandwidth in bytes per second, or zero for unlimited. Only applies to loopback connections.
+    void SetSimulatedBandwidth(unsigned bytesPerSec);
     /// Register a remote event as allowed to be received. There is also a fixed blacklist of events that can not be allowed in any case, such as ConsoleCommand.
     void RegisterRemoteEvent(StringHash eventType);
     /// Unregister a remote event as allowed to received.
@@ -107,12 +118,18 @@ public:
     /// Return network update FPS.
     int GetUpdateFps() const { return updateFps_; }
 
+    /// Return interest grid cell size.
+    float GetInterestCellSize() const { return interestCellSize_; }
+
     /// Return simulated latency in milliseconds.
     int GetSimulatedLatency() const { return simulatedLatency_; }
 
     /// Return simulated packet loss probability.
     float GetSimulatedPacketLoss() const { return simulatedPacketLoss_; }
 
+    /// Return simulated outgoing bandwidth in bytes per second.
+    unsigned GetSimulatedBandwidth() const { return simulatedBandwidth_; }
+
     /// Return a client or server connection by RakNet connection address, or null if none exist.
     Connection* GetConnection(const SLNet::AddressOrGUID& connection) const;
     /// Return the connection to the server. Null if not connected.
@@ -124,6 +141,9 @@ public:
     /// Return whether a remote event is allowed to be received.
     bool CheckRemoteEvent(StringHash eventType) const;
 
+    /// Return the interest management grid of a scene for the current server update, or null if not built.
+    const InterestGrid* GetInterestGrid(Scene* scene) const;
+
     /// Return the package download cache directory.
     const String& GetPackageCacheDir() const { return packageCacheDir_; }
 
@@ -141,6 +161,12 @@ private:
     void OnServerConnected(const SLNet::AddressOrGUID& address);
     /// Handle server disconnection.
     void OnServerDisconnected();
+    /// Register a new client connection and send the connected event.
+    void AddClientConnection(Connection* newConnection);
+    /// Process a message received by a connection, or send it as an event if not handled by the connection.
+    void HandleConnectionMessage(Connection* connection, int msgID, MemoryBuffer& msg);
+    /// Deliver the due messages and receipts of a loopback connection.
+    void ProcessLoopbackMessages(Connection* connection, unsigned time);
     /// Reconfigure network simulator parameters on all existing connections.
     void ConfigureNetworkSimulator();
     /// All incoming packages are handled here.
@@ -160,16 +186,34 @@ private:
     HashSet<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
     HashSet<Scene*> networkScenes_;
+    /// Client connections to process during a server update.
+    PODVector<Connection*> updateConnections_;
+    /// Reusable message buffers for serialized remote events.
+    MessageBufferPool messageBufferPool_;
+    /// Interest management grids of networked scenes.
+    HashMap<Scene*, InterestGrid> interestGrids_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
     int simulatedLatency_;
     /// Simulated packet loss probability between 0.0 - 1.0.
     float simulatedPacketLoss_;
+    /// Simulated outgoing bandwidth in bytes per second, or zero if unlimited.
+    unsigned simulatedBandwidth_;
+    /// Loopback client connections to process during an update.
+    Vector<SharedPtr<Connection> > loopbackConnections_;
+    /// Reusable buffer for received loopback messages.
+    PODVector<unsigned char> loopbackData_;
+    /// Number of loopback connections accepted, used to identify them.
+    unsigned loopbackConnectionCount_;
+    /// Whether the server only accepts loopback connections.
+    bool loopbackServer_;
     /// Update time interval.
     float updateInterval_;
     /// Update time accumulator.
     float updateAcc_;
+    /// Interest grid cell size.
+    float interestCellSize_;
     /// Package cache directory.
     String packageCacheDir_;
     /// Whether we started as server or not.
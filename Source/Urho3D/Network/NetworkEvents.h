@@ -85,6 +85,19 @@ URHO3D_EVENT(E_NETWORKUPDATESENT, NetworkUpdateSent)
 {
 }
 
+/// Client-side prediction: a predicted node was reset to the state received from the server, and the controls not yet processed by the server are replayed, oldest first. Apply them to the node for the time step as the client-side movement does.
+URHO3D_EVENT(E_REPLAYCONTROLS, ReplayControls)
+{
+    URHO3D_PARAM(P_CONNECTION, Connection);      // Connection pointer
+    URHO3D_PARAM(P_NODE, Node);                  // Node pointer
+    URHO3D_PARAM(P_BUTTONS, Buttons);            // unsigned
+    URHO3D_PARAM(P_YAW, Yaw);                    // float
+    URHO3D_PARAM(P_PITCH, Pitch);                // float
+    URHO3D_PARAM(P_EXTRADATA, ExtraData);        // VariantMap
+    URHO3D_PARAM(P_TIMESTAMP, TimeStamp);        // unsigned (0-255)
+    URHO3D_PARAM(P_TIMESTEP, TimeStep);          // float
+}
+
 /// Scene load failed, either due to file not found or checksum error.
 URHO3D_EVENT(E_NETWORKSCENELOADFAILED, NetworkSceneLoadFailed)
 {
@@ -63,6 +63,8 @@ static const int MSG_REMOTEEVENT = 0x96;
 static const int MSG_REMOTENODEEVENT = 0x97;
 /// Server->client: info about package.
 static const int MSG_PACKAGEINFO = 0x98;
+/// Client->server: latest data updates that could not be decoded due to a missing delta baseline.
+static const int MSG_MISSINGBASELINES = 0x99;
 
 /// Fixed content ID for client controls update.
 static const unsigned CONTROLS_CONTENT_ID = 1;
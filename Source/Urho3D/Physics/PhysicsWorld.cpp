@@ -25,6 +25,7 @@
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Model.h"
 #include "../IO/Log.h"
@@ -46,7 +47,11 @@
 #include <Bullet/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
-#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <Bullet/BulletDynamics/Dynamics/btSimulationIslandManagerMt.h>
+#include <Bullet/LinearMath/btTransformUtil.h>
+
+#include <atomic>
 
 extern ContactAddedCallback gContactAddedCallback;
 
@@ -144,6 +149,474 @@ struct PhysicsQueryCallback : public btCollisionWorld::ContactResultCallback
     unsigned collisionMask_;
 };
 
+/// Loop shared by the work items of a parallel physics loop.
+struct PhysicsParallelLoop
+{
+    /// Next index to process.
+    std::atomic<unsigned> next_;
+    /// Number of indices.
+    unsigned count_;
+    /// Number of indices taken at a time.
+    unsigned batchSize_;
+    /// Loop body, called with an index range and the work queue thread index.
+    void (*function_)(void* data, unsigned start, unsigned end, unsigned threadIndex);
+    /// Loop body data.
+    void* data_;
+};
+
+static void PhysicsParallelLoopWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* loop = reinterpret_cast<PhysicsParallelLoop*>(item->aux_);
+
+    // Take batches until the loop is done, so that threads which get cheap batches take more of them
+    for (;;)
+    {
+        unsigned start = loop->next_.fetch_add(loop->batchSize_);
+        if (start >= loop->count_)
+            break;
+        loop->function_(loop->data_, start, Min(start + loop->batchSize_, loop->count_), threadIndex);
+    }
+}
+
+/// Run a loop in batches on the work queue and wait for it to finish. Run it directly if it has only one batch or there is
+/// no work queue or worker threads.
+static void RunPhysicsParallelLoop(WorkQueue* queue, unsigned count, unsigned batchSize,
+    void (*function)(void* data, unsigned start, unsigned end, unsigned threadIndex), void* data)
+{
+    unsigned numBatches = (count + batchSize - 1) / batchSize;
+    if (numBatches <= 1 || !queue || !queue->GetNumThreads())
+    {
+        if (count)
+            function(data, 0, count, 0);
+        return;
+    }
+
+    PhysicsParallelLoop loop;
+    loop.next_ = 0;
+    loop.count_ = count;
+    loop.batchSize_ = batchSize;
+    loop.function_ = function;
+    loop.data_ = data;
+
+    unsigned numWorkItems = Min(numBatches, queue->GetNumThreads() + 1);
+    for (unsigned i = 0; i < numWorkItems; ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = PhysicsParallelLoopWork;
+        item->aux_ = &loop;
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+/// Collision dispatcher which can run the narrowphase of the overlapping pairs in parallel.
+class PhysicsCollisionDispatcher : public btCollisionDispatcher
+{
+public:
+    /// Construct.
+    explicit PhysicsCollisionDispatcher(btCollisionConfiguration* collisionConfiguration) :
+        btCollisionDispatcher(collisionConfiguration)
+    {
+    }
+
+    /// Create a manifold. Called by the collision algorithms, possibly from several threads.
+    btPersistentManifold* getNewManifold(const btCollisionObject* body0, const btCollisionObject* body1) override
+    {
+        MutexLock lock(manifoldMutex_);
+        return btCollisionDispatcher::getNewManifold(body0, body1);
+    }
+
+    /// Destroy a manifold. Called by the collision algorithms, possibly from several threads.
+    void releaseManifold(btPersistentManifold* manifold) override
+    {
+        MutexLock lock(manifoldMutex_);
+        btCollisionDispatcher::releaseManifold(manifold);
+    }
+
+    /// Run the narrowphase of all overlapping pairs.
+    void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo,
+        btDispatcher* dispatcher) override
+    {
+        if (!workQueue_)
+        {
+            btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+            return;
+        }
+
+        pairs_ = pairCache->getOverlappingPairArrayPtr();
+        dispatchInfo_ = &dispatchInfo;
+        RunPhysicsParallelLoop(workQueue_, (unsigned)pairCache->getNumOverlappingPairs(), PAIRS_PER_BATCH, DispatchPairs, this);
+
+        // Manifolds created by the threads are in the order the threads happened to create them, which affects the solver
+        if (deterministic_)
+            SortManifolds(pairCache);
+    }
+
+    /// Work queue for the narrowphase, or null to run it the same way as btCollisionDispatcher.
+    WorkQueue* workQueue_{};
+    /// Deterministic manifold order flag.
+    bool deterministic_{true};
+
+private:
+    /// Run the narrowphase of a pair range.
+    static void DispatchPairs(void* data, unsigned start, unsigned end, unsigned /*threadIndex*/)
+    {
+        auto* dispatcher = static_cast<PhysicsCollisionDispatcher*>(data);
+        btNearCallback nearCallback = dispatcher->getNearCallback();
+        for (unsigned i = start; i < end; ++i)
+            nearCallback(dispatcher->pairs_[i], *dispatcher, *dispatcher->dispatchInfo_);
+    }
+
+    /// Order the manifolds by overlapping pair. Manifolds not owned by the pairs, e.g. those of ghost object pair caches,
+    /// keep their order after them.
+    void SortManifolds(btOverlappingPairCache* pairCache)
+    {
+        for (int i = 0; i < m_manifoldsPtr.size(); ++i)
+            m_manifoldsPtr[i]->m_index1a = -1;
+
+        sortedManifolds_.resize(0);
+        btBroadphasePair* pairs = pairCache->getOverlappingPairArrayPtr();
+        for (int i = 0; i < pairCache->getNumOverlappingPairs(); ++i)
+        {
+            if (!pairs[i].m_algorithm)
+                continue;
+
+            pairManifolds_.resize(0);
+            pairs[i].m_algorithm->getAllContactManifolds(pairManifolds_);
+            for (int j = 0; j < pairManifolds_.size(); ++j)
+                AddSortedManifold(pairManifolds_[j]);
+        }
+        for (int i = 0; i < m_manifoldsPtr.size(); ++i)
+            AddSortedManifold(m_manifoldsPtr[i]);
+
+        m_manifoldsPtr.copyFromArray(sortedManifolds_);
+    }
+
+    /// Add a manifold to the sorted manifolds unless already added. The index is needed for releasing the manifold.
+    void AddSortedManifold(btPersistentManifold* manifold)
+    {
+        if (manifold->m_index1a < 0)
+        {
+            manifold->m_index1a = sortedManifolds_.size();
+            sortedManifolds_.push_back(manifold);
+        }
+    }
+
+    /// Number of overlapping pairs processed at a time.
+    static const unsigned PAIRS_PER_BATCH = 32;
+
+    /// Overlapping pairs being processed.
+    btBroadphasePair* pairs_{};
+    /// Dispatch info of the pairs being processed.
+    const btDispatcherInfo* dispatchInfo_{};
+    /// Manifold creation and destruction mutex.
+    Mutex manifoldMutex_;
+    /// Manifolds in the deterministic order.
+    btManifoldArray sortedManifolds_;
+    /// Manifolds of one overlapping pair.
+    btManifoldArray pairManifolds_;
+};
+
+/// World transform of a moving rigid body, published after a simulation step.
+struct RigidBodySnapshot
+{
+    /// Bullet rigid body.
+    btRigidBody* body_;
+    /// Rigid body component.
+    RigidBody* rigidBody_;
+    /// Time to extrapolate the last simulated transform by.
+    float time_;
+    /// Whether the body has fallen asleep, in which case its world transform is final.
+    bool sleeping_;
+    /// World position of the node.
+    Vector3 position_;
+    /// World rotation of the node.
+    Quaternion rotation_;
+};
+
+/// Number of snapshots interpolated at a time.
+static const unsigned SNAPSHOTS_PER_BATCH = 256;
+
+/// Dynamics world which can solve its simulation islands in parallel and publishes the rigid body transforms as snapshots.
+ATTRIBUTE_ALIGNED16(class) PhysicsDynamicsWorld : public btDiscreteDynamicsWorldMt
+{
+public:
+    BT_DECLARE_ALIGNED_ALLOCATOR();
+
+    /// Construct.
+    PhysicsDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* broadphase, btConstraintSolver* constraintSolver,
+        btCollisionConfiguration* collisionConfiguration) :
+        btDiscreteDynamicsWorldMt(dispatcher, broadphase, constraintSolver, collisionConfiguration)
+    {
+        static_cast<btSimulationIslandManagerMt*>(m_islandManager)->setIslandDispatchFunction(DispatchIslands);
+    }
+
+    /// Work queue for solving the islands, or null to solve them like btDiscreteDynamicsWorld.
+    WorkQueue* workQueue_{};
+
+protected:
+    /// Publish the interpolated transforms of the active rigid bodies as snapshots instead of setting them to the motion
+    /// states one by one, then apply them to the nodes. Sleeping bodies are skipped, except for once when they fall asleep.
+    void synchronizeMotionStates() override
+    {
+        snapshots_.Clear();
+
+        // Interpolate the same way as btDiscreteDynamicsWorld::synchronizeSingleMotionState()
+        bool latency = m_latencyMotionStateInterpolation && m_fixedTimeStep;
+        for (int i = 0; i < m_nonStaticRigidBodies.size(); ++i)
+        {
+            btRigidBody* body = m_nonStaticRigidBodies[i];
+            if (!body->getMotionState() || body->isStaticOrKinematicObject())
+                continue;
+
+            // Bodies added to the world directly may have motion states of their own
+            auto* rigidBody = static_cast<RigidBody*>(body->getUserPointer());
+            if (!rigidBody || static_cast<btMotionState*>(rigidBody) != body->getMotionState())
+            {
+                synchronizeSingleMotionState(body);
+                continue;
+            }
+
+            bool sleeping = !body->isActive();
+            if (sleeping)
+            {
+                // The interpolation velocities of a sleeping body are left from its last step. Publish its final transform
+                // once, and mark it published by clearing them. They are set again by the next step it is simulated in
+                if (body->getInterpolationLinearVelocity().isZero() && body->getInterpolationAngularVelocity().isZero())
+                    continue;
+                body->setInterpolationLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+                body->setInterpolationAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+            }
+
+            RigidBodySnapshot snapshot;
+            snapshot.body_ = body;
+            snapshot.rigidBody_ = rigidBody;
+            snapshot.time_ = latency ? m_localTime - m_fixedTimeStep : m_localTime * body->getHitFraction();
+            snapshot.sleeping_ = sleeping;
+            snapshots_.Push(snapshot);
+        }
+
+        if (workQueue_)
+            RunPhysicsParallelLoop(workQueue_, snapshots_.Size(), SNAPSHOTS_PER_BATCH, InterpolateSnapshots, &snapshots_);
+        else
+            InterpolateSnapshots(&snapshots_, 0, snapshots_.Size(), 0);
+
+        // Apply on the calling thread, as moving the nodes sends events. Bullet synchronizes after every substep, so the
+        // handlers of the next substep see the moved nodes, and a body falling asleep in any substep gets its final transform
+        for (Vector<RigidBodySnapshot>::ConstIterator i = snapshots_.Begin(); i != snapshots_.End(); ++i)
+            i->rigidBody_->ApplySimulatedTransform(i->position_, i->rotation_);
+    }
+
+    /// Solve the constraints of all active islands.
+    void solveConstraints(btContactSolverInfo& solverInfo) override
+    {
+        // Without threads, solve the islands the way btDiscreteDynamicsWorld does, which does not merge them into batches
+        if (!workQueue_)
+        {
+            btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+            return;
+        }
+
+        islandCallback_.world_ = this;
+        islandCallback_.solverInfo_ = &solverInfo;
+        m_constraintSolver->prepareSolve(getNumCollisionObjects(), getDispatcher()->getNumManifolds());
+        static_cast<btSimulationIslandManagerMt*>(m_islandManager)->buildAndProcessIslands(getDispatcher(), this, m_constraints,
+            &islandCallback_);
+        m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
+    }
+
+private:
+    /// Island callback, which solves with the world's constraint solver on the calling thread.
+    struct IslandCallback : public btSimulationIslandManagerMt::IslandCallback
+    {
+        /// Solve an island.
+        void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+            btTypedConstraint** constraints, int numConstraints, int /*islandId*/) override
+        {
+            world_->getConstraintSolver()->solveGroup(bodies, numBodies, manifolds, numManifolds, constraints, numConstraints,
+                *solverInfo_, world_->getDebugDrawer(), world_->getDispatcher());
+        }
+
+        /// World being solved.
+        PhysicsDynamicsWorld* world_{};
+        /// Solver info of the step.
+        btContactSolverInfo* solverInfo_{};
+        /// Islands being dispatched.
+        btAlignedObjectArray<btSimulationIslandManagerMt::Island*>* islands_{};
+    };
+
+    /// Calculate the interpolated node transforms of a snapshot range.
+    static void InterpolateSnapshots(void* data, unsigned start, unsigned end, unsigned /*threadIndex*/)
+    {
+        RigidBodySnapshot* snapshots = static_cast<Vector<RigidBodySnapshot>*>(data)->Buffer();
+        for (unsigned i = start; i < end; ++i)
+        {
+            RigidBodySnapshot& snapshot = snapshots[i];
+            btRigidBody* body = snapshot.body_;
+            // When an island falls asleep, the interpolation transforms of its bodies are left at the motion predicted
+            // for the step, which is never integrated
+            btTransform transform;
+            if (snapshot.sleeping_)
+                transform = body->getWorldTransform();
+            else
+            {
+                btTransformUtil::integrateTransform(body->getInterpolationWorldTransform(),
+                    body->getInterpolationLinearVelocity(), body->getInterpolationAngularVelocity(), snapshot.time_, transform);
+            }
+            snapshot.rotation_ = ToQuaternion(transform.getRotation());
+            snapshot.position_ = ToVector3(transform.getOrigin()) - snapshot.rotation_ * snapshot.rigidBody_->GetCenterOfMass();
+        }
+    }
+
+    /// Dispatch the active islands to the solvers of the work queue threads.
+    static void DispatchIslands(btAlignedObjectArray<btSimulationIslandManagerMt::Island*>* islands,
+        btSimulationIslandManagerMt::IslandCallback* callback)
+    {
+        // The callback is always the world's own
+        auto* islandCallback = static_cast<IslandCallback*>(callback);
+        PhysicsDynamicsWorld* world = islandCallback->world_;
+
+        // Each thread solves with its own solver, the calling thread with the world's. The islands are sorted by
+        // decreasing size, so taking one at a time balances the threads
+        unsigned numSolvers = world->workQueue_->GetNumThreads() + 1;
+        while (world->threadSolvers_.Size() < numSolvers - 1)
+            world->threadSolvers_.Push(UniquePtr<btConstraintSolver>(new btSequentialImpulseConstraintSolver()));
+
+        islandCallback->islands_ = islands;
+        RunPhysicsParallelLoop(world->workQueue_, (unsigned)islands->size(), 1, SolveIslands, islandCallback);
+    }
+
+    /// Solve an island range.
+    static void SolveIslands(void* data, unsigned start, unsigned end, unsigned threadIndex)
+    {
+        auto* islandCallback = static_cast<IslandCallback*>(data);
+        PhysicsDynamicsWorld* world = islandCallback->world_;
+        btConstraintSolver* solver = threadIndex ? world->threadSolvers_[threadIndex - 1].Get() : world->getConstraintSolver();
+
+        for (unsigned i = start; i < end; ++i)
+        {
+            btSimulationIslandManagerMt::Island& island = *(*islandCallback->islands_)[i];
+            solver->solveGroup(&island.bodyArray[0], island.bodyArray.size(),
+                island.manifoldArray.size() ? &island.manifoldArray[0] : nullptr, island.manifoldArray.size(),
+                island.constraintArray.size() ? &island.constraintArray[0] : nullptr, island.constraintArray.size(),
+                *islandCallback->solverInfo_, world->getDebugDrawer(), world->getDispatcher());
+        }
+    }
+
+    /// Transforms of the rigid bodies moved by the current step, kept to reuse the allocation.
+    Vector<RigidBodySnapshot> snapshots_;
+    /// Island callback.
+    IslandCallback islandCallback_;
+    /// Constraint solvers of the worker threads.
+    Vector<UniquePtr<btConstraintSolver> > threadSolvers_;
+};
+
+/// Number of batched queries processed at a time.
+static const unsigned QUERIES_PER_BATCH = 16;
+
+static void ClearRaycastResult(PhysicsRaycastResult& result)
+{
+    result.position_ = Vector3::ZERO;
+    result.normal_ = Vector3::ZERO;
+    result.distance_ = M_INFINITY;
+    result.hitFraction_ = 0.0f;
+    result.body_ = nullptr;
+}
+
+/// Return the closest ray hit. Safe to call from several threads, as Bullet is built thread-safe.
+static void RaycastSingle(btCollisionWorld* world, PhysicsRaycastResult& result, const Ray& ray, float maxDistance,
+    unsigned collisionMask)
+{
+    btCollisionWorld::ClosestRayResultCallback
+        rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ + maxDistance * ray.direction_));
+    rayCallback.m_collisionFilterGroup = (short)0xffff;
+    rayCallback.m_collisionFilterMask = (short)collisionMask;
+
+    world->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
+
+    if (rayCallback.hasHit())
+    {
+        result.position_ = ToVector3(rayCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
+        result.distance_ = (result.position_ - ray.origin_).Length();
+        result.hitFraction_ = rayCallback.m_closestHitFraction;
+        result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
+    }
+    else
+        ClearRaycastResult(result);
+}
+
+/// Return the first hit of a swept convex shape. Safe to call from several threads, as Bullet is built thread-safe.
+static void ConvexCast(btCollisionWorld* world, PhysicsRaycastResult& result, btConvexShape* shape, const Vector3& startPos,
+    const btQuaternion& startRot, const Vector3& endPos, const btQuaternion& endRot, unsigned collisionMask)
+{
+    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos));
+    convexCallback.m_collisionFilterGroup = (short)0xffff;
+    convexCallback.m_collisionFilterMask = (short)collisionMask;
+
+    world->convexSweepTest(shape, btTransform(startRot, convexCallback.m_convexFromWorld),
+        btTransform(endRot, convexCallback.m_convexToWorld), convexCallback);
+
+    if (convexCallback.hasHit())
+    {
+        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
+        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
+        result.distance_ = convexCallback.m_closestHitFraction * (endPos - startPos).Length();
+        result.hitFraction_ = convexCallback.m_closestHitFraction;
+    }
+    else
+        ClearRaycastResult(result);
+}
+
+/// Batch of ray or swept shape queries.
+struct PhysicsBatchQuery
+{
+    /// World to query.
+    btCollisionWorld* world_;
+    /// Rays.
+    const Ray* rays_;
+    /// Results, one per ray.
+    PhysicsRaycastResult* results_;
+    /// Maximum distance along the rays.
+    float maxDistance_;
+    /// Collision mask.
+    unsigned collisionMask_;
+    /// Swept shape, or null for raycasts.
+    btConvexShape* shape_;
+    /// Swept shape rotation.
+    btQuaternion rotation_;
+    /// Rotation and scale which the swept shape offset is transformed with.
+    Matrix3x4 offsetTransform_;
+    /// Swept shape offset.
+    Vector3 offset_;
+};
+
+static void RaycastSingleRange(void* data, unsigned start, unsigned end, unsigned /*threadIndex*/)
+{
+    auto* query = static_cast<PhysicsBatchQuery*>(data);
+    for (unsigned i = start; i < end; ++i)
+        RaycastSingle(query->world_, query->results_[i], query->rays_[i], query->maxDistance_, query->collisionMask_);
+}
+
+static void ConvexCastRange(void* data, unsigned start, unsigned end, unsigned /*threadIndex*/)
+{
+    auto* query = static_cast<PhysicsBatchQuery*>(data);
+    for (unsigned i = start; i < end; ++i)
+    {
+        // Transform the offset the same way as ConvexCast() does, so that the results are identical
+        const Ray& ray = query->rays_[i];
+        Matrix3x4 transform = query->offsetTransform_;
+        transform.SetTranslation(ray.origin_);
+        Vector3 startPos = transform * query->offset_;
+        transform.SetTranslation(ray.origin_ + query->maxDistance_ * ray.direction_);
+        Vector3 endPos = transform * query->offset_;
+        ConvexCast(query->world_, query->results_[i], query->shape_, startPos, query->rotation_, endPos, query->rotation_,
+            query->collisionMask_);
+    }
+}
+
 PhysicsWorld::PhysicsWorld(Context* context) :
     Component(context),
     fps_(DEFAULT_FPS),
@@ -156,12 +629,12 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     else
         collisionConfiguration_ = new btDefaultCollisionConfiguration();
 
-    collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
+    collisionDispatcher_ = new PhysicsCollisionDispatcher(collisionConfiguration_);
     btGImpactCollisionAlgorithm::registerAlgorithm(static_cast<btCollisionDispatcher*>(collisionDispatcher_.Get()));
 
     broadphase_ = new btDbvtBroadphase();
     solver_ = new btSequentialImpulseConstraintSolver();
-    world_ = new btDiscreteDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+    world_ = new PhysicsDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
 
     world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
     world_->getDispatchInfo().m_useContinuous = true;
@@ -169,7 +642,6 @@ PhysicsWorld::PhysicsWorld(Context* context) :
     world_->setDebugDrawer(this);
     world_->setInternalTickCallback(InternalPreTickCallback, static_cast<void*>(this), true);
     world_->setInternalTickCallback(InternalTickCallback, static_cast<void*>(this), false);
-    world_->setSynchronizeAllMotionStates(true);
 }
 
 PhysicsWorld::~PhysicsWorld()
@@ -210,6 +682,8 @@ void PhysicsWorld::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Interpolation", bool, interpolation_, true, AM_FILE);
     URHO3D_ATTRIBUTE("Internal Edge Utility", bool, internalEdge_, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, bool, false, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Multithreaded", bool, multiThreaded_, false, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Deterministic", bool, deterministic_, true, AM_DEFAULT);
 }
 
 bool PhysicsWorld::isVisible(const btVector3& aabbMin, const btVector3& aabbMax)
@@ -268,6 +742,7 @@ void PhysicsWorld::Update(float timeStep)
         maxSubSteps = Min(maxSubSteps, maxSubSteps_);
 
     delayedWorldTransforms_.Clear();
+    SetupThreading();
     simulating_ = true;
 
     if (interpolation_)
@@ -307,6 +782,7 @@ void PhysicsWorld::Update(float timeStep)
 
 void PhysicsWorld::UpdateCollisions()
 {
+    SetupThreading();
     world_->performDiscreteCollisionDetection();
 }
 
@@ -369,6 +845,20 @@ void PhysicsWorld::SetMaxNetworkAngularVelocity(float velocity)
     MarkNetworkUpdate();
 }
 
+void PhysicsWorld::SetMultiThreaded(bool enable)
+{
+    multiThreaded_ = enable;
+
+    MarkNetworkUpdate();
+}
+
+void PhysicsWorld::SetDeterministic(bool enable)
+{
+    deterministic_ = enable;
+
+    MarkNetworkUpdate();
+}
+
 void PhysicsWorld::Raycast(PODVector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask)
 {
     URHO3D_PROFILE(PhysicsRaycast);
@@ -404,29 +894,26 @@ void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, f
     if (maxDistance >= M_INFINITY)
         URHO3D_LOGWARNING("Infinite maxDistance in physics raycast is not supported");
 
-    btCollisionWorld::ClosestRayResultCallback
-        rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ + maxDistance * ray.direction_));
-    rayCallback.m_collisionFilterGroup = (short)0xffff;
-    rayCallback.m_collisionFilterMask = (short)collisionMask;
+    Urho3D::RaycastSingle(world_.Get(), result, ray, maxDistance, collisionMask);
+}
 
-    world_->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
+void PhysicsWorld::RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<Ray>& rays, float maxDistance,
+    unsigned collisionMask)
+{
+    URHO3D_PROFILE(PhysicsRaycastSingleBatch);
 
-    if (rayCallback.hasHit())
-    {
-        result.position_ = ToVector3(rayCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(rayCallback.m_hitNormalWorld);
-        result.distance_ = (result.position_ - ray.origin_).Length();
-        result.hitFraction_ = rayCallback.m_closestHitFraction;
-        result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
-    }
-    else
-    {
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
-        result.body_ = nullptr;
-    }
+    if (maxDistance >= M_INFINITY)
+        URHO3D_LOGWARNING("Infinite maxDistance in physics raycast is not supported");
+
+    results.Resize(rays.Size());
+
+    PhysicsBatchQuery query{};
+    query.world_ = world_.Get();
+    query.rays_ = rays.Buffer();
+    query.results_ = results.Buffer();
+    query.maxDistance_ = maxDistance;
+    query.collisionMask_ = collisionMask;
+    RunPhysicsParallelLoop(GetSubsystem<WorkQueue>(), rays.Size(), QUERIES_PER_BATCH, RaycastSingleRange, &query);
 }
 
 void PhysicsWorld::RaycastSingleSegmented(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, float segmentDistance, unsigned collisionMask, float overlapDistance)
@@ -489,32 +976,31 @@ void PhysicsWorld::SphereCast(PhysicsRaycastResult& result, const Ray& ray, floa
         URHO3D_LOGWARNING("Infinite maxDistance in physics sphere cast is not supported");
 
     btSphereShape shape(radius);
-    Vector3 endPos = ray.origin_ + maxDistance * ray.direction_;
+    Urho3D::ConvexCast(world_.Get(), result, &shape, ray.origin_, btQuaternion::getIdentity(),
+        ray.origin_ + maxDistance * ray.direction_, btQuaternion::getIdentity(), collisionMask);
+}
 
-    btCollisionWorld::ClosestConvexResultCallback
-        convexCallback(ToBtVector3(ray.origin_), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = (short)collisionMask;
+void PhysicsWorld::SphereCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<Ray>& rays, float radius,
+    float maxDistance, unsigned collisionMask)
+{
+    URHO3D_PROFILE(PhysicsSphereCastBatch);
 
-    world_->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), convexCallback.m_convexFromWorld),
-        btTransform(btQuaternion::getIdentity(), convexCallback.m_convexToWorld), convexCallback);
+    if (maxDistance >= M_INFINITY)
+        URHO3D_LOGWARNING("Infinite maxDistance in physics sphere cast is not supported");
 
-    if (convexCallback.hasHit())
-    {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = convexCallback.m_closestHitFraction * (endPos - ray.origin_).Length();
-        result.hitFraction_ = convexCallback.m_closestHitFraction;
-    }
-    else
-    {
-        result.body_ = nullptr;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
-    }
+    results.Resize(rays.Size());
+
+    btSphereShape shape(radius);
+    PhysicsBatchQuery query{};
+    query.world_ = world_.Get();
+    query.rays_ = rays.Buffer();
+    query.results_ = results.Buffer();
+    query.maxDistance_ = maxDistance;
+    query.collisionMask_ = collisionMask;
+    query.shape_ = &shape;
+    query.rotation_ = btQuaternion::getIdentity();
+    query.offsetTransform_ = Matrix3x4::IDENTITY;
+    RunPhysicsParallelLoop(GetSubsystem<WorkQueue>(), rays.Size(), QUERIES_PER_BATCH, ConvexCastRange, &query);
 }
 
 void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos,
@@ -585,30 +1071,58 @@ void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, btCollisionShape* sh
 
     URHO3D_PROFILE(PhysicsConvexCast);
 
-    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = (short)collisionMask;
+    Urho3D::ConvexCast(world_.Get(), result, static_cast<btConvexShape*>(shape), startPos, ToBtQuaternion(startRot), endPos,
+        ToBtQuaternion(endRot), collisionMask);
+}
 
-    world_->convexSweepTest(static_cast<btConvexShape*>(shape), btTransform(ToBtQuaternion(startRot),
-            convexCallback.m_convexFromWorld), btTransform(ToBtQuaternion(endRot), convexCallback.m_convexToWorld),
-        convexCallback);
+void PhysicsWorld::ConvexCastBatch(PODVector<PhysicsRaycastResult>& results, CollisionShape* shape, const PODVector<Ray>& rays,
+    const Quaternion& rotation, float maxDistance, unsigned collisionMask)
+{
+    URHO3D_PROFILE(PhysicsConvexCastBatch);
 
-    if (convexCallback.hasHit())
+    results.Resize(rays.Size());
+
+    btCollisionShape* collisionShape = shape ? shape->GetCollisionShape() : nullptr;
+    if (!collisionShape || !collisionShape->isConvex())
     {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = convexCallback.m_closestHitFraction * (endPos - startPos).Length();
-        result.hitFraction_ = convexCallback.m_closestHitFraction;
+        URHO3D_LOGERROR(collisionShape ? "Can not use non-convex collision shape for convex cast" :
+            "Null collision shape for convex cast");
+        for (unsigned i = 0; i < results.Size(); ++i)
+            ClearRaycastResult(results[i]);
+        return;
     }
-    else
+
+    if (maxDistance >= M_INFINITY)
+        URHO3D_LOGWARNING("Infinite maxDistance in physics convex cast is not supported");
+
+    // If shape is attached in a rigidbody, set its collision group temporarily to 0 to make sure it is not returned in the sweep result
+    auto* bodyComp = shape->GetComponent<RigidBody>();
+    btRigidBody* body = bodyComp ? bodyComp->GetBody() : nullptr;
+    btBroadphaseProxy* proxy = body ? body->getBroadphaseProxy() : nullptr;
+    short group = 0;
+    if (proxy)
     {
-        result.body_ = nullptr;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
+        group = proxy->m_collisionFilterGroup;
+        proxy->m_collisionFilterGroup = 0;
     }
+
+    // Take the shape's offset position & rotation into account, the same for all rays
+    Node* shapeNode = shape->GetNode();
+    PhysicsBatchQuery query{};
+    query.world_ = world_.Get();
+    query.rays_ = rays.Buffer();
+    query.results_ = results.Buffer();
+    query.maxDistance_ = maxDistance;
+    query.collisionMask_ = collisionMask;
+    query.shape_ = static_cast<btConvexShape*>(collisionShape);
+    query.rotation_ = ToBtQuaternion(rotation * shape->GetRotation());
+    query.offsetTransform_ = Matrix3x4(Vector3::ZERO, rotation, shapeNode ? shapeNode->GetWorldScale() : Vector3::ONE);
+    query.offset_ = shape->GetPosition();
+    RunPhysicsParallelLoop(GetSubsystem<WorkQueue>(), rays.Size(), QUERIES_PER_BATCH, ConvexCastRange, &query);
+
+    // Restore the collision group
+    if (proxy)
+        proxy->m_collisionFilterGroup = group;
 }
 
 void PhysicsWorld::RemoveCachedGeometry(Model* model)
@@ -715,6 +1229,16 @@ bool PhysicsWorld::GetSplitImpulse() const
     return world_->getSolverInfo().m_splitImpulse != 0;
 }
 
+void PhysicsWorld::SetupThreading()
+{
+    WorkQueue* queue = multiThreaded_ ? GetSubsystem<WorkQueue>() : nullptr;
+
+    auto* dispatcher = static_cast<PhysicsCollisionDispatcher*>(collisionDispatcher_.Get());
+    dispatcher->workQueue_ = queue;
+    dispatcher->deterministic_ = deterministic_;
+    static_cast<PhysicsDynamicsWorld*>(world_.Get())->workQueue_ = queue;
+}
+
 void PhysicsWorld::AddRigidBody(RigidBody* body)
 {
     rigidBodies_.Push(body);
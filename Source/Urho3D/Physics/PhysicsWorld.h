@@ -183,23 +183,41 @@ public:
     void SetSplitImpulse(bool enable);
     /// Set maximum angular velocity for network replication.
     void SetMaxNetworkAngularVelocity(float velocity);
+    /// Set whether to run the narrowphase and solve the simulation islands on the work queue threads. Disabled by default.
+    void SetMultiThreaded(bool enable);
+    /// Set whether multithreaded simulation gives the same results regardless of the thread count and timing, at a small
+    /// cost. Enabled by default.
+    void SetDeterministic(bool enable);
     /// Perform a physics world raycast and return all hits.
     void Raycast
         (PODVector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
     /// Perform a physics world raycast and return the closest hit.
     void RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform physics world raycasts on the work queue threads and return the closest hit of each ray. The results are
+    /// resized to the number of rays, which does not allocate when they are reused. Must not be called during simulation.
+    void RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<Ray>& rays, float maxDistance,
+        unsigned collisionMask = M_MAX_UNSIGNED);
     /// Perform a physics world segmented raycast and return the closest hit. Useful for big scenes with many bodies.
     /// overlapDistance is used to make sure there are no gap between segments, and must be smaller than segmentDistance.
     void RaycastSingleSegmented(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, float segmentDistance, unsigned collisionMask = M_MAX_UNSIGNED, float overlapDistance = 0.1f);
     /// Perform a physics world swept sphere test and return the closest hit.
     void SphereCast
         (PhysicsRaycastResult& result, const Ray& ray, float radius, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform physics world swept sphere tests on the work queue threads and return the closest hit of each ray. The results
+    /// are resized to the number of rays. Must not be called during simulation.
+    void SphereCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<Ray>& rays, float radius, float maxDistance,
+        unsigned collisionMask = M_MAX_UNSIGNED);
     /// Perform a physics world swept convex test using a user-supplied collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos, const Quaternion& startRot,
         const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
     /// Perform a physics world swept convex test using a user-supplied Bullet collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, btCollisionShape* shape, const Vector3& startPos, const Quaternion& startRot,
         const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform physics world swept convex tests of a user-supplied collision shape along rays, with a fixed rotation, on the
+    /// work queue threads and return the first hit of each ray. The results are resized to the number of rays. Must not be
+    /// called during simulation.
+    void ConvexCastBatch(PODVector<PhysicsRaycastResult>& results, CollisionShape* shape, const PODVector<Ray>& rays,
+        const Quaternion& rotation, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
     /// Invalidate cached collision geometry for a model.
     void RemoveCachedGeometry(Model* model);
     /// Return rigid bodies by a sphere query.
@@ -238,6 +256,12 @@ public:
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
+    /// Return whether multithreaded simulation is enabled.
+    bool IsMultiThreaded() const { return multiThreaded_; }
+
+    /// Return whether multithreaded simulation is deterministic.
+    bool IsDeterministic() const { return deterministic_; }
+
     /// Add a rigid body to keep track of. Called by RigidBody.
     void AddRigidBody(RigidBody* body);
     /// Remove a rigid body. Called by RigidBody.
@@ -299,6 +323,8 @@ private:
     void PostStep(float timeStep);
     /// Send accumulated collision events.
     void SendCollisionEvents();
+    /// Give the work queue to the collision dispatcher and the world if multithreaded, or remove it.
+    void SetupThreading();
 
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_{};
@@ -350,6 +376,10 @@ private:
     bool interpolation_{true};
     /// Use internal edge utility flag.
     bool internalEdge_{true};
+    /// Multithreaded simulation flag.
+    bool multiThreaded_{};
+    /// Deterministic multithreaded simulation flag.
+    bool deterministic_{true};
     /// Applying transforms flag.
     bool applyingTransforms_{};
     /// Simulating flag.
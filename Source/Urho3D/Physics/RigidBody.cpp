@@ -105,7 +105,7 @@ void RigidBody::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Rolling Friction", GetRollingFriction, SetRollingFriction, float, DEFAULT_ROLLING_FRICTION, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Restitution", GetRestitution, SetRestitution, float, DEFAULT_RESTITUTION, AM_DEFAULT);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Linear Velocity", GetLinearVelocity, SetLinearVelocity, Vector3, Vector3::ZERO,
-        AM_DEFAULT | AM_LATESTDATA);
+        AM_DEFAULT | AM_LATESTDATA).SetMetadata(AttributeMetadata::P_NET_PRECISION, 0.001f);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Angular Velocity", GetAngularVelocity, SetAngularVelocity, Vector3, Vector3::ZERO, AM_FILE);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Linear Factor", GetLinearFactor, SetLinearFactor, Vector3, Vector3::ONE, AM_DEFAULT);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Angular Factor", GetAngularFactor, SetAngularFactor, Vector3, Vector3::ONE, AM_DEFAULT);
@@ -163,6 +163,11 @@ void RigidBody::setWorldTransform(const btTransform& worldTrans)
 {
     Quaternion newWorldRotation = ToQuaternion(worldTrans.getRotation());
     Vector3 newWorldPosition = ToVector3(worldTrans.getOrigin()) - newWorldRotation * centerOfMass_;
+    ApplySimulatedTransform(newWorldPosition, newWorldRotation);
+}
+
+void RigidBody::ApplySimulatedTransform(const Vector3& newWorldPosition, const Quaternion& newWorldRotation)
+{
     RigidBody* parentRigidBody = nullptr;
 
     // It is possible that the RigidBody component has been kept alive via a shared pointer,
@@ -724,10 +729,20 @@ void RigidBody::ApplyWorldTransform(const Vector3& newWorldPosition, const Quate
     }
     else
     {
-        node_->SetWorldPosition(newWorldPosition);
-        node_->SetWorldRotation(newWorldRotation);
-        lastPosition_ = node_->GetWorldPosition();
-        lastRotation_ = node_->GetWorldRotation();
+        node_->SetWorldTransform(newWorldPosition, newWorldRotation);
+
+        // The world transform of a node parented to the scene is exactly the one set, so it does not need to be recalculated
+        // here. That happens when it is next needed, for example on the octree update worker threads
+        if (node_->GetParent() == GetScene())
+        {
+            lastPosition_ = newWorldPosition;
+            lastRotation_ = newWorldRotation;
+        }
+        else
+        {
+            lastPosition_ = node_->GetWorldPosition();
+            lastRotation_ = node_->GetWorldRotation();
+        }
     }
 
     physicsWorld_->SetApplyingTransforms(false);
@@ -0,0 +1,516 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Resource/Compress.h"
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// Gather a 4x4 block of RGBA pixels, repeating the edge pixels of partial blocks.
+static void GatherBlock(unsigned char* block, const unsigned char* rgba, int stride, int blockWidth, int blockHeight)
+{
+    for (int y = 0; y < 4; ++y)
+    {
+        const unsigned char* row = rgba + Min(y, blockHeight - 1) * stride;
+        for (int x = 0; x < 4; ++x)
+            memcpy(block + (y * 4 + x) * 4, row + Min(x, blockWidth - 1) * 4, 4);
+    }
+}
+
+static inline int ColorDistance(const int* a, const unsigned char* b)
+{
+    int dr = a[0] - b[0];
+    int dg = a[1] - b[1];
+    int db = a[2] - b[2];
+    return dr * dr + dg * dg + db * db;
+}
+
+/// Quantize a color to 5:6:5 bits with rounding.
+static unsigned Pack565(const float* color)
+{
+    int r = Clamp((int)(color[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+    int g = Clamp((int)(color[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+    int b = Clamp((int)(color[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+    return (unsigned)((r << 11) | (g << 5) | b);
+}
+
+/// Expand a 5:6:5 color to 8 bits per component the same way as the decompressor.
+static void Unpack565(unsigned value, int* color)
+{
+    int r = (value >> 11) & 0x1f;
+    int g = (value >> 5) & 0x3f;
+    int b = value & 0x1f;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+/// Choose the nearest palette color for each pixel of a DXT color block. Color0 must be greater than color1 or equal to it. Return the total squared error.
+static int FitColorIndices(const unsigned char* block, unsigned color0, unsigned color1, unsigned& indices)
+{
+    int palette[4][3];
+    Unpack565(color0, palette[0]);
+    Unpack565(color1, palette[1]);
+    for (int i = 0; i < 3; ++i)
+    {
+        palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+        palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+    }
+
+    // Equal endpoints select the three color mode, where the last entry is transparent black
+    int numColors = color0 > color1 ? 4 : 1;
+    int error = 0;
+    indices = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const unsigned char* pixel = block + i * 4;
+        int best = 0;
+        int bestDistance = ColorDistance(palette[0], pixel);
+        for (int j = 1; j < numColors; ++j)
+        {
+            int distance = ColorDistance(palette[j], pixel);
+            if (distance < bestDistance)
+            {
+                best = j;
+                bestDistance = distance;
+            }
+        }
+        indices |= (unsigned)best << (i * 2);
+        error += bestDistance;
+    }
+
+    return error;
+}
+
+/// Return the color block error and indices for endpoint colors, swapping them to select the four color mode.
+static int EncodeEndpoints(const unsigned char* block, const float* end0, const float* end1, unsigned& color0, unsigned& color1,
+    unsigned& indices)
+{
+    color0 = Pack565(end0);
+    color1 = Pack565(end1);
+    if (color0 < color1)
+        Swap(color0, color1);
+    return FitColorIndices(block, color0, color1, indices);
+}
+
+/// Compress the color of a block to the DXT1 format using the principal axis of the colors, followed by a least squares refinement of the endpoints.
+static void CompressColorDXT(unsigned char* dest, const unsigned char* block)
+{
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    int minColor[3] = {255, 255, 255};
+    int maxColor[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            mean[j] += block[i * 4 + j];
+            minColor[j] = Min(minColor[j], (int)block[i * 4 + j]);
+            maxColor[j] = Max(maxColor[j], (int)block[i * 4 + j]);
+        }
+    }
+    for (float& m : mean)
+        m *= 1.0f / 16.0f;
+
+    // Covariance matrix
+    float cov[6] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        float r = block[i * 4] - mean[0];
+        float g = block[i * 4 + 1] - mean[1];
+        float b = block[i * 4 + 2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+
+    // Principal axis by power iteration, starting from the bounding box diagonal
+    float axis[3] = {(float)(maxColor[0] - minColor[0]), (float)(maxColor[1] - minColor[1]), (float)(maxColor[2] - minColor[2])};
+    for (int iteration = 0; iteration < 4; ++iteration)
+    {
+        float x = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+        float y = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+        float z = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+        float length = Max(Max(Abs(x), Abs(y)), Abs(z));
+        if (length < M_EPSILON)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    // Endpoints are the extreme colors along the axis
+    int minIndex = 0;
+    int maxIndex = 0;
+    float minDot = M_INFINITY;
+    float maxDot = -M_INFINITY;
+    for (int i = 0; i < 16; ++i)
+    {
+        float dot = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+        if (dot < minDot)
+        {
+            minDot = dot;
+            minIndex = i;
+        }
+        if (dot > maxDot)
+        {
+            maxDot = dot;
+            maxIndex = i;
+        }
+    }
+
+    float end0[3];
+    float end1[3];
+    for (int j = 0; j < 3; ++j)
+    {
+        end0[j] = block[maxIndex * 4 + j];
+        end1[j] = block[minIndex * 4 + j];
+    }
+
+    unsigned color0, color1, indices;
+    int error = EncodeEndpoints(block, end0, end1, color0, color1, indices);
+
+    // Refine the endpoints by least squares fitting to the chosen indices
+    if (error > 0 && color0 != color1)
+    {
+        static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+        float ap[3] = {}, bp[3] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float a = weights[(indices >> (i * 2)) & 3];
+            float b = 1.0f - a;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (int j = 0; j < 3; ++j)
+            {
+                ap[j] += a * block[i * 4 + j];
+                bp[j] += b * block[i * 4 + j];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if (Abs(det) > M_EPSILON)
+        {
+            float invDet = 1.0f / det;
+            for (int j = 0; j < 3; ++j)
+            {
+                end0[j] = (ap[j] * bb - bp[j] * ab) * invDet;
+                end1[j] = (bp[j] * aa - ap[j] * ab) * invDet;
+            }
+
+            unsigned refinedColor0, refinedColor1, refinedIndices;
+            int refinedError = EncodeEndpoints(block, end0, end1, refinedColor0, refinedColor1, refinedIndices);
+            if (refinedError < error)
+            {
+                color0 = refinedColor0;
+                color1 = refinedColor1;
+                indices = refinedIndices;
+            }
+        }
+    }
+
+    dest[0] = (unsigned char)(color0 & 0xff);
+    dest[1] = (unsigned char)(color0 >> 8);
+    dest[2] = (unsigned char)(color1 & 0xff);
+    dest[3] = (unsigned char)(color1 >> 8);
+    dest[4] = (unsigned char)(indices & 0xff);
+    dest[5] = (unsigned char)((indices >> 8) & 0xff);
+    dest[6] = (unsigned char)((indices >> 16) & 0xff);
+    dest[7] = (unsigned char)(indices >> 24);
+}
+
+static void CompressAlphaDXT3(unsigned char* dest, const unsigned char* block)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        int low = (block[(i * 2) * 4 + 3] * 15 + 127) / 255;
+        int high = (block[(i * 2 + 1) * 4 + 3] * 15 + 127) / 255;
+        dest[i] = (unsigned char)(low | (high << 4));
+    }
+}
+
+static void CompressAlphaDXT5(unsigned char* dest, const unsigned char* block)
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        minAlpha = Min(minAlpha, (int)block[i * 4 + 3]);
+        maxAlpha = Max(maxAlpha, (int)block[i * 4 + 3]);
+    }
+
+    memset(dest, 0, 8);
+    dest[0] = (unsigned char)maxAlpha;
+    dest[1] = (unsigned char)minAlpha;
+    if (minAlpha == maxAlpha)
+        return;
+
+    // Seven interpolated alpha mode, with the codebook calculated the same way as the decompressor
+    int codes[8];
+    codes[0] = maxAlpha;
+    codes[1] = minAlpha;
+    for (int i = 1; i < 7; ++i)
+        codes[1 + i] = ((7 - i) * maxAlpha + i * minAlpha) / 7;
+
+    unsigned long long bits = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int alpha = block[i * 4 + 3];
+        int best = 0;
+        int bestDistance = Abs(codes[0] - alpha);
+        for (int j = 1; j < 8; ++j)
+        {
+            int distance = Abs(codes[j] - alpha);
+            if (distance < bestDistance)
+            {
+                best = j;
+                bestDistance = distance;
+            }
+        }
+        bits |= (unsigned long long)best << (i * 3);
+    }
+
+    for (int i = 0; i < 6; ++i)
+        dest[2 + i] = (unsigned char)((bits >> (i * 8)) & 0xff);
+}
+
+void CompressImageDXT(unsigned char* blocks, const unsigned char* rgba, int width, int height, CompressedFormat format)
+{
+    int bytesPerBlock = format == CF_DXT1 ? 8 : 16;
+    int stride = width * 4;
+
+    for (int y = 0; y < height; y += 4)
+    {
+        for (int x = 0; x < width; x += 4)
+        {
+            alignas(4) unsigned char block[4 * 16];
+            GatherBlock(block, rgba + stride * y + 4 * x, stride, Min(width - x, 4), Min(height - y, 4));
+
+            if (format == CF_DXT1)
+                CompressColorDXT(blocks, block);
+            else
+            {
+                if (format == CF_DXT3)
+                    CompressAlphaDXT3(blocks, block);
+                else
+                    CompressAlphaDXT5(blocks, block);
+                CompressColorDXT(blocks + 8, block);
+            }
+
+            blocks += bytesPerBlock;
+        }
+    }
+}
+
+/// ETC1 intensity modifier tables.
+static const int etcModifiers[8][2] =
+{
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+/// Encoded ETC1 subblock.
+struct ETCSubblock
+{
+    /// Modifier table.
+    int table_;
+    /// Two-bit modifier index of each of the 8 pixels, in the ETC1 order of +small, +large, -small, -large.
+    int indices_[8];
+    /// Squared error.
+    int error_;
+};
+
+/// Choose the modifier table and pixel modifiers for a subblock with a given base color.
+static void FitSubblockETC(ETCSubblock& subblock, const unsigned char* const* pixels, const int* base)
+{
+    subblock.error_ = M_MAX_INT;
+
+    for (int table = 0; table < 8; ++table)
+    {
+        const int modifiers[4] = {etcModifiers[table][0], etcModifiers[table][1], -etcModifiers[table][0], -etcModifiers[table][1]};
+        int candidates[4][3];
+        for (int m = 0; m < 4; ++m)
+        {
+            for (int j = 0; j < 3; ++j)
+                candidates[m][j] = Clamp(base[j] + modifiers[m], 0, 255);
+        }
+
+        int error = 0;
+        int indices[8];
+        for (int i = 0; i < 8 && error < subblock.error_; ++i)
+        {
+            int best = 0;
+            int bestDistance = ColorDistance(candidates[0], pixels[i]);
+            for (int m = 1; m < 4; ++m)
+            {
+                int distance = ColorDistance(candidates[m], pixels[i]);
+                if (distance < bestDistance)
+                {
+                    best = m;
+                    bestDistance = distance;
+                }
+            }
+            indices[i] = best;
+            error += bestDistance;
+        }
+
+        if (error < subblock.error_)
+        {
+            subblock.table_ = table;
+            subblock.error_ = error;
+            memcpy(subblock.indices_, indices, sizeof indices);
+        }
+    }
+}
+
+/// Compress a block to ETC1, trying both subblock orientations and both the individual and differential base color modes.
+static void CompressBlockETC(unsigned char* dest, const unsigned char* block)
+{
+    int bestError = M_MAX_INT;
+
+    for (int flip = 0; flip < 2; ++flip)
+    {
+        // Subblock pixels and their indices in the column-major ETC1 pixel order
+        const unsigned char* pixels[2][8];
+        int pixelIndices[2][8];
+        int counts[2] = {0, 0};
+        for (int y = 0; y < 4; ++y)
+        {
+            for (int x = 0; x < 4; ++x)
+            {
+                int sub = flip ? (y >= 2) : (x >= 2);
+                pixels[sub][counts[sub]] = block + (y * 4 + x) * 4;
+                pixelIndices[sub][counts[sub]] = x * 4 + y;
+                ++counts[sub];
+            }
+        }
+
+        float average[2][3];
+        for (int sub = 0; sub < 2; ++sub)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                int sum = 0;
+                for (int i = 0; i < 8; ++i)
+                    sum += pixels[sub][i][j];
+                average[sub][j] = sum / 8.0f;
+            }
+        }
+
+        for (int diff = 0; diff < 2; ++diff)
+        {
+            int quantized[2][3];
+            int base[2][3];
+            bool valid = true;
+
+            for (int sub = 0; sub < 2; ++sub)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    if (diff)
+                    {
+                        quantized[sub][j] = Clamp((int)(average[sub][j] * (31.0f / 255.0f) + 0.5f), 0, 31);
+                        base[sub][j] = (quantized[sub][j] << 3) | (quantized[sub][j] >> 2);
+                    }
+                    else
+                    {
+                        quantized[sub][j] = Clamp((int)(average[sub][j] * (15.0f / 255.0f) + 0.5f), 0, 15);
+                        base[sub][j] = quantized[sub][j] * 17;
+                    }
+                }
+            }
+
+            if (diff)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    int delta = quantized[1][j] - quantized[0][j];
+                    if (delta < -4 || delta > 3)
+                        valid = false;
+                }
+            }
+            if (!valid)
+                continue;
+
+            ETCSubblock subblocks[2];
+            FitSubblockETC(subblocks[0], pixels[0], base[0]);
+            FitSubblockETC(subblocks[1], pixels[1], base[1]);
+            int error = subblocks[0].error_ + subblocks[1].error_;
+            if (error >= bestError)
+                continue;
+            bestError = error;
+
+            // Base colors, table codewords and the diff and flip bits, most significant byte first
+            for (int j = 0; j < 3; ++j)
+            {
+                if (diff)
+                    dest[j] = (unsigned char)((quantized[0][j] << 3) | ((quantized[1][j] - quantized[0][j]) & 7));
+                else
+                    dest[j] = (unsigned char)((quantized[0][j] << 4) | quantized[1][j]);
+            }
+            dest[3] = (unsigned char)((subblocks[0].table_ << 5) | (subblocks[1].table_ << 2) | (diff << 1) | flip);
+
+            // Pixel modifier indices as most and least significant bit planes
+            unsigned msb = 0;
+            unsigned lsb = 0;
+            for (int sub = 0; sub < 2; ++sub)
+            {
+                for (int i = 0; i < 8; ++i)
+                {
+                    int index = subblocks[sub].indices_[i];
+                    msb |= (unsigned)(index >> 1) << pixelIndices[sub][i];
+                    lsb |= (unsigned)(index & 1) << pixelIndices[sub][i];
+                }
+            }
+            dest[4] = (unsigned char)(msb >> 8);
+            dest[5] = (unsigned char)(msb & 0xff);
+            dest[6] = (unsigned char)(lsb >> 8);
+            dest[7] = (unsigned char)(lsb & 0xff);
+        }
+    }
+}
+
+void CompressImageETC(unsigned char* blocks, const unsigned char* rgba, int width, int height)
+{
+    int stride = width * 4;
+
+    for (int y = 0; y < height; y += 4)
+    {
+        for (int x = 0; x < width; x += 4)
+        {
+            alignas(4) unsigned char block[4 * 16];
+            GatherBlock(block, rgba + stride * y + 4 * x, stride, Min(width - x, 4), Min(height - y, 4));
+            CompressBlockETC(blocks, block);
+            blocks += 8;
+        }
+    }
+}
+
+}
@@ -24,6 +24,12 @@
 
 #include "../Resource/Decompress.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
+
 // DXT decompression based on the Squish library, modified for Urho3D
 
 namespace Urho3D
@@ -219,48 +225,186 @@ static void DecompressDXT(unsigned char* rgba, const void* block, CompressedForm
         DecompressAlphaDXT5(rgba, alphaBock);
 }
 
+/// Copy a decompressed 4x4 block to the image, clipping the pixels outside it.
+static void CopyBlockClipped(unsigned char* dest, const unsigned char* blockRgba, int destStride, int blockWidth, int blockHeight)
+{
+    for (int py = 0; py < blockHeight; ++py)
+        memcpy(dest + py * destStride, blockRgba + py * 16, (size_t)blockWidth * 4);
+}
+
+#ifdef URHO3D_SSE
+/// Select one of four palette colors per lane by a 2-bit index.
+static inline __m128i SelectPaletteColor(__m128i index, __m128i c0, __m128i c1, __m128i c2, __m128i c3)
+{
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i three = _mm_set1_epi32(3);
+
+    __m128i result = _mm_and_si128(_mm_cmpeq_epi32(index, _mm_setzero_si128()), c0);
+    result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi32(index, one), c1));
+    result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi32(index, two), c2));
+    return _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi32(index, three), c3));
+}
+
+/// Divide lanes in the range 0-765 by three.
+static inline __m128i DivideByThree(__m128i value)
+{
+    // (x * 0xaaab) >> 17 equals x / 3 for all 16-bit inputs
+    return _mm_srli_epi32(_mm_mulhi_epu16(value, _mm_set1_epi32(0xaaab)), 1);
+}
+
+/// Expand 5 or 6 bit color channel lanes to 8 bits.
+static inline __m128i ExpandChannel(__m128i packed, int shift, int mask, int bits)
+{
+    __m128i value = _mm_and_si128(_mm_srl_epi32(packed, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(mask));
+    return _mm_or_si128(_mm_sll_epi32(value, _mm_cvtsi32_si128(8 - bits)), _mm_srl_epi32(value, _mm_cvtsi32_si128(2 * bits - 8)));
+}
+
+/// Pack 8-bit channel lanes to RGBA.
+static inline __m128i PackRGBA(__m128i r, __m128i g, __m128i b, __m128i a)
+{
+    return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+}
+
+/// Decompress the color of four horizontally adjacent DXT blocks at once. Each block's alpha is decompressed afterward if necessary.
+static void DecompressColourDXTx4(unsigned char* dest, int destStride, const unsigned char* blocks, int bytesPerBlock, bool isDxt1)
+{
+    // Gather the endpoints and the index words of the four blocks into lanes
+    int colourOffset = isDxt1 ? 0 : 8;
+    alignas(16) unsigned endpoints[4];
+    alignas(16) unsigned indices[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        memcpy(&endpoints[i], blocks + i * bytesPerBlock + colourOffset, 4);
+        memcpy(&indices[i], blocks + i * bytesPerBlock + colourOffset + 4, 4);
+    }
+    __m128i packed = _mm_load_si128(reinterpret_cast<const __m128i*>(endpoints));
+    __m128i indexWord = _mm_load_si128(reinterpret_cast<const __m128i*>(indices));
+
+    __m128i a = _mm_and_si128(packed, _mm_set1_epi32(0xffff));
+    __m128i b = _mm_srli_epi32(packed, 16);
+
+    __m128i r0 = ExpandChannel(a, 11, 0x1f, 5);
+    __m128i g0 = ExpandChannel(a, 5, 0x3f, 6);
+    __m128i b0 = ExpandChannel(a, 0, 0x1f, 5);
+    __m128i r1 = ExpandChannel(b, 11, 0x1f, 5);
+    __m128i g1 = ExpandChannel(b, 5, 0x3f, 6);
+    __m128i b1 = ExpandChannel(b, 0, 0x1f, 5);
+
+    const __m128i opaque = _mm_set1_epi32(255);
+    __m128i c0 = PackRGBA(r0, g0, b0, opaque);
+    __m128i c1 = PackRGBA(r1, g1, b1, opaque);
+
+    // Four-colour mode: interpolate at thirds
+    __m128i c2 = PackRGBA(
+        DivideByThree(_mm_add_epi32(_mm_add_epi32(r0, r0), r1)),
+        DivideByThree(_mm_add_epi32(_mm_add_epi32(g0, g0), g1)),
+        DivideByThree(_mm_add_epi32(_mm_add_epi32(b0, b0), b1)),
+        opaque);
+    __m128i c3 = PackRGBA(
+        DivideByThree(_mm_add_epi32(_mm_add_epi32(r1, r1), r0)),
+        DivideByThree(_mm_add_epi32(_mm_add_epi32(g1, g1), g0)),
+        DivideByThree(_mm_add_epi32(_mm_add_epi32(b1, b1), b0)),
+        opaque);
+
+    if (isDxt1)
+    {
+        // Three-colour mode when a <= b: midpoint and transparent black
+        __m128i midpoint = PackRGBA(
+            _mm_srli_epi32(_mm_add_epi32(r0, r1), 1),
+            _mm_srli_epi32(_mm_add_epi32(g0, g1), 1),
+            _mm_srli_epi32(_mm_add_epi32(b0, b1), 1),
+            opaque);
+        __m128i fourColour = _mm_cmpgt_epi32(a, b);
+        c2 = _mm_or_si128(_mm_and_si128(fourColour, c2), _mm_andnot_si128(fourColour, midpoint));
+        c3 = _mm_and_si128(fourColour, c3);
+    }
+
+    const __m128i indexMask = _mm_set1_epi32(3);
+    for (int row = 0; row < 4; ++row)
+    {
+        // Decode one pixel of each block per lane, then transpose so that each register holds a block row
+        __m128i p0 = SelectPaletteColor(_mm_and_si128(_mm_srli_epi32(indexWord, 0), indexMask), c0, c1, c2, c3);
+        __m128i p1 = SelectPaletteColor(_mm_and_si128(_mm_srli_epi32(indexWord, 2), indexMask), c0, c1, c2, c3);
+        __m128i p2 = SelectPaletteColor(_mm_and_si128(_mm_srli_epi32(indexWord, 4), indexMask), c0, c1, c2, c3);
+        __m128i p3 = SelectPaletteColor(_mm_and_si128(_mm_srli_epi32(indexWord, 6), indexMask), c0, c1, c2, c3);
+        indexWord = _mm_srli_epi32(indexWord, 8);
+
+        __m128i t0 = _mm_unpacklo_epi32(p0, p1);
+        __m128i t1 = _mm_unpacklo_epi32(p2, p3);
+        __m128i t2 = _mm_unpackhi_epi32(p0, p1);
+        __m128i t3 = _mm_unpackhi_epi32(p2, p3);
+
+        auto* rowDest = reinterpret_cast<__m128i*>(dest + row * destStride);
+        _mm_storeu_si128(rowDest, _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128(rowDest + 1, _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128(rowDest + 2, _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128(rowDest + 3, _mm_unpackhi_epi64(t2, t3));
+    }
+}
+#endif
+
+/// Write the alpha of a DXT3 / DXT5 block directly to the image.
+static void DecompressAlphaDXTStrided(unsigned char* dest, int destStride, const void* block, CompressedFormat format)
+{
+    unsigned char blockRgba[4 * 16];
+    if (format == CF_DXT3)
+        DecompressAlphaDXT3(blockRgba, block);
+    else
+        DecompressAlphaDXT5(blockRgba, block);
+
+    for (int py = 0; py < 4; ++py)
+    {
+        unsigned char* rowDest = dest + py * destStride;
+        const unsigned char* rowSrc = blockRgba + py * 16;
+        rowDest[3] = rowSrc[3];
+        rowDest[7] = rowSrc[7];
+        rowDest[11] = rowSrc[11];
+        rowDest[15] = rowSrc[15];
+    }
+}
+
 void DecompressImageDXT(unsigned char* rgba, const void* blocks, int width, int height, int depth, CompressedFormat format)
 {
     // initialise the block input
     auto const* sourceBlock = reinterpret_cast< unsigned char const* >( blocks );
     int bytesPerBlock = format == CF_DXT1 ? 8 : 16;
+    int stride = width * 4;
 
     // loop over blocks
     for (int z = 0; z < depth; ++z)
     {
-        int sz = width * height * 4 * z;
+        unsigned char* slice = rgba + width * height * 4 * z;
         for (int y = 0; y < height; y += 4)
         {
-            for (int x = 0; x < width; x += 4)
+            int x = 0;
+
+#ifdef URHO3D_SSE
+            // decompress runs of four complete blocks directly to the image
+            if (y + 4 <= height)
+            {
+                for (; x + 16 <= width; x += 16)
+                {
+                    unsigned char* dest = slice + stride * y + 4 * x;
+                    DecompressColourDXTx4(dest, stride, sourceBlock, bytesPerBlock, format == CF_DXT1);
+                    if (format != CF_DXT1)
+                    {
+                        for (int i = 0; i < 4; ++i)
+                            DecompressAlphaDXTStrided(dest + 16 * i, stride, sourceBlock + i * bytesPerBlock, format);
+                    }
+                    sourceBlock += 4 * bytesPerBlock;
+                }
+            }
+#endif
+
+            for (; x < width; x += 4)
             {
                 // decompress the block
                 unsigned char targetRgba[4 * 16];
                 DecompressDXT(targetRgba, sourceBlock, format);
 
                 // write the decompressed pixels to the correct image locations
-                unsigned char const* sourcePixel = targetRgba;
-                for (int py = 0; py < 4; ++py)
-                {
-                    for (int px = 0; px < 4; ++px)
-                    {
-                        // get the target location
-                        int sx = x + px;
-                        int sy = y + py;
-                        if (sx < width && sy < height)
-                        {
-                            unsigned char* targetPixel = rgba + sz + 4 * (width * sy + sx);
-
-                            // copy the rgba value
-                            for (int i = 0; i < 4; ++i)
-                                *targetPixel++ = *sourcePixel++;
-                        }
-                        else
-                        {
-                            // skip this pixel as its outside the image
-                            sourcePixel += 4;
-                        }
-                    }
-                }
+                CopyBlockClipped(slice + stride * y + 4 * x, targetRgba, stride, Min(width - x, 4), Min(height - y, 4));
 
                 // advance
                 sourceBlock += bytesPerBlock;
@@ -304,10 +448,10 @@ const int mod[8][4] = {{2,  8,   -2,  -8},
                        {47, 183, -47, -183}};
 
 // lsb: hgfedcba ponmlkji msb: hgfedcba ponmlkji due to endianness
-static unsigned long ModifyPixel(int red, int green, int blue, int x, int y, unsigned long modBlock, int modTable)
+static unsigned ModifyPixel(int red, int green, int blue, int x, int y, unsigned modBlock, int modTable)
 {
     int index = x * 4 + y, pixelMod;
-    unsigned long mostSig = modBlock << 1;
+    unsigned mostSig = modBlock << 1;
     if (index < 8)    //hgfedcba
         pixelMod = mod[modTable][((modBlock >> (index + 24)) & 0x1) + ((mostSig >> (index + 8)) & 0x2)];
     else    // ponmlkj
@@ -322,7 +466,9 @@ static unsigned long ModifyPixel(int red, int green, int blue, int x, int y, uns
 
 static void DecompressETC(unsigned char* pDestData, const void* pSrcData)
 {
-    unsigned long blockTop, blockBot, * input = (unsigned long*)pSrcData, * output;
+    // Note: use 32-bit words; unsigned long is 64-bit on LP64 platforms and would overrun the block
+    unsigned blockTop, blockBot, * output;
+    auto* input = (const unsigned*)pSrcData;
     unsigned char red1, green1, blue1, red2, green2, blue2;
     bool bFlip, bDiff;
     int modtable1, modtable2;
@@ -330,7 +476,7 @@ static void DecompressETC(unsigned char* pDestData, const void* pSrcData)
     blockTop = *(input++);
     blockBot = *(input++);
 
-    output = (unsigned long*)pDestData;
+    output = (unsigned*)pDestData;
     // check flipbit
     bFlip = (blockTop & ETC_FLIP) != 0;
     bDiff = (blockTop & ETC_DIFF) != 0;
@@ -410,6 +556,7 @@ void DecompressImageETC(unsigned char* rgba, const void* blocks, int width, int
     // initialise the block input
     auto const* sourceBlock = reinterpret_cast< unsigned char const* >( blocks );
     int bytesPerBlock = 8;
+    int stride = width * 4;
 
     // loop over blocks
     for (int y = 0; y < height; y += 4)
@@ -417,33 +564,11 @@ void DecompressImageETC(unsigned char* rgba, const void* blocks, int width, int
         for (int x = 0; x < width; x += 4)
         {
             // decompress the block
-            unsigned char targetRgba[4 * 16];
+            alignas(4) unsigned char targetRgba[4 * 16];
             DecompressETC(targetRgba, sourceBlock);
 
             // write the decompressed pixels to the correct image locations
-            unsigned char const* sourcePixel = targetRgba;
-            for (int py = 0; py < 4; ++py)
-            {
-                for (int px = 0; px < 4; ++px)
-                {
-                    // get the target location
-                    int sx = x + px;
-                    int sy = y + py;
-                    if (sx < width && sy < height)
-                    {
-                        unsigned char* targetPixel = rgba + 4 * (width * sy + sx);
-
-                        // copy the rgba value
-                        for (int i = 0; i < 4; ++i)
-                            *targetPixel++ = *sourcePixel++;
-                    }
-                    else
-                    {
-                        // skip this pixel as its outside the image
-                        sourcePixel += 4;
-                    }
-                }
-            }
+            CopyBlockClipped(rgba + stride * y + 4 * x, targetRgba, stride, Min(width - x, 4), Min(height - y, 4));
 
             // advance
             sourceBlock += bytesPerBlock;
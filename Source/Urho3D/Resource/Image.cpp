@@ -24,10 +24,14 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
+#include "../Resource/Compress.h"
 #include "../Resource/Decompress.h"
+#include "../Resource/ImageResample.h"
 
 #include <SDL/SDL_surface.h>
 #define STB_IMAGE_IMPLEMENTATION
@@ -53,6 +57,13 @@
 #define FOURCC_DXT5 (MAKEFOURCC('D','X','T','5'))
 #define FOURCC_DX10 (MAKEFOURCC('D','X','1','0'))
 
+/// Rows of pixels decompressed by one work item, when a mip level is split between worker threads.
+static const int DECOMPRESS_ROWS_PER_WORK_ITEM = 64;
+/// Destination rows of pixels calculated by one work item when generating mip levels or resizing.
+static const int RESAMPLE_ROWS_PER_WORK_ITEM = 32;
+/// Rows of pixels compressed by one work item. Must be a multiple of the block size.
+static const int COMPRESS_ROWS_PER_WORK_ITEM = 32;
+
 static const unsigned DDSCAPS_COMPLEX = 0x00000008U;
 static const unsigned DDSCAPS_TEXTURE = 0x00001000U;
 static const unsigned DDSCAPS_MIPMAP = 0x00400000U;
@@ -212,6 +223,126 @@ struct DDSurfaceDesc2
     unsigned dwTextureStage_;
 };
 
+/// Decompression work of a band of rows of a compressed mip level.
+struct DecompressWork
+{
+    /// Compressed level or the part of it to decompress.
+    CompressedLevel level_;
+    /// Destination RGBA data.
+    unsigned char* dest_;
+};
+
+/// Decompress work function.
+static void DecompressLevelWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* work = reinterpret_cast<DecompressWork*>(item->start_);
+    work->level_.Decompress(work->dest_);
+}
+
+/// Compression work of a band of rows of an RGBA mip level.
+struct CompressWork
+{
+    /// Source RGBA data.
+    const unsigned char* rgba_;
+    /// Destination blocks.
+    unsigned char* blocks_;
+    /// Width in pixels.
+    int width_;
+    /// Height in pixels.
+    int height_;
+    /// Compressed format.
+    CompressedFormat format_;
+};
+
+/// Compress work function.
+static void CompressLevelWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* work = reinterpret_cast<CompressWork*>(item->start_);
+    if (work->format_ == CF_ETC1)
+        CompressImageETC(work->blocks_, work->rgba_, work->width_, work->height_);
+    else
+        CompressImageDXT(work->blocks_, work->rgba_, work->width_, work->height_, work->format_);
+}
+
+/// Mip level generation or resampling work of a band of destination rows.
+struct ResampleWork
+{
+    /// Source pixel data.
+    const unsigned char* src_;
+    /// Destination pixel data.
+    unsigned char* dest_;
+    /// Source width.
+    int srcWidth_;
+    /// Source height.
+    int srcHeight_;
+    /// Number of color components.
+    unsigned components_;
+    /// Horizontal resampling weights. Null to use the 2x2 box filter.
+    const ResampleAxis* xAxis_;
+    /// Vertical resampling weights. Null to use the 2x2 box filter.
+    const ResampleAxis* yAxis_;
+    /// Filter color components in linear space.
+    bool sRGB_;
+    /// First destination row.
+    int firstRow_;
+    /// Number of destination rows.
+    int numRows_;
+};
+
+/// Resample work function.
+static void ResampleWorkFunction(const WorkItem* item, unsigned threadIndex)
+{
+    auto* work = reinterpret_cast<ResampleWork*>(item->start_);
+    if (work->xAxis_ && work->yAxis_)
+    {
+        ResampleImage(work->dest_, work->src_, work->srcWidth_, work->srcHeight_, work->components_, *work->xAxis_, *work->yAxis_,
+            work->sRGB_, work->firstRow_, work->numRows_);
+    }
+    else
+        DownsampleImageBox(work->dest_, work->src_, work->srcWidth_, work->srcHeight_, work->components_, work->firstRow_, work->numRows_);
+}
+
+/// Execute image work items, distributing them to worker threads when possible. The work queue may only be used from the main thread.
+template <class T> static void RunImageWork(WorkQueue* queue, PODVector<T>& works, void (*workFunction)(const WorkItem*, unsigned))
+{
+    if (queue && queue->GetNumThreads() && works.Size() > 1 && Thread::IsMainThread() && !queue->IsCompleting())
+    {
+        for (unsigned i = 0; i < works.Size(); ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = workFunction;
+            item->start_ = &works[i];
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+    else
+    {
+        WorkItem item;
+        for (unsigned i = 0; i < works.Size(); ++i)
+        {
+            item.start_ = &works[i];
+            workFunction(&item, 0);
+        }
+    }
+}
+
+/// Split resampling of a 2D image into bands of destination rows and execute them.
+static void RunResampleWork(WorkQueue* queue, const ResampleWork& work)
+{
+    PODVector<ResampleWork> works;
+    int lastRow = work.firstRow_ + work.numRows_;
+    for (int row = work.firstRow_; row < lastRow; row += RESAMPLE_ROWS_PER_WORK_ITEM)
+    {
+        ResampleWork band = work;
+        band.firstRow_ = row;
+        band.numRows_ = Min(RESAMPLE_ROWS_PER_WORK_ITEM, lastRow - row);
+        works.Push(band);
+    }
+    RunImageWork(queue, works, ResampleWorkFunction);
+}
+
 bool CompressedLevel::Decompress(unsigned char* dest)
 {
     if (!data_)
@@ -219,6 +350,10 @@ bool CompressedLevel::Decompress(unsigned char* dest)
 
     switch (format_)
     {
+    case CF_RGBA:
+        memcpy(dest, data_, (size_t)width_ * height_ * depth_ * 4);
+        return true;
+
     case CF_DXT1:
     case CF_DXT3:
     case CF_DXT5:
@@ -1144,36 +1279,15 @@ bool Image::Resize(int width, int height)
     if (!data_ || width <= 0 || height <= 0)
         return false;
 
-    /// \todo Reducing image size does not sample all needed pixels
+    // Separable resampling: bilinear when enlarging, covering all source pixels when reducing
+    ResampleAxis xAxis;
+    ResampleAxis yAxis;
+    xAxis.Define(width_, width, RESAMPLE_TENT);
+    yAxis.Define(height_, height, RESAMPLE_TENT);
+
     SharedArrayPtr<unsigned char> newData(new unsigned char[width * height * components_]);
-    for (int y = 0; y < height; ++y)
-    {
-        for (int x = 0; x < width; ++x)
-        {
-            // Calculate float coordinates between 0 - 1 for resampling
-            float xF = (width_ > 1) ? (float)x / (float)(width - 1) : 0.0f;
-            float yF = (height_ > 1) ? (float)y / (float)(height - 1) : 0.0f;
-            unsigned uintColor = GetPixelBilinear(xF, yF).ToUInt();
-            unsigned char* dest = newData + (y * width + x) * components_;
-            auto* src = (unsigned char*)&uintColor;
-
-            switch (components_)
-            {
-            case 4:
-                dest[3] = src[3];
-                // Fall through
-            case 3:
-                dest[2] = src[2];
-                // Fall through
-            case 2:
-                dest[1] = src[1];
-                // Fall through
-            default:
-                dest[0] = src[0];
-                break;
-            }
-        }
-    }
+    ResampleWork work{data_.Get(), newData.Get(), width_, height_, components_, &xAxis, &yAxis, false, 0, height};
+    RunResampleWork(GetSubsystem<WorkQueue>(), work);
 
     width_ = width;
     height_ = height;
@@ -1308,10 +1422,7 @@ bool Image::SaveDDS(const String& fileName) const
     }
 
     if (IsCompressed())
-    {
-        URHO3D_LOGERROR("Can not save compressed image to DDS");
-        return false;
-    }
+        return SaveCompressedDDS(outFile);
 
     if (components_ != 4)
     {
@@ -1348,6 +1459,64 @@ bool Image::SaveDDS(const String& fileName) const
     return true;
 }
 
+bool Image::SaveCompressedDDS(Serializer& dest) const
+{
+    unsigned fourCC;
+    switch (compressedFormat_)
+    {
+    case CF_DXT1:
+        fourCC = FOURCC_DXT1;
+        break;
+
+    case CF_DXT3:
+        fourCC = FOURCC_DXT3;
+        break;
+
+    case CF_DXT5:
+        fourCC = FOURCC_DXT5;
+        break;
+
+    default:
+        URHO3D_LOGERROR("Can not save image compressed in a non-DXT format to DDS");
+        return false;
+    }
+
+    if (depth_ > 1 || cubemap_ || array_)
+    {
+        URHO3D_LOGERROR("Can not save compressed 3D, cube or array image to DDS");
+        return false;
+    }
+
+    dest.WriteFileID("DDS ");
+
+    CompressedLevel firstLevel = GetCompressedLevel(0);
+    DDSurfaceDesc2 ddsd;        // NOLINT(hicpp-member-init)
+    memset(&ddsd, 0, sizeof(ddsd));
+    ddsd.dwSize_ = sizeof(ddsd);
+    ddsd.dwFlags_ = 0x00000001l /*DDSD_CAPS*/
+        | 0x00000002l /*DDSD_HEIGHT*/ | 0x00000004l /*DDSD_WIDTH*/ | 0x00020000l /*DDSD_MIPMAPCOUNT*/ | 0x00001000l /*DDSD_PIXELFORMAT*/
+        | 0x00080000l /*DDSD_LINEARSIZE*/;
+    ddsd.dwWidth_ = width_;
+    ddsd.dwHeight_ = height_;
+    ddsd.dwLinearSize_ = firstLevel.dataSize_;
+    ddsd.dwMipMapCount_ = numCompressedLevels_;
+    ddsd.ddpfPixelFormat_.dwSize_ = sizeof(ddsd.ddpfPixelFormat_);
+    ddsd.ddpfPixelFormat_.dwFlags_ = 0x00000004l /*DDPF_FOURCC*/;
+    ddsd.ddpfPixelFormat_.dwFourCC_ = fourCC;
+    ddsd.ddsCaps_.dwCaps_ = DDSCAPS_TEXTURE | (numCompressedLevels_ > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+    dest.Write(&ddsd, sizeof(ddsd));
+    for (unsigned i = 0; i < numCompressedLevels_; ++i)
+    {
+        CompressedLevel level = GetCompressedLevel(i);
+        if (!level.data_)
+            return false;
+        dest.Write(level.data_, level.dataSize_);
+    }
+
+    return true;
+}
+
 bool Image::SaveWEBP(const String& fileName, float compression /* = 0.0f */) const
 {
 #ifdef URHO3D_WEBP
@@ -1516,6 +1685,67 @@ unsigned Image::GetPixelInt(int x, int y, int z) const
     return ret;
 }
 
+unsigned char* Image::GetRowData(int y, int z) const
+{
+    if (!data_ || IsCompressed() || y < 0 || y >= height_ || z < 0 || z >= depth_)
+        return nullptr;
+
+    return data_ + (z * width_ * height_ + y * width_) * components_;
+}
+
+void Image::GetPixelsInt(int x, int y, int count, unsigned* dest) const
+{
+    if (!dest || count <= 0)
+        return;
+
+    const unsigned char* src = GetRowData(Clamp(y, 0, height_ - 1));
+    if (!src)
+    {
+        for (int i = 0; i < count; ++i)
+            dest[i] = 0xff000000;
+        return;
+    }
+
+    // Pixels outside the row are clamped to the edge as in GetPixelInt()
+    int i = 0;
+    for (; i < count && x + i < 0; ++i)
+        dest[i] = GetPixelInt(0, y);
+    int inside = Max(Min(count - i, width_ - (x + i)), 0);
+
+    if (inside)
+    {
+        src += (x + i) * components_;
+        unsigned* out = dest + i;
+
+        switch (components_)
+        {
+        case 4:
+            memcpy(out, src, inside * sizeof(unsigned));
+            break;
+
+        case 3:
+            for (int j = 0; j < inside; ++j, src += 3)
+                out[j] = 0xff000000 | ((unsigned)src[2] << 16) | ((unsigned)src[1] << 8) | (unsigned)src[0];
+            break;
+
+        case 2:
+            for (int j = 0; j < inside; ++j, src += 2)
+                out[j] = 0xff000000 | ((unsigned)src[1] << 8) | (unsigned)src[0];
+            break;
+
+        default:
+            for (int j = 0; j < inside; ++j, ++src)
+                out[j] = 0xff000000 | ((unsigned)src[0] << 16) | ((unsigned)src[0] << 8) | (unsigned)src[0];
+            break;
+        }
+
+        i += inside;
+    }
+
+    for (; i < count; ++i)
+        dest[i] = GetPixelInt(width_ - 1, y);
+}
+
 Color Image::GetPixelBilinear(float x, float y) const
 {
     x = Clamp(x * width_ - 0.5f, 0.0f, (float)(width_ - 1));
@@ -1646,84 +1876,8 @@ SharedPtr<Image> Image::GetNextLevel() const
     // 2D case
     else if (depth_ == 1)
     {
-        switch (components_)
-        {
-        case 1:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_];
-                unsigned char* out = &pixelDataOut[y * widthOut];
-
-                for (int x = 0; x < widthOut; ++x)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 1] +
-                                              inLower[x * 2] + inLower[x * 2 + 1]) >> 2);
-                }
-            }
-            break;
-
-        case 2:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 2];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 2];
-                unsigned char* out = &pixelDataOut[y * widthOut * 2];
-
-                for (int x = 0; x < widthOut * 2; x += 2)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 2] +
-                                              inLower[x * 2] + inLower[x * 2 + 2]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 3] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 3]) >> 2);
-                }
-            }
-            break;
-
-        case 3:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 3];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 3];
-                unsigned char* out = &pixelDataOut[y * widthOut * 3];
-
-                for (int x = 0; x < widthOut * 3; x += 3)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 3] +
-                                              inLower[x * 2] + inLower[x * 2 + 3]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 4] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 5]) >> 2);
-                }
-            }
-            break;
-
-        case 4:
-            for (int y = 0; y < heightOut; ++y)
-            {
-                const unsigned char* inUpper = &pixelDataIn[(y * 2) * width_ * 4];
-                const unsigned char* inLower = &pixelDataIn[(y * 2 + 1) * width_ * 4];
-                unsigned char* out = &pixelDataOut[y * widthOut * 4];
-
-                for (int x = 0; x < widthOut * 4; x += 4)
-                {
-                    out[x] = (unsigned char)(((unsigned)inUpper[x * 2] + inUpper[x * 2 + 4] +
-                                              inLower[x * 2] + inLower[x * 2 + 4]) >> 2);
-                    out[x + 1] = (unsigned char)(((unsigned)inUpper[x * 2 + 1] + inUpper[x * 2 + 5] +
-                                                  inLower[x * 2 + 1] + inLower[x * 2 + 5]) >> 2);
-                    out[x + 2] = (unsigned char)(((unsigned)inUpper[x * 2 + 2] + inUpper[x * 2 + 6] +
-                                                  inLower[x * 2 + 2] + inLower[x * 2 + 6]) >> 2);
-                    out[x + 3] = (unsigned char)(((unsigned)inUpper[x * 2 + 3] + inUpper[x * 2 + 7] +
-                                                  inLower[x * 2 + 3] + inLower[x * 2 + 7]) >> 2);
-                }
-            }
-            break;
-
-        default:
-            assert(false);  // Should never reach here
-            break;
-        }
+        ResampleWork work{pixelDataIn, pixelDataOut, width_, height_, components_, nullptr, nullptr, false, 0, heightOut};
+        RunResampleWork(GetSubsystem<WorkQueue>(), work);
     }
     // 3D case
     else
@@ -1859,6 +2013,48 @@ SharedPtr<Image> Image::GetNextLevel() const
     return mipImage;
 }
 
+SharedPtr<Image> Image::GetNextLevel(ResampleFilter filter, bool gammaCorrect) const
+{
+    if (filter == RESAMPLE_BOX && !gammaCorrect)
+        return nextLevel_ ? nextLevel_ : GetNextLevel();
+
+    if (IsCompressed())
+    {
+        URHO3D_LOGERROR("Can not generate mip level from compressed data");
+        return SharedPtr<Image>();
+    }
+    if (components_ < 1 || components_ > 4)
+    {
+        URHO3D_LOGERROR("Illegal number of image components for mip level generation");
+        return SharedPtr<Image>();
+    }
+    if (depth_ > 1)
+    {
+        URHO3D_LOGWARNING("Filtered mip level generation not supported for 3D images, using box filter");
+        return GetNextLevel();
+    }
+    if (!data_)
+        return SharedPtr<Image>();
+
+    URHO3D_PROFILE(CalculateFilteredImageMipLevel);
+
+    int widthOut = Max(width_ / 2, 1);
+    int heightOut = Max(height_ / 2, 1);
+
+    SharedPtr<Image> mipImage(new Image(context_));
+    mipImage->SetSize(widthOut, heightOut, components_);
+
+    ResampleAxis xAxis;
+    ResampleAxis yAxis;
+    xAxis.Define(width_, widthOut, filter);
+    yAxis.Define(height_, heightOut, filter);
+
+    ResampleWork work{data_.Get(), mipImage->data_.Get(), width_, height_, components_, &xAxis, &yAxis, gammaCorrect, 0, heightOut};
+    RunResampleWork(GetSubsystem<WorkQueue>(), work);
+
+    return mipImage;
+}
+
 SharedPtr<Image> Image::ConvertToRGBA() const
 {
     if (IsCompressed())
@@ -1929,6 +2125,143 @@ SharedPtr<Image> Image::ConvertToRGBA() const
     return ret;
 }
 
+SharedPtr<Image> Image::GetDecompressedImage() const
+{
+    if (!IsCompressed())
+        return ConvertToRGBA();
+    if (!numCompressedLevels_)
+    {
+        URHO3D_LOGERROR("Can not decompress image without compressed levels");
+        return SharedPtr<Image>();
+    }
+
+    URHO3D_PROFILE(DecompressImage);
+
+    Vector<SharedPtr<Image> > levelImages;
+    PODVector<DecompressWork> works;
+
+    for (unsigned i = 0; i < numCompressedLevels_; ++i)
+    {
+        CompressedLevel level = GetCompressedLevel(i);
+        if (!level.data_)
+            return SharedPtr<Image>();
+
+        SharedPtr<Image> levelImage(new Image(context_));
+        levelImage->SetSize(level.width_, level.height_, level.depth_, 4);
+        levelImages.Push(levelImage);
+
+        // DXT and ETC blocks are independent, so large 2D levels can be split into bands of block rows.
+        // PVRTC blocks are interpolated with their neighbours and have to be decompressed as a whole
+        bool canSplit = level.depth_ == 1 && compressedFormat_ >= CF_DXT1 && compressedFormat_ <= CF_ETC1;
+        int rowsPerWork = canSplit ? DECOMPRESS_ROWS_PER_WORK_ITEM : level.height_;
+
+        for (int row = 0; row < level.height_; row += rowsPerWork)
+        {
+            DecompressWork work;
+            work.level_ = level;
+            work.level_.height_ = Min(rowsPerWork, level.height_ - row);
+            work.level_.data_ += (row / 4) * level.rowSize_;
+            work.dest_ = levelImage->GetData() + row * level.width_ * 4;
+            works.Push(work);
+        }
+    }
+
+    RunImageWork(GetSubsystem<WorkQueue>(), works, DecompressLevelWork);
+
+    // Store the remaining levels as the precalculated mip levels of the decompressed image
+    for (unsigned i = 0; i + 1 < levelImages.Size(); ++i)
+        levelImages[i]->nextLevel_ = levelImages[i + 1];
+
+    return levelImages[0];
+}
+
+SharedPtr<Image> Image::GetCompressedImage(CompressedFormat format) const
+{
+    if (format != CF_DXT1 && format != CF_DXT3 && format != CF_DXT5 && format != CF_ETC1)
+    {
+        URHO3D_LOGERROR("Unsupported compressed format for image compression");
+        return SharedPtr<Image>();
+    }
+    if (IsCompressed())
+    {
+        URHO3D_LOGERROR("Image is already compressed");
+        return SharedPtr<Image>();
+    }
+    if (depth_ > 1)
+    {
+        URHO3D_LOGERROR("Compression not supported for 3D images");
+        return SharedPtr<Image>();
+    }
+    if (!data_)
+        return SharedPtr<Image>();
+
+    URHO3D_PROFILE(CompressImage);
+
+    // Collect RGBA mip levels down to 1x1, using the precalculated levels when they exist
+    Vector<SharedPtr<Image> > tempImages;
+    PODVector<const Image*> levels;
+    const Image* level = this;
+    while (level)
+    {
+        if (level->components_ != 4)
+        {
+            // The converted image has no precalculated levels, so the mip chain continues from the original level
+            SharedPtr<Image> rgbaLevel = level->ConvertToRGBA();
+            if (!rgbaLevel)
+                return SharedPtr<Image>();
+            tempImages.Push(rgbaLevel);
+            levels.Push(rgbaLevel);
+        }
+        else
+            levels.Push(level);
+
+        if (level->width_ == 1 && level->height_ == 1)
+            break;
+        tempImages.Push(level->GetNextLevel());
+        level = tempImages.Back();
+    }
+
+    unsigned bytesPerBlock = format == CF_DXT3 || format == CF_DXT5 ? 16 : 8;
+    unsigned dataSize = 0;
+    for (unsigned i = 0; i < levels.Size(); ++i)
+        dataSize += ((levels[i]->width_ + 3) / 4) * ((levels[i]->height_ + 3) / 4) * bytesPerBlock;
+
+    SharedPtr<Image> compressedImage(new Image(context_));
+    compressedImage->data_ = new unsigned char[dataSize];
+    compressedImage->width_ = width_;
+    compressedImage->height_ = height_;
+    compressedImage->depth_ = 1;
+    compressedImage->components_ = format == CF_DXT1 || format == CF_ETC1 ? 3 : 4;
+    compressedImage->compressedFormat_ = format;
+    compressedImage->numCompressedLevels_ = levels.Size();
+    compressedImage->sRGB_ = sRGB_;
+    compressedImage->SetMemoryUse(dataSize);
+
+    // Split the levels into bands of block rows
+    PODVector<CompressWork> works;
+    unsigned char* blocks = compressedImage->data_.Get();
+    for (unsigned i = 0; i < levels.Size(); ++i)
+    {
+        const Image* levelImage = levels[i];
+        unsigned rowSize = ((levelImage->width_ + 3) / 4) * bytesPerBlock;
+        for (int row = 0; row < levelImage->height_; row += COMPRESS_ROWS_PER_WORK_ITEM)
+        {
+            CompressWork work;
+            work.rgba_ = levelImage->data_.Get() + row * levelImage->width_ * 4;
+            work.blocks_ = blocks + (row / 4) * rowSize;
+            work.width_ = levelImage->width_;
+            work.height_ = Min(COMPRESS_ROWS_PER_WORK_ITEM, levelImage->height_ - row);
+            work.format_ = format;
+            works.Push(work);
+        }
+        blocks += ((levelImage->height_ + 3) / 4) * rowSize;
+    }
+
+    RunImageWork(GetSubsystem<WorkQueue>(), works, CompressLevelWork);
+
+    return compressedImage;
+}
+
 CompressedLevel Image::GetCompressedLevel(unsigned index) const
 {
     CompressedLevel level;
@@ -2238,7 +2571,7 @@ SDL_Surface* Image::GetSDLSurface(const IntRect& rect) const
     return surface;
 }
 
-void Image::PrecalculateLevels()
+void Image::PrecalculateLevels(ResampleFilter filter, bool gammaCorrect)
 {
     if (!data_ || IsCompressed())
         return;
@@ -2249,11 +2582,11 @@ void Image::PrecalculateLevels()
 
     if (width_ > 1 || height_ > 1)
     {
-        SharedPtr<Image> current = GetNextLevel();
+        SharedPtr<Image> current = GetNextLevel(filter, gammaCorrect);
         nextLevel_ = current;
         while (current && (current->width_ > 1 || current->height_ > 1))
         {
-            current->nextLevel_ = current->GetNextLevel();
+            current->nextLevel_ = current->GetNextLevel(filter, gammaCorrect);
             current = current->nextLevel_;
         }
     }
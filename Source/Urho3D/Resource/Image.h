@@ -47,6 +47,17 @@ enum CompressedFormat
     CF_PVRTC_RGBA_4BPP,
 };
 
+/// Image resampling filters.
+enum ResampleFilter
+{
+    /// Average of the source pixels covered by each destination pixel.
+    RESAMPLE_BOX = 0,
+    /// Bilinear interpolation when enlarging, triangle-weighted average when reducing.
+    RESAMPLE_TENT,
+    /// Kaiser-windowed sinc. Sharper mip levels with less aliasing than the box filter.
+    RESAMPLE_KAISER
+};
+
 /// Compressed image mip level.
 struct CompressedLevel
 {
@@ -113,7 +124,7 @@ public:
     bool FlipHorizontal();
     /// Flip image vertically. Return true if successful.
     bool FlipVertical();
-    /// Resize image by bilinear resampling. Return true if successful.
+    /// Resize image. Uses bilinear interpolation when enlarging and averages all covered source pixels when reducing. Large images are processed in worker threads when called from the main thread. Return true if successful.
     bool Resize(int width, int height);
     /// Clear the image with a color.
     void Clear(const Color& color);
@@ -127,7 +138,7 @@ public:
     bool SaveTGA(const String& fileName) const;
     /// Save in JPG format with specified quality. Return true if successful.
     bool SaveJPG(const String& fileName, int quality) const;
-    /// Save in DDS format. Only uncompressed RGBA images are supported. Return true if successful.
+    /// Save in DDS format. Uncompressed RGBA and DXT compressed 2D images are supported. Return true if successful.
     bool SaveDDS(const String& fileName) const;
     /// Save in WebP format with minimum (fastest) or specified compression. Return true if successful. Fails always if WebP support is not compiled in.
     bool SaveWEBP(const String& fileName, float compression = 0.0f) const;
@@ -146,6 +157,10 @@ public:
     unsigned GetPixelInt(int x, int y) const;
     /// Return a 3D pixel integer color. R component is in the 8 lowest bits.
     unsigned GetPixelInt(int x, int y, int z) const;
+    /// Return pointer to the pixel data of a row, or null if out of range or compressed.
+    unsigned char* GetRowData(int y, int z = 0) const;
+    /// Return a horizontal run of 2D pixel integer colors starting from x. R component is in the 8 lowest bits. Avoids per-pixel lookups when reading many pixels.
+    void GetPixelsInt(int x, int y, int count, unsigned* dest) const;
     /// Return a bilinearly sampled 2D pixel color. X and Y have the range 0-1.
     Color GetPixelBilinear(float x, float y) const;
     /// Return a trilinearly sampled 3D pixel color. X, Y and Z have the range 0-1.
@@ -177,18 +192,24 @@ public:
 
     /// Return next mip level by bilinear filtering. Note that if the image is already 1x1x1, will keep returning an image of that size.
     SharedPtr<Image> GetNextLevel() const;
+    /// Return next mip level calculated with the specified filter, optionally filtering color in linear space for sRGB data. Always recalculated unless using the plain box filter. 3D images only support the box filter.
+    SharedPtr<Image> GetNextLevel(ResampleFilter filter, bool gammaCorrect) const;
     /// Return the next sibling image of an array or cubemap.
     SharedPtr<Image> GetNextSibling() const { return nextSibling_;  }
     /// Return image converted to 4-component (RGBA) to circumvent modern rendering API's not supporting e.g. the luminance-alpha format.
     SharedPtr<Image> ConvertToRGBA() const;
     /// Return a compressed mip level.
     CompressedLevel GetCompressedLevel(unsigned index) const;
+    /// Return the image compressed to DXT1, DXT3, DXT5 or ETC1 with a full mip chain, using the precalculated mip levels if they exist. DXT1 and ETC1 discard alpha. Levels are compressed in worker threads when called from the main thread. 3D images are not supported. Return null if failed.
+    SharedPtr<Image> GetCompressedImage(CompressedFormat format) const;
+    /// Return the image decompressed to RGBA, with the remaining compressed mip levels stored as its precalculated mip levels. Large levels are decompressed in worker threads when called from the main thread. Uncompressed images are converted to RGBA. Return null if failed.
+    SharedPtr<Image> GetDecompressedImage() const;
     /// Return subimage from the image by the defined rect or null if failed. 3D images are not supported. You must free the subimage yourself.
     Image* GetSubimage(const IntRect& rect) const;
     /// Return an SDL surface from the image, or null if failed. Only RGB images are supported. Specify rect to only return partial image. You must free the surface yourself.
     SDL_Surface* GetSDLSurface(const IntRect& rect = IntRect::ZERO) const;
-    /// Precalculate the mip levels. Used by asynchronous texture loading.
-    void PrecalculateLevels();
+    /// Precalculate the mip levels with the specified filter. Used by asynchronous texture loading. Large 2D levels are calculated in worker threads when called from the main thread.
+    void PrecalculateLevels(ResampleFilter filter = RESAMPLE_BOX, bool gammaCorrect = false);
     /// Whether this texture has an alpha channel
     bool HasAlphaChannel() const;
     /// Copy contents of the image into the defined rect, scaling if necessary. This image should already be large enough to include the rect. Compressed and 3D images are not supported.
@@ -205,6 +226,8 @@ private:
     static unsigned char* GetImageData(Deserializer& source, int& width, int& height, unsigned& components);
     /// Free an image file's pixel data.
     static void FreeImageData(unsigned char* pixelData);
+    /// Save a DXT compressed image in DDS format.
+    bool SaveCompressedDDS(Serializer& dest) const;
 
     /// Width.
     int width_{};
@@ -0,0 +1,388 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Resource/ImageResample.h"
+
+#include <cstring>
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Radius of the Kaiser filter in destination pixels.
+static const float KAISER_RADIUS = 3.0f;
+/// Kaiser window shape parameter.
+static const float KAISER_ALPHA = 4.0f;
+/// Size of the linear to sRGB conversion table.
+static const int LINEAR_TO_SRGB_SIZE = 4096;
+
+/// Conversion tables between 8-bit color components and linear floats.
+struct GammaTables
+{
+    /// Construct.
+    GammaTables()
+    {
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            float c = (float)i / 255.0f;
+            unorm_[i] = c;
+            toLinear_[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < LINEAR_TO_SRGB_SIZE; ++i)
+        {
+            float l = (float)i / (float)(LINEAR_TO_SRGB_SIZE - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+            toSRGB_[i] = (unsigned char)Clamp((int)(c * 255.0f + 0.5f), 0, 255);
+        }
+    }
+
+    /// 8-bit value to float without gamma conversion.
+    float unorm_[256];
+    /// 8-bit sRGB value to linear float.
+    float toLinear_[256];
+    /// Linear float, quantized to the table size, to 8-bit sRGB value.
+    unsigned char toSRGB_[LINEAR_TO_SRGB_SIZE];
+};
+
+static const GammaTables& GetGammaTables()
+{
+    static const GammaTables tables;
+    return tables;
+}
+
+/// Zeroth order modified Bessel function of the first kind.
+static float BesselI0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+    float halfX = x * 0.5f;
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-7f)
+            break;
+    }
+    return sum;
+}
+
+static float Sinc(float x)
+{
+    if (x < 1e-5f)
+        return 1.0f;
+    x *= M_PI;
+    return sinf(x) / x;
+}
+
+static float GetFilterRadius(ResampleFilter filter)
+{
+    switch (filter)
+    {
+    case RESAMPLE_TENT:
+        return 1.0f;
+
+    case RESAMPLE_KAISER:
+        return KAISER_RADIUS;
+
+    default:
+        return 0.5f;
+    }
+}
+
+static float GetFilterWeight(ResampleFilter filter, float x)
+{
+    x = Abs(x);
+
+    switch (filter)
+    {
+    case RESAMPLE_TENT:
+        return x < 1.0f ? 1.0f - x : 0.0f;
+
+    case RESAMPLE_KAISER:
+        {
+            if (x >= KAISER_RADIUS)
+                return 0.0f;
+            float t = x / KAISER_RADIUS;
+            return Sinc(x) * BesselI0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / BesselI0(KAISER_ALPHA);
+        }
+
+    default:
+        return x < 0.5f ? 1.0f : 0.0f;
+    }
+}
+
+void ResampleAxis::Define(int srcSize, int destSize, ResampleFilter filter)
+{
+    srcSize = Max(srcSize, 1);
+    destSize = Max(destSize, 1);
+
+    // When reducing, stretch the filter to cover all source pixels of a destination pixel
+    float scale = (float)srcSize / (float)destSize;
+    float filterScale = Max(scale, 1.0f);
+    float support = GetFilterRadius(filter) * filterScale;
+    auto maxTaps = (unsigned)CeilToInt(support * 2.0f) + 2;
+
+    PODVector<int> firsts(destSize);
+    PODVector<unsigned> counts(destSize);
+    PODVector<float> weights(destSize * maxTaps);
+    numTaps_ = 1;
+
+    for (int i = 0; i < destSize; ++i)
+    {
+        float center = ((float)i + 0.5f) * scale;
+        int first = FloorToInt(center - support);
+        float* w = &weights[i * maxTaps];
+        float total = 0.0f;
+        int firstNonZero = -1;
+        int lastNonZero = -1;
+
+        for (unsigned t = 0; t < maxTaps; ++t)
+        {
+            w[t] = GetFilterWeight(filter, ((float)(first + (int)t) + 0.5f - center) / filterScale);
+            if (w[t] != 0.0f)
+            {
+                if (firstNonZero < 0)
+                    firstNonZero = t;
+                lastNonZero = t;
+                total += w[t];
+            }
+        }
+
+        if (firstNonZero < 0 || total == 0.0f)
+        {
+            // Degenerate case, use the nearest source pixel
+            firstNonZero = lastNonZero = Clamp((int)center - first, 0, (int)maxTaps - 1);
+            w[firstNonZero] = total = 1.0f;
+        }
+
+        for (unsigned t = 0; t < maxTaps; ++t)
+            w[t] /= total;
+
+        // Drop the zero weights from both ends
+        if (firstNonZero > 0)
+            memmove(w, w + firstNonZero, (lastNonZero - firstNonZero + 1) * sizeof(float));
+        firsts[i] = first + firstNonZero;
+        counts[i] = (unsigned)(lastNonZero - firstNonZero + 1);
+        numTaps_ = Max(numTaps_, counts[i]);
+    }
+
+    indices_.Resize(destSize * numTaps_);
+    weights_.Resize(destSize * numTaps_);
+
+    // Pad destination pixels with fewer taps than the maximum with zero weights
+    for (int i = 0; i < destSize; ++i)
+    {
+        const float* w = &weights[i * maxTaps];
+        for (unsigned t = 0; t < numTaps_; ++t)
+        {
+            bool valid = t < counts[i];
+            indices_[i * numTaps_ + t] = Clamp(valid ? firsts[i] + (int)t : firsts[i], 0, srcSize - 1);
+            weights_[i * numTaps_ + t] = valid ? w[t] : 0.0f;
+        }
+    }
+}
+
+void DownsampleImageBox(unsigned char* dest, const unsigned char* src, int srcWidth, int srcHeight, unsigned components,
+    int firstRow, int numRows)
+{
+    int destWidth = Max(srcWidth / 2, 1);
+    int lastRow = Min(firstRow + numRows, Max(srcHeight / 2, 1));
+    int c = components;
+    unsigned srcRowSize = (unsigned)(srcWidth * c);
+
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+        const unsigned char* inUpper = src + (y * 2) * srcRowSize;
+        const unsigned char* inLower = inUpper + srcRowSize;
+        unsigned char* out = dest + y * destWidth * c;
+        int x = 0;
+
+#ifdef URHO3D_SSE
+        const __m128i zero = _mm_setzero_si128();
+        if (c == 4)
+        {
+            // 8 source pixels to 4 destination pixels per iteration
+            for (; x + 4 <= destWidth; x += 4)
+            {
+                __m128i sums[2];
+                for (int half = 0; half < 2; ++half)
+                {
+                    __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inUpper + x * 8 + half * 16));
+                    __m128i lower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inLower + x * 8 + half * 16));
+                    __m128i a = _mm_add_epi16(_mm_unpacklo_epi8(upper, zero), _mm_unpacklo_epi8(lower, zero));
+                    __m128i b = _mm_add_epi16(_mm_unpackhi_epi8(upper, zero), _mm_unpackhi_epi8(lower, zero));
+                    sums[half] = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b)), 2);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(sums[0], sums[1]));
+            }
+        }
+        else if (c == 1)
+        {
+            // 16 source pixels to 8 destination pixels per iteration
+            const __m128i ones = _mm_set1_epi16(1);
+            for (; x + 8 <= destWidth; x += 8)
+            {
+                __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inUpper + x * 2));
+                __m128i lower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inLower + x * 2));
+                __m128i a = _mm_add_epi16(_mm_unpacklo_epi8(upper, zero), _mm_unpacklo_epi8(lower, zero));
+                __m128i b = _mm_add_epi16(_mm_unpackhi_epi8(upper, zero), _mm_unpackhi_epi8(lower, zero));
+                __m128i sums = _mm_packs_epi32(_mm_madd_epi16(a, ones), _mm_madd_epi16(b, ones));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(_mm_srli_epi16(sums, 2), zero));
+            }
+        }
+#endif
+
+        for (; x < destWidth; ++x)
+        {
+            const unsigned char* upper = inUpper + x * 2 * c;
+            const unsigned char* lower = inLower + x * 2 * c;
+            for (int k = 0; k < c; ++k)
+                out[x * c + k] = (unsigned char)(((unsigned)upper[k] + upper[k + c] + lower[k] + lower[k + c]) >> 2);
+        }
+    }
+}
+
+void ResampleImage(unsigned char* dest, const unsigned char* src, int srcWidth, int srcHeight, unsigned components,
+    const ResampleAxis& xAxis, const ResampleAxis& yAxis, bool sRGB, int firstRow, int numRows)
+{
+    if (!xAxis.numTaps_ || !yAxis.numTaps_ || components < 1 || components > 4)
+        return;
+
+    const GammaTables& gamma = GetGammaTables();
+    int c = components;
+    int destWidth = xAxis.indices_.Size() / xAxis.numTaps_;
+    int destHeight = yAxis.indices_.Size() / yAxis.numTaps_;
+    int lastRow = Min(firstRow + numRows, destHeight);
+    if (firstRow >= lastRow)
+        return;
+    unsigned srcRowSize = (unsigned)(srcWidth * c);
+
+    // Alpha is never gamma corrected
+    int alphaIndex = c == 4 ? 3 : (c == 2 ? 1 : -1);
+    const float* toFloat[4];
+    bool gammaCorrect[4];
+    for (int k = 0; k < c; ++k)
+    {
+        gammaCorrect[k] = sRGB && k != alphaIndex;
+        toFloat[k] = gammaCorrect[k] ? gamma.toLinear_ : gamma.unorm_;
+    }
+
+    // Convert the source rows used by this band to floats once
+    int minRow = srcHeight - 1;
+    int maxRow = 0;
+    for (unsigned i = firstRow * yAxis.numTaps_; i < lastRow * yAxis.numTaps_; ++i)
+    {
+        if (yAxis.weights_[i] == 0.0f)
+            continue;
+        minRow = Min(minRow, yAxis.indices_[i]);
+        maxRow = Max(maxRow, yAxis.indices_[i]);
+    }
+    if (minRow > maxRow)
+        minRow = maxRow = 0;
+
+    PODVector<float> rows((maxRow - minRow + 1) * srcRowSize);
+    for (int y = minRow; y <= maxRow; ++y)
+    {
+        const unsigned char* in = src + y * srcRowSize;
+        float* out = &rows[(y - minRow) * srcRowSize];
+        for (unsigned i = 0; i < srcRowSize; i += c)
+        {
+            for (int k = 0; k < c; ++k)
+                out[i + k] = toFloat[k][in[i + k]];
+        }
+    }
+
+    PODVector<float> column(srcRowSize);
+
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+        // Vertical pass into a single row
+        float* col = &column[0];
+        memset(col, 0, srcRowSize * sizeof(float));
+
+        for (unsigned t = 0; t < yAxis.numTaps_; ++t)
+        {
+            float weight = yAxis.weights_[y * yAxis.numTaps_ + t];
+            if (weight == 0.0f)
+                continue;
+            const float* row = &rows[(yAxis.indices_[y * yAxis.numTaps_ + t] - minRow) * srcRowSize];
+            unsigned i = 0;
+
+#ifdef URHO3D_SSE
+            __m128 w = _mm_set1_ps(weight);
+            for (; i + 4 <= srcRowSize; i += 4)
+                _mm_storeu_ps(col + i, _mm_add_ps(_mm_loadu_ps(col + i), _mm_mul_ps(_mm_loadu_ps(row + i), w)));
+#endif
+
+            for (; i < srcRowSize; ++i)
+                col[i] += row[i] * weight;
+        }
+
+        // Horizontal pass and conversion back to 8-bit
+        unsigned char* out = dest + y * destWidth * c;
+        for (int x = 0; x < destWidth; ++x)
+        {
+            const int* indices = &xAxis.indices_[x * xAxis.numTaps_];
+            const float* weights = &xAxis.weights_[x * xAxis.numTaps_];
+            float acc[4];
+
+#ifdef URHO3D_SSE
+            if (c == 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (unsigned t = 0; t < xAxis.numTaps_; ++t)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(col + indices[t] * 4), _mm_set1_ps(weights[t])));
+                _mm_storeu_ps(acc, sum);
+            }
+            else
+#endif
+            {
+                for (int k = 0; k < c; ++k)
+                    acc[k] = 0.0f;
+                for (unsigned t = 0; t < xAxis.numTaps_; ++t)
+                {
+                    const float* pixel = col + indices[t] * c;
+                    for (int k = 0; k < c; ++k)
+                        acc[k] += pixel[k] * weights[t];
+                }
+            }
+
+            for (int k = 0; k < c; ++k)
+            {
+                if (gammaCorrect[k])
+                    out[x * c + k] = gamma.toSRGB_[Clamp((int)(acc[k] * (float)(LINEAR_TO_SRGB_SIZE - 1) + 0.5f), 0,
+                        LINEAR_TO_SRGB_SIZE - 1)];
+                else
+                    out[x * c + k] = (unsigned char)Clamp((int)(acc[k] * 255.0f + 0.5f), 0, 255);
+            }
+        }
+    }
+}
+
+}
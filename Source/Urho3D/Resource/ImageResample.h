@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Resource/Image.h"
+
+namespace Urho3D
+{
+
+/// Resampling weights along one image axis.
+struct URHO3D_API ResampleAxis
+{
+    /// Calculate the weights for resampling from source size to destination size.
+    void Define(int srcSize, int destSize, ResampleFilter filter);
+
+    /// Source pixel indices, clamped to the image edge. There are numTaps_ entries per destination pixel.
+    PODVector<int> indices_;
+    /// Normalized weights. There are numTaps_ entries per destination pixel.
+    PODVector<float> weights_;
+    /// Number of source pixels contributing to each destination pixel.
+    unsigned numTaps_{};
+};
+
+/// Calculate rows of the next mip level of a 2D image by averaging 2x2 pixel blocks. Odd last rows and columns of the source are ignored.
+URHO3D_API void DownsampleImageBox(unsigned char* dest, const unsigned char* src, int srcWidth, int srcHeight, unsigned components,
+    int firstRow, int numRows);
+/// Calculate rows of a resampled 2D image. Color components are filtered in linear space when sRGB is true, alpha is always linear.
+URHO3D_API void ResampleImage(unsigned char* dest, const unsigned char* src, int srcWidth, int srcHeight, unsigned components,
+    const ResampleAxis& xAxis, const ResampleAxis& yAxis, bool sRGB, int firstRow, int numRows);
+
+}
@@ -26,8 +26,10 @@
 #include "../Core/Profiler.h"
 #include "../Core/Context.h"
 #include "../IO/Deserializer.h"
+#include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
+#include "../IO/VectorBuffer.h"
 #include "../Resource/JSONFile.h"
 #include "../Resource/ResourceCache.h"
 
@@ -111,6 +113,134 @@ static void ToJSONValue(JSONValue& jsonValue, const rapidjson::Value& rapidjsonV
     }
 }
 
+// Write JSON value in the cooked binary format.
+static void WriteBinaryValue(Serializer& dest, const JSONValue& jsonValue)
+{
+    dest.WriteUByte((unsigned char)jsonValue.GetValueType());
+
+    switch (jsonValue.GetValueType())
+    {
+    case JSON_BOOL:
+        dest.WriteBool(jsonValue.GetBool());
+        break;
+
+    case JSON_NUMBER:
+        dest.WriteUByte((unsigned char)jsonValue.GetNumberType());
+        switch (jsonValue.GetNumberType())
+        {
+        case JSONNT_INT:
+            dest.WriteInt(jsonValue.GetInt());
+            break;
+
+        case JSONNT_UINT:
+            dest.WriteUInt(jsonValue.GetUInt());
+            break;
+
+        default:
+            dest.WriteDouble(jsonValue.GetDouble());
+            break;
+        }
+        break;
+
+    case JSON_STRING:
+        dest.WriteString(jsonValue.GetString());
+        break;
+
+    case JSON_ARRAY:
+        {
+            const JSONArray& jsonArray = jsonValue.GetArray();
+            dest.WriteVLE(jsonArray.Size());
+            for (unsigned i = 0; i < jsonArray.Size(); ++i)
+                WriteBinaryValue(dest, jsonArray[i]);
+        }
+        break;
+
+    case JSON_OBJECT:
+        {
+            const JSONObject& jsonObject = jsonValue.GetObject();
+            dest.WriteVLE(jsonObject.Size());
+            for (JSONObject::ConstIterator i = jsonObject.Begin(); i != jsonObject.End(); ++i)
+            {
+                dest.WriteString(i->first_);
+                WriteBinaryValue(dest, i->second_);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Read JSON value from the cooked binary format.
+static bool ReadBinaryValue(Deserializer& source, JSONValue& jsonValue)
+{
+    if (source.IsEof())
+        return false;
+
+    switch (source.ReadUByte())
+    {
+    case JSON_NULL:
+        jsonValue.SetType(JSON_NULL);
+        break;
+
+    case JSON_BOOL:
+        jsonValue = source.ReadBool();
+        break;
+
+    case JSON_NUMBER:
+        switch (source.ReadUByte())
+        {
+        case JSONNT_INT:
+            jsonValue = source.ReadInt();
+            break;
+
+        case JSONNT_UINT:
+            jsonValue = source.ReadUInt();
+            break;
+
+        default:
+            jsonValue = source.ReadDouble();
+            break;
+        }
+        break;
+
+    case JSON_STRING:
+        jsonValue = source.ReadString();
+        break;
+
+    case JSON_ARRAY:
+        {
+            unsigned size = source.ReadVLE();
+            jsonValue.Resize(size);
+            for (unsigned i = 0; i < size; ++i)
+            {
+                if (!ReadBinaryValue(source, jsonValue[i]))
+                    return false;
+            }
+        }
+        break;
+
+    case JSON_OBJECT:
+        {
+            unsigned size = source.ReadVLE();
+            jsonValue.SetType(JSON_OBJECT);
+            for (unsigned i = 0; i < size; ++i)
+            {
+                String name = source.ReadString();
+                if (!ReadBinaryValue(source, jsonValue[name]))
+                    return false;
+            }
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
 bool JSONFile::BeginLoad(Deserializer& source)
 {
     unsigned dataSize = source.GetSize();
@@ -125,6 +255,37 @@ bool JSONFile::BeginLoad(Deserializer& source)
         return false;
     buffer[dataSize] = '\0';
 
+    // Already cooked data can be loaded directly, for example from a package file
+    if (dataSize >= 4 && !strncmp(buffer.Get(), "UJSB", 4))
+    {
+        MemoryBuffer binarySource(buffer.Get(), dataSize);
+        if (!LoadBinary(binarySource))
+        {
+            URHO3D_LOGERROR("Could not load cooked JSON data from " + source.GetName());
+            return false;
+        }
+
+        SetMemoryUse(dataSize);
+        return true;
+    }
+
+    // Prefer an up to date cooked version of the file if one exists, as it does not need to be parsed
+    auto* cache = GetSubsystem<ResourceCache>();
+    const String& name = source.GetName();
+    unsigned checksum = 0;
+    if (cache && !name.Empty() && !cache->GetCookedResourceDir().Empty())
+    {
+        for (unsigned i = 0; i < dataSize; ++i)
+            checksum = SDBMHash(checksum, (unsigned char)buffer[i]);
+
+        SharedPtr<File> cookedFile = cache->GetCookedFile(name, checksum);
+        if (cookedFile && LoadBinary(*cookedFile))
+        {
+            SetMemoryUse(dataSize);
+            return true;
+        }
+    }
+
     rapidjson::Document document;
     if (document.Parse<kParseCommentsFlag | kParseTrailingCommasFlag>(buffer).HasParseError())
     {
@@ -134,6 +295,13 @@ bool JSONFile::BeginLoad(Deserializer& source)
 
     ToJSONValue(root_, document);
 
+    if (cache && !name.Empty() && cache->GetAutoCookResources())
+    {
+        SharedPtr<File> cookedFile = cache->CreateCookedFile(name, checksum);
+        if (cookedFile && !SaveBinary(*cookedFile))
+            URHO3D_LOGWARNING("Could not write cooked JSON data for " + name);
+    }
+
     SetMemoryUse(dataSize);
 
     return true;
@@ -229,6 +397,27 @@ bool JSONFile::Save(Serializer& dest, const String& indendation) const
     return dest.Write(buffer.GetString(), size) == size;
 }
 
+bool JSONFile::SaveBinary(Serializer& dest) const
+{
+    VectorBuffer buffer;
+    buffer.WriteFileID("UJSB");
+    WriteBinaryValue(buffer, root_);
+    return dest.Write(buffer.GetData(), buffer.GetSize()) == buffer.GetSize();
+}
+
+bool JSONFile::LoadBinary(Deserializer& source)
+{
+    if (source.ReadFileID() != "UJSB")
+        return false;
+
+    JSONValue root;
+    if (!ReadBinaryValue(source, root))
+        return false;
+
+    root_ = root;
+    return true;
+}
+
 bool JSONFile::FromString(const String & source)
 {
     if (source.Empty())
@@ -47,6 +47,8 @@ public:
     bool Save(Serializer& dest) const override;
     /// Save resource with user-defined indentation, only the first character (if any) of the string is used and the length of the string defines the character count. Return true if successful.
     bool Save(Serializer& dest, const String& indendation) const;
+    /// Save resource in the cooked binary format, which can be loaded without parsing JSON text. Return true if successful.
+    bool SaveBinary(Serializer& dest) const;
 
     /// Deserialize from a string. Return true if successful.
     bool FromString(const String& source);
@@ -59,6 +61,9 @@ public:
     const JSONValue& GetRoot() const { return root_; }
 
 private:
+    /// Load the root value from the cooked binary format. Return true if successful.
+    bool LoadBinary(Deserializer& source);
+
     /// JSON root value.
     JSONValue root_;
 };
@@ -72,6 +72,7 @@ ResourceCache::ResourceCache(Context* context) :
     autoReloadResources_(false),
     returnFailedResources_(false),
     searchPackagesFirst_(true),
+    autoCookResources_(false),
     isRouting_(false),
     finishBackgroundResourcesMs_(5)
 {
@@ -485,6 +486,13 @@ void ResourceCache::RemoveResourceRouter(ResourceRouter* router)
     }
 }
 
+void ResourceCache::SetCookedResourceDir(const String& pathName)
+{
+    MutexLock lock(resourceMutex_);
+
+    cookedResourceDir_ = pathName.Empty() ? String::EMPTY : SanitateResourceDirName(pathName);
+}
+
 SharedPtr<File> ResourceCache::GetFile(const String& name, bool sendEventOnFailure)
 {
     MutexLock lock(resourceMutex_);
@@ -539,6 +547,35 @@ SharedPtr<File> ResourceCache::GetFile(const String& name, bool sendEventOnFailu
     return SharedPtr<File>();
 }
 
+SharedPtr<File> ResourceCache::GetCookedFile(const String& name, unsigned sourceChecksum)
+{
+    String cookedFileName = GetCookedFileName(name);
+    if (cookedFileName.Empty() || !GetSubsystem<FileSystem>()->FileExists(cookedFileName))
+        return SharedPtr<File>();
+
+    SharedPtr<File> file(new File(context_, cookedFileName));
+    if (!file->IsOpen() || file->ReadFileID() != "UCKD" || file->ReadUInt() != sourceChecksum)
+        return SharedPtr<File>();
+
+    file->SetName(name);
+    return file;
+}
+
+SharedPtr<File> ResourceCache::CreateCookedFile(const String& name, unsigned sourceChecksum)
+{
+    String cookedFileName = GetCookedFileName(name);
+    if (cookedFileName.Empty() || !GetSubsystem<FileSystem>()->CreateDir(GetPath(cookedFileName)))
+        return SharedPtr<File>();
+
+    SharedPtr<File> file(new File(context_, cookedFileName, FILE_WRITE));
+    if (!file->IsOpen())
+        return SharedPtr<File>();
+
+    file->WriteFileID("UCKD");
+    file->WriteUInt(sourceChecksum);
+    return file;
+}
+
 Resource* ResourceCache::GetExistingResource(StringHash type, const String& name)
 {
     String sanitatedName = SanitateResourceName(name);
@@ -797,6 +834,13 @@ String ResourceCache::GetResourceFileName(const String& name) const
         return String();
 }
 
+String ResourceCache::GetCookedResourceDir() const
+{
+    MutexLock lock(resourceMutex_);
+
+    return cookedResourceDir_;
+}
+
 ResourceRouter* ResourceCache::GetResourceRouter(unsigned index) const
 {
     return index < resourceRouters_.Size() ? resourceRouters_[index] : nullptr;
@@ -1131,6 +1175,21 @@ File* ResourceCache::SearchPackages(const String& name)
     return nullptr;
 }
 
+String ResourceCache::GetCookedFileName(const String& name) const
+{
+    MutexLock lock(resourceMutex_);
+
+    if (cookedResourceDir_.Empty())
+        return String::EMPTY;
+
+    // Only resources identified by a relative resource name have a stable location inside the cooked resource directory
+    String sanitatedName = SanitateResourceName(name);
+    if (sanitatedName.Empty() || IsAbsolutePath(sanitatedName))
+        return String::EMPTY;
+
+    return cookedResourceDir_ + sanitatedName + ".cooked";
+}
+
 void RegisterResourceLibrary(Context* context)
 {
     Image::RegisterObject(context);
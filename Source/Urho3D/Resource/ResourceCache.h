@@ -129,6 +129,11 @@ public:
     /// Set how many milliseconds maximum per frame to spend on finishing background loaded resources.
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
 
+    /// Set directory for cooked (pre-parsed binary) versions of XML and JSON resources. Empty (default) disables cooked resources.
+    void SetCookedResourceDir(const String& pathName);
+    /// Enable or disable writing cooked resources when they are missing or out of date. Requires a cooked resource directory. Default false.
+    void SetAutoCookResources(bool enable) { autoCookResources_ = enable; }
+
     /// Add a resource router object. By default there is none, so the routing process is skipped.
     void AddResourceRouter(ResourceRouter* router, bool addAsFirst = false);
     /// Remove a resource router object.
@@ -136,6 +141,10 @@ public:
 
     /// Open and return a file from the resource load paths or from inside a package file. If not found, use a fallback search with absolute path. Return null if fails. Can be called from outside the main thread.
     SharedPtr<File> GetFile(const String& name, bool sendEventOnFailure = true);
+    /// Open the cooked version of a resource, positioned after the cooked header. Return null if not found or if it was cooked from a source with a different checksum. Can be called from outside the main thread.
+    SharedPtr<File> GetCookedFile(const String& name, unsigned sourceChecksum);
+    /// Create the cooked version of a resource for writing and write the cooked header. Return null if cooked resources are disabled or the file could not be created. Can be called from outside the main thread.
+    SharedPtr<File> CreateCookedFile(const String& name, unsigned sourceChecksum);
     /// Return a resource by type and name. Load if not loaded yet. Return null if not found or if fails, unless SetReturnFailedResources(true) has been called. Can be called only from the main thread.
     Resource* GetResource(StringHash type, const String& name, bool sendEventOnFailure = true);
     /// Load a resource without storing it in the resource cache. Return null if not found or if fails. Can be called from outside the main thread if the resource itself is safe to load completely (it does not possess for example GPU data.)
@@ -193,6 +202,12 @@ public:
     /// Return how many milliseconds maximum to spend on finishing background loaded resources.
     int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
 
+    /// Return cooked resource directory.
+    String GetCookedResourceDir() const;
+
+    /// Return whether cooked resources are written automatically.
+    bool GetAutoCookResources() const { return autoCookResources_; }
+
     /// Return a resource router by index.
     ResourceRouter* GetResourceRouter(unsigned index) const;
 
@@ -225,6 +240,8 @@ private:
     File* SearchResourceDirs(const String& name);
     /// Search resource packages for file.
     File* SearchPackages(const String& name);
+    /// Return full file name of the cooked version of a resource, or empty if cooked resources are disabled or the name can not be cooked.
+    String GetCookedFileName(const String& name) const;
 
     /// Mutex for thread-safe access to the resource directories, resource packages and resource dependencies.
     mutable Mutex resourceMutex_;
@@ -242,12 +259,16 @@ private:
     SharedPtr<BackgroundLoader> backgroundLoader_;
     /// Resource routers.
     Vector<SharedPtr<ResourceRouter> > resourceRouters_;
+    /// Cooked resource directory.
+    String cookedResourceDir_;
     /// Automatic resource reloading flag.
     bool autoReloadResources_;
     /// Return failed resources flag.
     bool returnFailedResources_;
     /// Search priority flag.
     bool searchPackagesFirst_;
+    /// Automatic resource cooking flag.
+    bool autoCookResources_;
     /// Resource routing flag to prevent endless recursion.
     mutable bool isRouting_;
     /// How many milliseconds maximum per frame to spend on finishing background loaded resources.
@@ -26,6 +26,7 @@
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
 #include "../IO/Deserializer.h"
+#include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../IO/VectorBuffer.h"
@@ -63,6 +64,93 @@ public:
     bool success_;
 };
 
+/// Add a string to the string table of a cooked XML document if not yet included.
+static void AddString(const char* str, HashMap<String, unsigned>& indices, Vector<String>& strings)
+{
+    String value(str);
+    if (!indices.Contains(value))
+    {
+        indices[value] = strings.Size();
+        strings.Push(value);
+    }
+}
+
+/// Build the string table of a cooked XML document.
+static void CollectStrings(const pugi::xml_node& node, HashMap<String, unsigned>& indices, Vector<String>& strings)
+{
+    AddString(node.name(), indices, strings);
+    AddString(node.value(), indices, strings);
+
+    for (pugi::xml_attribute attr = node.first_attribute(); attr; attr = attr.next_attribute())
+    {
+        AddString(attr.name(), indices, strings);
+        AddString(attr.value(), indices, strings);
+    }
+
+    for (pugi::xml_node child = node.first_child(); child; child = child.next_sibling())
+        CollectStrings(child, indices, strings);
+}
+
+/// Write a node and its children to a cooked XML document.
+static void WriteBinaryNode(Serializer& dest, const pugi::xml_node& node, const HashMap<String, unsigned>& indices)
+{
+    dest.WriteUByte((unsigned char)node.type());
+    dest.WriteVLE(*indices[String(node.name())]);
+    dest.WriteVLE(*indices[String(node.value())]);
+
+    unsigned numAttributes = 0;
+    for (pugi::xml_attribute attr = node.first_attribute(); attr; attr = attr.next_attribute())
+        ++numAttributes;
+    dest.WriteVLE(numAttributes);
+    for (pugi::xml_attribute attr = node.first_attribute(); attr; attr = attr.next_attribute())
+    {
+        dest.WriteVLE(*indices[String(attr.name())]);
+        dest.WriteVLE(*indices[String(attr.value())]);
+    }
+
+    unsigned numChildren = 0;
+    for (pugi::xml_node child = node.first_child(); child; child = child.next_sibling())
+        ++numChildren;
+    dest.WriteVLE(numChildren);
+    for (pugi::xml_node child = node.first_child(); child; child = child.next_sibling())
+        WriteBinaryNode(dest, child, indices);
+}
+
+/// Read a node and its children from a cooked XML document.
+static bool ReadBinaryNode(Deserializer& source, pugi::xml_node& parent, const Vector<String>& strings)
+{
+    auto type = (pugi::xml_node_type)source.ReadUByte();
+    unsigned nameIndex = source.ReadVLE();
+    unsigned valueIndex = source.ReadVLE();
+    if (type <= pugi::node_document || type > pugi::node_doctype || nameIndex >= strings.Size() || valueIndex >= strings.Size())
+        return false;
+
+    pugi::xml_node node = parent.append_child(type);
+    if (!strings[nameIndex].Empty())
+        node.set_name(strings[nameIndex].CString());
+    if (!strings[valueIndex].Empty())
+        node.set_value(strings[valueIndex].CString());
+
+    unsigned numAttributes = source.ReadVLE();
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        unsigned attrNameIndex = source.ReadVLE();
+        unsigned attrValueIndex = source.ReadVLE();
+        if (attrNameIndex >= strings.Size() || attrValueIndex >= strings.Size())
+            return false;
+        node.append_attribute(strings[attrNameIndex].CString()).set_value(strings[attrValueIndex].CString());
+    }
+
+    unsigned numChildren = source.ReadVLE();
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if (source.IsEof() || !ReadBinaryNode(source, node, strings))
+            return false;
+    }
+
+    return true;
+}
+
 XMLFile::XMLFile(Context* context) :
     Resource(context),
     document_(new pugi::xml_document())
@@ -89,11 +177,54 @@ bool XMLFile::BeginLoad(Deserializer& source)
     if (source.Read(buffer.Get(), dataSize) != dataSize)
         return false;
 
-    if (!document_->load_buffer(buffer.Get(), dataSize))
+    // Already cooked data can be loaded directly, for example from a package file
+    if (dataSize >= 4 && !strncmp(buffer.Get(), "UXMB", 4))
     {
-        URHO3D_LOGERROR("Could not parse XML data from " + source.GetName());
-        document_->reset();
-        return false;
+        MemoryBuffer binarySource(buffer.Get(), dataSize);
+        if (!LoadBinary(binarySource))
+        {
+            URHO3D_LOGERROR("Could not load cooked XML data from " + source.GetName());
+            document_->reset();
+            return false;
+        }
+    }
+    else
+    {
+        // Prefer an up to date cooked version of the file if one exists, as it does not need to be parsed
+        auto* cache = GetSubsystem<ResourceCache>();
+        const String& name = source.GetName();
+        bool cookedLoaded = false;
+        unsigned checksum = 0;
+        if (cache && !name.Empty() && !cache->GetCookedResourceDir().Empty())
+        {
+            for (unsigned i = 0; i < dataSize; ++i)
+                checksum = SDBMHash(checksum, (unsigned char)buffer[i]);
+
+            SharedPtr<File> cookedFile = cache->GetCookedFile(name, checksum);
+            if (cookedFile)
+            {
+                cookedLoaded = LoadBinary(*cookedFile);
+                if (!cookedLoaded)
+                    document_->reset();
+            }
+        }
+
+        if (!cookedLoaded)
+        {
+            if (!document_->load_buffer(buffer.Get(), dataSize))
+            {
+                URHO3D_LOGERROR("Could not parse XML data from " + source.GetName());
+                document_->reset();
+                return false;
+            }
+
+            if (cache && !name.Empty() && cache->GetAutoCookResources())
+            {
+                SharedPtr<File> cookedFile = cache->CreateCookedFile(name, checksum);
+                if (cookedFile && !SaveBinary(*cookedFile))
+                    URHO3D_LOGWARNING("Could not write cooked XML data for " + name);
+            }
+        }
     }
 
     XMLElement rootElem = GetRoot();
@@ -141,6 +272,57 @@ bool XMLFile::Save(Serializer& dest, const String& indentation) const
     return writer.success_;
 }
 
+bool XMLFile::SaveBinary(Serializer& dest) const
+{
+    // Index 0 is reserved for the empty string, which most node values and text node names are
+    HashMap<String, unsigned> indices;
+    Vector<String> strings;
+    indices[String::EMPTY] = 0;
+    strings.Push(String::EMPTY);
+    for (pugi::xml_node child = document_->first_child(); child; child = child.next_sibling())
+        CollectStrings(child, indices, strings);
+
+    VectorBuffer buffer;
+    buffer.WriteFileID("UXMB");
+    buffer.WriteVLE(strings.Size());
+    for (unsigned i = 0; i < strings.Size(); ++i)
+        buffer.WriteString(strings[i]);
+
+    unsigned numChildren = 0;
+    for (pugi::xml_node child = document_->first_child(); child; child = child.next_sibling())
+        ++numChildren;
+    buffer.WriteVLE(numChildren);
+    for (pugi::xml_node child = document_->first_child(); child; child = child.next_sibling())
+        WriteBinaryNode(buffer, child, indices);
+
+    return dest.Write(buffer.GetData(), buffer.GetSize()) == buffer.GetSize();
+}
+
+bool XMLFile::LoadBinary(Deserializer& source)
+{
+    if (source.ReadFileID() != "UXMB")
+        return false;
+
+    unsigned numStrings = source.ReadVLE();
+    Vector<String> strings;
+    strings.Reserve(numStrings);
+    for (unsigned i = 0; i < numStrings && !source.IsEof(); ++i)
+        strings.Push(source.ReadString());
+    if (strings.Size() != numStrings)
+        return false;
+
+    document_->reset();
+    pugi::xml_node root = *document_;
+    unsigned numChildren = source.ReadVLE();
+    for (unsigned i = 0; i < numChildren; ++i)
+    {
+        if (source.IsEof() || !ReadBinaryNode(source, root, strings))
+            return false;
+    }
+
+    return true;
+}
+
 XMLElement XMLFile::CreateRoot(const String& name)
 {
     document_->reset();
@@ -56,6 +56,8 @@ public:
     bool Save(Serializer& dest) const override;
     /// Save resource with user-defined indentation. Return true if successful.
     bool Save(Serializer& dest, const String& indentation) const;
+    /// Save resource in the cooked binary format, which can be loaded without parsing XML text. Return true if successful.
+    bool SaveBinary(Serializer& dest) const;
 
     /// Deserialize from a string. Return true if successful.
     bool FromString(const String& source);
@@ -79,6 +81,9 @@ public:
     void Patch(const XMLElement& patchElement);
 
 private:
+    /// Load the document from the cooked binary format. Return true if successful.
+    bool LoadBinary(Deserializer& source);
+
     /// Add an node in the Patch.
     void PatchAdd(const pugi::xml_node& patch, pugi::xpath_node& original) const;
     /// Replace a node or attribute in the Patch.
@@ -165,6 +165,12 @@ void Component::AddReplicationState(ComponentReplicationState* state)
     networkState_->replicationStates_.Push(state);
 }
 
+void Component::RemoveReplicationState(ComponentReplicationState* state)
+{
+    if (networkState_)
+        networkState_->replicationStates_.Remove(state);
+}
+
 void Component::PrepareNetworkUpdate()
 {
     if (!networkState_)
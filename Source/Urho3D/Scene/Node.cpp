@@ -45,6 +45,11 @@
 namespace Urho3D
 {
 
+/// Quantization step of replicated node positions.
+static const float NET_POSITION_PRECISION = 0.001f;
+/// Bits per smallest-three component of replicated node rotations.
+static const int NET_ROTATION_BITS = 12;
+
 Node::Node(Context* context) :
     Animatable(context),
     worldTransform_(Matrix3x4::IDENTITY),
@@ -86,9 +91,9 @@ void Node::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Scale", GetScale, SetScale, Vector3, Vector3::ONE, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Variables", VariantMap, vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     URHO3D_ACCESSOR_ATTRIBUTE("Network Position", GetNetPositionAttr, SetNetPositionAttr, Vector3, Vector3::ZERO,
-        AM_NET | AM_LATESTDATA | AM_NOEDIT);
-    URHO3D_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, PODVector<unsigned char>, Variant::emptyBuffer,
-        AM_NET | AM_LATESTDATA | AM_NOEDIT);
+        AM_NET | AM_LATESTDATA | AM_NOEDIT).SetMetadata(AttributeMetadata::P_NET_PRECISION, NET_POSITION_PRECISION);
+    URHO3D_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, Quaternion, Quaternion::IDENTITY,
+        AM_NET | AM_LATESTDATA | AM_NOEDIT).SetMetadata(AttributeMetadata::P_NET_ROTATION_BITS, NET_ROTATION_BITS);
     URHO3D_ACCESSOR_ATTRIBUTE("Network Parent Node", GetNetParentAttr, SetNetParentAttr, PODVector<unsigned char>, Variant::emptyBuffer,
         AM_NET | AM_NOEDIT);
 }
@@ -298,6 +303,12 @@ void Node::AddReplicationState(NodeReplicationState* state)
     networkState_->replicationStates_.Push(state);
 }
 
+void Node::RemoveReplicationState(NodeReplicationState* state)
+{
+    if (networkState_)
+        networkState_->replicationStates_.Remove(state);
+}
+
 bool Node::SaveXML(Serializer& dest, const String& indentation) const
 {
     SharedPtr<XMLFile> xml(new XMLFile(context_));
@@ -536,8 +547,11 @@ void Node::SetWorldScale(const Vector3& scale)
 
 void Node::SetWorldTransform(const Vector3& position, const Quaternion& rotation)
 {
-    SetWorldPosition(position);
-    SetWorldRotation(rotation);
+    // Convert both to parent space first, so that the node is marked dirty only once
+    if (parent_ == scene_ || !parent_)
+        SetTransform(position, rotation);
+    else
+        SetTransform(parent_->GetWorldTransform().Inverse() * position, parent_->GetWorldRotation().Inverse() * rotation);
 }
 
 void Node::SetWorldTransform(const Vector3& position, const Quaternion& rotation, float scale)
@@ -1455,14 +1469,13 @@ void Node::SetNetPositionAttr(const Vector3& value)
         SetPosition(value);
 }
 
-void Node::SetNetRotationAttr(const PODVector<unsigned char>& value)
+void Node::SetNetRotationAttr(const Quaternion& value)
 {
-    MemoryBuffer buf(value);
     auto* transform = GetComponent<SmoothedTransform>();
     if (transform)
-        transform->SetTargetRotation(buf.ReadPackedQuaternion());
+        transform->SetTargetRotation(value);
     else
-        SetRotation(buf.ReadPackedQuaternion());
+        SetRotation(value);
 }
 
 void Node::SetNetParentAttr(const PODVector<unsigned char>& value)
@@ -1507,11 +1520,9 @@ const Vector3& Node::GetNetPositionAttr() const
     return position_;
 }
 
-const PODVector<unsigned char>& Node::GetNetRotationAttr() const
+const Quaternion& Node::GetNetRotationAttr() const
 {
-    impl_->attrBuffer_.Clear();
-    impl_->attrBuffer_.WritePackedQuaternion(rotation_);
-    return impl_->attrBuffer_.GetBuffer();
+    return rotation_;
 }
 
 const PODVector<unsigned char>& Node::GetNetParentAttr() const
@@ -34,6 +34,8 @@ namespace Urho3D
 {
 
 static const unsigned MAX_NETWORK_ATTRIBUTES = 64;
+/// Number of received latest data states remembered per object for delta decoding. The sender only uses baselines within this window.
+static const unsigned NETWORK_BASELINE_HISTORY = 32;
 
 class Component;
 class Connection;
@@ -117,6 +119,15 @@ struct URHO3D_API DirtyBits
     unsigned char count_{};
 };
 
+/// Quantized latest data attribute values of an object, identified by the update sequence number they were sent with.
+struct URHO3D_API NetworkBaseline
+{
+    /// Update sequence number. 0 if not valid.
+    unsigned short sequence_{};
+    /// Quantized attribute components.
+    PODVector<int> values_;
+};
+
 /// Per-object attribute state for network replication, allocated on demand.
 struct URHO3D_API NetworkState
 {
@@ -132,6 +143,12 @@ struct URHO3D_API NetworkState
     VariantMap previousVars_;
     /// Bitmask for intercepting network messages. Used on the client only.
     unsigned long long interceptMask_{};
+    /// Recently received latest data states indexed by sequence number modulo history size. Used on the client only.
+    Vector<NetworkBaseline> receivedBaselines_;
+    /// Sequence number of the newest applied latest data update. Used on the client only.
+    unsigned short latestDataSequence_{};
+    /// Client controls timestamp the server had received when sending the newest applied latest data update. Used on the client only.
+    unsigned char latestDataTimeStamp_{};
 };
 
 /// Base class for per-user network replication states.
@@ -150,6 +167,11 @@ struct URHO3D_API ComponentReplicationState : public ReplicationState
     WeakPtr<Component> component_;
     /// Dirty attribute bits.
     DirtyBits dirtyAttributes_;
+    /// Newest latest data state acknowledged by the remote end.
+    NetworkBaseline latestDataBaseline_;
+    /// Oldest update sequence number whose acknowledged latest data may become the baseline. Set when the state is created
+    /// and when the remote end reports a missing baseline.
+    unsigned short minBaselineSequence_{};
 };
 
 /// Per-user node network replication state.
@@ -165,6 +187,11 @@ struct URHO3D_API NodeReplicationState : public ReplicationState
     HashSet<StringHash> dirtyVars_;
     /// Components by ID.
     HashMap<unsigned, ComponentReplicationState> componentStates_;
+    /// Newest latest data state acknowledged by the remote end.
+    NetworkBaseline latestDataBaseline_;
+    /// Oldest update sequence number whose acknowledged latest data may become the baseline. Set when the state is created
+    /// and when the remote end reports a missing baseline.
+    unsigned short minBaselineSequence_{};
     /// Interest management priority accumulator.
     float priorityAcc_{};
     /// Whether exists in the SceneState's dirty set.
@@ -54,6 +54,16 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+/// Initial server update interval estimate, matching the default network update rate.
+static const float DEFAULT_SNAPSHOT_INTERVAL = 1.0f / 30.0f;
+/// Filter factor for the server update interval estimate.
+static const float SNAPSHOT_INTERVAL_FILTER = 0.05f;
+/// Rate per second at which the interpolation playback clock converges to its target.
+static const float INTERPOLATION_CLOCK_RATE = 2.0f;
+/// Playback clock error in seconds beyond which the clock is reset instead of converged.
+static const float INTERPOLATION_CLOCK_SNAP = 1.0f;
+/// Sequence number difference beyond which the snapshot timeline is assumed to have restarted.
+static const int SNAPSHOT_SEQUENCE_RESET = 1024;
 
 Scene::Scene(Context* context) :
     Node(context),
@@ -67,6 +77,13 @@ Scene::Scene(Context* context) :
     elapsedTime_(0),
     smoothingConstant_(DEFAULT_SMOOTHING_CONSTANT),
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
+    interpolationDelay_(0.0f),
+    snapshotInterval_(DEFAULT_SNAPSHOT_INTERVAL),
+    networkClock_(0.0),
+    snapshotReceiveTime_(0.0),
+    latestSnapshotTick_(0.0),
+    interpolationTick_(0.0),
+    snapshotSequence_(0),
     updateEnabled_(true),
     asyncLoading_(false),
     threadedUpdate_(false)
@@ -102,6 +119,7 @@ void Scene::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Smoothing Constant", GetSmoothingConstant, SetSmoothingConstant, float, DEFAULT_SMOOTHING_CONSTANT,
         AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Snap Threshold", GetSnapThreshold, SetSnapThreshold, float, DEFAULT_SNAP_THRESHOLD, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Interpolation Delay", GetInterpolationDelay, SetInterpolationDelay, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Elapsed Time", GetElapsedTime, SetElapsedTime, float, 0.0f, AM_FILE);
     URHO3D_ATTRIBUTE("Next Replicated Node ID", unsigned, replicatedNodeID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Next Replicated Component ID", unsigned, replicatedComponentID_, FIRST_REPLICATED_ID, AM_FILE | AM_NOEDIT);
@@ -631,6 +649,7 @@ void Scene::Clear(bool clearReplicated, bool clearLocal)
     // Reset ID generators
     if (clearReplicated)
     {
+        ResetNetworkSnapshots();
         replicatedNodeID_ = FIRST_REPLICATED_ID;
         replicatedComponentID_ = FIRST_REPLICATED_ID;
     }
@@ -664,6 +683,39 @@ void Scene::SetSnapThreshold(float threshold)
     Node::MarkNetworkUpdate();
 }
 
+void Scene::SetInterpolationDelay(float delay)
+{
+    interpolationDelay_ = Max(delay, 0.0f);
+    Node::MarkNetworkUpdate();
+}
+
+double Scene::AddNetworkSnapshot(unsigned short sequence)
+{
+    int delta = (short)(sequence - snapshotSequence_);
+    if (!snapshotSequence_ || Abs(delta) > SNAPSHOT_SEQUENCE_RESET)
+    {
+        // First update, or the server connection has changed: start a new timeline
+        snapshotSequence_ = sequence;
+        snapshotReceiveTime_ = networkClock_;
+        latestSnapshotTick_ = 0.0;
+        interpolationTick_ = -interpolationDelay_ / snapshotInterval_;
+        return 0.0;
+    }
+
+    double tick = latestSnapshotTick_ + delta;
+    if (delta > 0)
+    {
+        // Estimate the server update interval from reception times. Jitter averages out over time
+        auto sample = (float)((networkClock_ - snapshotReceiveTime_) / delta);
+        snapshotInterval_ = Lerp(snapshotInterval_, Clamp(sample, M_EPSILON, INTERPOLATION_CLOCK_SNAP), SNAPSHOT_INTERVAL_FILTER);
+        snapshotSequence_ = sequence;
+        snapshotReceiveTime_ = networkClock_;
+        latestSnapshotTick_ = tick;
+    }
+
+    return tick;
+}
+
 void Scene::SetAsyncLoadingMs(int ms)
 {
     asyncLoadingMs_ = Max(ms, 1);
@@ -769,6 +821,9 @@ void Scene::Update(float timeStep)
 
     URHO3D_PROFILE(UpdateScene);
 
+    // The snapshot playback clock follows real time, as the server updates do
+    UpdateInterpolationClock(timeStep);
+
     timeStep *= timeScale_;
 
     using namespace SceneUpdate;
@@ -1185,6 +1240,32 @@ void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eve
     }
 }
 
+void Scene::UpdateInterpolationClock(float timeStep)
+{
+    networkClock_ += timeStep;
+    if (!snapshotSequence_ || interpolationDelay_ <= 0.0f)
+        return;
+
+    // Target the newest server update extrapolated to the present, minus the delay. Reception jitter is filtered by
+    // converging towards the target gradually, which slightly speeds up or slows down the playback
+    double target = latestSnapshotTick_ + ((networkClock_ - snapshotReceiveTime_) - interpolationDelay_) / snapshotInterval_;
+    interpolationTick_ += timeStep / snapshotInterval_;
+    double error = target - interpolationTick_;
+    if (Abs(error) * snapshotInterval_ > INTERPOLATION_CLOCK_SNAP)
+        interpolationTick_ = target;
+    else
+        interpolationTick_ += error * Min(timeStep * INTERPOLATION_CLOCK_RATE, 1.0f);
+}
+
+void Scene::ResetNetworkSnapshots()
+{
+    snapshotInterval_ = DEFAULT_SNAPSHOT_INTERVAL;
+    snapshotReceiveTime_ = 0.0;
+    latestSnapshotTick_ = 0.0;
+    interpolationTick_ = 0.0;
+    snapshotSequence_ = 0;
+}
+
 void Scene::UpdateAsyncLoading()
 {
     URHO3D_PROFILE(UpdateAsyncLoading);
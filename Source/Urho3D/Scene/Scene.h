@@ -152,6 +152,10 @@ public:
     void SetSmoothingConstant(float constant);
     /// Set network client motion smoothing snap threshold.
     void SetSnapThreshold(float threshold);
+    /// Set network client snapshot interpolation delay in seconds. When nonzero, smoothed transforms are played back this much behind the newest server update instead of exponential smoothing. Should cover at least two server update intervals plus network jitter. Default 0.
+    void SetInterpolationDelay(float delay);
+    /// Register a sequenced server update received on the client and return its time on the snapshot timeline in server update ticks. Called by SmoothedTransform.
+    double AddNetworkSnapshot(unsigned short sequence);
     /// Set maximum milliseconds per frame to spend on async scene loading.
     void SetAsyncLoadingMs(int ms);
     /// Add a required package file for networking. To be called on the server.
@@ -202,6 +206,15 @@ public:
     /// Return motion smoothing snap threshold.
     float GetSnapThreshold() const { return snapThreshold_; }
 
+    /// Return snapshot interpolation delay in seconds.
+    float GetInterpolationDelay() const { return interpolationDelay_; }
+
+    /// Return current snapshot interpolation playback time in server update ticks.
+    double GetInterpolationTick() const { return interpolationTick_; }
+
+    /// Return estimated server update interval in seconds.
+    float GetSnapshotInterval() const { return snapshotInterval_; }
+
     /// Return maximum milliseconds per frame to spend on async loading.
     int GetAsyncLoadingMs() const { return asyncLoadingMs_; }
 
@@ -265,6 +278,10 @@ private:
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
     void UpdateAsyncLoading();
+    /// Advance the snapshot interpolation playback clock.
+    void UpdateInterpolationClock(float timeStep);
+    /// Reset the snapshot timeline.
+    void ResetNetworkSnapshots();
     /// Finish asynchronous loading.
     void FinishAsyncLoading();
     /// Finish loading. Sets the scene filename and checksum.
@@ -328,6 +345,20 @@ private:
     float smoothingConstant_;
     /// Motion smoothing snap threshold.
     float snapThreshold_;
+    /// Snapshot interpolation delay.
+    float interpolationDelay_;
+    /// Estimated server update interval.
+    float snapshotInterval_;
+    /// Real time accumulator for snapshot reception times.
+    double networkClock_;
+    /// Reception time of the newest server update.
+    double snapshotReceiveTime_;
+    /// Snapshot timeline position of the newest server update.
+    double latestSnapshotTick_;
+    /// Snapshot interpolation playback position.
+    double interpolationTick_;
+    /// Sequence number of the newest server update, or zero if none received.
+    unsigned short snapshotSequence_;
     /// Update enabled flag.
     bool updateEnabled_;
     /// Asynchronous loading flag.
@@ -23,9 +23,12 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../IO/BitStream.h"
 #include "../IO/Deserializer.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
 #include "../IO/Serializer.h"
+#include "../IO/VectorBuffer.h"
 #include "../Resource/XMLElement.h"
 #include "../Resource/JSONValue.h"
 #include "../Scene/ReplicationState.h"
@@ -53,6 +56,263 @@ static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, con
     return netAttrIndex; // Could not remap
 }
 
+/// Variable-length group size for absolute quantized values.
+static const unsigned ABSOLUTE_GROUP_BITS = 7;
+/// Variable-length group size for quantized deltas.
+static const unsigned DELTA_GROUP_BITS = 4;
+/// Bits used for the distance from the update sequence number to its baseline.
+static const unsigned BASELINE_OFFSET_BITS = 5;
+/// Maximum number of quantized components per attribute.
+static const unsigned MAX_QUANTIZED_COMPONENTS = 4;
+/// Largest absolute quantized value, leaving headroom for deltas.
+static const float MAX_QUANTIZED_VALUE = (float)(M_MAX_INT >> 1);
+/// Range of the three smallest components of a unit quaternion is [-1/sqrt(2), 1/sqrt(2)].
+static const float SMALLEST_THREE_RANGE = 0.70710678f;
+
+/// Return network quantization step of an attribute, or 0 if not quantized.
+static float GetNetPrecision(const AttributeInfo& attr)
+{
+    return attr.metadata_.Empty() ? 0.0f : attr.GetMetadata(AttributeMetadata::P_NET_PRECISION).GetFloat();
+}
+
+/// Return bits per smallest-three component of a quaternion attribute, or 0 if not quantized.
+static unsigned GetNetRotationBits(const AttributeInfo& attr)
+{
+    int bits = attr.metadata_.Empty() ? 0 : attr.GetMetadata(AttributeMetadata::P_NET_ROTATION_BITS).GetInt();
+    return bits > 0 ? (unsigned)Clamp(bits, 2, 30) : 0;
+}
+
+/// Return number of quantized components of a network attribute, or 0 if it is sent as plain variant data.
+static unsigned GetNumQuantizedComponents(const AttributeInfo& attr)
+{
+    switch (attr.type_)
+    {
+    case VAR_FLOAT:
+        return GetNetPrecision(attr) > 0.0f ? 1 : 0;
+    case VAR_VECTOR2:
+        return GetNetPrecision(attr) > 0.0f ? 2 : 0;
+    case VAR_VECTOR3:
+        return GetNetPrecision(attr) > 0.0f ? 3 : 0;
+    case VAR_VECTOR4:
+        return GetNetPrecision(attr) > 0.0f ? 4 : 0;
+    case VAR_QUATERNION:
+        // Index of the omitted largest component, followed by the three smallest components
+        return GetNetRotationBits(attr) ? 4 : 0;
+    default:
+        return 0;
+    }
+}
+
+/// Quantize an attribute value for network replication.
+static void QuantizeNetworkAttribute(const AttributeInfo& attr, const Variant& value, unsigned numComponents, int* dest)
+{
+    if (attr.type_ == VAR_QUATERNION)
+    {
+        Quaternion rotation = value.GetQuaternion().Normalized();
+        const float* src = rotation.Data();
+        unsigned largest = 0;
+        for (unsigned i = 1; i < 4; ++i)
+        {
+            if (Abs(src[i]) > Abs(src[largest]))
+                largest = i;
+        }
+
+        // q and -q are the same rotation: flip so that the omitted component is positive
+        float sign = src[largest] < 0.0f ? -1.0f : 1.0f;
+        auto maxValue = (float)((1u << GetNetRotationBits(attr)) - 1);
+        dest[0] = largest;
+        for (unsigned i = 0, j = 1; i < 4; ++i)
+        {
+            if (i != largest)
+                dest[j++] = RoundToInt(Clamp((src[i] * sign / SMALLEST_THREE_RANGE + 1.0f) * 0.5f, 0.0f, 1.0f) * maxValue);
+        }
+    }
+    else
+    {
+        float src[MAX_QUANTIZED_COMPONENTS];
+        switch (attr.type_)
+        {
+        case VAR_FLOAT:
+            src[0] = value.GetFloat();
+            break;
+        case VAR_VECTOR2:
+            memcpy(src, value.GetVector2().Data(), 2 * sizeof(float));
+            break;
+        case VAR_VECTOR3:
+            memcpy(src, value.GetVector3().Data(), 3 * sizeof(float));
+            break;
+        default:
+            memcpy(src, value.GetVector4().Data(), 4 * sizeof(float));
+            break;
+        }
+
+        float invPrecision = 1.0f / GetNetPrecision(attr);
+        for (unsigned i = 0; i < numComponents; ++i)
+            dest[i] = RoundToInt(Clamp(src[i] * invPrecision, -MAX_QUANTIZED_VALUE, MAX_QUANTIZED_VALUE));
+    }
+}
+
+/// Reconstruct an attribute value from quantized network data.
+static Variant DequantizeNetworkAttribute(const AttributeInfo& attr, unsigned numComponents, const int* src)
+{
+    if (attr.type_ == VAR_QUATERNION)
+    {
+        float dest[4];
+        auto largest = (unsigned)src[0] & 3u;
+        float scale = 2.0f / (float)((1u << GetNetRotationBits(attr)) - 1);
+        float sumSquares = 0.0f;
+        for (unsigned i = 0, j = 1; i < 4; ++i)
+        {
+            if (i != largest)
+            {
+                dest[i] = ((float)src[j++] * scale - 1.0f) * SMALLEST_THREE_RANGE;
+                sumSquares += dest[i] * dest[i];
+            }
+        }
+        dest[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+        return Quaternion(dest).Normalized();
+    }
+    else
+    {
+        float precision = GetNetPrecision(attr);
+        float dest[MAX_QUANTIZED_COMPONENTS];
+        for (unsigned i = 0; i < numComponents; ++i)
+            dest[i] = (float)src[i] * precision;
+
+        switch (attr.type_)
+        {
+        case VAR_FLOAT:
+            return dest[0];
+        case VAR_VECTOR2:
+            return Vector2(dest);
+        case VAR_VECTOR3:
+            return Vector3(dest);
+        default:
+            return Vector4(dest);
+        }
+    }
+}
+
+/// Write a network attribute. Quantized attributes are delta encoded if a baseline is given, and their quantized components are written to quantized.
+static void WriteNetworkAttribute(BitWriter& dest, VectorBuffer& variantBuffer, const AttributeInfo& attr, const Variant& value,
+    const int* baseline, int* quantized)
+{
+    unsigned numComponents = GetNumQuantizedComponents(attr);
+    if (!numComponents)
+    {
+        variantBuffer.Clear();
+        variantBuffer.WriteVariantData(value);
+        dest.WriteBytes(variantBuffer.GetData(), variantBuffer.GetSize());
+        return;
+    }
+
+    QuantizeNetworkAttribute(attr, value, numComponents, quantized);
+
+    unsigned first = 0;
+    if (baseline)
+    {
+        bool changed = memcmp(quantized, baseline, numComponents * sizeof(int)) != 0;
+        dest.WriteBool(changed);
+        if (!changed)
+            return;
+
+        // For rotations the deltas are only meaningful if the omitted component stays the same
+        if (attr.type_ == VAR_QUATERNION)
+        {
+            bool sameLargest = quantized[0] == baseline[0];
+            dest.WriteBool(sameLargest);
+            if (!sameLargest)
+                baseline = nullptr;
+            else
+                first = 1;
+        }
+    }
+
+    if (baseline)
+    {
+        for (unsigned i = first; i < numComponents; ++i)
+            dest.WriteVarInt(quantized[i] - baseline[i], DELTA_GROUP_BITS);
+    }
+    else if (attr.type_ == VAR_QUATERNION)
+    {
+        unsigned bits = GetNetRotationBits(attr);
+        dest.WriteBits((unsigned)quantized[0], 2);
+        for (unsigned i = 1; i < 4; ++i)
+            dest.WriteBits((unsigned)quantized[i], bits);
+    }
+    else
+    {
+        for (unsigned i = 0; i < numComponents; ++i)
+            dest.WriteVarInt(quantized[i], ABSOLUTE_GROUP_BITS);
+    }
+}
+
+/// Read a network attribute written by WriteNetworkAttribute. The quantized components are written to quantized.
+static Variant ReadNetworkAttribute(BitReader& source, const AttributeInfo& attr, const int* baseline, int* quantized)
+{
+    unsigned numComponents = GetNumQuantizedComponents(attr);
+    if (!numComponents)
+    {
+        source.AlignToByte();
+        MemoryBuffer buffer(source.GetCurrentData(), source.GetRemainingBytes());
+        Variant value = buffer.ReadVariant(attr.type_);
+        source.SkipBytes(buffer.GetPosition());
+        return value;
+    }
+
+    unsigned first = 0;
+    if (baseline)
+    {
+        memcpy(quantized, baseline, numComponents * sizeof(int));
+        if (!source.ReadBool())
+            return DequantizeNetworkAttribute(attr, numComponents, quantized);
+
+        if (attr.type_ == VAR_QUATERNION)
+        {
+            if (!source.ReadBool())
+                baseline = nullptr;
+            else
+                first = 1;
+        }
+    }
+
+    if (baseline)
+    {
+        for (unsigned i = first; i < numComponents; ++i)
+            quantized[i] = baseline[i] + source.ReadVarInt(DELTA_GROUP_BITS);
+    }
+    else if (attr.type_ == VAR_QUATERNION)
+    {
+        unsigned bits = GetNetRotationBits(attr);
+        quantized[0] = source.ReadBits(2);
+        for (unsigned i = 1; i < 4; ++i)
+            quantized[i] = source.ReadBits(bits);
+    }
+    else
+    {
+        for (unsigned i = 0; i < numComponents; ++i)
+            quantized[i] = source.ReadVarInt(ABSOLUTE_GROUP_BITS);
+    }
+
+    return DequantizeNetworkAttribute(attr, numComponents, quantized);
+}
+
+/// Read a length-prefixed bit-packed network data section.
+static void ReadNetworkSection(Deserializer& source, PODVector<unsigned char>& dest)
+{
+    unsigned size = source.ReadVLE();
+    dest.Resize(Min(size, source.GetSize() - source.GetPosition()));
+    if (dest.Size())
+        source.Read(&dest[0], dest.Size());
+}
+
+/// Write a bit-packed network data section with a length prefix.
+static void WriteNetworkSection(Serializer& dest, const BitWriter& section)
+{
+    dest.WriteVLE(section.GetSize());
+    dest.Write(section.GetData(), section.GetSize());
+}
+
 Serializable::Serializable(Context* context) :
     Object(context),
     setInstanceDefault_(false),
@@ -757,15 +1017,7 @@ void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeS
             attributeBits.Set(i);
     }
 
-    // First write the change bitfield, then attribute data for non-default attributes
-    dest.WriteUByte(timeStamp);
-    dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
-
-    for (unsigned i = 0; i < numAttributes; ++i)
-    {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
-    }
+    WriteDeltaUpdate(dest, attributeBits, timeStamp);
 }
 
 void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp)
@@ -781,20 +1033,27 @@ void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attribute
         return;
 
     unsigned numAttributes = attributes->Size();
+    BitWriter section;
+    VectorBuffer variantBuffer;
+    int quantized[MAX_QUANTIZED_COMPONENTS];
 
-    // First write the change bitfield, then attribute data for changed attributes
-    // Note: the attribute bits should not contain LATESTDATA attributes
-    dest.WriteUByte(timeStamp);
-    dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
+    // First write the change bitfield, then attribute data for changed attributes. Quantized attributes are written as
+    // absolute values, as the update may be applied on top of any latest data baseline
+    section.WriteBits(timeStamp, 8);
+    for (unsigned i = 0; i < numAttributes; ++i)
+        section.WriteBool(attributeBits.IsSet(i));
 
     for (unsigned i = 0; i < numAttributes; ++i)
     {
         if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+            WriteNetworkAttribute(section, variantBuffer, attributes->At(i), networkState_->currentValues_[i], nullptr, quantized);
     }
+
+    WriteNetworkSection(dest, section);
 }
 
-void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp)
+void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp, unsigned short sequence,
+    const NetworkBaseline* baseline, NetworkBaseline* sent)
 {
     if (!networkState_)
     {
@@ -807,14 +1066,48 @@ void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeSta
         return;
 
     unsigned numAttributes = attributes->Size();
+    BitWriter section;
+    VectorBuffer variantBuffer;
+    int quantized[MAX_QUANTIZED_COMPONENTS];
+
+    // A baseline is only usable if it has been sent with a sequence number and is within the receiver's history.
+    // It is identified by its distance to the current sequence number, zero meaning absolute values
+    unsigned baselineOffset = baseline && baseline->sequence_ ? (unsigned short)(sequence - baseline->sequence_) : 0;
+    if (!sequence || baselineOffset >= NETWORK_BASELINE_HISTORY)
+        baselineOffset = 0;
+    if (!baselineOffset)
+        baseline = nullptr;
+    if (sent)
+    {
+        sent->sequence_ = sequence;
+        sent->values_.Clear();
+    }
 
-    dest.WriteUByte(timeStamp);
+    section.WriteBits(timeStamp, 8);
+    section.WriteBits(sequence, 16);
+    section.WriteBits(baselineOffset, BASELINE_OFFSET_BITS);
 
+    unsigned offset = 0;
     for (unsigned i = 0; i < numAttributes; ++i)
     {
-        if (attributes->At(i).mode_ & AM_LATESTDATA)
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_LATESTDATA))
+            continue;
+
+        unsigned numComponents = GetNumQuantizedComponents(attr);
+        const int* baselineValues = baseline && offset + numComponents <= baseline->values_.Size() ?
+            &baseline->values_[offset] : nullptr;
+        WriteNetworkAttribute(section, variantBuffer, attr, networkState_->currentValues_[i], baselineValues, quantized);
+
+        if (sent)
+        {
+            for (unsigned j = 0; j < numComponents; ++j)
+                sent->values_.Push(quantized[j]);
+        }
+        offset += numComponents;
     }
+
+    WriteNetworkSection(dest, section);
 }
 
 bool Serializable::ReadDeltaUpdate(Deserializer& source)
@@ -823,22 +1116,35 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
     if (!attributes)
         return false;
 
+    PODVector<unsigned char> data;
+    ReadNetworkSection(source, data);
+    BitReader section(data.Begin().ptr_, data.Size());
+
     unsigned numAttributes = attributes->Size();
     DirtyBits attributeBits;
     bool changed = false;
+    int quantized[MAX_QUANTIZED_COMPONENTS];
 
     unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
-    unsigned char timeStamp = source.ReadUByte();
-    source.Read(attributeBits.data_, (numAttributes + 7) >> 3u);
+    auto timeStamp = (unsigned char)section.ReadBits(8);
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (section.ReadBool())
+            attributeBits.Set(i);
+    }
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    for (unsigned i = 0; i < numAttributes && !section.IsOverflow(); ++i)
     {
         if (attributeBits.IsSet(i))
         {
             const AttributeInfo& attr = attributes->At(i);
+            Variant value = ReadNetworkAttribute(section, attr, nullptr, quantized);
+            if (section.IsOverflow())
+                break;
+
             if (!(interceptMask & (1ULL << i)))
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
+                OnSetAttribute(attr, value);
                 changed = true;
             }
             else
@@ -850,7 +1156,7 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
                 eventData[P_TIMESTAMP] = (unsigned)timeStamp;
                 eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
                 eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
+                eventData[P_VALUE] = value;
                 SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
             }
         }
@@ -859,40 +1165,126 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
     return changed;
 }
 
-bool Serializable::ReadLatestDataUpdate(Deserializer& source)
+bool Serializable::ReadLatestDataUpdate(Deserializer& source, unsigned short* missingSequence)
 {
     const Vector<AttributeInfo>* attributes = GetNetworkAttributes();
     if (!attributes)
         return false;
 
+    PODVector<unsigned char> data;
+    ReadNetworkSection(source, data);
+    BitReader section(data.Begin().ptr_, data.Size());
+
     unsigned numAttributes = attributes->Size();
     bool changed = false;
+    int quantized[MAX_QUANTIZED_COMPONENTS];
 
-    unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
-    unsigned char timeStamp = source.ReadUByte();
+    auto timeStamp = (unsigned char)section.ReadBits(8);
+    auto sequence = (unsigned short)section.ReadBits(16);
+    unsigned baselineOffset = section.ReadBits(BASELINE_OFFSET_BITS);
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    // Sequenced updates are remembered as future delta baselines
+    NetworkBaseline received;
+    const NetworkBaseline* baseline = nullptr;
+    if (sequence)
     {
-        const AttributeInfo& attr = attributes->At(i);
-        if (attr.mode_ & AM_LATESTDATA)
+        AllocateNetworkState();
+        if (networkState_->receivedBaselines_.Size() != NETWORK_BASELINE_HISTORY)
+            networkState_->receivedBaselines_.Resize(NETWORK_BASELINE_HISTORY);
+
+        if (baselineOffset)
         {
-            if (!(interceptMask & (1ULL << i)))
+            auto baselineSequence = (unsigned short)(sequence - baselineOffset);
+            baseline = &networkState_->receivedBaselines_[baselineSequence % NETWORK_BASELINE_HISTORY];
+            if (baseline->sequence_ != baselineSequence)
             {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
-                changed = true;
+                // The baseline of a resent update may have been replaced in the history by a newer state. Such an update
+                // would not be applied anyway
+                unsigned short newest = networkState_->latestDataSequence_;
+                if (newest && (short)(sequence - newest) < 0)
+                    return false;
+
+                // The caller may recover by requesting absolute values, otherwise the attributes stay out of date
+                if (missingSequence)
+                    *missingSequence = sequence;
+                else
+                {
+                    URHO3D_LOGWARNING("Missing baseline " + String(baselineSequence) + " for latest data update " +
+                        String(sequence));
+                }
+                return false;
             }
-            else
-            {
-                using namespace InterceptNetworkUpdate;
+        }
+    }
 
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_SERIALIZABLE] = this;
-                eventData[P_TIMESTAMP] = (unsigned)timeStamp;
-                eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
-                eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
-                SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
-            }
+    // Decode all attributes first, so that an outdated update can still be stored as a baseline without applying it
+    Vector<Variant> values;
+    PODVector<unsigned> indices;
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_LATESTDATA))
+            continue;
+
+        unsigned numComponents = GetNumQuantizedComponents(attr);
+        unsigned offset = received.values_.Size();
+        const int* baselineValues = baseline && offset + numComponents <= baseline->values_.Size() ?
+            &baseline->values_[offset] : nullptr;
+        Variant value = ReadNetworkAttribute(section, attr, baselineValues, quantized);
+        if (section.IsOverflow())
+            break;
+
+        for (unsigned j = 0; j < numComponents; ++j)
+            received.values_.Push(quantized[j]);
+        values.Push(value);
+        indices.Push(i);
+    }
+
+    if (section.IsOverflow())
+    {
+        URHO3D_LOGWARNING("Truncated latest data update");
+        return false;
+    }
+
+    if (sequence)
+    {
+        // A resent update may arrive after newer ones: do not let it overwrite a newer baseline sharing the history slot
+        NetworkBaseline& slot = networkState_->receivedBaselines_[sequence % NETWORK_BASELINE_HISTORY];
+        if (!slot.sequence_ || (short)(sequence - slot.sequence_) > 0)
+        {
+            received.sequence_ = sequence;
+            slot = received;
+        }
+
+        // Latest data is sent unordered: skip updates older than the newest applied one
+        unsigned short newest = networkState_->latestDataSequence_;
+        if (newest && (short)(sequence - newest) < 0)
+            return false;
+        networkState_->latestDataSequence_ = sequence;
+        networkState_->latestDataTimeStamp_ = timeStamp;
+    }
+
+    unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
+    for (unsigned k = 0; k < values.Size(); ++k)
+    {
+        unsigned i = indices[k];
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(interceptMask & (1ULL << i)))
+        {
+            OnSetAttribute(attr, values[k]);
+            changed = true;
+        }
+        else
+        {
+            using namespace InterceptNetworkUpdate;
+
+            VariantMap& eventData = GetEventDataMap();
+            eventData[P_SERIALIZABLE] = this;
+            eventData[P_TIMESTAMP] = (unsigned)timeStamp;
+            eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
+            eventData[P_NAME] = attr.name_;
+            eventData[P_VALUE] = values[k];
+            SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
         }
     }
 
@@ -37,6 +37,7 @@ class XMLElement;
 class JSONValue;
 
 struct DirtyBits;
+struct NetworkBaseline;
 struct NetworkState;
 struct ReplicationState;
 
@@ -101,12 +102,13 @@ public:
     void WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeStamp);
     /// Write a delta network update according to dirty attribute bits.
     void WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp);
-    /// Write a latest data network update.
-    void WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp);
+    /// Write a latest data network update. Quantized attributes are delta encoded against the baseline if given, and the quantized values are stored to sent for use as a future baseline. A zero sequence number disables delta encoding.
+    void WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp, unsigned short sequence = 0,
+        const NetworkBaseline* baseline = nullptr, NetworkBaseline* sent = nullptr);
     /// Read and apply a network delta update. Return true if attributes were changed.
     bool ReadDeltaUpdate(Deserializer& source);
-    /// Read and apply a network latest data update. Return true if attributes were changed.
-    bool ReadLatestDataUpdate(Deserializer& source);
+    /// Read and apply a network latest data update. Return true if attributes were changed. If the update can not be decoded because its delta baseline has not been received, its sequence number is stored to missingSequence.
+    bool ReadLatestDataUpdate(Deserializer& source, unsigned short* missingSequence = nullptr);
 
     /// Return attribute value by index. Return empty if illegal index.
     Variant GetAttribute(unsigned index) const;
@@ -224,6 +226,10 @@ namespace AttributeMetadata
 {
     /// Names of vector struct elements. StringVector.
     static const StringHash P_VECTOR_STRUCT_ELEMENTS("VectorStructElements");
+    /// Quantization step for network replication of Float, Vector2, Vector3 and Vector4 attributes. Float.
+    static const StringHash P_NET_PRECISION("NetPrecision");
+    /// Bits per component for smallest-three network replication of Quaternion attributes. Int.
+    static const StringHash P_NET_ROTATION_BITS("NetRotationBits");
 }
 
 // The following macros need to be used within a class member function such as ClassName::RegisterObject().
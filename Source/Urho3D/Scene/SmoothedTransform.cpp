@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 #include "../Scene/SmoothedTransform.h"
@@ -32,12 +33,19 @@
 namespace Urho3D
 {
 
+/// Maximum number of buffered snapshots.
+static const unsigned MAX_SNAPSHOTS = 32;
+/// Maximum time in seconds to interpolate between two snapshots. Unchanged transforms are not sent, so a longer gap means the node was at rest before the later snapshot.
+static const float MAX_INTERPOLATION_SPAN = 0.25f;
+
 SmoothedTransform::SmoothedTransform(Context* context) :
     Component(context),
     targetPosition_(Vector3::ZERO),
     targetRotation_(Quaternion::IDENTITY),
     smoothingMask_(SMOOTH_NONE),
-    subscribed_(false)
+    subscribed_(false),
+    predicted_(false),
+    reconcilePending_(false)
 {
 }
 
@@ -50,7 +58,9 @@ void SmoothedTransform::RegisterObject(Context* context)
 
 void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
 {
-    if (smoothingMask_ && node_)
+    if (smoothingMask_ && node_ && !snapshots_.Empty())
+        UpdateInterpolation(constant >= 1.0f, squaredSnapThreshold);
+    else if (smoothingMask_ && node_)
     {
         Vector3 position = node_->GetPosition();
         Quaternion rotation = node_->GetRotation();
@@ -99,13 +109,16 @@ void SmoothedTransform::Update(float constant, float squaredSnapThreshold)
 void SmoothedTransform::SetTargetPosition(const Vector3& position)
 {
     targetPosition_ = position;
-    smoothingMask_ |= SMOOTH_POSITION;
-
-    // Subscribe to smoothing update if not yet subscribed
-    if (!subscribed_)
+    if (OnTargetChanged())
     {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
+        smoothingMask_ |= SMOOTH_POSITION;
+
+        // Subscribe to smoothing update if not yet subscribed
+        if (!subscribed_)
+        {
+            SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+            subscribed_ = true;
+        }
     }
 
     SendEvent(E_TARGETPOSITION);
@@ -114,12 +127,15 @@ void SmoothedTransform::SetTargetPosition(const Vector3& position)
 void SmoothedTransform::SetTargetRotation(const Quaternion& rotation)
 {
     targetRotation_ = rotation;
-    smoothingMask_ |= SMOOTH_ROTATION;
-
-    if (!subscribed_)
+    if (OnTargetChanged())
     {
-        SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
-        subscribed_ = true;
+        smoothingMask_ |= SMOOTH_ROTATION;
+
+        if (!subscribed_)
+        {
+            SubscribeToEvent(GetScene(), E_UPDATESMOOTHING, URHO3D_HANDLER(SmoothedTransform, HandleUpdateSmoothing));
+            subscribed_ = true;
+        }
     }
 
     SendEvent(E_TARGETROTATION);
@@ -141,6 +157,21 @@ void SmoothedTransform::SetTargetWorldRotation(const Quaternion& rotation)
         SetTargetRotation(rotation);
 }
 
+void SmoothedTransform::SetPredicted(bool enable)
+{
+    predicted_ = enable;
+    reconcilePending_ = false;
+    snapshots_.Clear();
+    smoothingMask_ = SMOOTH_NONE;
+}
+
+void SmoothedTransform::ApplyTarget()
+{
+    if (node_)
+        node_->SetTransform(targetPosition_, targetRotation_);
+    reconcilePending_ = false;
+}
+
 Vector3 SmoothedTransform::GetTargetWorldPosition() const
 {
     if (node_ && node_->GetParent())
@@ -167,6 +198,95 @@ void SmoothedTransform::OnNodeSet(Node* node)
     }
 }
 
+bool SmoothedTransform::OnTargetChanged()
+{
+    if (predicted_)
+    {
+        reconcilePending_ = true;
+        return false;
+    }
+
+    // Targets received from sequenced latest data updates are buffered for interpolation, if enabled
+    Scene* scene = GetScene();
+    NetworkState* networkState = node_ ? node_->GetNetworkState() : nullptr;
+    if (!scene || scene->GetInterpolationDelay() <= 0.0f || !networkState || !networkState->latestDataSequence_)
+    {
+        snapshots_.Clear();
+        return true;
+    }
+
+    double tick = scene->AddNetworkSnapshot(networkState->latestDataSequence_);
+    // If the timeline has restarted, discard the old snapshots
+    if (!snapshots_.Empty() && tick < snapshots_.Back().tick_)
+        snapshots_.Clear();
+    // Position and rotation of the same update share the snapshot
+    if (!snapshots_.Empty() && tick == snapshots_.Back().tick_)
+    {
+        snapshots_.Back().position_ = targetPosition_;
+        snapshots_.Back().rotation_ = targetRotation_;
+        return true;
+    }
+
+    // Hold the previous transform until shortly before the new snapshot. Start from the current transform if none
+    TransformSnapshot hold;
+    if (snapshots_.Empty())
+    {
+        hold.tick_ = -M_INFINITY;
+        hold.position_ = node_->GetPosition();
+        hold.rotation_ = node_->GetRotation();
+    }
+    else
+        hold = snapshots_.Back();
+    double maxSpan = Max(MAX_INTERPOLATION_SPAN / scene->GetSnapshotInterval(), 1.0f);
+    if (tick - hold.tick_ > maxSpan)
+    {
+        hold.tick_ = tick - maxSpan;
+        snapshots_.Push(hold);
+    }
+
+    TransformSnapshot snapshot;
+    snapshot.tick_ = tick;
+    snapshot.position_ = targetPosition_;
+    snapshot.rotation_ = targetRotation_;
+    snapshots_.Push(snapshot);
+    if (snapshots_.Size() > MAX_SNAPSHOTS)
+        snapshots_.Erase(0, snapshots_.Size() - MAX_SNAPSHOTS);
+
+    return true;
+}
+
+void SmoothedTransform::UpdateInterpolation(bool snap, float squaredSnapThreshold)
+{
+    Scene* scene = GetScene();
+    if (snap || !scene)
+        snapshots_.Erase(0, snapshots_.Size() - 1);
+
+    // Discard snapshots the playback has passed, keeping the one preceding the playback position
+    double tick = scene ? scene->GetInterpolationTick() : 0.0;
+    while (snapshots_.Size() > 1 && snapshots_[1].tick_ <= tick)
+        snapshots_.Erase(0);
+
+    const TransformSnapshot& from = snapshots_.Front();
+    if (snapshots_.Size() == 1)
+    {
+        // Reached the newest snapshot: stop until a new one is received
+        node_->SetTransform(from.position_, from.rotation_);
+        smoothingMask_ = SMOOTH_NONE;
+        return;
+    }
+
+    // Do not interpolate across a teleport
+    const TransformSnapshot& to = snapshots_[1];
+    if ((to.position_ - from.position_).LengthSquared() > squaredSnapThreshold)
+    {
+        node_->SetTransform(from.position_, from.rotation_);
+        return;
+    }
+
+    float t = Clamp((float)((tick - from.tick_) / (to.tick_ - from.tick_)), 0.0f, 1.0f);
+    node_->SetTransform(from.position_.Lerp(to.position_, t), from.rotation_.Slerp(to.rotation_, t));
+}
+
 void SmoothedTransform::HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData)
 {
     using namespace UpdateSmoothing;
@@ -38,7 +38,18 @@ enum SmoothingType : unsigned
 };
 URHO3D_FLAGSET(SmoothingType, SmoothingTypeFlags);
 
-/// Transform smoothing component for network updates.
+/// Received transform at a point of the snapshot timeline.
+struct TransformSnapshot
+{
+    /// Snapshot timeline position in server update ticks.
+    double tick_;
+    /// Position in parent space.
+    Vector3 position_;
+    /// Rotation in parent space.
+    Quaternion rotation_;
+};
+
+/// Transform smoothing component for network updates. Uses exponential smoothing towards the latest target, or snapshot interpolation if the scene has an interpolation delay. A predicted transform is instead moved by the client and reconciled with the server state.
 class URHO3D_API SmoothedTransform : public Component
 {
     URHO3D_OBJECT(SmoothedTransform, Component);
@@ -61,6 +72,10 @@ public:
     void SetTargetWorldPosition(const Vector3& position);
     /// Set target rotation in world space.
     void SetTargetWorldRotation(const Quaternion& rotation);
+    /// Set whether the node is predicted by the client. A predicted node is not moved towards the received targets; instead Connection resets it to them and replays the unacknowledged controls.
+    void SetPredicted(bool enable);
+    /// Move the node to the target transform and clear the pending reconciliation. Called by Connection.
+    void ApplyTarget();
 
     /// Return target position in parent space.
     const Vector3& GetTargetPosition() const { return targetPosition_; }
@@ -76,6 +91,15 @@ public:
     /// Return whether smoothing is in progress.
     bool IsInProgress() const { return smoothingMask_ != SMOOTH_NONE; }
 
+    /// Return whether the node is predicted by the client.
+    bool IsPredicted() const { return predicted_; }
+
+    /// Return whether a target was received for a predicted node since the last reconciliation.
+    bool IsReconcilePending() const { return reconcilePending_; }
+
+    /// Return number of buffered interpolation snapshots.
+    unsigned GetNumSnapshots() const { return snapshots_.Size(); }
+
 protected:
     /// Handle scene node being assigned at creation.
     void OnNodeSet(Node* node) override;
@@ -83,15 +107,25 @@ protected:
 private:
     /// Handle smoothing update event.
     void HandleUpdateSmoothing(StringHash eventType, VariantMap& eventData);
+    /// Handle a changed target. Return true if smoothing should start.
+    bool OnTargetChanged();
+    /// Play back buffered snapshots.
+    void UpdateInterpolation(bool snap, float squaredSnapThreshold);
 
     /// Target position.
     Vector3 targetPosition_;
     /// Target rotation.
     Quaternion targetRotation_;
+    /// Buffered snapshots for interpolation, oldest first.
+    Vector<TransformSnapshot> snapshots_;
     /// Active smoothing operations bitmask.
     SmoothingTypeFlags smoothingMask_;
     /// Subscribed to smoothing update event flag.
     bool subscribed_;
+    /// Client-side prediction flag.
+    bool predicted_;
+    /// Target received for a predicted node flag.
+    bool reconcilePending_;
 };
 
 }
@@ -159,21 +159,25 @@ void Button::OnKey(Key key, MouseButtonFlags buttons, QualifierFlags qualifiers)
 void Button::SetPressedOffset(const IntVector2& offset)
 {
     pressedOffset_ = offset;
+    MarkBatchesDirty();
 }
 
 void Button::SetPressedOffset(int x, int y)
 {
     pressedOffset_ = IntVector2(x, y);
+    MarkBatchesDirty();
 }
 
 void Button::SetDisabledOffset(const IntVector2& offset)
 {
     disabledOffset_ = offset;
+    MarkBatchesDirty();
 }
 
 void Button::SetDisabledOffset(int x, int y)
 {
     disabledOffset_ = IntVector2(x, y);
+    MarkBatchesDirty();
 }
 
 void Button::SetPressedChildOffset(const IntVector2& offset)
@@ -206,6 +210,7 @@ void Button::SetPressed(bool enable)
 {
     pressed_ = enable;
     SetChildOffset(pressed_ ? pressedChildOffset_ : IntVector2::ZERO);
+    MarkBatchesDirty();
 }
 
 }
@@ -88,6 +88,7 @@ void CheckBox::SetChecked(bool enable)
     if (enable != checked_)
     {
         checked_ = enable;
+        MarkBatchesDirty();
 
         using namespace Toggled;
 
@@ -101,11 +102,13 @@ void CheckBox::SetChecked(bool enable)
 void CheckBox::SetCheckedOffset(const IntVector2& offset)
 {
     checkedOffset_ = offset;
+    MarkBatchesDirty();
 }
 
 void CheckBox::SetCheckedOffset(int x, int y)
 {
     checkedOffset_ = IntVector2(x, y);
+    MarkBatchesDirty();
 }
 
 }
@@ -186,6 +186,7 @@ void Cursor::SetShape(const String& shape)
     texture_ = info.texture_;
     imageRect_ = info.imageRect_;
     SetSize(info.imageRect_.Size());
+    MarkBatchesDirty();
 
     // To avoid flicker, the UI subsystem will apply the OS shape once per frame. Exception: if we are using the
     // busy shape, set it immediately as we may block before that
@@ -46,6 +46,8 @@ public:
     void ApplyAttributes() override;
     /// Return UI rendering batches.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the cached rendering batches can be reused. Never, as the selected item is rendered from another element.
+    bool CanCacheBatches() const override { return false; }
     /// React to the popup being shown.
     void OnShowPopup() override;
     /// React to the popup being hidden.
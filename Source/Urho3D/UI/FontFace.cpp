@@ -34,6 +34,20 @@
 namespace Urho3D
 {
 
+/// Maximum number of cached text layouts per font face.
+static const unsigned MAX_TEXT_LAYOUTS = 256;
+/// Maximum length of a text to cache the layout of.
+static const unsigned MAX_TEXT_LAYOUT_LENGTH = 1024;
+
+static unsigned GetTextLayoutKey(const PODVector<unsigned>& text, int maxWidth)
+{
+    // FNV-1a
+    unsigned hash = 2166136261u ^ (unsigned)maxWidth;
+    for (unsigned i = 0; i < text.Size(); ++i)
+        hash = (hash ^ text[i]) * 16777619u;
+    return hash;
+}
+
 FontFace::FontFace(Font* font) :
     font_(font)
 {
@@ -84,6 +98,48 @@ float FontFace::GetKerning(unsigned c, unsigned d) const
     return 0;
 }
 
+const TextLayout* FontFace::GetTextLayout(const PODVector<unsigned>& text, int maxWidth)
+{
+    if (textLayouts_.Empty() || text.Size() > MAX_TEXT_LAYOUT_LENGTH)
+        return nullptr;
+
+    HashMap<unsigned, TextLayout>::Iterator i = textLayouts_.Find(GetTextLayoutKey(text, maxWidth));
+    if (i == textLayouts_.End())
+        return nullptr;
+
+    // Verify, as different texts may share the key
+    TextLayout& layout = i->second_;
+    if (layout.maxWidth_ != maxWidth || layout.text_ != text)
+        return nullptr;
+
+    layout.lastUse_ = ++textLayoutUseCounter_;
+    return &layout;
+}
+
+TextLayout* FontFace::AddTextLayout(const PODVector<unsigned>& text, int maxWidth)
+{
+    if (text.Size() > MAX_TEXT_LAYOUT_LENGTH)
+        return nullptr;
+
+    unsigned key = GetTextLayoutKey(text, maxWidth);
+    if (textLayouts_.Size() >= MAX_TEXT_LAYOUTS && !textLayouts_.Contains(key))
+    {
+        HashMap<unsigned, TextLayout>::Iterator oldest = textLayouts_.Begin();
+        for (HashMap<unsigned, TextLayout>::Iterator i = textLayouts_.Begin(); i != textLayouts_.End(); ++i)
+        {
+            if (i->second_.lastUse_ < oldest->second_.lastUse_)
+                oldest = i;
+        }
+        textLayouts_.Erase(oldest);
+    }
+
+    TextLayout& layout = textLayouts_[key];
+    layout.text_ = text;
+    layout.maxWidth_ = maxWidth;
+    layout.lastUse_ = ++textLayoutUseCounter_;
+    return &layout;
+}
+
 bool FontFace::IsDataLost() const
 {
     for (unsigned i = 0; i < textures_.Size(); ++i)
@@ -60,6 +60,42 @@ struct URHO3D_API FontGlyph
     bool used_{};
 };
 
+/// Word wrapping state at the start of a row break. Used for resuming the word wrapping when text is appended.
+struct TextWrapState
+{
+    /// Index of the character being wrapped.
+    unsigned char_{};
+    /// Length of the printed text.
+    unsigned print_{};
+    /// Index of the next possible break.
+    unsigned nextBreak_{};
+    /// Index where the row started.
+    unsigned lineStart_{};
+    /// Row width so far.
+    int rowWidth_{};
+};
+
+/// Word wrapping and row widths of a text, cached by the font face for reuse by %Text elements.
+struct TextLayout
+{
+    /// Text as Unicode characters.
+    PODVector<unsigned> text_;
+    /// Maximum row width, M_MAX_INT when not wrapping.
+    int maxWidth_{};
+    /// Text modified into printed form.
+    PODVector<unsigned> printText_;
+    /// Mapping of printed form back to original char indices.
+    PODVector<unsigned> printToText_;
+    /// Row widths.
+    PODVector<float> rowWidths_;
+    /// Printed text index where each row starts.
+    PODVector<unsigned> rowStarts_;
+    /// Word wrapping state at the start of the last row break.
+    TextWrapState wrapState_;
+    /// Use counter value on last use.
+    unsigned lastUse_{};
+};
+
 /// %Font face description.
 class URHO3D_API FontFace : public RefCounted
 {
@@ -93,6 +129,14 @@ public:
     /// Return textures.
     const Vector<SharedPtr<Texture2D> >& GetTextures() const { return textures_; }
 
+    /// Return glyph version, incremented whenever existing glyphs change their texture position or size.
+    unsigned GetGlyphVersion() const { return glyphVersion_; }
+
+    /// Return cached layout of a text with the given maximum row width, or null if not cached.
+    const TextLayout* GetTextLayout(const PODVector<unsigned>& text, int maxWidth);
+    /// Add a layout to the cache for the caller to fill, discarding the least recently used layout if the cache is full. Return null if the text is too long to be cached.
+    TextLayout* AddTextLayout(const PODVector<unsigned>& text, int maxWidth);
+
 protected:
     friend class FontFaceBitmap;
     /// Create a texture for font rendering.
@@ -112,6 +156,12 @@ protected:
     float pointSize_{};
     /// Row height.
     float rowHeight_{};
+    /// Glyph version.
+    unsigned glyphVersion_{};
+    /// Cached text layouts.
+    HashMap<unsigned, TextLayout> textLayouts_;
+    /// Use counter of the cached text layouts.
+    unsigned textLayoutUseCounter_{};
 };
 
 }
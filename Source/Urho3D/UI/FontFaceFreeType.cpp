@@ -23,6 +23,8 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Texture2D.h"
 #include "../IO/FileSystem.h"
@@ -30,6 +32,7 @@
 #include "../IO/MemoryBuffer.h"
 #include "../UI/Font.h"
 #include "../UI/FontFaceFreeType.h"
+#include "../UI/FontGlyphAtlas.h"
 #include "../UI/UI.h"
 
 #include <cassert>
@@ -43,11 +46,19 @@
 namespace Urho3D
 {
 
+/// Priority of background glyph rasterization work items.
+static const unsigned GLYPH_RASTERIZE_PRIORITY = 0;
+
 inline float FixedToFloat(FT_Pos value)
 {
     return value / 64.0f;
 }
 
+static void RasterizeGlyphsWork(const WorkItem* item, unsigned threadIndex)
+{
+    static_cast<FontFaceFreeType*>(item->start_)->RasterizeGlyphs();
+}
+
 /// FreeType library subsystem.
 class FreeTypeLibrary : public Object
 {
@@ -84,6 +95,30 @@ FontFaceFreeType::FontFaceFreeType(Font* font) :
 
 FontFaceFreeType::~FontFaceFreeType()
 {
+    if (rasterizeItem_)
+    {
+        auto* queue = font_->GetSubsystem<WorkQueue>();
+        if (queue && !queue->RemoveWorkItem(rasterizeItem_))
+        {
+            while (!rasterizeItem_->completed_)
+                Time::Sleep(0);
+        }
+        rasterizeItem_.Reset();
+    }
+
+    if (atlas_)
+    {
+        atlas_->RemoveFace(this);
+        // The atlas texture is shared, so it must not be deducted from the font memory use
+        textures_.Clear();
+    }
+
+    if (workerFace_)
+    {
+        FT_Done_Face((FT_Face)workerFace_);
+        workerFace_ = nullptr;
+    }
+
     if (face_)
     {
         FT_Done_Face((FT_Face)face_);
@@ -194,35 +229,63 @@ bool FontFaceFreeType::Load(const unsigned char* fontData, unsigned fontDataSize
         rowHeight_ = Max(rowHeight_, ascender_ + descender);
     }
 
-    int textureWidth = maxTextureSize;
-    int textureHeight = maxTextureSize;
-    hasMutableGlyph_ = false;
-
-    SharedPtr<Image> image(new Image(font_->GetContext()));
-    image->SetSize(textureWidth, textureHeight, 1);
-    unsigned char* imageData = image->GetData();
-    memset(imageData, 0, (size_t)image->GetWidth() * image->GetHeight());
-    allocator_.Reset(FONT_TEXTURE_MIN_SIZE, FONT_TEXTURE_MIN_SIZE, textureWidth, textureHeight);
+    if (ui->GetUseMutableGlyphs())
+    {
+        // Rasterize glyphs on first use in the background, into the atlas shared by all faces. A second FreeType face
+        // is used by the worker thread, as a face must not be used from several threads at once
+        FT_Face workerFace;
+        error = FT_New_Memory_Face(library, fontData, fontDataSize, 0, &workerFace);
+        if (error)
+        {
+            URHO3D_LOGERROR("Could not create font face for background rasterization");
+            return false;
+        }
+        workerFace_ = workerFace;
+        error = FT_Set_Char_Size(workerFace, 0, pointSize * 64, oversampling_ * FONT_DPI, FONT_DPI);
+        if (error)
+        {
+            URHO3D_LOGERROR("Could not set font point size " + String(pointSize));
+            return false;
+        }
 
-    for (unsigned i = 0; i < charCodes.Size(); ++i)
+        hasMutableGlyph_ = true;
+        atlas_ = ui->GetGlyphAtlas();
+        atlas_->AddFace(this);
+        if (atlas_->GetTexture())
+            textures_.Push(SharedPtr<Texture2D>(atlas_->GetTexture()));
+    }
+    else
     {
-        unsigned charCode = charCodes[i];
-        if (charCode == 0)
-            continue;
+        int textureWidth = maxTextureSize;
+        int textureHeight = maxTextureSize;
+        hasMutableGlyph_ = false;
+
+        SharedPtr<Image> image(new Image(font_->GetContext()));
+        image->SetSize(textureWidth, textureHeight, 1);
+        unsigned char* imageData = image->GetData();
+        memset(imageData, 0, (size_t)image->GetWidth() * image->GetHeight());
+        allocator_.Reset(FONT_TEXTURE_MIN_SIZE, FONT_TEXTURE_MIN_SIZE, textureWidth, textureHeight);
 
-        if (!LoadCharGlyph(charCode, image))
+        for (unsigned i = 0; i < charCodes.Size(); ++i)
         {
-            hasMutableGlyph_ = true;
-            break;
+            unsigned charCode = charCodes[i];
+            if (charCode == 0)
+                continue;
+
+            if (!LoadCharGlyph(charCode, image))
+            {
+                hasMutableGlyph_ = true;
+                break;
+            }
         }
-    }
 
-    SharedPtr<Texture2D> texture = LoadFaceTexture(image);
-    if (!texture)
-        return false;
+        SharedPtr<Texture2D> texture = LoadFaceTexture(image);
+        if (!texture)
+            return false;
 
-    textures_.Push(texture);
-    font_->SetMemoryUse(font_->GetMemoryUse() + textureWidth * textureHeight);
+        textures_.Push(texture);
+        font_->SetMemoryUse(font_->GetMemoryUse() + textureWidth * textureHeight);
+    }
 
     // Store kerning if face has kerning information
     if (FT_HAS_KERNING(face))
@@ -307,6 +370,26 @@ bool FontFaceFreeType::Load(const unsigned char* fontData, unsigned fontDataSize
 
 const FontGlyph* FontFaceFreeType::GetGlyph(unsigned c)
 {
+    if (atlas_)
+    {
+        HashMap<unsigned, FontGlyph>::Iterator i = glyphMapping_.Find(c);
+        FontGlyph* glyph = i != glyphMapping_.End() ? &i->second_ : LoadGlyphMetrics(c);
+        if (!glyph)
+            return nullptr;
+        glyph->used_ = true;
+
+        HashMap<unsigned, unsigned>::ConstIterator j = atlasCells_.Find(c);
+        if (j != atlasCells_.End())
+            atlas_->Touch(j->second_);
+        else if (glyph->width_ > 0.0f && glyph->height_ > 0.0f && !requestedGlyphs_.Contains(c))
+        {
+            // Show the placeholder until the glyph has been rasterized
+            requestedGlyphs_.Insert(c);
+            pendingGlyphs_.Push(c);
+        }
+        return glyph;
+    }
+
     HashMap<unsigned, FontGlyph>::Iterator i = glyphMapping_.Find(c);
     if (i != glyphMapping_.End())
     {
@@ -433,27 +516,7 @@ bool FontFaceFreeType::LoadCharGlyph(unsigned charCode, Image* image)
     else
     {
         // Note: position within texture will be filled later
-        fontGlyph.texWidth_ = slot->bitmap.width + oversampling_ - 1;
-        fontGlyph.texHeight_ = slot->bitmap.rows;
-        fontGlyph.width_ = slot->bitmap.width + oversampling_ - 1;
-        fontGlyph.height_ = slot->bitmap.rows;
-        fontGlyph.offsetX_ = slot->bitmap_left - (oversampling_ - 1) / 2.0f;
-        fontGlyph.offsetY_ = floorf(ascender_ + 0.5f) - slot->bitmap_top;
-
-        if (subpixel_ && slot->linearHoriAdvance)
-        {
-            // linearHoriAdvance is stored in 16.16 fixed point, not the usual 26.6
-            fontGlyph.advanceX_ = slot->linearHoriAdvance / 65536.0;
-        }
-        else
-        {
-            // Round to nearest pixel (only necessary when hinting is disabled)
-            fontGlyph.advanceX_ = floorf(FixedToFloat(slot->metrics.horiAdvance) + 0.5f);
-        }
-
-        fontGlyph.width_ /= oversampling_;
-        fontGlyph.offsetX_ /= oversampling_;
-        fontGlyph.advanceX_ /= oversampling_;
+        SetGlyphMetrics(fontGlyph, slot);
     }
 
     int x = 0, y = 0;
@@ -500,27 +563,7 @@ bool FontFaceFreeType::LoadCharGlyph(unsigned charCode, Image* image)
             pitch = (unsigned)fontGlyph.texWidth_;
         }
 
-        if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
-        {
-            for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
-            {
-                unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
-                unsigned char* rowDest = dest + (oversampling_ - 1)/2 + y * pitch;
-
-                // Don't do any oversampling, just unpack the bits directly.
-                for (unsigned x = 0; x < (unsigned)slot->bitmap.width; ++x)
-                    rowDest[x] = (unsigned char)((src[x >> 3u] & (0x80u >> (x & 7u))) ? 255 : 0);
-            }
-        }
-        else
-        {
-            for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
-            {
-                unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
-                unsigned char* rowDest = dest + y * pitch;
-                BoxFilter(rowDest, fontGlyph.texWidth_, src, slot->bitmap.width);
-            }
-        }
+        CopyGlyphBitmap(dest, pitch, slot, fontGlyph);
 
         if (!image)
         {
@@ -540,4 +583,228 @@ bool FontFaceFreeType::LoadCharGlyph(unsigned charCode, Image* image)
     return true;
 }
 
+FontGlyph* FontFaceFreeType::LoadGlyphMetrics(unsigned charCode)
+{
+    auto face = (FT_Face)face_;
+    FT_GlyphSlot slot = face->glyph;
+
+    FontGlyph fontGlyph;
+    fontGlyph.page_ = 0;
+    FT_Error error = FT_Load_Char(face, charCode, loadMode_);
+    if (error)
+    {
+        const char* family = face->family_name ? face->family_name : "NULL";
+        URHO3D_LOGERRORF("FT_Load_Char failed (family: %s, char code: %u)", family, charCode);
+    }
+    else
+    {
+        // Without rendering there is no bitmap yet, so approximate its extents from the outline metrics.
+        // The advance is exact, so text layout does not change once the glyph has been rasterized
+        SetGlyphMetrics(fontGlyph, slot);
+        fontGlyph.texWidth_ = 0;
+        fontGlyph.texHeight_ = 0;
+        fontGlyph.width_ = ceilf(FixedToFloat(slot->metrics.width)) / oversampling_;
+        fontGlyph.height_ = ceilf(FixedToFloat(slot->metrics.height));
+        fontGlyph.offsetX_ = FixedToFloat(slot->metrics.horiBearingX) / oversampling_;
+        fontGlyph.offsetY_ = floorf(ascender_ + 0.5f) - FixedToFloat(slot->metrics.horiBearingY);
+
+        if (fontGlyph.width_ > 0.0f && fontGlyph.height_ > 0.0f)
+        {
+            const IntRect& placeholder = atlas_->GetPlaceholderRect();
+            fontGlyph.x_ = (short)placeholder.left_;
+            fontGlyph.y_ = (short)placeholder.top_;
+            fontGlyph.texWidth_ = (short)placeholder.Width();
+            fontGlyph.texHeight_ = (short)placeholder.Height();
+        }
+    }
+
+    return &(glyphMapping_[charCode] = fontGlyph);
+}
+
+void FontFaceFreeType::SetGlyphMetrics(FontGlyph& fontGlyph, void* slotPtr) const
+{
+    auto slot = (FT_GlyphSlot)slotPtr;
+
+    fontGlyph.texWidth_ = slot->bitmap.width + oversampling_ - 1;
+    fontGlyph.texHeight_ = slot->bitmap.rows;
+    fontGlyph.width_ = slot->bitmap.width + oversampling_ - 1;
+    fontGlyph.height_ = slot->bitmap.rows;
+    fontGlyph.offsetX_ = slot->bitmap_left - (oversampling_ - 1) / 2.0f;
+    fontGlyph.offsetY_ = floorf(ascender_ + 0.5f) - slot->bitmap_top;
+
+    if (subpixel_ && slot->linearHoriAdvance)
+    {
+        // linearHoriAdvance is stored in 16.16 fixed point, not the usual 26.6
+        fontGlyph.advanceX_ = slot->linearHoriAdvance / 65536.0;
+    }
+    else
+    {
+        // Round to nearest pixel (only necessary when hinting is disabled)
+        fontGlyph.advanceX_ = floorf(FixedToFloat(slot->metrics.horiAdvance) + 0.5f);
+    }
+
+    fontGlyph.width_ /= oversampling_;
+    fontGlyph.offsetX_ /= oversampling_;
+    fontGlyph.advanceX_ /= oversampling_;
+}
+
+void FontFaceFreeType::CopyGlyphBitmap(unsigned char* dest, unsigned pitch, void* slotPtr, const FontGlyph& fontGlyph)
+{
+    auto slot = (FT_GlyphSlot)slotPtr;
+
+    if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
+    {
+        for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
+        {
+            unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
+            unsigned char* rowDest = dest + (oversampling_ - 1)/2 + y * pitch;
+
+            // Don't do any oversampling, just unpack the bits directly.
+            for (unsigned x = 0; x < (unsigned)slot->bitmap.width; ++x)
+                rowDest[x] = (unsigned char)((src[x >> 3u] & (0x80u >> (x & 7u))) ? 255 : 0);
+        }
+    }
+    else
+    {
+        for (unsigned y = 0; y < (unsigned)slot->bitmap.rows; ++y)
+        {
+            unsigned char* src = slot->bitmap.buffer + slot->bitmap.pitch * y;
+            unsigned char* rowDest = dest + y * pitch;
+            BoxFilter(rowDest, fontGlyph.texWidth_, src, slot->bitmap.width);
+        }
+    }
+}
+
+void FontFaceFreeType::UpdateRasterization()
+{
+    if (rasterizeItem_)
+    {
+        if (!rasterizeItem_->completed_)
+            return;
+
+        rasterizeItem_.Reset();
+        StoreRasterizedGlyphs();
+    }
+
+    if (pendingGlyphs_.Empty())
+        return;
+
+    rasterizingGlyphs_ = pendingGlyphs_;
+    pendingGlyphs_.Clear();
+
+    auto* queue = font_->GetSubsystem<WorkQueue>();
+    if (!queue || !queue->GetNumThreads())
+    {
+        RasterizeGlyphs();
+        StoreRasterizedGlyphs();
+        return;
+    }
+
+    rasterizeItem_ = new WorkItem();
+    rasterizeItem_->priority_ = GLYPH_RASTERIZE_PRIORITY;
+    rasterizeItem_->workFunction_ = RasterizeGlyphsWork;
+    rasterizeItem_->start_ = this;
+    queue->AddWorkItem(rasterizeItem_);
+}
+
+void FontFaceFreeType::OnGlyphEvicted(unsigned charCode)
+{
+    atlasCells_.Erase(charCode);
+
+    HashMap<unsigned, FontGlyph>::Iterator i = glyphMapping_.Find(charCode);
+    if (i != glyphMapping_.End())
+    {
+        // Keep the metrics, show the placeholder until rasterized again
+        FontGlyph& glyph = i->second_;
+        const IntRect& placeholder = atlas_->GetPlaceholderRect();
+        glyph.x_ = (short)placeholder.left_;
+        glyph.y_ = (short)placeholder.top_;
+        glyph.texWidth_ = (short)placeholder.Width();
+        glyph.texHeight_ = (short)placeholder.Height();
+    }
+
+    ++glyphVersion_;
+}
+
+void FontFaceFreeType::RasterizeGlyphs()
+{
+    auto face = (FT_Face)workerFace_;
+    FT_GlyphSlot slot = face->glyph;
+
+    rasterizedGlyphs_.Resize(rasterizingGlyphs_.Size());
+    for (unsigned i = 0; i < rasterizingGlyphs_.Size(); ++i)
+    {
+        RasterizedGlyph& rasterized = rasterizedGlyphs_[i];
+        rasterized.charCode_ = rasterizingGlyphs_[i];
+        rasterized.glyph_ = FontGlyph();
+        rasterized.data_.Clear();
+
+        // Failure leaves an empty glyph, the error has already been logged when loading the metrics
+        if (FT_Load_Char(face, rasterized.charCode_, loadMode_ | FT_LOAD_RENDER))
+            continue;
+
+        SetGlyphMetrics(rasterized.glyph_, slot);
+        const FontGlyph& glyph = rasterized.glyph_;
+        if (glyph.texWidth_ > 0 && glyph.texHeight_ > 0)
+        {
+            rasterized.data_.Resize((unsigned)(glyph.texWidth_ * glyph.texHeight_));
+            memset(&rasterized.data_[0], 0, rasterized.data_.Size());
+            CopyGlyphBitmap(&rasterized.data_[0], (unsigned)glyph.texWidth_, slot, glyph);
+        }
+    }
+}
+
+void FontFaceFreeType::StoreRasterizedGlyphs()
+{
+    for (unsigned i = 0; i < rasterizedGlyphs_.Size(); ++i)
+    {
+        const RasterizedGlyph& rasterized = rasterizedGlyphs_[i];
+        const unsigned charCode = rasterized.charCode_;
+        HashMap<unsigned, FontGlyph>::Iterator j = glyphMapping_.Find(charCode);
+        if (j == glyphMapping_.End())
+            continue;
+
+        FontGlyph& glyph = j->second_;
+        const bool used = glyph.used_;
+        const int width = rasterized.glyph_.texWidth_;
+        const int height = rasterized.glyph_.texHeight_;
+
+        if (width > 0 && height > 0)
+        {
+            if (!atlas_->IsSizeSupported(width + 1, height + 1))
+            {
+                // Leave requested so that it is not rasterized again
+                URHO3D_LOGWARNINGF("Glyph of char code %u is too large for the glyph atlas", charCode);
+                continue;
+            }
+
+            requestedGlyphs_.Erase(charCode);
+            unsigned cell = atlas_->Allocate(this, charCode, width + 1, height + 1);
+            // If the atlas is full of glyphs drawn during the last frame, retry when drawn again
+            if (cell == M_MAX_UNSIGNED)
+                continue;
+
+            atlas_->SetCellData(cell, &rasterized.data_[0], width, height);
+            IntVector2 position = atlas_->GetCellPosition(cell);
+            glyph = rasterized.glyph_;
+            glyph.x_ = (short)position.x_;
+            glyph.y_ = (short)position.y_;
+            atlasCells_[charCode] = cell;
+        }
+        else
+        {
+            requestedGlyphs_.Erase(charCode);
+            glyph = rasterized.glyph_;
+            glyph.x_ = 0;
+            glyph.y_ = 0;
+        }
+
+        glyph.page_ = 0;
+        glyph.used_ = used;
+        ++glyphVersion_;
+    }
+
+    rasterizedGlyphs_.Clear();
+}
+
 }
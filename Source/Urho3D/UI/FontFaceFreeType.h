@@ -22,13 +22,27 @@
 
 #pragma once
 
+#include "../Container/HashSet.h"
 #include "../UI/FontFace.h"
 
 namespace Urho3D
 {
 
+class FontGlyphAtlas;
 class FreeTypeLibrary;
 class Texture2D;
+struct WorkItem;
+
+/// Glyph rasterized in the background for the glyph atlas.
+struct RasterizedGlyph
+{
+    /// Character code.
+    unsigned charCode_;
+    /// Glyph description. Position within texture is not filled.
+    FontGlyph glyph_;
+    /// 8-bit glyph image.
+    PODVector<unsigned char> data_;
+};
 
 /// Free type font face description.
 class URHO3D_API FontFaceFreeType : public FontFace
@@ -47,11 +61,26 @@ public:
     /// Return if font face uses mutable glyphs.
     bool HasMutableGlyphs() const override { return hasMutableGlyph_; }
 
+    /// Store glyphs rasterized in the background to the glyph atlas and start rasterizing newly requested glyphs. Called by the glyph atlas once per frame.
+    void UpdateRasterization();
+    /// Handle a glyph being evicted from the glyph atlas. Called by the glyph atlas.
+    void OnGlyphEvicted(unsigned charCode);
+    /// Rasterize the requested glyphs. Called from a worker thread.
+    void RasterizeGlyphs();
+
 private:
     /// Setup next texture.
     bool SetupNextTexture(int textureWidth, int textureHeight);
     /// Load char glyph.
     bool LoadCharGlyph(unsigned charCode, Image* image = nullptr);
+    /// Load glyph metrics only and show it as a placeholder until rasterized. Used with the glyph atlas.
+    FontGlyph* LoadGlyphMetrics(unsigned charCode);
+    /// Fill glyph size, offset and advance from a loaded FreeType glyph slot.
+    void SetGlyphMetrics(FontGlyph& fontGlyph, void* slot) const;
+    /// Copy a rendered FreeType glyph slot bitmap to an 8-bit image, applying the oversampling filter.
+    void CopyGlyphBitmap(unsigned char* dest, unsigned pitch, void* slot, const FontGlyph& fontGlyph);
+    /// Move finished rasterized glyphs to the glyph atlas.
+    void StoreRasterizedGlyphs();
     /// Smooth one row of a horizontally oversampled glyph image.
     void BoxFilter(unsigned char* dest, size_t destSize, const unsigned char* src, size_t srcSize);
 
@@ -71,6 +100,22 @@ private:
     bool hasMutableGlyph_{};
     /// Glyph area allocator.
     AreaAllocator allocator_;
+    /// Shared glyph atlas. Non-null when glyphs are rasterized on demand in the background.
+    SharedPtr<FontGlyphAtlas> atlas_;
+    /// FreeType face used by the worker thread. Non-null only with the glyph atlas.
+    void* workerFace_{};
+    /// Atlas cells of the resident glyphs.
+    HashMap<unsigned, unsigned> atlasCells_;
+    /// Glyphs requested or being rasterized.
+    HashSet<unsigned> requestedGlyphs_;
+    /// Glyphs requested during the current frame.
+    PODVector<unsigned> pendingGlyphs_;
+    /// Glyphs being rasterized by the work item.
+    PODVector<unsigned> rasterizingGlyphs_;
+    /// Glyphs rasterized by the work item.
+    Vector<RasterizedGlyph> rasterizedGlyphs_;
+    /// Background rasterization work item.
+    SharedPtr<WorkItem> rasterizeItem_;
 };
 
 }
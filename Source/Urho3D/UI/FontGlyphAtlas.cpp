@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/Texture2D.h"
+#include "../IO/Log.h"
+#include "../UI/FontFaceFreeType.h"
+#include "../UI/FontGlyphAtlas.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Cell sizes of the size buckets. Glyphs larger than the last bucket are not supported.
+static const int bucketSizes[] = {8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256};
+static const unsigned NUM_BUCKETS = sizeof(bucketSizes) / sizeof(bucketSizes[0]);
+/// Value of the placeholder pixels.
+static const unsigned char PLACEHOLDER_VALUE = 80;
+
+FontGlyphAtlas::FontGlyphAtlas(Context* context, int size) :
+    Object(context),
+    size_(size),
+    nextShelfY_(0),
+    frameNumber_(0),
+    numEvictions_(0)
+{
+    data_ = new unsigned char[size_ * size_];
+    memset(data_.Get(), 0, (size_t)size_ * size_);
+    bucketCells_.Resize(NUM_BUCKETS);
+    freeCells_.Resize(NUM_BUCKETS);
+
+    if (GetSubsystem<Graphics>())
+    {
+        texture_ = new Texture2D(context_);
+        texture_->SetMipsToSkip(QUALITY_LOW, 0);
+        texture_->SetNumLevels(1);
+        texture_->SetAddressMode(COORD_U, ADDRESS_BORDER);
+        texture_->SetAddressMode(COORD_V, ADDRESS_BORDER);
+        texture_->SetBorderColor(Color(0.0f, 0.0f, 0.0f, 0.0f));
+        if (!texture_->SetSize(size_, size_, Graphics::GetAlphaFormat()))
+        {
+            URHO3D_LOGERROR("Could not create glyph atlas texture");
+            texture_.Reset();
+        }
+        else
+            texture_->SetData(0, 0, 0, size_, size_, data_.Get());
+    }
+
+    // Reserve a cell of the smallest bucket for the placeholder, a faint box sampled well inside its borders
+    unsigned cell = Allocate(nullptr, 0, bucketSizes[0], bucketSizes[0]);
+    const int cellSize = bucketSizes[0];
+    PODVector<unsigned char> box((unsigned)(cellSize * cellSize), 0);
+    for (int y = 1; y < cellSize - 1; ++y)
+        memset(&box[y * cellSize + 1], PLACEHOLDER_VALUE, (size_t)(cellSize - 2));
+    SetCellData(cell, &box[0], cellSize, cellSize);
+    IntVector2 position = GetCellPosition(cell);
+    placeholderRect_ = IntRect(position.x_ + 2, position.y_ + 2, position.x_ + cellSize - 2, position.y_ + cellSize - 2);
+}
+
+FontGlyphAtlas::~FontGlyphAtlas() = default;
+
+void FontGlyphAtlas::AddFace(FontFaceFreeType* face)
+{
+    if (!faces_.Contains(face))
+        faces_.Push(face);
+}
+
+void FontGlyphAtlas::RemoveFace(FontFaceFreeType* face)
+{
+    faces_.Remove(face);
+
+    for (unsigned i = 0; i < cells_.Size(); ++i)
+    {
+        if (cells_[i].owner_ == face)
+            Free(i);
+    }
+}
+
+unsigned FontGlyphAtlas::Allocate(FontFaceFreeType* owner, unsigned charCode, int width, int height)
+{
+    unsigned bucket = GetBucket(width, height);
+    if (bucket == M_MAX_UNSIGNED)
+        return M_MAX_UNSIGNED;
+
+    PODVector<unsigned>& freeCells = freeCells_[bucket];
+    unsigned cell = M_MAX_UNSIGNED;
+    if (!freeCells.Empty() || AddShelf(bucket))
+    {
+        cell = freeCells.Back();
+        freeCells.Pop();
+    }
+    else
+    {
+        cell = Evict(bucket);
+        if (cell == M_MAX_UNSIGNED)
+            return M_MAX_UNSIGNED;
+    }
+
+    Cell& c = cells_[cell];
+    c.owner_ = owner;
+    c.charCode_ = charCode;
+    c.lastUse_ = frameNumber_;
+    return cell;
+}
+
+void FontGlyphAtlas::Free(unsigned cell)
+{
+    Cell& c = cells_[cell];
+    c.owner_ = nullptr;
+    c.charCode_ = 0;
+    freeCells_[c.bucket_].Push(cell);
+}
+
+void FontGlyphAtlas::SetCellData(unsigned cell, const unsigned char* data, int width, int height)
+{
+    const Cell& c = cells_[cell];
+    const int cellSize = bucketSizes[c.bucket_];
+    width = Min(width, cellSize);
+    height = Min(height, cellSize);
+
+    // Clear the whole cell so that no leftovers of an evicted glyph remain in the padding
+    unsigned char* dest = data_.Get() + c.y_ * size_ + c.x_;
+    for (int y = 0; y < cellSize; ++y)
+    {
+        unsigned char* rowDest = dest + y * size_;
+        if (y < height)
+        {
+            memcpy(rowDest, data + y * width, (size_t)width);
+            memset(rowDest + width, 0, (size_t)(cellSize - width));
+        }
+        else
+            memset(rowDest, 0, (size_t)cellSize);
+    }
+
+    MarkDirty(IntRect(c.x_, c.y_, c.x_ + cellSize, c.y_ + cellSize));
+}
+
+void FontGlyphAtlas::Update()
+{
+    URHO3D_PROFILE(UpdateGlyphAtlas);
+
+    // Faces may allocate cells here, evicting glyphs that were not drawn during the frame that just ended
+    for (unsigned i = 0; i < faces_.Size(); ++i)
+        faces_[i]->UpdateRasterization();
+
+    if (texture_)
+    {
+        if (texture_->IsDataLost())
+        {
+            texture_->SetData(0, 0, 0, size_, size_, data_.Get());
+            texture_->ClearDataLost();
+        }
+        else
+        {
+            for (unsigned i = 0; i < dirtyRects_.Size(); ++i)
+            {
+                const IntRect& rect = dirtyRects_[i];
+                const int width = rect.Width();
+                const int height = rect.Height();
+                uploadData_.Resize((unsigned)(width * height));
+                for (int y = 0; y < height; ++y)
+                    memcpy(&uploadData_[y * width], data_.Get() + (rect.top_ + y) * size_ + rect.left_, (size_t)width);
+                texture_->SetData(0, rect.left_, rect.top_, width, height, &uploadData_[0]);
+            }
+        }
+    }
+
+    dirtyRects_.Clear();
+    ++frameNumber_;
+}
+
+bool FontGlyphAtlas::IsSizeSupported(int width, int height) const
+{
+    return GetBucket(width, height) != M_MAX_UNSIGNED;
+}
+
+unsigned FontGlyphAtlas::GetNumUsedCells() const
+{
+    unsigned numUsed = 0;
+    for (unsigned i = 0; i < cells_.Size(); ++i)
+    {
+        if (cells_[i].owner_)
+            ++numUsed;
+    }
+    return numUsed;
+}
+
+unsigned FontGlyphAtlas::GetBucket(int width, int height) const
+{
+    const int size = Max(width, height);
+    for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+    {
+        if (size <= bucketSizes[i] && bucketSizes[i] <= size_)
+            return i;
+    }
+    return M_MAX_UNSIGNED;
+}
+
+bool FontGlyphAtlas::AddShelf(unsigned bucket)
+{
+    const int cellSize = bucketSizes[bucket];
+    if (nextShelfY_ + cellSize > size_)
+        return false;
+
+    // Push in reverse so that cells are handed out left to right
+    const unsigned numCells = (unsigned)(size_ / cellSize);
+    const unsigned first = cells_.Size();
+    cells_.Resize(first + numCells);
+    PODVector<unsigned>& freeCells = freeCells_[bucket];
+    for (unsigned i = 0; i < numCells; ++i)
+    {
+        Cell& c = cells_[first + i];
+        c.x_ = (short)(i * cellSize);
+        c.y_ = (short)nextShelfY_;
+        c.bucket_ = bucket;
+        c.owner_ = nullptr;
+        c.charCode_ = 0;
+        c.lastUse_ = 0;
+        bucketCells_[bucket].Push(first + i);
+        freeCells.Push(first + numCells - 1 - i);
+    }
+
+    nextShelfY_ += cellSize;
+    return true;
+}
+
+unsigned FontGlyphAtlas::Evict(unsigned bucket)
+{
+    const PODVector<unsigned>& cells = bucketCells_[bucket];
+    unsigned oldest = M_MAX_UNSIGNED;
+    unsigned oldestAge = 0;
+    for (unsigned i = 0; i < cells.Size(); ++i)
+    {
+        const Cell& c = cells_[cells[i]];
+        if (!c.owner_)
+            continue;
+        unsigned age = frameNumber_ - c.lastUse_;
+        if (age > oldestAge)
+        {
+            oldest = cells[i];
+            oldestAge = age;
+        }
+    }
+
+    if (oldest == M_MAX_UNSIGNED)
+        return M_MAX_UNSIGNED;
+
+    Cell& c = cells_[oldest];
+    c.owner_->OnGlyphEvicted(c.charCode_);
+    c.owner_ = nullptr;
+    c.charCode_ = 0;
+    ++numEvictions_;
+    return oldest;
+}
+
+void FontGlyphAtlas::MarkDirty(const IntRect& rect)
+{
+    // Merge into the region of the same shelf, uploading the cells in between is cheaper than another upload call
+    for (unsigned i = 0; i < dirtyRects_.Size(); ++i)
+    {
+        IntRect& dirty = dirtyRects_[i];
+        if (dirty.top_ == rect.top_ && dirty.bottom_ == rect.bottom_)
+        {
+            dirty.left_ = Min(dirty.left_, rect.left_);
+            dirty.right_ = Max(dirty.right_, rect.right_);
+            return;
+        }
+    }
+
+    dirtyRects_.Push(rect);
+}
+
+}
@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/ArrayPtr.h"
+#include "../Core/Object.h"
+#include "../Math/Rect.h"
+
+namespace Urho3D
+{
+
+class FontFaceFreeType;
+class Texture2D;
+
+/// Glyph atlas texture shared by all FreeType font faces when glyphs are rasterized on demand. Glyphs are stored in square cells grouped into size buckets, so that a cell freed by eviction can be reused by any glyph of the same bucket.
+class URHO3D_API FontGlyphAtlas : public Object
+{
+    URHO3D_OBJECT(FontGlyphAtlas, Object);
+
+public:
+    /// Construct with texture size.
+    FontGlyphAtlas(Context* context, int size);
+    /// Destruct.
+    ~FontGlyphAtlas() override;
+
+    /// Register a font face to be updated each frame.
+    void AddFace(FontFaceFreeType* face);
+    /// Unregister a font face and free its cells.
+    void RemoveFace(FontFaceFreeType* face);
+    /// Allocate a cell for a glyph of the given size including padding. When the size bucket is full, evict the least recently used glyph that was not drawn during the last frame. Return cell index or M_MAX_UNSIGNED on failure.
+    unsigned Allocate(FontFaceFreeType* owner, unsigned charCode, int width, int height);
+    /// Free a cell.
+    void Free(unsigned cell);
+    /// Copy an 8-bit glyph image to a cell and mark the region for upload.
+    void SetCellData(unsigned cell, const unsigned char* data, int width, int height);
+    /// Mark a cell as used during the current frame.
+    void Touch(unsigned cell) { cells_[cell].lastUse_ = frameNumber_; }
+    /// Collect rasterized glyphs from the font faces, upload the modified texture regions and start a new frame.
+    void Update();
+
+    /// Return texture.
+    Texture2D* GetTexture() const { return texture_; }
+    /// Return texture size.
+    int GetSize() const { return size_; }
+    /// Return whether a glyph of the given size including padding fits in a cell.
+    bool IsSizeSupported(int width, int height) const;
+    /// Return texture position of a cell.
+    IntVector2 GetCellPosition(unsigned cell) const { return IntVector2(cells_[cell].x_, cells_[cell].y_); }
+    /// Return texture rectangle of the placeholder shown for glyphs that are not rasterized yet.
+    const IntRect& GetPlaceholderRect() const { return placeholderRect_; }
+    /// Return number of cells holding a glyph.
+    unsigned GetNumUsedCells() const;
+    /// Return number of glyphs evicted so far.
+    unsigned GetNumEvictions() const { return numEvictions_; }
+
+private:
+    /// Atlas cell.
+    struct Cell
+    {
+        /// X position in texture.
+        short x_;
+        /// Y position in texture.
+        short y_;
+        /// Size bucket.
+        unsigned bucket_;
+        /// Owner font face, null if free or reserved.
+        FontFaceFreeType* owner_;
+        /// Character code of the glyph.
+        unsigned charCode_;
+        /// Frame number of last use.
+        unsigned lastUse_;
+    };
+
+    /// Return size bucket for a glyph size, or M_MAX_UNSIGNED if too large.
+    unsigned GetBucket(int width, int height) const;
+    /// Add a shelf of cells for a size bucket. Return false if the texture is full.
+    bool AddShelf(unsigned bucket);
+    /// Evict the least recently used glyph of a size bucket. Return cell index or M_MAX_UNSIGNED if all were used during the last frame.
+    unsigned Evict(unsigned bucket);
+    /// Add a texture region to be uploaded.
+    void MarkDirty(const IntRect& rect);
+
+    /// Atlas texture.
+    SharedPtr<Texture2D> texture_;
+    /// Shadow copy of the texture data.
+    SharedArrayPtr<unsigned char> data_;
+    /// Texture data for region upload.
+    PODVector<unsigned char> uploadData_;
+    /// Texture size.
+    int size_;
+    /// Cells.
+    PODVector<Cell> cells_;
+    /// Cells per size bucket.
+    Vector<PODVector<unsigned> > bucketCells_;
+    /// Free cells per size bucket.
+    Vector<PODVector<unsigned> > freeCells_;
+    /// Texture regions to upload, one per shelf.
+    PODVector<IntRect> dirtyRects_;
+    /// Registered font faces.
+    PODVector<FontFaceFreeType*> faces_;
+    /// Placeholder texture rectangle.
+    IntRect placeholderRect_;
+    /// Y position of the next shelf.
+    int nextShelfY_;
+    /// Current frame number.
+    unsigned frameNumber_;
+    /// Number of evictions.
+    unsigned numEvictions_;
+};
+
+}
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/HashSet.h"
 #include "../Core/Context.h"
 #include "../Input/InputEvents.h"
 #include "../IO/Log.h"
@@ -70,6 +71,25 @@ void SetItemHierarchyParent(UIElement* item, bool enable)
     item->SetVar(hierarchyParentHash, enable);
 }
 
+/// Return whether the first count indices of a sorted index vector contain an index.
+static bool ContainsSorted(const PODVector<unsigned>& indices, unsigned count, unsigned index)
+{
+    int left = 0;
+    int right = (int)count - 1;
+    while (right >= left)
+    {
+        int mid = (left + right) / 2;
+        if (indices[mid] == index)
+            return true;
+        if (index < indices[mid])
+            right = mid - 1;
+        else
+            left = mid + 1;
+    }
+
+    return false;
+}
+
 /// Hierarchy container (used by ListView internally when in hierarchy mode).
 class HierarchyContainer : public UIElement
 {
@@ -171,7 +191,11 @@ ListView::ListView(Context* context) :
     hierarchyMode_(true),    // Init to true here so that the setter below takes effect
     baseIndent_(0),
     clearSelectionOnDefocus_(false),
-    selectOnClickEnd_(false)
+    selectOnClickEnd_(false),
+    virtualMode_(false),
+    virtualItemCount_(0),
+    virtualItemHeight_(20),
+    virtualItemType_(Text::GetTypeStatic())
 {
     resizeContentWidth_ = true;
 
@@ -182,6 +206,7 @@ ListView::ListView(Context* context) :
     SubscribeToEvent(E_FOCUSCHANGED, URHO3D_HANDLER(ListView, HandleItemFocusChanged));
     SubscribeToEvent(this, E_DEFOCUSED, URHO3D_HANDLER(ListView, HandleFocusChanged));
     SubscribeToEvent(this, E_FOCUSED, URHO3D_HANDLER(ListView, HandleFocusChanged));
+    SubscribeToEvent(this, E_VIEWCHANGED, URHO3D_HANDLER(ListView, HandleViewChanged));
 
     UpdateUIClickSubscription();
 }
@@ -201,6 +226,8 @@ void ListView::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Base Indent", GetBaseIndent, SetBaseIndent, int, 0, AM_FILE);
     URHO3D_ACCESSOR_ATTRIBUTE("Clear Sel. On Defocus", GetClearSelectionOnDefocus, SetClearSelectionOnDefocus, bool, false, AM_FILE);
     URHO3D_ACCESSOR_ATTRIBUTE("Select On Click End", GetSelectOnClickEnd, SetSelectOnClickEnd, bool, false, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Virtual Mode", GetVirtualMode, SetVirtualMode, bool, false, AM_FILE);
+    URHO3D_ACCESSOR_ATTRIBUTE("Virtual Item Height", GetVirtualItemHeight, SetVirtualItemHeight, int, 20, AM_FILE);
 }
 
 void ListView::OnKey(Key key, MouseButtonFlags buttons, QualifierFlags qualifiers)
@@ -260,6 +287,13 @@ void ListView::OnKey(Key key, MouseButtonFlags buttons, QualifierFlags qualifier
                 // Convert page step to pixels and see how many items have to be skipped to reach that many pixels
                 if (selection == M_MAX_UNSIGNED)
                     selection = 0;      // Assume as if first item is selected
+                if (virtualMode_)
+                {
+                    // All rows have the same height, so the step can be calculated directly
+                    int pageItems = Max((int)(pageStep_ * scrollPanel_->GetHeight()) / virtualItemHeight_ - 1, 1);
+                    delta = pageDirection * pageItems;
+                    break;
+                }
                 int stepPixels = ((int)(pageStep_ * scrollPanel_->GetHeight())) - contentElement_->GetChild(selection)->GetHeight();
                 unsigned newSelection = selection;
                 unsigned okSelection = selection;
@@ -319,6 +353,10 @@ void ListView::OnResize(const IntVector2& newSize, const IntVector2& delta)
     // When in hierarchy mode also need to resize the overlay container
     if (hierarchyMode_)
         overlayContainer_->SetSize(scrollPanel_->GetSize());
+
+    // In virtual mode the number of rows needed to cover the view may have changed
+    if (virtualMode_)
+        UpdateVirtualRows();
 }
 
 void ListView::UpdateInternalLayout()
@@ -352,6 +390,12 @@ void ListView::InsertItem(unsigned index, UIElement* item, UIElement* parentItem
     if (!item || item->GetParent() == contentElement_)
         return;
 
+    if (virtualMode_)
+    {
+        URHO3D_LOGERROR("Can not insert items to a ListView in virtual mode");
+        return;
+    }
+
     // Enable input so that clicking the item can be detected
     item->SetEnabled(true);
     item->SetSelected(false);
@@ -417,6 +461,12 @@ void ListView::RemoveItem(UIElement* item, unsigned index)
     if (!item)
         return;
 
+    if (virtualMode_)
+    {
+        URHO3D_LOGERROR("Can not remove items from a ListView in virtual mode");
+        return;
+    }
+
     unsigned numItems = GetNumItems();
     for (unsigned i = index; i < numItems; ++i)
     {
@@ -495,6 +545,12 @@ void ListView::RemoveItem(unsigned index)
 
 void ListView::RemoveAllItems()
 {
+    if (virtualMode_)
+    {
+        SetVirtualItemCount(0);
+        return;
+    }
+
     contentElement_->DisableLayoutUpdate();
 
     ClearSelection();
@@ -521,55 +577,56 @@ void ListView::SetSelections(const PODVector<unsigned>& indices)
 
     unsigned numItems = GetNumItems();
 
-    // Remove first items that should no longer be selected
-    for (PODVector<unsigned>::Iterator i = selections_.Begin(); i != selections_.End();)
+    // Sort a copy of the new indices so that lookups stay logarithmic also for large range selections
+    PODVector<unsigned> sortedIndices = indices;
+    Sort(sortedIndices.Begin(), sortedIndices.End());
+
+    // Remove first items that should no longer be selected. Compact the selection in one pass before sending the events
+    PODVector<unsigned> deselectedIndices;
+    unsigned numKept = 0;
+    for (unsigned i = 0; i < selections_.Size(); ++i)
     {
-        unsigned index = *i;
-        if (!indices.Contains(index))
-        {
-            i = selections_.Erase(i);
+        unsigned index = selections_[i];
+        if (ContainsSorted(sortedIndices, sortedIndices.Size(), index))
+            selections_[numKept++] = index;
+        else
+            deselectedIndices.Push(index);
+    }
+    selections_.Resize(numKept);
 
-            using namespace ItemSelected;
+    for (PODVector<unsigned>::ConstIterator i = deselectedIndices.Begin(); i != deselectedIndices.End(); ++i)
+    {
+        using namespace ItemSelected;
 
-            VariantMap& eventData = GetEventDataMap();
-            eventData[P_ELEMENT] = this;
-            eventData[P_SELECTION] = index;
-            SendEvent(E_ITEMDESELECTED, eventData);
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_ELEMENT] = this;
+        eventData[P_SELECTION] = *i;
+        SendEvent(E_ITEMDESELECTED, eventData);
 
-            if (self.Expired())
-                return;
-        }
-        else
-            ++i;
+        if (self.Expired())
+            return;
     }
 
-    bool added = false;
-
-    // Then add missing items
+    // Then add missing items. The remaining old selections are still sorted and newly added ones are tracked separately,
+    // so that the selection can be sorted again before any events are sent
+    unsigned numOldSelections = selections_.Size();
+    HashSet<unsigned> addedIndices;
+    PODVector<unsigned> selectedIndices;
     for (PODVector<unsigned>::ConstIterator i = indices.Begin(); i != indices.End(); ++i)
     {
         unsigned index = *i;
         if (index < numItems)
         {
             // In singleselect mode, resend the event even for the same selection
-            bool duplicate = selections_.Contains(index);
+            bool duplicate = ContainsSorted(selections_, numOldSelections, index) || addedIndices.Contains(index);
             if (!duplicate || !multiselect_)
             {
                 if (!duplicate)
                 {
                     selections_.Push(index);
-                    added = true;
+                    addedIndices.Insert(index);
                 }
-
-                using namespace ItemSelected;
-
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_ELEMENT] = this;
-                eventData[P_SELECTION] = *i;
-                SendEvent(E_ITEMSELECTED, eventData);
-
-                if (self.Expired())
-                    return;
+                selectedIndices.Push(index);
             }
         }
         // If no multiselect enabled, allow setting only one item
@@ -578,9 +635,22 @@ void ListView::SetSelections(const PODVector<unsigned>& indices)
     }
 
     // Re-sort selections if necessary
-    if (added)
+    if (!addedIndices.Empty())
         Sort(selections_.Begin(), selections_.End());
 
+    for (PODVector<unsigned>::ConstIterator i = selectedIndices.Begin(); i != selectedIndices.End(); ++i)
+    {
+        using namespace ItemSelected;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_ELEMENT] = this;
+        eventData[P_SELECTION] = *i;
+        SendEvent(E_ITEMSELECTED, eventData);
+
+        if (self.Expired())
+            return;
+    }
+
     UpdateSelectionEffect();
     SendEvent(E_SELECTIONCHANGED);
 }
@@ -597,9 +667,10 @@ void ListView::AddSelection(unsigned index)
         if (index >= GetNumItems())
             return;
 
-        if (!selections_.Contains(index))
+        if (!ContainsSorted(selections_, selections_.Size(), index))
         {
             selections_.Push(index);
+            Sort(selections_.Begin(), selections_.End());
 
             using namespace ItemSelected;
 
@@ -610,8 +681,6 @@ void ListView::AddSelection(unsigned index)
 
             if (self.Expired())
                 return;
-
-            Sort(selections_.Begin(), selections_.End());
         }
 
         EnsureItemVisibility(index);
@@ -666,6 +735,14 @@ void ListView::ChangeSelection(int delta, bool additive)
     if (!multiselect_)
         additive = false;
 
+    // In virtual mode all items are visible, so a plain selection change does not need to walk the items
+    if (virtualMode_ && !additive)
+    {
+        unsigned selection = delta > 0 ? selections_.Back() : selections_.Front();
+        SetSelection((unsigned)Clamp((int)selection + delta, 0, (int)numItems - 1));
+        return;
+    }
+
     // If going downwards, use the last selection as a base. Otherwise use first
     unsigned selection = delta > 0 ? selections_.Back() : selections_.Front();
     int direction = delta > 0 ? 1 : -1;
@@ -680,7 +757,7 @@ void ListView::ChangeSelection(int delta, bool additive)
             break;
 
         UIElement* item = GetItem(newSelection);
-        if (item->IsVisible())
+        if (virtualMode_ || item->IsVisible())
         {
             indices.Push(okSelection = newSelection);
             delta -= direction;
@@ -714,6 +791,12 @@ void ListView::SetHierarchyMode(bool enable)
     if (enable == hierarchyMode_)
         return;
 
+    if (enable && virtualMode_)
+    {
+        URHO3D_LOGERROR("Can not enable hierarchy mode on a ListView in virtual mode");
+        return;
+    }
+
     hierarchyMode_ = enable;
     UIElement* container;
     if (enable)
@@ -770,6 +853,89 @@ void ListView::SetSelectOnClickEnd(bool enable)
     }
 }
 
+void ListView::SetVirtualMode(bool enable)
+{
+    if (enable == virtualMode_)
+        return;
+
+    if (enable && hierarchyMode_)
+    {
+        URHO3D_LOGERROR("Can not enable virtual mode on a ListView in hierarchy mode");
+        return;
+    }
+
+    ClearSelection();
+    virtualMode_ = enable;
+    virtualItemCount_ = 0;
+    virtualRows_.Clear();
+    virtualRowIndices_.Clear();
+
+    auto* container = new UIElement(context_);
+    container->SetName("LV_ItemContainer");
+    container->SetInternal(true);
+    SetContentElement(container);
+    container->SetEnabled(true);
+    container->SetSortChildren(false);
+
+    if (virtualMode_)
+        UpdateVirtualRows();
+}
+
+void ListView::SetVirtualItemCount(unsigned count)
+{
+    if (!virtualMode_)
+    {
+        URHO3D_LOGERROR("ListView is not in virtual mode");
+        return;
+    }
+
+    // Drop selections past the new end
+    if (!selections_.Empty() && selections_.Back() >= count)
+    {
+        PODVector<unsigned> indices;
+        for (unsigned i = 0; i < selections_.Size() && selections_[i] < count; ++i)
+            indices.Push(selections_[i]);
+        SetSelections(indices);
+    }
+
+    virtualItemCount_ = count;
+    UpdateVirtualRows(true);
+}
+
+void ListView::SetVirtualItemHeight(int height)
+{
+    height = Max(height, 1);
+    if (height != virtualItemHeight_)
+    {
+        virtualItemHeight_ = height;
+        if (virtualMode_)
+            UpdateVirtualRows(true);
+    }
+}
+
+void ListView::SetVirtualItemType(StringHash type)
+{
+    if (type != virtualItemType_)
+    {
+        virtualItemType_ = type;
+        if (virtualMode_)
+        {
+            // Recreate the row pool with the new type
+            for (unsigned i = 0; i < virtualRows_.Size(); ++i)
+                contentElement_->RemoveChild(virtualRows_[i]);
+            virtualRows_.Clear();
+            virtualRowIndices_.Clear();
+            UpdateVirtualRows();
+        }
+    }
+}
+
+void ListView::RefreshVirtualItems()
+{
+    if (virtualMode_)
+        UpdateVirtualRows(true);
+}
+
 void ListView::Expand(unsigned index, bool enable, bool recursive)
 {
     if (!hierarchyMode_)
@@ -827,18 +993,42 @@ void ListView::ToggleExpand(unsigned index, bool recursive)
 
 unsigned ListView::GetNumItems() const
 {
-    return contentElement_->GetNumChildren();
+    return virtualMode_ ? virtualItemCount_ : contentElement_->GetNumChildren();
 }
 
 UIElement* ListView::GetItem(unsigned index) const
 {
+    if (virtualMode_)
+    {
+        // Only the items currently bound to a row exist as elements
+        if (index >= virtualItemCount_ || virtualRows_.Empty())
+            return nullptr;
+        unsigned row = index % virtualRows_.Size();
+        return virtualRowIndices_[row] == index ? virtualRows_[row].Get() : nullptr;
+    }
+
     return contentElement_->GetChild(index);
 }
 
 PODVector<UIElement*> ListView::GetItems() const
 {
     PODVector<UIElement*> items;
-    contentElement_->GetChildren(items);
+    if (virtualMode_)
+    {
+        // Return the bound rows in item order
+        unsigned numRows = virtualRows_.Size();
+        unsigned first = M_MAX_UNSIGNED;
+        for (unsigned i = 0; i < numRows; ++i)
+            first = Min(first, virtualRowIndices_[i]);
+        for (unsigned i = first; i < first + numRows && i < virtualItemCount_; ++i)
+        {
+            UIElement* item = GetItem(i);
+            if (item)
+                items.Push(item);
+        }
+    }
+    else
+        contentElement_->GetChildren(items);
     return items;
 }
 
@@ -851,6 +1041,16 @@ unsigned ListView::FindItem(UIElement* item) const
     if (item->GetParent() != contentElement_)
         return M_MAX_UNSIGNED;
 
+    if (virtualMode_)
+    {
+        for (unsigned i = 0; i < virtualRows_.Size(); ++i)
+        {
+            if (virtualRows_[i] == item)
+                return virtualRowIndices_[i];
+        }
+        return M_MAX_UNSIGNED;
+    }
+
     const Vector<SharedPtr<UIElement> >& children = contentElement_->GetChildren();
 
     // Binary search for list item based on screen coordinate Y
@@ -891,7 +1091,7 @@ unsigned ListView::GetSelection() const
 
 UIElement* ListView::GetSelectedItem() const
 {
-    return contentElement_->GetChild(GetSelection());
+    return GetItem(GetSelection());
 }
 
 PODVector<UIElement*> ListView::GetSelectedItems() const
@@ -925,12 +1125,12 @@ void ListView::CopySelectedItemsToClipboard() const
 
 bool ListView::IsSelected(unsigned index) const
 {
-    return selections_.Contains(index);
+    return ContainsSorted(selections_, selections_.Size(), index);
 }
 
 bool ListView::IsExpanded(unsigned index) const
 {
-    return GetItemExpanded(contentElement_->GetChild(index));
+    return GetItemExpanded(GetItem(index));
 }
 
 bool ListView::FilterImplicitAttributes(XMLElement& dest) const
@@ -978,13 +1178,24 @@ bool ListView::FilterImplicitAttributes(XMLElement& dest) const
 
 void ListView::UpdateSelectionEffect()
 {
-    unsigned numItems = GetNumItems();
     bool highlighted = highlightMode_ == HM_ALWAYS || HasFocus();
 
+    if (virtualMode_)
+    {
+        // Only the bound rows need their selection state updated
+        for (unsigned i = 0; i < virtualRows_.Size(); ++i)
+        {
+            unsigned index = virtualRowIndices_[i];
+            virtualRows_[i]->SetSelected(highlighted && highlightMode_ != HM_NEVER && index != M_MAX_UNSIGNED && IsSelected(index));
+        }
+        return;
+    }
+
+    unsigned numItems = GetNumItems();
     for (unsigned i = 0; i < numItems; ++i)
     {
         UIElement* item = GetItem(i);
-        if (highlightMode_ != HM_NEVER && selections_.Contains(i))
+        if (highlightMode_ != HM_NEVER && IsSelected(i))
             item->SetSelected(highlighted);
         else
             item->SetSelected(false);
@@ -993,6 +1204,26 @@ void ListView::UpdateSelectionEffect()
 
 void ListView::EnsureItemVisibility(unsigned index)
 {
+    if (virtualMode_)
+    {
+        if (index >= virtualItemCount_)
+            return;
+
+        // The item may not be bound to a row yet, so calculate its position from the fixed row height
+        IntVector2 newView = GetViewPosition();
+        int itemY = (int)index * virtualItemHeight_;
+        const IntRect& clipBorder = scrollPanel_->GetClipBorder();
+        int windowHeight = scrollPanel_->GetHeight() - clipBorder.top_ - clipBorder.bottom_;
+
+        if (itemY < newView.y_)
+            newView.y_ = itemY;
+        if (itemY + virtualItemHeight_ > newView.y_ + windowHeight)
+            newView.y_ = itemY + virtualItemHeight_ - windowHeight;
+
+        SetViewPosition(newView);
+        return;
+    }
+
     EnsureItemVisibility(GetItem(index));
 }
 
@@ -1161,4 +1392,106 @@ void ListView::UpdateUIClickSubscription()
     SubscribeToEvent(selectOnClickEnd_ ? E_UIMOUSECLICKEND : E_UIMOUSECLICK, URHO3D_HANDLER(ListView, HandleUIMouseClick));
 }
 
+void ListView::HandleViewChanged(StringHash eventType, VariantMap& eventData)
+{
+    if (virtualMode_)
+        UpdateVirtualRows();
+}
+
+void ListView::UpdateVirtualRows(bool forceRebind)
+{
+    // Make a weak pointer to self to check for destruction as a response to the bind events
+    WeakPtr<ListView> self(this);
+
+    if (forceRebind)
+    {
+        for (unsigned i = 0; i < virtualRowIndices_.Size(); ++i)
+            virtualRowIndices_[i] = M_MAX_UNSIGNED;
+    }
+
+    // The rows are positioned manually, so make sure a layout from the style does not stack them
+    if (contentElement_->GetLayoutMode() != LM_FREE)
+        contentElement_->SetLayoutMode(LM_FREE);
+
+    // Resizing the content may change the view position, which calls this function again
+    int contentHeight = (int)virtualItemCount_ * virtualItemHeight_;
+    if (contentElement_->GetHeight() != contentHeight)
+    {
+        contentElement_->SetHeight(contentHeight);
+        if (self.Expired())
+            return;
+    }
+
+    int contentWidth = contentElement_->GetWidth();
+
+    // Make the pool large enough to cover the view at any scroll offset
+    const IntRect& clipBorder = scrollPanel_->GetClipBorder();
+    int windowHeight = Max(scrollPanel_->GetHeight() - clipBorder.top_ - clipBorder.bottom_, 0);
+    unsigned numRows = (unsigned)((windowHeight + virtualItemHeight_ - 1) / virtualItemHeight_ + 1);
+    if (numRows != virtualRows_.Size())
+    {
+        for (unsigned i = numRows; i < virtualRows_.Size(); ++i)
+            contentElement_->RemoveChild(virtualRows_[i]);
+        unsigned oldNumRows = virtualRows_.Size();
+        virtualRows_.Resize(numRows);
+        for (unsigned i = oldNumRows; i < numRows; ++i)
+        {
+            UIElement* row = contentElement_->CreateChild(virtualItemType_);
+            if (!row)
+            {
+                URHO3D_LOGERROR("Could not create ListView row of type " + virtualItemType_.ToString());
+                virtualRows_.Resize(i);
+                break;
+            }
+            row->SetTemporary(true);
+            row->SetStyleAuto();
+            virtualRows_[i] = row;
+        }
+        // Item to row mapping depends on the pool size, so all rows have to be bound again
+        numRows = virtualRows_.Size();
+        virtualRowIndices_.Resize(numRows);
+        for (unsigned i = 0; i < numRows; ++i)
+            virtualRowIndices_[i] = M_MAX_UNSIGNED;
+    }
+
+    if (!numRows)
+        return;
+
+    unsigned first = (unsigned)(GetViewPosition().y_ / virtualItemHeight_);
+    for (unsigned index = first; index < first + numRows; ++index)
+    {
+        unsigned rowIndex = index % numRows;
+        UIElement* row = virtualRows_[rowIndex];
+        if (index >= virtualItemCount_)
+        {
+            row->SetVisible(false);
+            virtualRowIndices_[rowIndex] = M_MAX_UNSIGNED;
+            continue;
+        }
+
+        if (virtualRowIndices_[rowIndex] != index)
+        {
+            virtualRowIndices_[rowIndex] = index;
+            row->SetVisible(true);
+            row->SetEnabled(true);
+
+            using namespace VirtualItemBind;
+
+            VariantMap& eventData = GetEventDataMap();
+            eventData[P_ELEMENT] = this;
+            eventData[P_ITEM] = row;
+            eventData[P_INDEX] = index;
+            SendEvent(E_VIRTUALITEMBIND, eventData);
+
+            if (self.Expired())
+                return;
+        }
+
+        row->SetPosition(0, (int)index * virtualItemHeight_);
+        row->SetWidth(contentWidth);
+    }
+
+    UpdateSelectionEffect();
+}
+
 }
@@ -104,6 +104,17 @@ public:
     void SetClearSelectionOnDefocus(bool enable);
     /// Enable reacting to click end instead of click start for item selection. Default false.
     void SetSelectOnClickEnd(bool enable);
+    /// \brief Enable virtual mode. Items are not stored in the list; instead a small pool of rows covering the visible area is recycled and filled through the VirtualItemBind event.
+    /// All items in the list will be lost during mode change. Can not be combined with hierarchy mode.
+    void SetVirtualMode(bool enable);
+    /// Set number of items provided by the data source in virtual mode. Visible rows are refreshed and selections past the end are removed.
+    void SetVirtualItemCount(unsigned count);
+    /// Set fixed row height used in virtual mode.
+    void SetVirtualItemHeight(int height);
+    /// Set type of the row elements created in virtual mode. Default is Text.
+    void SetVirtualItemType(StringHash type);
+    /// Request the data source to fill all visible rows again, e.g. after the underlying data changed.
+    void RefreshVirtualItems();
 
     /// Expand item at index. Only has effect in hierarchy mode.
     void Expand(unsigned index, bool enable, bool recursive = false);
@@ -153,6 +164,15 @@ public:
     /// Return base indent.
     int GetBaseIndent() const { return baseIndent_; }
 
+    /// Return whether virtual mode enabled.
+    bool GetVirtualMode() const { return virtualMode_; }
+
+    /// Return fixed row height used in virtual mode.
+    int GetVirtualItemHeight() const { return virtualItemHeight_; }
+
+    /// Return type of the row elements created in virtual mode.
+    StringHash GetVirtualItemType() const { return virtualItemType_; }
+
     /// Ensure full visibility of the item.
     void EnsureItemVisibility(unsigned index);
     /// Ensure full visibility of the item.
@@ -180,6 +200,18 @@ protected:
     bool clearSelectionOnDefocus_;
     /// React to click end instead of click start flag.
     bool selectOnClickEnd_;
+    /// Virtual mode flag.
+    bool virtualMode_;
+    /// Number of items in virtual mode.
+    unsigned virtualItemCount_;
+    /// Row height in virtual mode.
+    int virtualItemHeight_;
+    /// Row element type in virtual mode.
+    StringHash virtualItemType_;
+    /// Row pool in virtual mode. Item index N is always shown by the row at N modulo pool size.
+    Vector<SharedPtr<UIElement> > virtualRows_;
+    /// Item index each pooled row is bound to, or M_MAX_UNSIGNED if unbound.
+    PODVector<unsigned> virtualRowIndices_;
 
 private:
     /// Handle global UI mouseclick to check for selection change.
@@ -192,6 +224,10 @@ private:
     void HandleFocusChanged(StringHash eventType, VariantMap& eventData);
     /// Update subscription to UI click events
     void UpdateUIClickSubscription();
+    /// Handle view position change in virtual mode.
+    void HandleViewChanged(StringHash eventType, VariantMap& eventData);
+    /// Bind the pooled rows to the items in the visible area. Rebind also rows that are already bound if forced.
+    void UpdateVirtualRows(bool forceRebind = false);
 };
 
 }
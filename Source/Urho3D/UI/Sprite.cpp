@@ -118,7 +118,8 @@ void Sprite::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexDat
     UIBatch
         batch(this, blendMode_ == BLEND_REPLACE && !allOpaque ? BLEND_ALPHA : blendMode_, currentScissor, texture_, &vertexData);
 
-    batch.AddQuad(GetTransform(), 0, 0, size.x_, size.y_, imageRect_.left_, imageRect_.top_, imageRect_.right_ - imageRect_.left_,
+    batchTransform_ = GetTransform();
+    batch.AddQuad(batchTransform_, 0, 0, size.x_, size.y_, imageRect_.left_, imageRect_.top_, imageRect_.right_ - imageRect_.left_,
         imageRect_.bottom_ - imageRect_.top_);
 
     UIBatch::AddOrMerge(batch, batches);
@@ -127,6 +128,11 @@ void Sprite::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexDat
     hovering_ = false;
 }
 
+bool Sprite::CanCacheBatches() const
+{
+    return GetTransform() == batchTransform_;
+}
+
 void Sprite::OnPositionSet(const IntVector2& newPosition)
 {
     // If the integer position was set (layout update?), copy to the float position
@@ -196,12 +202,14 @@ void Sprite::SetTexture(Texture* texture)
     texture_ = texture;
     if (imageRect_ == IntRect::ZERO)
         SetFullImageRect();
+    MarkBatchesDirty();
 }
 
 void Sprite::SetImageRect(const IntRect& rect)
 {
     if (rect != IntRect::ZERO)
         imageRect_ = rect;
+    MarkBatchesDirty();
 }
 
 void Sprite::SetFullImageRect()
@@ -213,6 +221,7 @@ void Sprite::SetFullImageRect()
 void Sprite::SetBlendMode(BlendMode mode)
 {
     blendMode_ = mode;
+    MarkBatchesDirty();
 }
 
 const Matrix3x4& Sprite::GetTransform() const
@@ -47,6 +47,8 @@ public:
     const IntVector2& GetScreenPosition() const override;
     /// Return UI rendering batches.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the cached rendering batches can be reused. Only if the transform has not changed since they were generated.
+    bool CanCacheBatches() const override;
     /// React to position change.
     void OnPositionSet(const IntVector2& newPosition) override;
     /// Convert screen coordinates to element coordinates.
@@ -124,6 +126,8 @@ protected:
     BlendMode blendMode_;
     /// Transform matrix.
     mutable Matrix3x4 transform_;
+    /// Transform used when the rendering batches were last generated.
+    Matrix3x4 batchTransform_;
 };
 
 }
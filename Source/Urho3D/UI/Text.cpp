@@ -67,7 +67,13 @@ Text::Text(Context* context) :
     roundStroke_(false),
     effectColor_(Color::BLACK),
     effectDepthBias_(0.0f),
-    rowHeight_(0)
+    rowHeight_(0),
+    layoutMaxWidth_(0),
+    appendStart_(M_MAX_UNSIGNED),
+    charLocationsFrom_(0),
+    glyphVertexOpacity_(0.0f),
+    glyphVertexVersion_(0),
+    glyphVerticesDirty_(true)
 {
     // By default Text does not derive opacity from parent elements
     useDerivedOpacity_ = false;
@@ -98,6 +104,13 @@ void Text::RegisterObject(Context* context)
     context->GetAttribute<Text>("Use Derived Opacity")->defaultValue_ = false;
 }
 
+void Text::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
+{
+    UISelectable::OnSetAttribute(attr, src);
+    charLocationsFrom_ = 0;
+    glyphVerticesDirty_ = true;
+}
+
 void Text::ApplyAttributes()
 {
     UISelectable::ApplyAttributes();
@@ -177,77 +190,154 @@ void Text::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData,
     // Text batch
     TextEffect textEffect = font_->IsSDFFont() ? TE_NONE : textEffect_;
     const Vector<SharedPtr<Texture2D> >& textures = face->GetTextures();
-    for (unsigned n = 0; n < textures.Size() && n < pageGlyphLocations_.Size(); ++n)
+    const unsigned numPages = Min(textures.Size(), pageGlyphLocations_.Size());
+    const IntVector2& screenPosition = GetScreenPosition();
+    const Color& derivedColor = GetDerivedColor();
+    float derivedOpacity = GetDerivedOpacity();
+
+    // Reuse the glyph vertices when only appended to or moved, as constructing glyph quads with effects is expensive
+    if (glyphVerticesDirty_ || pageVertexData_.Size() != numPages || HasColorGradient() || derivedColor != glyphVertexColor_ ||
+        derivedOpacity != glyphVertexOpacity_ || face->GetGlyphVersion() != glyphVertexVersion_)
     {
-        // One batch per texture/page
-        UIBatch pageBatch(this, BLEND_ALPHA, currentScissor, textures[n], &vertexData);
+        pageVertexData_.Resize(numPages);
+        pageVertexGlyphs_.Resize(numPages);
+        for (unsigned n = 0; n < numPages; ++n)
+        {
+            pageVertexData_[n].Clear();
+            pageVertexGlyphs_[n] = 0;
+        }
+        glyphVertexPosition_ = screenPosition;
+        glyphVertexColor_ = derivedColor;
+        glyphVertexOpacity_ = derivedOpacity;
+        glyphVertexVersion_ = face->GetGlyphVersion();
+        glyphVerticesDirty_ = false;
+    }
+    else if (screenPosition != glyphVertexPosition_)
+    {
+        Vector2 delta((float)(screenPosition.x_ - glyphVertexPosition_.x_), (float)(screenPosition.y_ - glyphVertexPosition_.y_));
+        for (unsigned n = 0; n < numPages; ++n)
+        {
+            PODVector<float>& pageVertexData = pageVertexData_[n];
+            for (unsigned i = 0; i < pageVertexData.Size(); i += UI_VERTEX_SIZE)
+            {
+                pageVertexData[i] += delta.x_;
+                pageVertexData[i + 1] += delta.y_;
+            }
+        }
+        glyphVertexPosition_ = screenPosition;
+    }
 
+    for (unsigned n = 0; n < numPages; ++n)
+    {
+        // One batch per texture/page
         const PODVector<GlyphLocation>& pageGlyphLocation = pageGlyphLocations_[n];
+        PODVector<float>& pageVertexData = pageVertexData_[n];
+        unsigned& pageVertexGlyphs = pageVertexGlyphs_[n];
 
-        switch (textEffect)
+        if (pageVertexGlyphs != pageGlyphLocation.Size())
         {
-        case TE_NONE:
-            ConstructBatch(pageBatch, pageGlyphLocation, 0, 0);
-            break;
+            // Effects are drawn in separate passes over all glyphs, so only plain glyphs can be appended
+            if (textEffect != TE_NONE || pageVertexGlyphs > pageGlyphLocation.Size())
+            {
+                pageVertexData.Clear();
+                pageVertexGlyphs = 0;
+            }
 
-        case TE_SHADOW:
-            ConstructBatch(pageBatch, pageGlyphLocation, shadowOffset_.x_, shadowOffset_.y_, &effectColor_, effectDepthBias_);
-            ConstructBatch(pageBatch, pageGlyphLocation, 0, 0);
-            break;
+            UIBatch pageBatch(this, BLEND_ALPHA, currentScissor, textures[n], &pageVertexData);
 
-        case TE_STROKE:
-            if (roundStroke_)
+            switch (textEffect)
             {
-                // Samples should be even or glyph may be redrawn in wrong x y pos making stroke corners rough
-                // Adding to thickness helps with thickness of 1 not having enought samples for this formula
-                // or certain fonts with reflex corners requiring more glyph samples for a smooth stroke when large
-                int thickness = Min(strokeThickness_, fontSize_);
-                int samples = thickness * thickness + (thickness % 2 == 0 ? 4 : 3);
-                float angle = 360.f / samples;
-                auto floatThickness = (float)thickness;
-                for (int i = 0; i < samples; ++i)
+            case TE_NONE:
+                ConstructBatch(pageBatch, pageGlyphLocation, 0, 0, nullptr, 0.0f, pageVertexGlyphs);
+                break;
+
+            case TE_SHADOW:
+                ConstructBatch(pageBatch, pageGlyphLocation, shadowOffset_.x_, shadowOffset_.y_, &effectColor_, effectDepthBias_);
+                ConstructBatch(pageBatch, pageGlyphLocation, 0, 0);
+                break;
+
+            case TE_STROKE:
+                if (roundStroke_)
                 {
-                    float x = Cos(angle * i) * floatThickness;
-                    float y = Sin(angle * i) * floatThickness;
-                    ConstructBatch(pageBatch, pageGlyphLocation, x, y, &effectColor_, effectDepthBias_);
+                    // Samples should be even or glyph may be redrawn in wrong x y pos making stroke corners rough
+                    // Adding to thickness helps with thickness of 1 not having enought samples for this formula
+                    // or certain fonts with reflex corners requiring more glyph samples for a smooth stroke when large
+                    int thickness = Min(strokeThickness_, fontSize_);
+                    int samples = thickness * thickness + (thickness % 2 == 0 ? 4 : 3);
+                    float angle = 360.f / samples;
+                    auto floatThickness = (float)thickness;
+                    for (int i = 0; i < samples; ++i)
+                    {
+                        float x = Cos(angle * i) * floatThickness;
+                        float y = Sin(angle * i) * floatThickness;
+                        ConstructBatch(pageBatch, pageGlyphLocation, x, y, &effectColor_, effectDepthBias_);
+                    }
                 }
-            }
-            else
-            {
-                int thickness = Min(strokeThickness_, fontSize_);
-                int x, y;
-                for (x = -thickness; x <= thickness; ++x)
+                else
                 {
-                    for (y = -thickness; y <= thickness; ++y)
+                    int thickness = Min(strokeThickness_, fontSize_);
+                    int x, y;
+                    for (x = -thickness; x <= thickness; ++x)
                     {
-                        // Don't draw glyphs that aren't on the edges
-                        if (x > -thickness && x < thickness &&
-                            y > -thickness && y < thickness)
-                            continue;
+                        for (y = -thickness; y <= thickness; ++y)
+                        {
+                            // Don't draw glyphs that aren't on the edges
+                            if (x > -thickness && x < thickness &&
+                                y > -thickness && y < thickness)
+                                continue;
 
-                        ConstructBatch(pageBatch, pageGlyphLocation, x, y, &effectColor_, effectDepthBias_);
+                            ConstructBatch(pageBatch, pageGlyphLocation, x, y, &effectColor_, effectDepthBias_);
+                        }
                     }
                 }
+                ConstructBatch(pageBatch, pageGlyphLocation, 0, 0);
+                break;
             }
-            ConstructBatch(pageBatch, pageGlyphLocation, 0, 0);
-            break;
+
+            pageVertexGlyphs = pageGlyphLocation.Size();
         }
 
+        if (pageVertexData.Empty())
+            continue;
+
+        UIBatch pageBatch(this, BLEND_ALPHA, currentScissor, textures[n], &vertexData);
+        unsigned vertexStart = vertexData.Size();
+        vertexData.Resize(vertexStart + pageVertexData.Size());
+        memcpy(&vertexData[vertexStart], &pageVertexData[0], pageVertexData.Size() * sizeof(float));
+        pageBatch.vertexStart_ = vertexStart;
+        pageBatch.vertexEnd_ = vertexData.Size();
         UIBatch::AddOrMerge(pageBatch, batches);
     }
 }
 
+bool Text::CanCacheBatches() const
+{
+    if (!UISelectable::CanCacheBatches() || charLocationsDirty_ || !font_ || !fontFace_)
+        return false;
+
+    // Mutable glyphs may be evicted from the texture, so they must be reacquired every frame
+    return font_->GetFace(fontSize_) == fontFace_ && !fontFace_->HasMutableGlyphs();
+}
+
 void Text::OnResize(const IntVector2& newSize, const IntVector2& delta)
 {
     if (wordWrap_)
-        UpdateText(true);
+    {
+        // Wrapping depends only on the width, so the height set by UpdateText() itself does not need another layout
+        if (!layoutFace_ || GetWidth() != layoutMaxWidth_)
+            UpdateText(true);
+    }
     else
+    {
         charLocationsDirty_ = true;
+        charLocationsFrom_ = 0;
+    }
 }
 
 void Text::OnIndentSet()
 {
     charLocationsDirty_ = true;
+    charLocationsFrom_ = 0;
 }
 
 bool Text::SetFont(const String& fontName, float size)
@@ -300,6 +390,16 @@ void Text::SetText(const String& text)
     }
     else
     {
+        if (text == text_)
+            return;
+
+        // Lay out only the changed rows when the old text is kept as the beginning
+        if (text.Length() > text_.Length() && text.StartsWith(text_))
+        {
+            AppendText(text.Substring(text_.Length()));
+            return;
+        }
+
         text_ = text;
     }
 
@@ -308,12 +408,33 @@ void Text::SetText(const String& text)
     UpdateText();
 }
 
+void Text::AppendText(const String& text)
+{
+    if (autoLocalizable_)
+    {
+        SetText(stringId_ + text);
+        return;
+    }
+
+    if (text.Empty())
+        return;
+
+    appendStart_ = unicodeText_.Size();
+    text_ += text;
+    for (unsigned i = 0; i < text.Length();)
+        unicodeText_.Push(text.NextUTF8Char(i));
+
+    ValidateSelection();
+    UpdateText();
+}
+
 void Text::SetTextAlignment(HorizontalAlignment align)
 {
     if (align != textAlignment_)
     {
         textAlignment_ = align;
         charLocationsDirty_ = true;
+        charLocationsFrom_ = 0;
     }
 }
 
@@ -373,42 +494,56 @@ void Text::SetSelection(unsigned start, unsigned length)
     selectionStart_ = start;
     selectionLength_ = length;
     ValidateSelection();
+    MarkBatchesDirty();
 }
 
 void Text::ClearSelection()
 {
     selectionStart_ = 0;
     selectionLength_ = 0;
+    MarkBatchesDirty();
 }
 
 void Text::SetTextEffect(TextEffect textEffect)
 {
     textEffect_ = textEffect;
+    glyphVerticesDirty_ = true;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectShadowOffset(const IntVector2& offset)
 {
     shadowOffset_ = offset;
+    glyphVerticesDirty_ = true;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectStrokeThickness(int thickness)
 {
     strokeThickness_ = Abs(thickness);
+    glyphVerticesDirty_ = true;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectRoundStroke(bool roundStroke)
 {
     roundStroke_ = roundStroke;
+    glyphVerticesDirty_ = true;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectColor(const Color& effectColor)
 {
     effectColor_ = effectColor;
+    glyphVerticesDirty_ = true;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectDepthBias(float bias)
 {
     effectDepthBias_ = bias;
+    glyphVerticesDirty_ = true;
+    MarkBatchesDirty();
 }
 
 float Text::GetRowWidth(unsigned index) const
@@ -486,161 +621,113 @@ bool Text::FilterImplicitAttributes(XMLElement& dest) const
 
 void Text::UpdateText(bool onResize)
 {
-    rowWidths_.Clear();
-    printText_.Clear();
+    MarkBatchesDirty();
+
+    const unsigned appendStart = appendStart_;
+    appendStart_ = M_MAX_UNSIGNED;
 
     if (font_)
     {
         FontFace* face = font_->GetFace(fontSize_);
         if (!face)
+        {
+            rowWidths_.Clear();
+            rowStarts_.Clear();
+            printText_.Clear();
+            layoutFace_.Reset();
             return;
+        }
 
         rowHeight_ = face->GetRowHeight();
 
         int width = 0;
         int height = 0;
-        int rowWidth = 0;
         auto rowHeight = RoundToInt(rowSpacing_ * rowHeight_);
+        const int maxWidth = wordWrap_ ? GetWidth() : M_MAX_INT;
 
-        // First see if the text must be split up
-        if (!wordWrap_)
+        if (appendStart <= unicodeText_.Size() && face == layoutFace_ && maxWidth == layoutMaxWidth_)
         {
-            printText_ = unicodeText_;
-            printToText_.Resize(printText_.Size());
-            for (unsigned i = 0; i < printText_.Size(); ++i)
-                printToText_[i] = i;
-        }
-        else
-        {
-            int maxWidth = GetWidth();
-            unsigned nextBreak = 0;
-            unsigned lineStart = 0;
-            printToText_.Clear();
-
-            for (unsigned i = 0; i < unicodeText_.Size(); ++i)
+            // Text was appended to. As the layout only looks ahead, the rows before the one containing the first changed
+            // printed character stay the same
+            unsigned changeStart;
+            if (!wordWrap_)
             {
-                unsigned j;
-                unsigned c = unicodeText_[i];
-
-                if (c != '\n')
+                changeStart = appendStart;
+                for (unsigned i = appendStart; i < unicodeText_.Size(); ++i)
                 {
-                    bool ok = true;
-
-                    if (nextBreak <= i)
-                    {
-                        int futureRowWidth = rowWidth;
-                        for (j = i; j < unicodeText_.Size(); ++j)
-                        {
-                            unsigned d = unicodeText_[j];
-                            if (d == ' ' || d == '\n')
-                            {
-                                nextBreak = j;
-                                break;
-                            }
-                            const FontGlyph* glyph = face->GetGlyph(d);
-                            if (glyph)
-                            {
-                                futureRowWidth += glyph->advanceX_;
-                                if (j < unicodeText_.Size() - 1)
-                                    futureRowWidth += face->GetKerning(d, unicodeText_[j + 1]);
-                            }
-                            if (d == '-' && futureRowWidth <= maxWidth)
-                            {
-                                nextBreak = j + 1;
-                                break;
-                            }
-                            if (futureRowWidth > maxWidth)
-                            {
-                                ok = false;
-                                break;
-                            }
-                        }
-                    }
-
-                    if (!ok)
-                    {
-                        // If did not find any breaks on the line, copy until j, or at least 1 char, to prevent infinite loop
-                        if (nextBreak == lineStart)
-                        {
-                            while (i < j)
-                            {
-                                printText_.Push(unicodeText_[i]);
-                                printToText_.Push(i);
-                                ++i;
-                            }
-                        }
-                        // Eliminate spaces that have been copied before the forced break
-                        while (printText_.Size() && printText_.Back() == ' ')
-                        {
-                            printText_.Pop();
-                            printToText_.Pop();
-                        }
-                        printText_.Push('\n');
-                        printToText_.Push(Min(i, unicodeText_.Size() - 1));
-                        rowWidth = 0;
-                        nextBreak = lineStart = i;
-                    }
-
-                    if (i < unicodeText_.Size())
-                    {
-                        // When copying a space, position is allowed to be over row width
-                        c = unicodeText_[i];
-                        const FontGlyph* glyph = face->GetGlyph(c);
-                        if (glyph)
-                        {
-                            rowWidth += glyph->advanceX_;
-                            if (i < unicodeText_.Size() - 1)
-                                rowWidth += face->GetKerning(c, unicodeText_[i + 1]);
-                        }
-                        if (rowWidth <= maxWidth)
-                        {
-                            printText_.Push(c);
-                            printToText_.Push(i);
-                        }
-                    }
+                    printText_.Push(unicodeText_[i]);
+                    printToText_.Push(i);
                 }
-                else
+            }
+            else
+                changeStart = wrapState_.print_;
+
+            // The kerning of the character before the change may differ too
+            unsigned printStart = 0;
+            for (unsigned i = changeStart; i > 1; --i)
+            {
+                if (printText_[i - 2] == '\n')
                 {
-                    printText_.Push('\n');
-                    printToText_.Push(Min(i, unicodeText_.Size() - 1));
-                    rowWidth = 0;
-                    nextBreak = lineStart = i;
+                    printStart = i - 1;
+                    break;
                 }
             }
-        }
 
-        rowWidth = 0;
+            if (wordWrap_)
+                WrapText(face, maxWidth, true);
 
-        for (unsigned i = 0; i < printText_.Size(); ++i)
-        {
-            unsigned c = printText_[i];
+            unsigned rowIndex = (unsigned)(LowerBound(rowStarts_.Begin(), rowStarts_.End(), printStart) - rowStarts_.Begin());
+            MeasureRows(face, rowIndex, printStart);
 
-            if (c != '\n')
+            charLocationsFrom_ = charLocationsDirty_ ? Min(charLocationsFrom_, printStart) : printStart;
+        }
+        else
+        {
+            const TextLayout* cached = face->GetTextLayout(unicodeText_, maxWidth);
+            if (cached)
             {
-                const FontGlyph* glyph = face->GetGlyph(c);
-                if (glyph)
-                {
-                    rowWidth += glyph->advanceX_;
-                    if (i < printText_.Size() - 1)
-                        rowWidth += face->GetKerning(c, printText_[i + 1]);
-                }
+                printText_ = cached->printText_;
+                printToText_ = cached->printToText_;
+                rowWidths_ = cached->rowWidths_;
+                rowStarts_ = cached->rowStarts_;
+                wrapState_ = cached->wrapState_;
             }
             else
             {
-                width = Max(width, rowWidth);
-                height += rowHeight;
-                rowWidths_.Push(rowWidth);
-                rowWidth = 0;
+                // First see if the text must be split up
+                if (!wordWrap_)
+                {
+                    printText_ = unicodeText_;
+                    printToText_.Resize(printText_.Size());
+                    for (unsigned i = 0; i < printText_.Size(); ++i)
+                        printToText_[i] = i;
+                }
+                else
+                    WrapText(face, maxWidth, false);
+
+                MeasureRows(face, 0, 0);
+
+                TextLayout* layout = face->AddTextLayout(unicodeText_, maxWidth);
+                if (layout)
+                {
+                    layout->printText_ = printText_;
+                    layout->printToText_ = printToText_;
+                    layout->rowWidths_ = rowWidths_;
+                    layout->rowStarts_ = rowStarts_;
+                    layout->wrapState_ = wrapState_;
+                }
             }
-        }
 
-        if (rowWidth)
-        {
-            width = Max(width, rowWidth);
-            height += rowHeight;
-            rowWidths_.Push(rowWidth);
+            charLocationsFrom_ = 0;
         }
 
+        layoutFace_ = face;
+        layoutMaxWidth_ = maxWidth;
+
+        for (unsigned i = 0; i < rowWidths_.Size(); ++i)
+            width = Max(width, (int)rowWidths_[i]);
+        height = rowWidths_.Size() * rowHeight;
+
         // Set at least one row height even if text is empty
         if (!height)
             height = rowHeight;
@@ -663,6 +750,10 @@ void Text::UpdateText(bool onResize)
     else
     {
         // No font, nothing to render
+        rowWidths_.Clear();
+        rowStarts_.Clear();
+        printText_.Clear();
+        layoutFace_.Reset();
         pageGlyphLocations_.Clear();
     }
 
@@ -676,22 +767,193 @@ void Text::UpdateText(bool onResize)
     }
 }
 
+void Text::WrapText(FontFace* face, int maxWidth, bool resume)
+{
+    unsigned i = 0;
+    unsigned nextBreak = 0;
+    unsigned lineStart = 0;
+    int rowWidth = 0;
+
+    if (resume)
+    {
+        // Continue from the start of the last row break, which is made again in case the text after it changed
+        i = wrapState_.char_;
+        nextBreak = wrapState_.nextBreak_;
+        lineStart = wrapState_.lineStart_;
+        rowWidth = wrapState_.rowWidth_;
+        printText_.Resize(wrapState_.print_);
+        printToText_.Resize(wrapState_.print_);
+    }
+    else
+    {
+        printText_.Clear();
+        printToText_.Clear();
+        wrapState_ = TextWrapState();
+    }
+
+    for (; i < unicodeText_.Size(); ++i)
+    {
+        TextWrapState state;
+        state.char_ = i;
+        state.print_ = printText_.Size();
+        state.nextBreak_ = nextBreak;
+        state.lineStart_ = lineStart;
+        state.rowWidth_ = rowWidth;
+
+        unsigned j;
+        unsigned c = unicodeText_[i];
+
+        if (c != '\n')
+        {
+            bool ok = true;
+
+            if (nextBreak <= i)
+            {
+                int futureRowWidth = rowWidth;
+                for (j = i; j < unicodeText_.Size(); ++j)
+                {
+                    unsigned d = unicodeText_[j];
+                    if (d == ' ' || d == '\n')
+                    {
+                        nextBreak = j;
+                        break;
+                    }
+                    const FontGlyph* glyph = face->GetGlyph(d);
+                    if (glyph)
+                    {
+                        futureRowWidth += glyph->advanceX_;
+                        if (j < unicodeText_.Size() - 1)
+                            futureRowWidth += face->GetKerning(d, unicodeText_[j + 1]);
+                    }
+                    if (d == '-' && futureRowWidth <= maxWidth)
+                    {
+                        nextBreak = j + 1;
+                        break;
+                    }
+                    if (futureRowWidth > maxWidth)
+                    {
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+
+            if (!ok)
+            {
+                // If did not find any breaks on the line, copy until j, or at least 1 char, to prevent infinite loop
+                if (nextBreak == lineStart)
+                {
+                    while (i < j)
+                    {
+                        printText_.Push(unicodeText_[i]);
+                        printToText_.Push(i);
+                        ++i;
+                    }
+                }
+                // Eliminate spaces that have been copied before the forced break
+                bool eliminated = false;
+                while (printText_.Size() && printText_.Back() == ' ')
+                {
+                    printText_.Pop();
+                    printToText_.Pop();
+                    eliminated = true;
+                }
+                // Resuming from here is not possible if spaces were eliminated, so keep the previous break then
+                if (!eliminated)
+                    wrapState_ = state;
+                printText_.Push('\n');
+                printToText_.Push(Min(i, unicodeText_.Size() - 1));
+                rowWidth = 0;
+                nextBreak = lineStart = i;
+            }
+
+            if (i < unicodeText_.Size())
+            {
+                // When copying a space, position is allowed to be over row width
+                c = unicodeText_[i];
+                const FontGlyph* glyph = face->GetGlyph(c);
+                if (glyph)
+                {
+                    rowWidth += glyph->advanceX_;
+                    if (i < unicodeText_.Size() - 1)
+                        rowWidth += face->GetKerning(c, unicodeText_[i + 1]);
+                }
+                if (rowWidth <= maxWidth)
+                {
+                    printText_.Push(c);
+                    printToText_.Push(i);
+                }
+            }
+        }
+        else
+        {
+            printText_.Push('\n');
+            printToText_.Push(Min(i, unicodeText_.Size() - 1));
+            rowWidth = 0;
+            nextBreak = lineStart = i;
+            wrapState_ = state;
+        }
+    }
+}
+
+void Text::MeasureRows(FontFace* face, unsigned rowIndex, unsigned printStart)
+{
+    rowWidths_.Resize(rowIndex);
+    rowStarts_.Resize(rowIndex);
+
+    int rowWidth = 0;
+    unsigned rowStart = printStart;
+
+    for (unsigned i = printStart; i < printText_.Size(); ++i)
+    {
+        unsigned c = printText_[i];
+
+        if (c != '\n')
+        {
+            const FontGlyph* glyph = face->GetGlyph(c);
+            if (glyph)
+            {
+                rowWidth += glyph->advanceX_;
+                if (i < printText_.Size() - 1)
+                    rowWidth += face->GetKerning(c, printText_[i + 1]);
+            }
+        }
+        else
+        {
+            rowWidths_.Push(rowWidth);
+            rowStarts_.Push(rowStart);
+            rowWidth = 0;
+            rowStart = i + 1;
+        }
+    }
+
+    if (rowWidth)
+    {
+        rowWidths_.Push(rowWidth);
+        rowStarts_.Push(rowStart);
+    }
+}
+
 void Text::UpdateCharLocations()
 {
     // Remember the font face to see if it's still valid when it's time to render
     FontFace* face = font_ ? font_->GetFace(fontSize_) : nullptr;
     if (!face)
         return;
-    fontFace_ = face;
 
     auto rowHeight = RoundToInt(rowSpacing_ * rowHeight_);
 
+    // When text was appended to, the rows before the changed ones keep their locations if they are left aligned
+    unsigned printStart = charLocationsFrom_;
+    if (face != fontFace_ || textAlignment_ != HA_LEFT || rowHeight <= 0 || printStart > printText_.Size() ||
+        pageGlyphLocations_.Size() != face->GetTextures().Size())
+        printStart = 0;
+    fontFace_ = face;
+    charLocationsFrom_ = 0;
+
     // Store position & size of each character, and locations per texture page
     unsigned numChars = unicodeText_.Size();
     charLocations_.Resize(numChars + 1);
-    pageGlyphLocations_.Resize(face->GetTextures().Size());
-    for (unsigned i = 0; i < pageGlyphLocations_.Size(); ++i)
-        pageGlyphLocations_[i].Clear();
 
     IntVector2 offset = font_->GetTotalGlyphOffset(fontSize_);
 
@@ -700,7 +962,45 @@ void Text::UpdateCharLocations()
     float x = Round(GetRowStartPosition(rowIndex) + offset.x_);
     float y = Round(offset.y_);
 
-    for (unsigned i = 0; i < printText_.Size(); ++i)
+    if (printStart)
+    {
+        rowIndex = (unsigned)(LowerBound(rowStarts_.Begin(), rowStarts_.End(), printStart) - rowStarts_.Begin());
+        x = Round(GetRowStartPosition(rowIndex) + offset.x_);
+        for (unsigned i = 0; i < rowIndex; ++i)
+            y += rowHeight;
+        lastFilled = printToText_[printStart - 1] + 1;
+
+        for (unsigned n = 0; n < pageGlyphLocations_.Size(); ++n)
+        {
+            PODVector<GlyphLocation>& pageGlyphLocation = pageGlyphLocations_[n];
+            while (pageGlyphLocation.Size() && pageGlyphLocation.Back().y_ >= y)
+                pageGlyphLocation.Pop();
+
+            // Keep the vertices of the remaining glyphs if each glyph is exactly one quad
+            if (n < pageVertexData_.Size())
+            {
+                const unsigned quadSize = 6 * UI_VERTEX_SIZE;
+                PODVector<float>& pageVertexData = pageVertexData_[n];
+                unsigned& pageVertexGlyphs = pageVertexGlyphs_[n];
+                if (pageVertexData.Size() == pageVertexGlyphs * quadSize)
+                {
+                    pageVertexGlyphs = Min(pageVertexGlyphs, pageGlyphLocation.Size());
+                    pageVertexData.Resize(pageVertexGlyphs * quadSize);
+                }
+                else
+                    glyphVerticesDirty_ = true;
+            }
+        }
+    }
+    else
+    {
+        pageGlyphLocations_.Resize(face->GetTextures().Size());
+        for (unsigned i = 0; i < pageGlyphLocations_.Size(); ++i)
+            pageGlyphLocations_[i].Clear();
+        glyphVerticesDirty_ = true;
+    }
+
+    for (unsigned i = printStart; i < printText_.Size(); ++i)
     {
         CharLocation loc;
         loc.position_ = Vector2(x, y);
@@ -735,9 +1035,11 @@ void Text::UpdateCharLocations()
             charLocations_[j] = loc;
         lastFilled = printToText_[i] + 1;
     }
-    // Store the ending position
+    // Store the ending position, also for trailing characters that were skipped from printing
     charLocations_[numChars].position_ = Vector2(x, y);
     charLocations_[numChars].size_ = Vector2::ZERO;
+    for (unsigned j = lastFilled; j < numChars; ++j)
+        charLocations_[j] = charLocations_[numChars];
 
     charLocationsDirty_ = false;
 }
@@ -785,7 +1087,7 @@ int Text::GetRowStartPosition(unsigned rowIndex) const
 }
 
 void Text::ConstructBatch(UIBatch& pageBatch, const PODVector<GlyphLocation>& pageGlyphLocation, float dx, float dy, Color* color,
-    float depthBias)
+    float depthBias, unsigned startIndex)
 {
     unsigned startDataSize = pageBatch.vertexData_->Size();
 
@@ -794,7 +1096,7 @@ void Text::ConstructBatch(UIBatch& pageBatch, const PODVector<GlyphLocation>& pa
     else
         pageBatch.SetColor(*color);
 
-    for (unsigned i = 0; i < pageGlyphLocation.Size(); ++i)
+    for (unsigned i = startIndex; i < pageGlyphLocation.Size(); ++i)
     {
         const GlyphLocation& glyphLocation = pageGlyphLocation[i];
         const FontGlyph& glyph = *glyphLocation.glyph_;
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "../UI/FontFace.h"
 #include "../UI/UISelectable.h"
 
 namespace Urho3D
@@ -30,8 +31,6 @@ namespace Urho3D
 static const float DEFAULT_FONT_SIZE = 12;
 
 class Font;
-class FontFace;
-struct FontGlyph;
 
 /// Text effect.
 enum TextEffect
@@ -84,10 +83,14 @@ public:
     /// Register object factory.
     static void RegisterObject(Context* context);
 
+    /// Handle attribute write access. Marks the glyph vertices dirty.
+    void OnSetAttribute(const AttributeInfo& attr, const Variant& src) override;
     /// Apply attribute changes that can not be applied immediately.
     void ApplyAttributes() override;
     /// Return UI rendering batches.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the cached rendering batches can be reused. Not while the font face or character locations are changing.
+    bool CanCacheBatches() const override;
     /// React to resize.
     void OnResize(const IntVector2& newSize, const IntVector2& delta) override;
     /// React to indent change.
@@ -101,6 +104,8 @@ public:
     bool SetFontSize(float size);
     /// Set text. Text is assumed to be either ASCII or UTF8-encoded.
     void SetText(const String& text);
+    /// Append to text. Only the rows from the last row break onward are laid out again.
+    void AppendText(const String& text);
     /// Set row alignment.
     void SetTextAlignment(HorizontalAlignment align);
     /// Set row spacing, 1.0 for original font spacing.
@@ -204,6 +209,10 @@ protected:
     void UpdateText(bool onResize = false);
     /// Update cached character locations after text update, or when text alignment or indent has changed.
     void UpdateCharLocations();
+    /// Word wrap the text into printed form, optionally resuming from the last row break.
+    void WrapText(FontFace* face, int maxWidth, bool resume);
+    /// Measure row widths of the printed text, starting from a row.
+    void MeasureRows(FontFace* face, unsigned rowIndex, unsigned printStart);
     /// Validate text selection to be within the text.
     void ValidateSelection();
     /// Return row start X position.
@@ -211,7 +220,7 @@ protected:
     /// Construct batch.
     void ConstructBatch
         (UIBatch& pageBatch, const PODVector<GlyphLocation>& pageGlyphLocation, float dx = 0, float dy = 0, Color* color = nullptr,
-            float depthBias = 0.0f);
+            float depthBias = 0.0f, unsigned startIndex = 0);
 
     /// Font.
     SharedPtr<Font> font_;
@@ -255,10 +264,36 @@ protected:
     PODVector<unsigned> printToText_;
     /// Row widths.
     PODVector<float> rowWidths_;
+    /// Printed text index where each row starts.
+    PODVector<unsigned> rowStarts_;
+    /// Word wrapping state at the start of the last row break.
+    TextWrapState wrapState_;
+    /// Font face the layout was made with.
+    WeakPtr<FontFace> layoutFace_;
+    /// Maximum row width the layout was made with, M_MAX_INT when not wrapping.
+    int layoutMaxWidth_;
+    /// Index of the first appended character for the next text update, M_MAX_UNSIGNED when not appending.
+    unsigned appendStart_;
+    /// Printed text index from which the char locations need updating.
+    unsigned charLocationsFrom_;
     /// Glyph locations per each texture in the font.
     Vector<PODVector<GlyphLocation> > pageGlyphLocations_;
     /// Cached locations of each character in the text.
     PODVector<CharLocation> charLocations_;
+    /// Glyph vertex data per texture page, reused while the glyph locations and colors stay the same.
+    Vector<PODVector<float> > pageVertexData_;
+    /// Number of glyph locations per texture page included in the glyph vertex data.
+    PODVector<unsigned> pageVertexGlyphs_;
+    /// Screen position of the glyph vertex data.
+    IntVector2 glyphVertexPosition_;
+    /// Derived color the glyph vertex data was generated with.
+    Color glyphVertexColor_;
+    /// Derived opacity the glyph vertex data was generated with.
+    float glyphVertexOpacity_;
+    /// Font face glyph version the glyph vertex data was generated with.
+    unsigned glyphVertexVersion_;
+    /// Glyph vertex data dirty flag.
+    bool glyphVerticesDirty_;
     /// The text will be automatically translated.
     bool autoLocalizable_;
     /// Localization string id storage. Used when autoLocalizable flag is set.
@@ -33,6 +33,7 @@
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Node.h"
 #include "../UI/Font.h"
+#include "../UI/FontFace.h"
 #include "../UI/Text.h"
 #include "../UI/Text3D.h"
 
@@ -59,7 +60,8 @@ Text3D::Text3D(Context* context) :
     textDirty_(true),
     geometryDirty_(true),
     usingSDFShader_(false),
-    fontDataLost_(false)
+    fontDataLost_(false),
+    glyphVersion_(0)
 {
     text_.SetEffectDepthBias(DEFAULT_EFFECT_DEPTH_BIAS);
 }
@@ -133,6 +135,11 @@ void Text3D::UpdateBatches(const FrameInfo& frame)
             break;
         }
     }
+
+    // Glyphs rasterized in the background or evicted from the glyph atlas change without the texture losing data
+    FontFace* glyphFace = glyphFace_.Get();
+    if (glyphFace && glyphFace->GetGlyphVersion() != glyphVersion_)
+        fontDataLost_ = true;
 }
 
 void Text3D::UpdateGeometry(const FrameInfo& frame)
@@ -575,6 +582,11 @@ void Text3D::UpdateTextBatches()
 
     text_.GetBatches(uiBatches_, uiVertexData_, IntRect::ZERO);
 
+    Font* font = text_.GetFont();
+    FontFace* face = font ? font->GetFace(text_.GetFontSize()) : nullptr;
+    glyphFace_ = face && face->HasMutableGlyphs() ? face : nullptr;
+    glyphVersion_ = face ? face->GetGlyphVersion() : 0;
+
     Vector3 offset(Vector3::ZERO);
 
     switch (text_.GetHorizontalAlignment())
@@ -214,6 +214,10 @@ protected:
     bool usingSDFShader_;
     /// Font texture data lost flag.
     bool fontDataLost_;
+    /// Font face whose glyphs change in place, tracked for rebuilding the text.
+    WeakPtr<FontFace> glyphFace_;
+    /// Glyph version of the tracked font face when the text was built.
+    unsigned glyphVersion_;
 };
 
 }
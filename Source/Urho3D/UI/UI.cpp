@@ -47,6 +47,7 @@
 #include "../UI/DropDownList.h"
 #include "../UI/FileSelector.h"
 #include "../UI/Font.h"
+#include "../UI/FontGlyphAtlas.h"
 #include "../UI/LineEdit.h"
 #include "../UI/ListView.h"
 #include "../UI/MessageBox.h"
@@ -116,6 +117,7 @@ UI::UI(Context* context) :
     useScreenKeyboard_(false),
 #endif
     useMutableGlyphs_(false),
+    useBatchCache_(true),
     forceAutoHint_(false),
     fontHintLevel_(FONT_HINT_LEVEL_NORMAL),
     fontSubpixelThreshold_(12),
@@ -416,6 +418,10 @@ void UI::RenderUpdate()
 
     uiRendered_ = false;
 
+    // Store glyphs rasterized in the background, so that they are used by the batches below
+    if (glyphAtlas_)
+        glyphAtlas_->Update();
+
     // If the OS cursor is visible, do not render the UI's own cursor
     bool osCursorVisible = GetSubsystem<Input>()->IsMouseVisible();
 
@@ -666,6 +672,7 @@ void UI::SetMaxFontTextureSize(int size)
         {
             maxFontTextureSize_ = size;
             ReleaseFontFaces();
+            glyphAtlas_.Reset();
         }
     }
 }
@@ -694,6 +701,18 @@ void UI::SetUseMutableGlyphs(bool enable)
     }
 }
 
+void UI::SetUseBatchCache(bool enable)
+{
+    useBatchCache_ = enable;
+}
+
+FontGlyphAtlas* UI::GetGlyphAtlas()
+{
+    if (!glyphAtlas_)
+        glyphAtlas_ = new FontGlyphAtlas(context_, maxFontTextureSize_);
+    return glyphAtlas_;
+}
+
 void UI::SetForceAutoHint(bool enable)
 {
     if (enable != forceAutoHint_)
@@ -935,6 +954,7 @@ void UI::Initialize()
     ResizeRootElement();
 
     vertexBuffer_ = new VertexBuffer(context_);
+    vertexBuffer_->SetShadowed(true);
     debugVertexBuffer_ = new VertexBuffer(context_);
 
     initialized_ = true;
@@ -969,10 +989,56 @@ void UI::SetVertexData(VertexBuffer* dest, const PODVector<float>& vertexData)
     // Update quad geometry into the vertex buffer
     // Resize the vertex buffer first if too small or much too large
     unsigned numVertices = vertexData.Size() / UI_VERTEX_SIZE;
-    if (dest->GetVertexCount() < numVertices || dest->GetVertexCount() > numVertices * 2)
-        dest->SetSize(numVertices, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1, true);
+    bool resized = dest->GetVertexCount() < numVertices || dest->GetVertexCount() > numVertices * 2;
+    if (resized)
+    {
+        // Shadowed buffers are partially updated, so they are created static to allow range updates on all APIs
+        dest->SetSize(numVertices, MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1, !dest->IsShadowed());
+    }
+
+    // Without the previous frame's data to compare against, upload everything
+    const unsigned char* shadowData = dest->GetShadowData();
+    if (resized || !shadowData)
+    {
+        dest->SetData(&vertexData[0]);
+        return;
+    }
+
+    // Compare against the previous frame quad by quad and upload only the changed ranges. Ranges separated by a small
+    // gap are merged, and if the changes are scattered the whole changed span is uploaded in one call
+    static const unsigned QUAD_VERTICES = 6;
+    static const unsigned MERGE_GAP_VERTICES = 4 * QUAD_VERTICES;
+    static const unsigned MAX_UPLOAD_RANGES = 8;
 
-    dest->SetData(&vertexData[0]);
+    const auto* newData = reinterpret_cast<const unsigned char*>(&vertexData[0]);
+    unsigned vertexSize = dest->GetVertexSize();
+    PODVector<Pair<unsigned, unsigned> > ranges;
+    for (unsigned start = 0; start < numVertices; start += QUAD_VERTICES)
+    {
+        unsigned count = Min(QUAD_VERTICES, numVertices - start);
+        if (!memcmp(newData + start * vertexSize, shadowData + start * vertexSize, count * vertexSize))
+            continue;
+
+        if (!ranges.Empty() && start <= ranges.Back().second_ + MERGE_GAP_VERTICES)
+            ranges.Back().second_ = start + count;
+        else
+            ranges.Push(MakePair(start, start + count));
+    }
+
+    if (ranges.Empty())
+        return;
+
+    if (ranges.Size() > MAX_UPLOAD_RANGES)
+    {
+        ranges.Front().second_ = ranges.Back().second_;
+        ranges.Resize(1);
+    }
+
+    for (unsigned i = 0; i < ranges.Size(); ++i)
+    {
+        unsigned start = ranges[i].first_;
+        dest->SetDataRange(newData + start * vertexSize, start, ranges[i].second_ - start);
+    }
 }
 
 void UI::Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd)
@@ -1173,7 +1239,7 @@ void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, U
             while (j != children.End() && (*j)->GetPriority() == currentPriority)
             {
                 if ((*j)->IsWithinScissor(currentScissor) && (*j) != cursor_)
-                    (*j)->GetBatches(batches, vertexData, currentScissor);
+                    GetElementBatches(batches, vertexData, *j, currentScissor);
                 ++j;
             }
             // Now recurse into the children
@@ -1193,7 +1259,7 @@ void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, U
             if ((*i) != cursor_)
             {
                 if ((*i)->IsWithinScissor(currentScissor))
-                    (*i)->GetBatches(batches, vertexData, currentScissor);
+                    GetElementBatches(batches, vertexData, *i, currentScissor);
                 if ((*i)->IsVisible())
                     GetBatches(batches, vertexData, *i, currentScissor);
             }
@@ -1202,6 +1268,15 @@ void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, U
     }
 }
 
+void UI::GetElementBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element,
+    const IntRect& currentScissor)
+{
+    if (useBatchCache_)
+        element->GetBatchesCached(batches, vertexData, currentScissor);
+    else
+        element->GetBatches(batches, vertexData, currentScissor);
+}
+
 void UI::GetElementAt(UIElement*& result, UIElement* current, const IntVector2& position, bool enabledOnly)
 {
     if (!current)
@@ -2183,6 +2258,7 @@ void UI::SetElementRenderTexture(UIElement* element, Texture2D* texture)
         data.texture_ = texture;
         data.rootElement_ = element;
         data.vertexBuffer_ = new VertexBuffer(context_);
+        data.vertexBuffer_->SetShadowed(true);
         data.debugVertexBuffer_ = new VertexBuffer(context_);
         renderToTexture_[element] = data;
     }
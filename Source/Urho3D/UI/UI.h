@@ -44,6 +44,7 @@ enum FontHintLevel
 };
 
 class Cursor;
+class FontGlyphAtlas;
 class Graphics;
 class ResourceCache;
 class Timer;
@@ -108,8 +109,10 @@ public:
     void SetUseSystemClipboard(bool enable);
     /// Set whether to show the on-screen keyboard (if supported) when a %LineEdit is focused. Default true on mobile devices.
     void SetUseScreenKeyboard(bool enable);
-    /// Set whether to use mutable (eraseable) glyphs to ensure a font face never expands to more than one texture. Default false.
+    /// Set whether to use mutable (eraseable) glyphs to ensure font faces never expand to more than one texture. FreeType glyphs are then rasterized on first use in the background into an atlas shared by all faces, and the least recently used glyphs are erased when it fills up. Default false.
     void SetUseMutableGlyphs(bool enable);
+    /// Set whether elements reuse their rendering batches from the previous frame when unchanged. Default true.
+    void SetUseBatchCache(bool enable);
     /// Set whether to force font autohinting instead of using FreeType's TTF bytecode interpreter.
     void SetForceAutoHint(bool enable);
     /// Set the hinting level used by FreeType fonts.
@@ -193,6 +196,12 @@ public:
     /// Return whether is using mutable (eraseable) glyphs for fonts.
     bool GetUseMutableGlyphs() const { return useMutableGlyphs_; }
 
+    /// Return whether elements reuse their rendering batches from the previous frame when unchanged.
+    bool GetUseBatchCache() const { return useBatchCache_; }
+
+    /// Return the glyph atlas shared by font faces when using mutable glyphs. Created on first use.
+    FontGlyphAtlas* GetGlyphAtlas();
+
     /// Return whether is using forced autohinting.
     bool GetForceAutoHint() const { return forceAutoHint_; }
 
@@ -269,6 +278,8 @@ private:
     void Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd);
     /// Generate batches from an UI element recursively. Skip the cursor element.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, IntRect currentScissor);
+    /// Generate batches from a single UI element, reusing its cached batches if enabled.
+    void GetElementBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, const IntRect& currentScissor);
     /// Return UI element at global screen coordinates. Return position converted to element's screen coordinates.
     UIElement* GetElementAt(const IntVector2& position, bool enabledOnly, IntVector2* elementScreenPosition);
     /// Return UI element at screen position recursively.
@@ -363,6 +374,8 @@ private:
     SharedPtr<VertexBuffer> vertexBuffer_;
     /// UI debug geometry vertex buffer.
     SharedPtr<VertexBuffer> debugVertexBuffer_;
+    /// Glyph atlas for mutable glyphs.
+    SharedPtr<FontGlyphAtlas> glyphAtlas_;
     /// UI element query vector.
     PODVector<UIElement*> tempElements_;
     /// Clipboard text.
@@ -395,6 +408,8 @@ private:
     bool useScreenKeyboard_;
     /// Flag for using mutable (erasable) font glyphs.
     bool useMutableGlyphs_;
+    /// Flag for reusing cached element rendering batches.
+    bool useBatchCache_;
     /// Flag for forcing FreeType auto hinting.
     bool forceAutoHint_;
     /// FreeType hinting level (default is FONT_HINT_LEVEL_NORMAL).
@@ -166,6 +166,14 @@ void UIElement::ApplyAttributes()
         if (colors_[i] != colors_[0])
             colorGradient_ = true;
     }
+
+    MarkBatchesDirty();
+}
+
+void UIElement::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
+{
+    Animatable::OnSetAttribute(attr, src);
+    MarkBatchesDirty();
 }
 
 bool UIElement::LoadXML(const XMLElement& source)
@@ -346,6 +354,67 @@ void UIElement::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertex
     hovering_ = false;
 }
 
+void UIElement::GetBatchesCached(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
+{
+    const IntVector2& screenPosition = GetScreenPosition();
+    bool focus = HasFocus();
+
+    if (batchesDirty_ || !CanCacheBatches() || currentScissor != cachedScissor_ || size_ != cachedSize_ ||
+        hovering_ != cachedHovering_ || selected_ != cachedSelected_ || enabled_ != cachedEnabled_ || focus != cachedFocus_ ||
+        GetIndentWidth() != cachedIndentWidth_ || GetDerivedOpacity() != cachedOpacity_ || GetDerivedColor() != cachedColor_)
+    {
+        cachedScissor_ = currentScissor;
+        cachedScreenPosition_ = screenPosition;
+        cachedSize_ = size_;
+        cachedColor_ = GetDerivedColor();
+        cachedOpacity_ = GetDerivedOpacity();
+        cachedIndentWidth_ = GetIndentWidth();
+        cachedHovering_ = hovering_;
+        cachedSelected_ = selected_;
+        cachedEnabled_ = enabled_;
+        cachedFocus_ = focus;
+
+        cachedBatches_.Clear();
+        cachedVertexData_.Clear();
+        GetBatches(cachedBatches_, cachedVertexData_, currentScissor);
+        cachedHoveringAfter_ = hovering_;
+        batchesDirty_ = false;
+    }
+    else
+    {
+        // Only moved: translate the vertices instead of generating them again
+        if (screenPosition != cachedScreenPosition_)
+        {
+            Vector2 delta((float)(screenPosition.x_ - cachedScreenPosition_.x_), (float)(screenPosition.y_ - cachedScreenPosition_.y_));
+            for (unsigned i = 0; i < cachedVertexData_.Size(); i += UI_VERTEX_SIZE)
+            {
+                cachedVertexData_[i] += delta.x_;
+                cachedVertexData_[i + 1] += delta.y_;
+            }
+            cachedScreenPosition_ = screenPosition;
+        }
+
+        // Batch generation resets hovering for the next frame
+        hovering_ = cachedHoveringAfter_;
+    }
+
+    if (cachedBatches_.Empty())
+        return;
+
+    unsigned vertexStart = vertexData.Size();
+    vertexData.Resize(vertexStart + cachedVertexData_.Size());
+    memcpy(&vertexData[vertexStart], &cachedVertexData_[0], cachedVertexData_.Size() * sizeof(float));
+
+    for (PODVector<UIBatch>::ConstIterator i = cachedBatches_.Begin(); i != cachedBatches_.End(); ++i)
+    {
+        UIBatch batch(*i);
+        batch.vertexData_ = &vertexData;
+        batch.vertexStart_ += vertexStart;
+        batch.vertexEnd_ += vertexStart;
+        UIBatch::AddOrMerge(batch, batches);
+    }
+}
+
 void UIElement::GetDebugDrawBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
 {
     UIBatch batch(this, BLEND_ALPHA, currentScissor, nullptr, &vertexData);
@@ -825,6 +894,7 @@ void UIElement::SetColor(const Color& color)
         cornerColor = color;
     colorGradient_ = false;
     derivedColorDirty_ = true;
+    MarkBatchesDirty();
 }
 
 void UIElement::SetColor(Corner corner, const Color& color)
@@ -838,6 +908,8 @@ void UIElement::SetColor(Corner corner, const Color& color)
         if (i != corner && colors_[i] != colors_[corner])
             colorGradient_ = true;
     }
+
+    MarkBatchesDirty();
 }
 
 void UIElement::SetPriority(int priority)
@@ -131,6 +131,8 @@ public:
 
     /// Apply attribute changes that can not be applied immediately.
     void ApplyAttributes() override;
+    /// Handle attribute write access. Marks cached batches dirty.
+    void OnSetAttribute(const AttributeInfo& attr, const Variant& src) override;
     /// Load from XML data. Return true if successful.
     bool LoadXML(const XMLElement& source) override;
     /// Load from XML data with style. Return true if successful.
@@ -148,6 +150,8 @@ public:
     virtual const IntVector2& GetScreenPosition() const;
     /// Return UI rendering batches.
     virtual void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
+    /// Return whether batches generated on an earlier frame may be reused when no common state has changed and MarkBatchesDirty() has not been called. Elements whose appearance can change otherwise should return false.
+    virtual bool CanCacheBatches() const { return true; }
     /// Return UI rendering batches for debug draw.
     virtual void GetDebugDrawBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
     /// React to mouse hover.
@@ -630,6 +634,10 @@ public:
     void AdjustScissor(IntRect& currentScissor);
     /// Get UI rendering batches with a specified offset. Also recurse to child elements.
     void GetBatchesWithOffset(IntVector2& offset, PODVector<UIBatch>& batches, PODVector<float>& vertexData, IntRect currentScissor);
+    /// Get UI rendering batches, reusing those generated on an earlier frame if the element has not changed. Only translated if the element has moved.
+    void GetBatchesCached(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor);
+    /// Mark cached batches dirty so that they are generated again on the next render update.
+    void MarkBatchesDirty() { batchesDirty_ = true; }
 
     /// Return color attribute. Uses just the top-left color.
     const Color& GetColorAttr() const { return colors_[0]; }
@@ -814,6 +822,34 @@ private:
     static XPathQuery styleXPathQuery_;
     /// Tag list.
     StringVector tags_;
+    /// Batches generated on an earlier frame. Vertex ranges refer to the cached vertex data.
+    PODVector<UIBatch> cachedBatches_;
+    /// Vertex data of the cached batches.
+    PODVector<float> cachedVertexData_;
+    /// Scissor the cached batches were generated with.
+    IntRect cachedScissor_;
+    /// Screen position of the cached vertex data.
+    IntVector2 cachedScreenPosition_;
+    /// Size the cached batches were generated with.
+    IntVector2 cachedSize_;
+    /// Derived color the cached batches were generated with.
+    Color cachedColor_;
+    /// Derived opacity the cached batches were generated with.
+    float cachedOpacity_{};
+    /// Indent width the cached batches were generated with.
+    int cachedIndentWidth_{};
+    /// Hovering state the cached batches were generated with.
+    bool cachedHovering_{};
+    /// Hovering state after generating the cached batches, restored when reusing them.
+    bool cachedHoveringAfter_{};
+    /// Selected state the cached batches were generated with.
+    bool cachedSelected_{};
+    /// Enabled state the cached batches were generated with.
+    bool cachedEnabled_{};
+    /// Focus state the cached batches were generated with.
+    bool cachedFocus_{};
+    /// Cached batches dirty flag.
+    bool batchesDirty_{true};
 };
 
 template <class T> T* UIElement::CreateChild(const String& name, unsigned index)
@@ -294,6 +294,14 @@ URHO3D_EVENT(E_ITEMCLICKED, ItemClicked)
     URHO3D_PARAM(P_QUALIFIERS, Qualifiers);        // int
 }
 
+/// Listview row in virtual mode needs to be filled with the contents of an item.
+URHO3D_EVENT(E_VIRTUALITEMBIND, VirtualItemBind)
+{
+    URHO3D_PARAM(P_ELEMENT, Element);              // UIElement pointer
+    URHO3D_PARAM(P_ITEM, Item);                    // UIElement pointer
+    URHO3D_PARAM(P_INDEX, Index);                  // int
+}
+
 /// Listview item double clicked.
 URHO3D_EVENT(E_ITEMDOUBLECLICKED, ItemDoubleClicked)
 {
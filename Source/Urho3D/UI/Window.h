@@ -57,6 +57,8 @@ public:
 
     /// Return UI rendering batches.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the cached rendering batches can be reused. Not while modal, as the modal shade covers the whole root.
+    bool CanCacheBatches() const override { return !modal_; }
 
     /// React to mouse hover.
     void OnHover(const IntVector2& position, const IntVector2& screenPosition, int buttons, int qualifiers, Cursor* cursor) override;
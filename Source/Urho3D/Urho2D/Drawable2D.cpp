@@ -30,11 +30,16 @@
 #include "../Urho2D/Drawable2D.h"
 #include "../Urho2D/Renderer2D.h"
 
+#include <atomic>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Counter for source batch versions, shared by all drawables so that a version is never reused.
+static std::atomic<unsigned> sourceBatchesVersionCounter{};
+
 const float PIXEL_SIZE = 0.01f;
 
 SourceBatch2D::SourceBatch2D() :
@@ -47,7 +52,8 @@ Drawable2D::Drawable2D(Context* context) :
     Drawable(context, DRAWABLE_GEOMETRY2D),
     layer_(0),
     orderInLayer_(0),
-    sourceBatchesDirty_(true)
+    sourceBatchesDirty_(true),
+    sourceBatchesVersion_(0)
 {
 }
 
@@ -99,7 +105,11 @@ void Drawable2D::SetOrderInLayer(int orderInLayer)
 const Vector<SourceBatch2D>& Drawable2D::GetSourceBatches()
 {
     if (sourceBatchesDirty_)
+    {
         UpdateSourceBatches();
+        // May be called from worker threads during visibility checks, so use an atomic counter
+        sourceBatchesVersion_ = ++sourceBatchesVersionCounter;
+    }
 
     return sourceBatches_;
 }
@@ -95,6 +95,9 @@ public:
     /// Return all source batches (called by Renderer2D).
     const Vector<SourceBatch2D>& GetSourceBatches();
 
+    /// Return source batches version. Changes whenever the source batches are updated, and is unique among all drawables.
+    unsigned GetSourceBatchesVersion() const { return sourceBatchesVersion_; }
+
 protected:
     /// Handle scene being assigned.
     void OnSceneSet(Scene* scene) override;
@@ -116,6 +119,8 @@ protected:
     Vector<SourceBatch2D> sourceBatches_;
     /// Source batches dirty flag.
     bool sourceBatchesDirty_;
+    /// Source batches version.
+    unsigned sourceBatchesVersion_;
     /// Renderer2D.
     WeakPtr<Renderer2D> renderer_;
 };
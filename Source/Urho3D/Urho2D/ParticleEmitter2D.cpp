@@ -23,6 +23,8 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/Material.h"
 #include "../Resource/ResourceCache.h"
@@ -34,6 +36,10 @@
 #include "../Urho2D/Sprite2D.h"
 #include "../Urho2D/Urho2DEvents.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -42,6 +48,313 @@ namespace Urho3D
 extern const char* URHO2D_CATEGORY;
 extern const char* blendModeNames[];
 
+/// Minimum number of particles updated per work item.
+static const unsigned MIN_PARTICLES_PER_WORK_ITEM = 4096;
+
+/// Per-frame 2D particle update values, resolved from the particle effect once instead of per particle.
+struct ParticleUpdateParams2D
+{
+    /// Timestep.
+    float timeStep_;
+    /// Gravity X, scaled to world units.
+    float gravityX_;
+    /// Gravity Y, scaled to world units.
+    float gravityY_;
+    /// Radial emitter type flag.
+    bool radial_;
+};
+
+/// 2D particle index range updated by one work item, and the bounding box of the updated particles.
+struct ParticleUpdateRange2D
+{
+    /// Particles.
+    ParticleData2D* particles_;
+    /// Update values.
+    const ParticleUpdateParams2D* params_;
+    /// Start index.
+    unsigned start_;
+    /// End index.
+    unsigned end_;
+    /// Bounding box min point.
+    Vector3 boundingBoxMin_;
+    /// Bounding box max point.
+    Vector3 boundingBoxMax_;
+};
+
+/// Update one particle. The values are read into locals first, as stores to the particle arrays could otherwise alias them.
+static inline void UpdateParticle(ParticleData2D& p, unsigned i, const ParticleUpdateParams2D& params, Vector3& boundingBoxMin,
+    Vector3& boundingBoxMax)
+{
+    float timeToLive = p.timeToLive_[i];
+    float timeStep = params.timeStep_;
+    if (timeStep > timeToLive)
+        timeStep = timeToLive;
+
+    p.timeToLive_[i] = timeToLive - timeStep;
+
+    float positionX;
+    float positionY;
+    if (params.radial_)
+    {
+        float emitRotation = p.emitRotation_[i] + p.emitRotationDelta_[i] * timeStep;
+        float emitRadius = p.emitRadius_[i] + p.emitRadiusDelta_[i] * timeStep;
+        p.emitRotation_[i] = emitRotation;
+        p.emitRadius_[i] = emitRadius;
+
+        positionX = p.startPosX_[i] - Cos(emitRotation) * emitRadius;
+        positionY = p.startPosY_[i] + Sin(emitRotation) * emitRadius;
+    }
+    else
+    {
+        positionX = p.positionX_[i];
+        positionY = p.positionY_[i];
+        float distanceX = positionX - p.startPosX_[i];
+        float distanceY = positionY - p.startPosY_[i];
+
+        float distanceScalar = Vector2(distanceX, distanceY).Length();
+        if (distanceScalar < 0.0001f)
+            distanceScalar = 0.0001f;
+
+        float radialX = distanceX / distanceScalar;
+        float radialY = distanceY / distanceScalar;
+
+        float tangentialX = radialX;
+        float tangentialY = radialY;
+
+        float radialAcceleration = p.radialAcceleration_[i];
+        float tangentialAcceleration = p.tangentialAcceleration_[i];
+        radialX *= radialAcceleration;
+        radialY *= radialAcceleration;
+
+        float newY = tangentialX;
+        tangentialX = -tangentialY * tangentialAcceleration;
+        tangentialY = newY * tangentialAcceleration;
+
+        float velocityX = p.velocityX_[i] + (params.gravityX_ + radialX - tangentialX) * timeStep;
+        float velocityY = p.velocityY_[i] - (params.gravityY_ - radialY + tangentialY) * timeStep;
+        p.velocityX_[i] = velocityX;
+        p.velocityY_[i] = velocityY;
+        positionX += velocityX * timeStep;
+        positionY += velocityY * timeStep;
+    }
+
+    p.positionX_[i] = positionX;
+    p.positionY_[i] = positionY;
+
+    float size = p.size_[i] + p.sizeDelta_[i] * timeStep;
+    p.size_[i] = size;
+    p.rotation_[i] += p.rotationDelta_[i] * timeStep;
+    p.colorR_[i] += p.colorDeltaR_[i] * timeStep;
+    p.colorG_[i] += p.colorDeltaG_[i] * timeStep;
+    p.colorB_[i] += p.colorDeltaB_[i] * timeStep;
+    p.colorA_[i] += p.colorDeltaA_[i] * timeStep;
+
+    float positionZ = p.positionZ_[i];
+    float halfSize = size * 0.5f;
+    boundingBoxMin.x_ = Min(boundingBoxMin.x_, positionX - halfSize);
+    boundingBoxMin.y_ = Min(boundingBoxMin.y_, positionY - halfSize);
+    boundingBoxMin.z_ = Min(boundingBoxMin.z_, positionZ);
+    boundingBoxMax.x_ = Max(boundingBoxMax.x_, positionX + halfSize);
+    boundingBoxMax.y_ = Max(boundingBoxMax.y_, positionY + halfSize);
+    boundingBoxMax.z_ = Max(boundingBoxMax.z_, positionZ);
+}
+
+#ifdef URHO3D_SSE
+/// Update four particles at once.
+static inline void UpdateFourParticles(ParticleData2D& p, unsigned i, const ParticleUpdateParams2D& params,
+    __m128& minX, __m128& minY, __m128& minZ, __m128& maxX, __m128& maxY, __m128& maxZ)
+{
+    __m128 timeToLive = _mm_loadu_ps(&p.timeToLive_[i]);
+    __m128 timeStep = _mm_min_ps(timeToLive, _mm_set1_ps(params.timeStep_));
+    _mm_storeu_ps(&p.timeToLive_[i], _mm_sub_ps(timeToLive, timeStep));
+
+    __m128 positionX;
+    __m128 positionY;
+    if (params.radial_)
+    {
+        __m128 emitRotation = _mm_add_ps(_mm_loadu_ps(&p.emitRotation_[i]),
+            _mm_mul_ps(_mm_loadu_ps(&p.emitRotationDelta_[i]), timeStep));
+        __m128 emitRadius = _mm_add_ps(_mm_loadu_ps(&p.emitRadius_[i]),
+            _mm_mul_ps(_mm_loadu_ps(&p.emitRadiusDelta_[i]), timeStep));
+        _mm_storeu_ps(&p.emitRotation_[i], emitRotation);
+        _mm_storeu_ps(&p.emitRadius_[i], emitRadius);
+
+        // There is no vector sine and cosine, so calculate them one particle at a time
+        float rotations[4];
+        float cosines[4];
+        float sines[4];
+        _mm_storeu_ps(rotations, emitRotation);
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            cosines[j] = Cos(rotations[j]);
+            sines[j] = Sin(rotations[j]);
+        }
+        positionX = _mm_sub_ps(_mm_loadu_ps(&p.startPosX_[i]), _mm_mul_ps(_mm_loadu_ps(cosines), emitRadius));
+        positionY = _mm_add_ps(_mm_loadu_ps(&p.startPosY_[i]), _mm_mul_ps(_mm_loadu_ps(sines), emitRadius));
+    }
+    else
+    {
+        positionX = _mm_loadu_ps(&p.positionX_[i]);
+        positionY = _mm_loadu_ps(&p.positionY_[i]);
+        __m128 distanceX = _mm_sub_ps(positionX, _mm_loadu_ps(&p.startPosX_[i]));
+        __m128 distanceY = _mm_sub_ps(positionY, _mm_loadu_ps(&p.startPosY_[i]));
+        __m128 distanceScalar = _mm_max_ps(_mm_set1_ps(0.0001f),
+            _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(distanceX, distanceX), _mm_mul_ps(distanceY, distanceY))));
+        __m128 radialX = _mm_div_ps(distanceX, distanceScalar);
+        __m128 radialY = _mm_div_ps(distanceY, distanceScalar);
+        __m128 radialAcceleration = _mm_loadu_ps(&p.radialAcceleration_[i]);
+        __m128 tangentialAcceleration = _mm_loadu_ps(&p.tangentialAcceleration_[i]);
+
+        // Subtracting the negated tangential term is the same as adding it
+        __m128 accelX = _mm_add_ps(_mm_add_ps(_mm_set1_ps(params.gravityX_), _mm_mul_ps(radialX, radialAcceleration)),
+            _mm_mul_ps(radialY, tangentialAcceleration));
+        __m128 accelY = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(params.gravityY_), _mm_mul_ps(radialY, radialAcceleration)),
+            _mm_mul_ps(radialX, tangentialAcceleration));
+        __m128 velocityX = _mm_add_ps(_mm_loadu_ps(&p.velocityX_[i]), _mm_mul_ps(accelX, timeStep));
+        __m128 velocityY = _mm_sub_ps(_mm_loadu_ps(&p.velocityY_[i]), _mm_mul_ps(accelY, timeStep));
+        _mm_storeu_ps(&p.velocityX_[i], velocityX);
+        _mm_storeu_ps(&p.velocityY_[i], velocityY);
+        positionX = _mm_add_ps(positionX, _mm_mul_ps(velocityX, timeStep));
+        positionY = _mm_add_ps(positionY, _mm_mul_ps(velocityY, timeStep));
+    }
+
+    _mm_storeu_ps(&p.positionX_[i], positionX);
+    _mm_storeu_ps(&p.positionY_[i], positionY);
+
+    __m128 size = _mm_add_ps(_mm_loadu_ps(&p.size_[i]), _mm_mul_ps(_mm_loadu_ps(&p.sizeDelta_[i]), timeStep));
+    _mm_storeu_ps(&p.size_[i], size);
+    _mm_storeu_ps(&p.rotation_[i],
+        _mm_add_ps(_mm_loadu_ps(&p.rotation_[i]), _mm_mul_ps(_mm_loadu_ps(&p.rotationDelta_[i]), timeStep)));
+    _mm_storeu_ps(&p.colorR_[i], _mm_add_ps(_mm_loadu_ps(&p.colorR_[i]), _mm_mul_ps(_mm_loadu_ps(&p.colorDeltaR_[i]), timeStep)));
+    _mm_storeu_ps(&p.colorG_[i], _mm_add_ps(_mm_loadu_ps(&p.colorG_[i]), _mm_mul_ps(_mm_loadu_ps(&p.colorDeltaG_[i]), timeStep)));
+    _mm_storeu_ps(&p.colorB_[i], _mm_add_ps(_mm_loadu_ps(&p.colorB_[i]), _mm_mul_ps(_mm_loadu_ps(&p.colorDeltaB_[i]), timeStep)));
+    _mm_storeu_ps(&p.colorA_[i], _mm_add_ps(_mm_loadu_ps(&p.colorA_[i]), _mm_mul_ps(_mm_loadu_ps(&p.colorDeltaA_[i]), timeStep)));
+
+    __m128 halfSize = _mm_mul_ps(size, _mm_set1_ps(0.5f));
+    __m128 positionZ = _mm_loadu_ps(&p.positionZ_[i]);
+    minX = _mm_min_ps(minX, _mm_sub_ps(positionX, halfSize));
+    minY = _mm_min_ps(minY, _mm_sub_ps(positionY, halfSize));
+    minZ = _mm_min_ps(minZ, positionZ);
+    maxX = _mm_max_ps(maxX, _mm_add_ps(positionX, halfSize));
+    maxY = _mm_max_ps(maxY, _mm_add_ps(positionY, halfSize));
+    maxZ = _mm_max_ps(maxZ, positionZ);
+}
+
+static inline float ReduceMin(__m128 v)
+{
+    float f[4];
+    _mm_storeu_ps(f, v);
+    return Min(Min(f[0], f[1]), Min(f[2], f[3]));
+}
+
+static inline float ReduceMax(__m128 v)
+{
+    float f[4];
+    _mm_storeu_ps(f, v);
+    return Max(Max(f[0], f[1]), Max(f[2], f[3]));
+}
+#endif
+
+/// Update a range of particles and calculate their bounding box.
+static void UpdateParticleRange(ParticleUpdateRange2D& range)
+{
+    ParticleData2D& particles = *range.particles_;
+    const ParticleUpdateParams2D& params = *range.params_;
+    Vector3 boundingBoxMin(M_INFINITY, M_INFINITY, M_INFINITY);
+    Vector3 boundingBoxMax(-M_INFINITY, -M_INFINITY, -M_INFINITY);
+
+    unsigned i = range.start_;
+
+#ifdef URHO3D_SSE
+    if (i + 4 <= range.end_)
+    {
+        __m128 minX = _mm_set1_ps(M_INFINITY);
+        __m128 minY = minX;
+        __m128 minZ = minX;
+        __m128 maxX = _mm_set1_ps(-M_INFINITY);
+        __m128 maxY = maxX;
+        __m128 maxZ = maxX;
+
+        for (; i + 4 <= range.end_; i += 4)
+            UpdateFourParticles(particles, i, params, minX, minY, minZ, maxX, maxY, maxZ);
+
+        boundingBoxMin = Vector3(ReduceMin(minX), ReduceMin(minY), ReduceMin(minZ));
+        boundingBoxMax = Vector3(ReduceMax(maxX), ReduceMax(maxY), ReduceMax(maxZ));
+    }
+#endif
+
+    for (; i < range.end_; ++i)
+        UpdateParticle(particles, i, params, boundingBoxMin, boundingBoxMax);
+
+    range.boundingBoxMin_ = boundingBoxMin;
+    range.boundingBoxMax_ = boundingBoxMax;
+}
+
+static void UpdateParticlesWork(const WorkItem* item, unsigned threadIndex)
+{
+    UpdateParticleRange(*reinterpret_cast<ParticleUpdateRange2D*>(item->aux_));
+}
+
+void ParticleData2D::Resize(unsigned num)
+{
+    timeToLive_.Resize(num);
+    positionX_.Resize(num);
+    positionY_.Resize(num);
+    positionZ_.Resize(num);
+    size_.Resize(num);
+    sizeDelta_.Resize(num);
+    rotation_.Resize(num);
+    rotationDelta_.Resize(num);
+    colorR_.Resize(num);
+    colorG_.Resize(num);
+    colorB_.Resize(num);
+    colorA_.Resize(num);
+    colorDeltaR_.Resize(num);
+    colorDeltaG_.Resize(num);
+    colorDeltaB_.Resize(num);
+    colorDeltaA_.Resize(num);
+    startPosX_.Resize(num);
+    startPosY_.Resize(num);
+    velocityX_.Resize(num);
+    velocityY_.Resize(num);
+    radialAcceleration_.Resize(num);
+    tangentialAcceleration_.Resize(num);
+    emitRadius_.Resize(num);
+    emitRadiusDelta_.Resize(num);
+    emitRotation_.Resize(num);
+    emitRotationDelta_.Resize(num);
+}
+
+void ParticleData2D::Copy(unsigned dest, unsigned source)
+{
+    timeToLive_[dest] = timeToLive_[source];
+    positionX_[dest] = positionX_[source];
+    positionY_[dest] = positionY_[source];
+    positionZ_[dest] = positionZ_[source];
+    size_[dest] = size_[source];
+    sizeDelta_[dest] = sizeDelta_[source];
+    rotation_[dest] = rotation_[source];
+    rotationDelta_[dest] = rotationDelta_[source];
+    colorR_[dest] = colorR_[source];
+    colorG_[dest] = colorG_[source];
+    colorB_[dest] = colorB_[source];
+    colorA_[dest] = colorA_[source];
+    colorDeltaR_[dest] = colorDeltaR_[source];
+    colorDeltaG_[dest] = colorDeltaG_[source];
+    colorDeltaB_[dest] = colorDeltaB_[source];
+    colorDeltaA_[dest] = colorDeltaA_[source];
+    startPosX_[dest] = startPosX_[source];
+    startPosY_[dest] = startPosY_[source];
+    velocityX_[dest] = velocityX_[source];
+    velocityY_[dest] = velocityY_[source];
+    radialAcceleration_[dest] = radialAcceleration_[source];
+    tangentialAcceleration_[dest] = tangentialAcceleration_[source];
+    emitRadius_[dest] = emitRadius_[source];
+    emitRadiusDelta_[dest] = emitRadiusDelta_[source];
+    emitRotation_[dest] = emitRotation_[source];
+    emitRotationDelta_[dest] = emitRotationDelta_[source];
+}
+
 ParticleEmitter2D::ParticleEmitter2D(Context* context) :
     Drawable2D(context),
     blendMode_(BLEND_ADDALPHA),
@@ -240,22 +553,25 @@ void ParticleEmitter2D::UpdateSourceBatches()
     vertex2.uv_ = textureRect.max_;
     vertex3.uv_ = Vector2(textureRect.max_.x_, textureRect.min_.y_);
 
+    const ParticleData2D& p = particles_;
     for (unsigned i = 0; i < numParticles_; ++i)
     {
-        Particle2D& p = particles_[i];
-
-        float rotation = -p.rotation_;
+        float rotation = -p.rotation_[i];
         float c = Cos(rotation);
         float s = Sin(rotation);
-        float add = (c + s) * p.size_ * 0.5f;
-        float sub = (c - s) * p.size_ * 0.5f;
+        float add = (c + s) * p.size_[i] * 0.5f;
+        float sub = (c - s) * p.size_[i] * 0.5f;
+        float x = p.positionX_[i];
+        float y = p.positionY_[i];
+        float z = p.positionZ_[i];
 
-        vertex0.position_ = Vector3(p.position_.x_ - sub, p.position_.y_ - add, p.position_.z_);
-        vertex1.position_ = Vector3(p.position_.x_ - add, p.position_.y_ + sub, p.position_.z_);
-        vertex2.position_ = Vector3(p.position_.x_ + sub, p.position_.y_ + add, p.position_.z_);
-        vertex3.position_ = Vector3(p.position_.x_ + add, p.position_.y_ - sub, p.position_.z_);
+        vertex0.position_ = Vector3(x - sub, y - add, z);
+        vertex1.position_ = Vector3(x - add, y + sub, z);
+        vertex2.position_ = Vector3(x + sub, y + add, z);
+        vertex3.position_ = Vector3(x + add, y - sub, z);
 
-        vertex0.color_ = vertex1.color_ = vertex2.color_ = vertex3.color_ = p.color_.ToUInt();
+        vertex0.color_ = vertex1.color_ = vertex2.color_ = vertex3.color_ =
+            Color(p.colorR_[i], p.colorG_[i], p.colorB_[i], p.colorA_[i]).ToUInt();
 
         vertices.Push(vertex0);
         vertices.Push(vertex1);
@@ -319,23 +635,22 @@ void ParticleEmitter2D::Update(float timeStep)
     boundingBoxMinPoint_ = Vector3(M_INFINITY, M_INFINITY, M_INFINITY);
     boundingBoxMaxPoint_ = Vector3(-M_INFINITY, -M_INFINITY, -M_INFINITY);
 
+    // Remove expired particles first, so that the remaining ones can be updated as one contiguous range
     unsigned particleIndex = 0;
     while (particleIndex < numParticles_)
     {
-        Particle2D& particle = particles_[particleIndex];
-        if (particle.timeToLive_ > 0.0f)
-        {
-            UpdateParticle(particle, timeStep, worldPosition, worldScale);
+        if (particles_.timeToLive_[particleIndex] > 0.0f)
             ++particleIndex;
-        }
         else
         {
             if (particleIndex != numParticles_ - 1)
-                particles_[particleIndex] = particles_[numParticles_ - 1];
+                particles_.Copy(particleIndex, numParticles_ - 1);
             --numParticles_;
         }
     }
 
+    UpdateParticles(0, numParticles_, timeStep, worldScale);
+
     if (emitting_ && emissionTime_ > 0.0f)
     {
         float worldAngle = GetNode()->GetWorldRotation().RollAngle();
@@ -346,7 +661,7 @@ void ParticleEmitter2D::Update(float timeStep)
         while (emitParticleTime_ > 0.0f)
         {
             if (EmitParticle(worldPosition, worldAngle, worldScale))
-                UpdateParticle(particles_[numParticles_ - 1], emitParticleTime_, worldPosition, worldScale);
+                UpdateParticles(numParticles_ - 1, numParticles_, emitParticleTime_, worldScale);
 
             emitParticleTime_ -= timeBetweenParticles;
         }
@@ -371,103 +686,118 @@ bool ParticleEmitter2D::EmitParticle(const Vector3& worldPosition, float worldAn
 
     float invLifespan = 1.0f / lifespan;
 
-    Particle2D& particle = particles_[numParticles_++];
-    particle.timeToLive_ = lifespan;
+    ParticleData2D& p = particles_;
+    unsigned i = numParticles_++;
+    p.timeToLive_[i] = lifespan;
 
-    particle.position_.x_ = worldPosition.x_ + worldScale * effect_->GetSourcePositionVariance().x_ * Random(-1.0f, 1.0f);
-    particle.position_.y_ = worldPosition.y_ + worldScale * effect_->GetSourcePositionVariance().y_ * Random(-1.0f, 1.0f);
-    particle.position_.z_ = worldPosition.z_;
-    particle.startPos_.x_ = worldPosition.x_;
-    particle.startPos_.y_ = worldPosition.y_;
+    p.positionX_[i] = worldPosition.x_ + worldScale * effect_->GetSourcePositionVariance().x_ * Random(-1.0f, 1.0f);
+    p.positionY_[i] = worldPosition.y_ + worldScale * effect_->GetSourcePositionVariance().y_ * Random(-1.0f, 1.0f);
+    p.positionZ_[i] = worldPosition.z_;
+    p.startPosX_[i] = worldPosition.x_;
+    p.startPosY_[i] = worldPosition.y_;
 
     float angle = worldAngle + effect_->GetAngle() + effect_->GetAngleVariance() * Random(-1.0f, 1.0f);
     float speed = worldScale * (effect_->GetSpeed() + effect_->GetSpeedVariance() * Random(-1.0f, 1.0f));
-    particle.velocity_.x_ = speed * Cos(angle);
-    particle.velocity_.y_ = speed * Sin(angle);
+    p.velocityX_[i] = speed * Cos(angle);
+    p.velocityY_[i] = speed * Sin(angle);
 
     float maxRadius = Max(0.0f, worldScale * (effect_->GetMaxRadius() + effect_->GetMaxRadiusVariance() * Random(-1.0f, 1.0f)));
     float minRadius = Max(0.0f, worldScale * (effect_->GetMinRadius() + effect_->GetMinRadiusVariance() * Random(-1.0f, 1.0f)));
-    particle.emitRadius_ = maxRadius;
-    particle.emitRadiusDelta_ = (minRadius - maxRadius) * invLifespan;
-    particle.emitRotation_ = worldAngle + effect_->GetAngle() + effect_->GetAngleVariance() * Random(-1.0f, 1.0f);
-    particle.emitRotationDelta_ = effect_->GetRotatePerSecond() + effect_->GetRotatePerSecondVariance() * Random(-1.0f, 1.0f);
-    particle.radialAcceleration_ =
+    p.emitRadius_[i] = maxRadius;
+    p.emitRadiusDelta_[i] = (minRadius - maxRadius) * invLifespan;
+    p.emitRotation_[i] = worldAngle + effect_->GetAngle() + effect_->GetAngleVariance() * Random(-1.0f, 1.0f);
+    p.emitRotationDelta_[i] = effect_->GetRotatePerSecond() + effect_->GetRotatePerSecondVariance() * Random(-1.0f, 1.0f);
+    p.radialAcceleration_[i] =
         worldScale * (effect_->GetRadialAcceleration() + effect_->GetRadialAccelVariance() * Random(-1.0f, 1.0f));
-    particle.tangentialAcceleration_ =
+    p.tangentialAcceleration_[i] =
         worldScale * (effect_->GetTangentialAcceleration() + effect_->GetTangentialAccelVariance() * Random(-1.0f, 1.0f));
 
     float startSize =
         worldScale * Max(0.1f, effect_->GetStartParticleSize() + effect_->GetStartParticleSizeVariance() * Random(-1.0f, 1.0f));
     float finishSize =
         worldScale * Max(0.1f, effect_->GetFinishParticleSize() + effect_->GetFinishParticleSizeVariance() * Random(-1.0f, 1.0f));
-    particle.size_ = startSize;
-    particle.sizeDelta_ = (finishSize - startSize) * invLifespan;
+    p.size_[i] = startSize;
+    p.sizeDelta_[i] = (finishSize - startSize) * invLifespan;
 
-    particle.color_ = effect_->GetStartColor() + effect_->GetStartColorVariance() * Random(-1.0f, 1.0f);
+    Color startColor = effect_->GetStartColor() + effect_->GetStartColorVariance() * Random(-1.0f, 1.0f);
     Color endColor = effect_->GetFinishColor() + effect_->GetFinishColorVariance() * Random(-1.0f, 1.0f);
-    particle.colorDelta_ = (endColor - particle.color_) * invLifespan;
-
-    particle.rotation_ = worldAngle + effect_->GetRotationStart() + effect_->GetRotationStartVariance() * Random(-1.0f, 1.0f);
+    Color colorDelta = (endColor - startColor) * invLifespan;
+    p.colorR_[i] = startColor.r_;
+    p.colorG_[i] = startColor.g_;
+    p.colorB_[i] = startColor.b_;
+    p.colorA_[i] = startColor.a_;
+    p.colorDeltaR_[i] = colorDelta.r_;
+    p.colorDeltaG_[i] = colorDelta.g_;
+    p.colorDeltaB_[i] = colorDelta.b_;
+    p.colorDeltaA_[i] = colorDelta.a_;
+
+    p.rotation_[i] = worldAngle + effect_->GetRotationStart() + effect_->GetRotationStartVariance() * Random(-1.0f, 1.0f);
     float endRotation = worldAngle + effect_->GetRotationEnd() + effect_->GetRotationEndVariance() * Random(-1.0f, 1.0f);
-    particle.rotationDelta_ = (endRotation - particle.rotation_) * invLifespan;
+    p.rotationDelta_[i] = (endRotation - p.rotation_[i]) * invLifespan;
 
     return true;
 }
 
-void ParticleEmitter2D::UpdateParticle(Particle2D& particle, float timeStep, const Vector3& worldPosition, float worldScale)
+void ParticleEmitter2D::UpdateParticles(unsigned start, unsigned end, float timeStep, float worldScale)
 {
-    if (timeStep > particle.timeToLive_)
-        timeStep = particle.timeToLive_;
-
-    particle.timeToLive_ -= timeStep;
-
-    if (effect_->GetEmitterType() == EMITTER_TYPE_RADIAL)
+    ParticleUpdateParams2D params;
+    params.timeStep_ = timeStep;
+    params.gravityX_ = effect_->GetGravity().x_ * worldScale;
+    params.gravityY_ = effect_->GetGravity().y_ * worldScale;
+    params.radial_ = effect_->GetEmitterType() == EMITTER_TYPE_RADIAL;
+
+    unsigned numParticles = end - start;
+    unsigned numWorkItems = 1;
+    auto* queue = numParticles >= MIN_PARTICLES_PER_WORK_ITEM * 2 ? GetSubsystem<WorkQueue>() : nullptr;
+    if (queue && queue->GetNumThreads())
+        numWorkItems = Clamp(numParticles / MIN_PARTICLES_PER_WORK_ITEM, 1U, queue->GetNumThreads() + 1);
+
+    if (numWorkItems == 1)
     {
-        particle.emitRotation_ += particle.emitRotationDelta_ * timeStep;
-        particle.emitRadius_ += particle.emitRadiusDelta_ * timeStep;
-
-        particle.position_.x_ = particle.startPos_.x_ - Cos(particle.emitRotation_) * particle.emitRadius_;
-        particle.position_.y_ = particle.startPos_.y_ + Sin(particle.emitRotation_) * particle.emitRadius_;
+        ParticleUpdateRange2D range;
+        range.particles_ = &particles_;
+        range.params_ = &params;
+        range.start_ = start;
+        range.end_ = end;
+        UpdateParticleRange(range);
+        MergeBoundingBox(range);
+        return;
     }
-    else
-    {
-        float distanceX = particle.position_.x_ - particle.startPos_.x_;
-        float distanceY = particle.position_.y_ - particle.startPos_.y_;
-
-        float distanceScalar = Vector2(distanceX, distanceY).Length();
-        if (distanceScalar < 0.0001f)
-            distanceScalar = 0.0001f;
 
-        float radialX = distanceX / distanceScalar;
-        float radialY = distanceY / distanceScalar;
-
-        float tangentialX = radialX;
-        float tangentialY = radialY;
+    URHO3D_PROFILE(UpdateParticles2D);
 
-        radialX *= particle.radialAcceleration_;
-        radialY *= particle.radialAcceleration_;
+    // Keep the ranges a multiple of four particles so that only the last one has a partial SIMD batch
+    unsigned particlesPerItem = ((numParticles + numWorkItems - 1) / numWorkItems + 3) & ~3U;
+    PODVector<ParticleUpdateRange2D> ranges(numWorkItems);
+    for (unsigned i = 0; i < numWorkItems; ++i)
+    {
+        ParticleUpdateRange2D& range = ranges[i];
+        range.particles_ = &particles_;
+        range.params_ = &params;
+        range.start_ = Min(start + i * particlesPerItem, end);
+        range.end_ = Min(range.start_ + particlesPerItem, end);
+
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = UpdateParticlesWork;
+        item->aux_ = &range;
+        queue->AddWorkItem(item);
+    }
 
-        float newY = tangentialX;
-        tangentialX = -tangentialY * particle.tangentialAcceleration_;
-        tangentialY = newY * particle.tangentialAcceleration_;
+    queue->Complete(M_MAX_UNSIGNED);
 
-        particle.velocity_.x_ += (effect_->GetGravity().x_ * worldScale + radialX - tangentialX) * timeStep;
-        particle.velocity_.y_ -= (effect_->GetGravity().y_ * worldScale - radialY + tangentialY) * timeStep;
-        particle.position_.x_ += particle.velocity_.x_ * timeStep;
-        particle.position_.y_ += particle.velocity_.y_ * timeStep;
-    }
+    for (unsigned i = 0; i < numWorkItems; ++i)
+        MergeBoundingBox(ranges[i]);
+}
 
-    particle.size_ += particle.sizeDelta_ * timeStep;
-    particle.rotation_ += particle.rotationDelta_ * timeStep;
-    particle.color_ += particle.colorDelta_ * timeStep;
-
-    float halfSize = particle.size_ * 0.5f;
-    boundingBoxMinPoint_.x_ = Min(boundingBoxMinPoint_.x_, particle.position_.x_ - halfSize);
-    boundingBoxMinPoint_.y_ = Min(boundingBoxMinPoint_.y_, particle.position_.y_ - halfSize);
-    boundingBoxMinPoint_.z_ = Min(boundingBoxMinPoint_.z_, particle.position_.z_);
-    boundingBoxMaxPoint_.x_ = Max(boundingBoxMaxPoint_.x_, particle.position_.x_ + halfSize);
-    boundingBoxMaxPoint_.y_ = Max(boundingBoxMaxPoint_.y_, particle.position_.y_ + halfSize);
-    boundingBoxMaxPoint_.z_ = Max(boundingBoxMaxPoint_.z_, particle.position_.z_);
+void ParticleEmitter2D::MergeBoundingBox(const ParticleUpdateRange2D& range)
+{
+    boundingBoxMinPoint_.x_ = Min(boundingBoxMinPoint_.x_, range.boundingBoxMin_.x_);
+    boundingBoxMinPoint_.y_ = Min(boundingBoxMinPoint_.y_, range.boundingBoxMin_.y_);
+    boundingBoxMinPoint_.z_ = Min(boundingBoxMinPoint_.z_, range.boundingBoxMin_.z_);
+    boundingBoxMaxPoint_.x_ = Max(boundingBoxMaxPoint_.x_, range.boundingBoxMax_.x_);
+    boundingBoxMaxPoint_.y_ = Max(boundingBoxMaxPoint_.y_, range.boundingBoxMax_.y_);
+    boundingBoxMaxPoint_.z_ = Max(boundingBoxMaxPoint_.z_, range.boundingBoxMax_.z_);
 }
 
 }
@@ -49,6 +49,8 @@ namespace Urho3D
 extern const char* blendModeNames[];
 
 static const unsigned MASK_VERTEX2D = MASK_POSITION | MASK_COLOR | MASK_TEXCOORD1;
+/// Minimum number of vertices filled per work item.
+static const unsigned MIN_VERTICES_PER_WORK_ITEM = 4096;
 
 ViewBatchInfo2D::ViewBatchInfo2D() :
     vertexBufferUpdateFrameNumber_(0),
@@ -190,31 +192,7 @@ void Renderer2D::UpdateGeometry(const FrameInfo& frame)
 
     if (viewBatchInfo.vertexBufferUpdateFrameNumber_ != frame_.frameNumber_)
     {
-        unsigned vertexCount = viewBatchInfo.vertexCount_;
-        VertexBuffer* vertexBuffer = viewBatchInfo.vertexBuffer_;
-        if (vertexBuffer->GetVertexCount() < vertexCount)
-            vertexBuffer->SetSize(vertexCount, MASK_VERTEX2D, true);
-
-        if (vertexCount)
-        {
-            auto* dest = reinterpret_cast<Vertex2D*>(vertexBuffer->Lock(0, vertexCount, true));
-            if (dest)
-            {
-                const PODVector<const SourceBatch2D*>& sourceBatches = viewBatchInfo.sourceBatches_;
-                for (unsigned b = 0; b < sourceBatches.Size(); ++b)
-                {
-                    const Vector<Vertex2D>& vertices = sourceBatches[b]->vertices_;
-                    for (unsigned i = 0; i < vertices.Size(); ++i)
-                        dest[i] = vertices[i];
-                    dest += vertices.Size();
-                }
-
-                vertexBuffer->Unlock();
-            }
-            else
-                URHO3D_LOGERROR("Failed to lock vertex buffer");
-        }
-
+        UpdateVertexBuffer(viewBatchInfo);
         viewBatchInfo.vertexBufferUpdateFrameNumber_ = frame_.frameNumber_;
     }
 }
@@ -365,9 +343,12 @@ void Renderer2D::HandleBeginViewUpdate(StringHash eventType, VariantMap& eventDa
 
     ViewBatchInfo2D& viewBatchInfo = viewBatchInfos_[camera];
 
-    // Create vertex buffer
+    // Create vertex buffer. It is shadowed, so that the vertices can be filled from worker threads
     if (!viewBatchInfo.vertexBuffer_)
+    {
         viewBatchInfo.vertexBuffer_ = new VertexBuffer(context_);
+        viewBatchInfo.vertexBuffer_->SetShadowed(true);
+    }
 
     UpdateViewBatchInfo(viewBatchInfo, camera);
 
@@ -402,18 +383,48 @@ void Renderer2D::GetDrawables(PODVector<Drawable2D*>& drawables, Node* node)
         GetDrawables(drawables, i->Get());
 }
 
-static inline bool CompareSourceBatch2Ds(const SourceBatch2D* lhs, const SourceBatch2D* rhs)
+/// Return a sort key which orders draw orders ascending.
+static inline unsigned GetDrawOrderSortKey(int drawOrder)
+{
+    return (unsigned)drawOrder ^ 0x80000000u;
+}
+
+/// Return a sort key which orders distances descending.
+static inline unsigned GetDistanceSortKey(float distance)
+{
+    // Map negative zero to positive, so that they compare equal
+    if (distance == 0.0f)
+        distance = 0.0f;
+
+    unsigned bits;
+    memcpy(&bits, &distance, sizeof bits);
+    // Flip the magnitude of negative values and the sign of positive values to order as unsigned, then invert
+    return (bits & 0x80000000u) ? bits : ~bits & 0x7fffffffu;
+}
+
+void Renderer2D::SortSourceBatches(PODVector<const SourceBatch2D*>& sourceBatches)
 {
-    if (lhs->drawOrder_ != rhs->drawOrder_)
-        return lhs->drawOrder_ < rhs->drawOrder_;
+    unsigned numSourceBatches = sourceBatches.Size();
+    if (numSourceBatches < 2)
+        return;
 
-    if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
+    sortKeys_.Resize(numSourceBatches);
+    tempSortKeys_.Resize(numSourceBatches);
+    tempSourceBatches_.Resize(numSourceBatches);
 
-    if (lhs->material_ != rhs->material_)
-        return lhs->material_->GetNameHash() < rhs->material_->GetNameHash();
+    // The radix sort is stable, so sorting first by material and then by draw order and distance packed into one key
+    // orders by draw order, then distance, then material. Source batches equal in all keep their collection order
+    for (unsigned i = 0; i < numSourceBatches; ++i)
+        sortKeys_[i] = sourceBatches[i]->material_->GetNameHash().Value();
+    RadixSort(&sortKeys_[0], &sourceBatches[0], numSourceBatches, &tempSortKeys_[0], &tempSourceBatches_[0]);
 
-    return lhs < rhs;
+    for (unsigned i = 0; i < numSourceBatches; ++i)
+    {
+        const SourceBatch2D* sourceBatch = sourceBatches[i];
+        sortKeys_[i] = (unsigned long long)GetDrawOrderSortKey(sourceBatch->drawOrder_) << 32u |
+            GetDistanceSortKey(sourceBatch->distance_);
+    }
+    RadixSort(&sortKeys_[0], &sourceBatches[0], numSourceBatches, &tempSortKeys_[0], &tempSourceBatches_[0]);
 }
 
 void Renderer2D::UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* camera)
@@ -444,7 +455,8 @@ void Renderer2D::UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* cam
         sourceBatch->distance_ = camera->GetDistance(worldPos);
     }
 
-    Sort(sourceBatches.Begin(), sourceBatches.End(), CompareSourceBatch2Ds);
+    SortSourceBatches(sourceBatches);
+    viewBatchInfo.vertexStarts_.Resize(sourceBatches.Size());
 
     viewBatchInfo.batchCount_ = 0;
     Material* currMaterial = nullptr;
@@ -476,6 +488,7 @@ void Renderer2D::UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* cam
             currMaterial = material;
         }
 
+        viewBatchInfo.vertexStarts_[b] = vStart + vCount;
         iCount += vertices.Size() * 6 / 4;
         vCount += vertices.Size();
     }
@@ -519,4 +532,130 @@ void Renderer2D::AddViewBatch(ViewBatchInfo2D& viewBatchInfo, Material* material
     viewBatchInfo.batchCount_++;
 }
 
+void FillVertexRangesWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* viewBatchInfo = reinterpret_cast<ViewBatchInfo2D*>(item->aux_);
+    auto** start = reinterpret_cast<const SourceBatch2D**>(item->start_);
+    auto** end = reinterpret_cast<const SourceBatch2D**>(item->end_);
+    auto* dest = reinterpret_cast<Vertex2D*>(viewBatchInfo->vertexBuffer_->GetShadowData());
+
+    // The work items have disjoint source batch ranges, so they also write disjoint vertex ranges
+    for (auto i = (unsigned)(start - viewBatchInfo->sourceBatches_.Buffer()); start != end; ++start, ++i)
+    {
+        const SourceBatch2D* sourceBatch = *start;
+        unsigned version = sourceBatch->owner_->GetSourceBatchesVersion();
+        unsigned vertexStart = viewBatchInfo->vertexStarts_[i];
+        VertexRange2D& range = viewBatchInfo->vertexRanges_[i];
+
+        // The vertices are still in place if the source batch was written at the same offset and has not changed since
+        range.written_ = range.sourceBatch_ != sourceBatch || range.version_ != version || range.vertexStart_ != vertexStart;
+        if (range.written_)
+        {
+            const Vector<Vertex2D>& vertices = sourceBatch->vertices_;
+            memcpy(dest + vertexStart, &vertices[0], vertices.Size() * sizeof(Vertex2D));
+            range.sourceBatch_ = sourceBatch;
+            range.version_ = version;
+            range.vertexStart_ = vertexStart;
+        }
+    }
+}
+
+void Renderer2D::UpdateVertexBuffer(ViewBatchInfo2D& viewBatchInfo)
+{
+    unsigned vertexCount = viewBatchInfo.vertexCount_;
+    if (!vertexCount)
+        return;
+
+    VertexBuffer* vertexBuffer = viewBatchInfo.vertexBuffer_;
+    const PODVector<const SourceBatch2D*>& sourceBatches = viewBatchInfo.sourceBatches_;
+    const PODVector<unsigned>& vertexStarts = viewBatchInfo.vertexStarts_;
+    PODVector<VertexRange2D>& vertexRanges = viewBatchInfo.vertexRanges_;
+    unsigned numSourceBatches = sourceBatches.Size();
+
+    // When the buffer is resized or its data lost, all vertices must be written again. Shadowed buffers are partially
+    // updated, so they are created static to allow range updates on all APIs
+    if (vertexBuffer->GetVertexCount() < vertexCount || vertexBuffer->IsDataLost())
+    {
+        if (vertexBuffer->GetVertexCount() < vertexCount)
+            vertexBuffer->SetSize(vertexCount, MASK_VERTEX2D, false);
+        vertexBuffer->ClearDataLost();
+        vertexRanges.Clear();
+    }
+
+    if (!vertexBuffer->GetShadowData())
+    {
+        URHO3D_LOGERROR("Failed to allocate vertex buffer");
+        return;
+    }
+
+    unsigned numOldRanges = vertexRanges.Size();
+    vertexRanges.Resize(numSourceBatches);
+    for (unsigned i = numOldRanges; i < numSourceBatches; ++i)
+        vertexRanges[i].sourceBatch_ = nullptr;
+
+    {
+        URHO3D_PROFILE(FillVertexRanges);
+
+        // Split the work by vertex count, as the source batch sizes vary a lot
+        auto* queue = GetSubsystem<WorkQueue>();
+        unsigned numWorkItems = Clamp(vertexCount / MIN_VERTICES_PER_WORK_ITEM, 1u, queue->GetNumThreads() + 1);
+        unsigned start = 0;
+        for (unsigned i = 0; i < numWorkItems && start < numSourceBatches; ++i)
+        {
+            unsigned end = numSourceBatches;
+            if (i < numWorkItems - 1)
+            {
+                auto splitVertex = (unsigned)((unsigned long long)vertexCount * (i + 1) / numWorkItems);
+                end = start + 1;
+                while (end < numSourceBatches && vertexStarts[end] < splitVertex)
+                    ++end;
+            }
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = FillVertexRangesWork;
+            item->aux_ = &viewBatchInfo;
+            item->start_ = sourceBatches.Buffer() + start;
+            item->end_ = sourceBatches.Buffer() + end;
+            queue->AddWorkItem(item);
+
+            start = end;
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+
+    // Upload the written ranges. Ranges separated by a small gap are merged, and if the changes are scattered the whole
+    // changed span is uploaded in one call
+    static const unsigned MERGE_GAP_VERTICES = 16 * 4;
+    static const unsigned MAX_UPLOAD_RANGES = 8;
+
+    PODVector<Pair<unsigned, unsigned> > uploadRanges;
+    for (unsigned i = 0; i < numSourceBatches; ++i)
+    {
+        if (!vertexRanges[i].written_)
+            continue;
+
+        unsigned start = vertexStarts[i];
+        unsigned end = start + sourceBatches[i]->vertices_.Size();
+        if (!uploadRanges.Empty() && start <= uploadRanges.Back().second_ + MERGE_GAP_VERTICES)
+            uploadRanges.Back().second_ = end;
+        else
+            uploadRanges.Push(MakePair(start, end));
+    }
+
+    if (uploadRanges.Size() > MAX_UPLOAD_RANGES)
+    {
+        uploadRanges.Front().second_ = uploadRanges.Back().second_;
+        uploadRanges.Resize(1);
+    }
+
+    const auto* shadowData = reinterpret_cast<const Vertex2D*>(vertexBuffer->GetShadowData());
+    for (unsigned i = 0; i < uploadRanges.Size(); ++i)
+    {
+        unsigned start = uploadRanges[i].first_;
+        vertexBuffer->SetDataRange(shadowData + start, start, uploadRanges[i].second_ - start);
+    }
+}
+
 }
@@ -36,6 +36,19 @@ class VertexBuffer;
 struct FrameInfo;
 struct SourceBatch2D;
 
+/// Source batch vertex range in a 2D view vertex buffer.
+struct VertexRange2D
+{
+    /// Source batch.
+    const SourceBatch2D* sourceBatch_;
+    /// Source batches version of the owner when the vertices were written.
+    unsigned version_;
+    /// Vertex start.
+    unsigned vertexStart_;
+    /// Whether the vertices were written on the last update.
+    bool written_;
+};
+
 /// 2D view batch info.
 struct ViewBatchInfo2D
 {
@@ -54,6 +67,10 @@ struct ViewBatchInfo2D
     unsigned batchUpdatedFrameNumber_;
     /// Source batches.
     PODVector<const SourceBatch2D*> sourceBatches_;
+    /// Vertex start of each source batch.
+    PODVector<unsigned> vertexStarts_;
+    /// Vertex ranges currently in the vertex buffer by source batch index. Unchanged ranges are reused on the next update.
+    PODVector<VertexRange2D> vertexRanges_;
     /// Batch count;
     unsigned batchCount_;
     /// Distances.
@@ -70,6 +87,7 @@ class URHO3D_API Renderer2D : public Drawable
     URHO3D_OBJECT(Renderer2D, Drawable);
 
     friend void CheckDrawableVisibilityWork(const WorkItem* item, unsigned threadIndex);
+    friend void FillVertexRangesWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -109,6 +127,10 @@ private:
     void GetDrawables(PODVector<Drawable2D*>& drawables, Node* node);
     /// Update view batch info.
     void UpdateViewBatchInfo(ViewBatchInfo2D& viewBatchInfo, Camera* camera);
+    /// Sort source batches by draw order, distance and material.
+    void SortSourceBatches(PODVector<const SourceBatch2D*>& sourceBatches);
+    /// Fill the changed source batch vertex ranges of a view and upload them.
+    void UpdateVertexBuffer(ViewBatchInfo2D& viewBatchInfo);
     /// Add view batch.
     void AddViewBatch(ViewBatchInfo2D& viewBatchInfo, Material* material,
         unsigned indexStart, unsigned indexCount, unsigned vertexStart, unsigned vertexCount, float distance);
@@ -131,6 +153,12 @@ private:
     HashMap<Texture2D*, HashMap<int, SharedPtr<Material> > > cachedMaterials_;
     /// Cached techniques per blend mode.
     HashMap<int, SharedPtr<Technique> > cachedTechniques_;
+    /// Source batch sort keys.
+    PODVector<unsigned long long> sortKeys_;
+    /// Temporary sort keys.
+    PODVector<unsigned long long> tempSortKeys_;
+    /// Temporary source batches for sorting.
+    PODVector<const SourceBatch2D*> tempSourceBatches_;
 };
 
 }
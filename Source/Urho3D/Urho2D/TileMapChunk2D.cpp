@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Texture2D.h"
+#include "../Scene/Node.h"
+#include "../Urho2D/Renderer2D.h"
+#include "../Urho2D/Sprite2D.h"
+#include "../Urho2D/TileMap2D.h"
+#include "../Urho2D/TileMapChunk2D.h"
+#include "../Urho2D/TileMapLayer2D.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+TileMapChunk2D::TileMapChunk2D(Context* context) :
+    Drawable2D(context),
+    rowOrderStep_(0),
+    boundingBoxDirty_(true)
+{
+}
+
+TileMapChunk2D::~TileMapChunk2D() = default;
+
+void TileMapChunk2D::RegisterObject(Context* context)
+{
+    context->RegisterFactory<TileMapChunk2D>();
+}
+
+void TileMapChunk2D::Initialize(TileMapLayer2D* tileMapLayer, const IntRect& tileRect, int rowOrderStep)
+{
+    tileMapLayer_ = tileMapLayer;
+    tileRect_ = tileRect;
+    rowOrderStep_ = rowOrderStep;
+    MarkTilesDirty();
+}
+
+void TileMapChunk2D::MarkTilesDirty()
+{
+    sourceBatchesDirty_ = true;
+    boundingBoxDirty_ = true;
+    worldBoundingBoxDirty_ = true;
+}
+
+TileMapLayer2D* TileMapChunk2D::GetTileMapLayer() const
+{
+    return tileMapLayer_;
+}
+
+void TileMapChunk2D::OnWorldBoundingBoxUpdate()
+{
+    // Calculate from the tiles instead of the vertices, as this may be called from a worker thread, where the materials
+    // needed for the source batches can not be created
+    if (boundingBoxDirty_)
+    {
+        boundingBox_.Clear();
+
+        Sprite2D* sprite;
+        bool flipX, flipY, swapXY;
+        Vector2 position;
+        Rect drawRect;
+        for (int y = tileRect_.top_; y < tileRect_.bottom_; ++y)
+        {
+            for (int x = tileRect_.left_; x < tileRect_.right_; ++x)
+            {
+                if (!GetTileDrawInfo(x, y, sprite, flipX, flipY, swapXY, position) ||
+                    !sprite->GetDrawRectangle(drawRect, flipX, flipY))
+                    continue;
+
+                boundingBox_.Merge(Vector3(position + drawRect.min_));
+                boundingBox_.Merge(Vector3(position + drawRect.max_));
+            }
+        }
+
+        boundingBoxDirty_ = false;
+    }
+
+    if (boundingBox_.Defined())
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+    else
+        worldBoundingBox_.Clear();
+}
+
+void TileMapChunk2D::OnDrawOrderChanged()
+{
+    // The draw order of each tile row is derived from the chunk's, so rebuild
+    sourceBatchesDirty_ = true;
+}
+
+void TileMapChunk2D::UpdateSourceBatches()
+{
+    if (!sourceBatchesDirty_)
+        return;
+
+    // Materials are acquired from the renderer, which exists only when in a scene
+    if (!renderer_)
+    {
+        sourceBatches_.Clear();
+        return;
+    }
+
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    const unsigned color = Color::WHITE.ToUInt();
+
+    Sprite2D* sprite;
+    bool flipX, flipY, swapXY;
+    Vector2 position;
+    Rect drawRect;
+    Rect textureRect;
+    unsigned numBatches = 0;
+
+    // Each tile row gets its own batches and draw order, so that the rows of horizontally adjacent chunks interleave.
+    // Tiles are then drawn row by row across the whole layer, as the individual tile sprites used to be
+    for (int y = tileRect_.top_; y < tileRect_.bottom_; ++y)
+    {
+        int drawOrder = GetDrawOrder() + (y - tileRect_.top_) * rowOrderStep_;
+        unsigned rowStart = numBatches;
+        Texture2D* lastTexture = nullptr;
+        SourceBatch2D* batch = nullptr;
+
+        for (int x = tileRect_.left_; x < tileRect_.right_; ++x)
+        {
+            if (!GetTileDrawInfo(x, y, sprite, flipX, flipY, swapXY, position) ||
+                !sprite->GetDrawRectangle(drawRect, flipX, flipY) || !sprite->GetTextureRectangle(textureRect, flipX, flipY))
+                continue;
+
+            // Tiles of a tileset share a texture, so the batch rarely changes
+            Texture2D* texture = sprite->GetTexture();
+            if (texture != lastTexture || !batch)
+            {
+                Material* material = renderer_->GetMaterial(texture, BLEND_ALPHA);
+                batch = nullptr;
+                for (unsigned i = rowStart; i < numBatches; ++i)
+                {
+                    if (sourceBatches_[i].material_ == material)
+                    {
+                        batch = &sourceBatches_[i];
+                        break;
+                    }
+                }
+                if (!batch)
+                {
+                    // Reuse the vertex storage of the previous build
+                    if (numBatches == sourceBatches_.Size())
+                        sourceBatches_.Resize(numBatches + 1);
+                    batch = &sourceBatches_[numBatches++];
+                    batch->owner_ = this;
+                    batch->drawOrder_ = drawOrder;
+                    batch->material_ = material;
+                    batch->vertices_.Clear();
+                }
+                lastTexture = texture;
+            }
+
+            /*
+            V1---------V2
+            |         / |
+            |       /   |
+            |     /     |
+            |   /       |
+            | /         |
+            V0---------V3
+            */
+            Vertex2D vertex0;
+            Vertex2D vertex1;
+            Vertex2D vertex2;
+            Vertex2D vertex3;
+
+            vertex0.position_ = worldTransform * Vector3(position.x_ + drawRect.min_.x_, position.y_ + drawRect.min_.y_, 0.0f);
+            vertex1.position_ = worldTransform * Vector3(position.x_ + drawRect.min_.x_, position.y_ + drawRect.max_.y_, 0.0f);
+            vertex2.position_ = worldTransform * Vector3(position.x_ + drawRect.max_.x_, position.y_ + drawRect.max_.y_, 0.0f);
+            vertex3.position_ = worldTransform * Vector3(position.x_ + drawRect.max_.x_, position.y_ + drawRect.min_.y_, 0.0f);
+
+            vertex0.uv_ = textureRect.min_;
+            (swapXY ? vertex3.uv_ : vertex1.uv_) = Vector2(textureRect.min_.x_, textureRect.max_.y_);
+            vertex2.uv_ = textureRect.max_;
+            (swapXY ? vertex1.uv_ : vertex3.uv_) = Vector2(textureRect.max_.x_, textureRect.min_.y_);
+
+            vertex0.color_ = vertex1.color_ = vertex2.color_ = vertex3.color_ = color;
+
+            Vector<Vertex2D>& vertices = batch->vertices_;
+            vertices.Push(vertex0);
+            vertices.Push(vertex1);
+            vertices.Push(vertex2);
+            vertices.Push(vertex3);
+        }
+    }
+
+    sourceBatches_.Resize(numBatches);
+    sourceBatchesDirty_ = false;
+}
+
+bool TileMapChunk2D::GetTileDrawInfo(int x, int y, Sprite2D*& sprite, bool& flipX, bool& flipY, bool& swapXY,
+    Vector2& position) const
+{
+    if (!tileMapLayer_)
+        return false;
+
+    sprite = tileMapLayer_->GetTileSprite(x, y);
+    if (!sprite)
+        return false;
+
+    // A sprite set to a cell without a tile is drawn unflipped
+    Tile2D* tile = tileMapLayer_->GetTile(x, y);
+    flipX = tile && tile->GetFlipX();
+    flipY = tile && tile->GetFlipY();
+    swapXY = tile && tile->GetSwapXY();
+    position = tileMapLayer_->GetTileMap()->GetInfo().TileIndexToPosition(x, y);
+    return true;
+}
+
+}
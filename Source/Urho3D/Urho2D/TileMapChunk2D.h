@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2008-2019 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Urho2D/Drawable2D.h"
+
+namespace Urho3D
+{
+
+class TileMapLayer2D;
+
+/// Rectangular chunk of a tile map layer, drawn with one source batch per tile row and material. Culled as a whole.
+class URHO3D_API TileMapChunk2D : public Drawable2D
+{
+    URHO3D_OBJECT(TileMapChunk2D, Drawable2D);
+
+public:
+    /// Construct.
+    explicit TileMapChunk2D(Context* context);
+    /// Destruct.
+    ~TileMapChunk2D() override;
+    /// Register object factory. Drawable2D must be registered first.
+    static void RegisterObject(Context* context);
+
+    /// Initialize with tile map layer, the tile index range, right and bottom exclusive, and the draw order step between tile
+    /// rows. The chunk's own draw order is that of its top row.
+    void Initialize(TileMapLayer2D* tileMapLayer, const IntRect& tileRect, int rowOrderStep);
+    /// Mark tiles changed. The vertices are rebuilt when next drawn.
+    void MarkTilesDirty();
+
+    /// Return tile map layer.
+    TileMapLayer2D* GetTileMapLayer() const;
+
+    /// Return tile index range.
+    const IntRect& GetTileRect() const { return tileRect_; }
+
+protected:
+    /// Recalculate the world-space bounding box.
+    void OnWorldBoundingBoxUpdate() override;
+    /// Handle draw order changed.
+    void OnDrawOrderChanged() override;
+    /// Update source batches.
+    void UpdateSourceBatches() override;
+
+private:
+    /// Return sprite, flipping and position of a tile. Return false if the tile is empty.
+    bool GetTileDrawInfo(int x, int y, Sprite2D*& sprite, bool& flipX, bool& flipY, bool& swapXY, Vector2& position) const;
+
+    /// Tile map layer.
+    WeakPtr<TileMapLayer2D> tileMapLayer_;
+    /// Tile index range.
+    IntRect tileRect_;
+    /// Draw order step between tile rows.
+    int rowOrderStep_;
+    /// Local bounding box dirty flag.
+    bool boundingBoxDirty_;
+};
+
+}
@@ -28,6 +28,7 @@
 #include "../Scene/Node.h"
 #include "../Urho2D/StaticSprite2D.h"
 #include "../Urho2D/TileMap2D.h"
+#include "../Urho2D/TileMapChunk2D.h"
 #include "../Urho2D/TileMapLayer2D.h"
 #include "../Urho2D/TmxFile2D.h"
 
@@ -36,6 +37,9 @@
 namespace Urho3D
 {
 
+/// Width and height of a tile chunk in tiles.
+static const int TILE_CHUNK_SIZE = 16;
+
 TileMapLayer2D::TileMapLayer2D(Context* context) :
     Component(context)
 {
@@ -181,6 +185,13 @@ void TileMapLayer2D::Initialize(TileMap2D* tileMap, const TmxLayer2D* tmxLayer)
         }
 
         nodes_.Clear();
+
+        for (unsigned i = 0; i < chunks_.Size(); ++i)
+            chunks_[i]->Remove();
+
+        chunks_.Clear();
+        tileSprites_.Clear();
+        numChunksX_ = 0;
     }
 
     tileLayer_ = nullptr;
@@ -230,6 +241,9 @@ void TileMapLayer2D::SetDrawOrder(int drawOrder)
         if (staticSprite)
             staticSprite->SetLayer(drawOrder_);
     }
+
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+        chunks_[i]->SetLayer(drawOrder_);
 }
 
 void TileMapLayer2D::SetVisible(bool visible)
@@ -244,6 +258,22 @@ void TileMapLayer2D::SetVisible(bool visible)
         if (nodes_[i])
             nodes_[i]->SetEnabled(visible_);
     }
+
+    for (unsigned i = 0; i < chunks_.Size(); ++i)
+        chunks_[i]->SetEnabled(visible_);
+}
+
+void TileMapLayer2D::SetTileSprite(int x, int y, Sprite2D* sprite)
+{
+    if (!tileLayer_ || x < 0 || x >= tileLayer_->GetWidth() || y < 0 || y >= tileLayer_->GetHeight())
+        return;
+
+    SharedPtr<Sprite2D>& tileSprite = tileSprites_[y * tileLayer_->GetWidth() + x];
+    if (tileSprite == sprite)
+        return;
+
+    tileSprite = sprite;
+    chunks_[(y / TILE_CHUNK_SIZE) * numChunksX_ + x / TILE_CHUNK_SIZE]->MarkTilesDirty();
 }
 
 TileMap2D* TileMapLayer2D::GetTileMap() const
@@ -289,7 +319,7 @@ Tile2D* TileMapLayer2D::GetTile(int x, int y) const
     return tileLayer_->GetTile(x, y);
 }
 
-Node* TileMapLayer2D::GetTileNode(int x, int y) const
+Sprite2D* TileMapLayer2D::GetTileSprite(int x, int y) const
 {
     if (!tileLayer_)
         return nullptr;
@@ -297,7 +327,12 @@ Node* TileMapLayer2D::GetTileNode(int x, int y) const
     if (x < 0 || x >= tileLayer_->GetWidth() || y < 0 || y >= tileLayer_->GetHeight())
         return nullptr;
 
-    return nodes_[y * tileLayer_->GetWidth() + x];
+    return tileSprites_[y * tileLayer_->GetWidth() + x];
+}
+
+TileMapChunk2D* TileMapLayer2D::GetChunk(unsigned index) const
+{
+    return index < chunks_.Size() ? chunks_[index] : nullptr;
 }
 
 unsigned TileMapLayer2D::GetNumObjects() const
@@ -341,27 +376,38 @@ void TileMapLayer2D::SetTileLayer(const TmxTileLayer2D* tileLayer)
 
     int width = tileLayer->GetWidth();
     int height = tileLayer->GetHeight();
-    nodes_.Resize((unsigned)(width * height));
+    tileSprites_.Resize((unsigned)(width * height));
 
-    const TileMapInfo2D& info = tileMap_->GetInfo();
     for (int y = 0; y < height; ++y)
     {
         for (int x = 0; x < width; ++x)
         {
             const Tile2D* tile = tileLayer->GetTile(x, y);
-            if (!tile)
-                continue;
+            if (tile)
+                tileSprites_[y * width + x] = tile->GetSprite();
+        }
+    }
 
-            SharedPtr<Node> tileNode(GetNode()->CreateTemporaryChild("Tile"));
-            tileNode->SetPosition(Vector3(info.TileIndexToPosition(x, y)));
+    // Instead of a node per tile, draw and cull the tiles in chunks. The tile rows of each chunk are ordered after the same
+    // row of the chunks to their left, which draws the tiles row by row across the layer
+    numChunksX_ = (width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    int numChunksY = (height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    chunks_.Resize((unsigned)(numChunksX_ * numChunksY));
 
-            auto* staticSprite = tileNode->CreateComponent<StaticSprite2D>();
-            staticSprite->SetSprite(tile->GetSprite());
-            staticSprite->SetFlip(tile->GetFlipX(), tile->GetFlipY(), tile->GetSwapXY());
-            staticSprite->SetLayer(drawOrder_);
-            staticSprite->SetOrderInLayer(y * width + x);
+    for (int chunkY = 0; chunkY < numChunksY; ++chunkY)
+    {
+        for (int chunkX = 0; chunkX < numChunksX_; ++chunkX)
+        {
+            IntRect tileRect(chunkX * TILE_CHUNK_SIZE, chunkY * TILE_CHUNK_SIZE, Min((chunkX + 1) * TILE_CHUNK_SIZE, width),
+                Min((chunkY + 1) * TILE_CHUNK_SIZE, height));
+
+            SharedPtr<TileMapChunk2D> chunk(GetNode()->CreateComponent<TileMapChunk2D>(LOCAL));
+            chunk->SetTemporary(true);
+            chunk->Initialize(this, tileRect, numChunksX_);
+            chunk->SetLayer(drawOrder_);
+            chunk->SetOrderInLayer(chunkY * TILE_CHUNK_SIZE * numChunksX_ + chunkX);
 
-            nodes_[y * width + x] = tileNode;
+            chunks_[chunkY * numChunksX_ + chunkX] = chunk;
         }
     }
 }
@@ -35,6 +35,7 @@ namespace Urho3D
 class DebugRenderer;
 class Node;
 class TileMap2D;
+class TileMapChunk2D;
 class TmxImageLayer2D;
 class TmxLayer2D;
 class TmxObjectGroup2D;
@@ -62,6 +63,9 @@ public:
     void SetDrawOrder(int drawOrder);
     /// Set visible.
     void SetVisible(bool visible);
+    /// Set sprite of a tile, null to hide the tile (for tile layer only). Only the chunk of the tile is rebuilt. On a cell
+    /// without a tile the sprite is drawn unflipped, while GetTile() still returns null.
+    void SetTileSprite(int x, int y, Sprite2D* sprite);
 
     /// Return tile map.
     TileMap2D* GetTileMap() const;
@@ -86,10 +90,14 @@ public:
     int GetWidth() const;
     /// Return height (for tile layer only).
     int GetHeight() const;
-    /// Return tile node (for tile layer only).
-    Node* GetTileNode(int x, int y) const;
     /// Return tile (for tile layer only).
     Tile2D* GetTile(int x, int y) const;
+    /// Return sprite of a tile (for tile layer only).
+    Sprite2D* GetTileSprite(int x, int y) const;
+    /// Return number of tile chunks (for tile layer only).
+    unsigned GetNumChunks() const { return chunks_.Size(); }
+    /// Return tile chunk by index (for tile layer only).
+    TileMapChunk2D* GetChunk(unsigned index) const;
 
     /// Return number of tile map objects (for object group only).
     unsigned GetNumObjects() const;
@@ -123,8 +131,14 @@ private:
     int drawOrder_{};
     /// Visible.
     bool visible_{true};
-    /// Tile node or image nodes.
+    /// Object nodes or image node.
     Vector<SharedPtr<Node> > nodes_;
+    /// Tile chunks.
+    Vector<SharedPtr<TileMapChunk2D> > chunks_;
+    /// Tile sprites.
+    Vector<SharedPtr<Sprite2D> > tileSprites_;
+    /// Number of tile chunks in X direction.
+    int numChunksX_{};
 };
 
 }
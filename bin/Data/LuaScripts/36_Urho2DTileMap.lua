@@ -148,19 +148,18 @@ function HandleMouseButtonDown(eventType, eventData)
 
     success, x, y = map:PositionToTileIndex(GetMousePositionXY())
     if success then
-        -- Get tile's sprite. Note that layer.GetTile(x, y).sprite is read-only, so we get the sprite through tile's node
-        local n = layer:GetTileNode(x, y)
-        if n == nil then
+        -- Note that layer.GetTile(x, y).sprite is read-only, so the sprite drawn for the tile is set through the layer
+        local tile = layer:GetTile(x, y)
+        if tile == nil then
             return
         end
-        local sprite = n:GetComponent("StaticSprite2D")
 
         if input:GetMouseButtonDown(MOUSEB_RIGHT) then
             -- Swap grass and water
-            if layer:GetTile(x, y).gid < 9 then -- First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
-                sprite.sprite = layer:GetTile(0, 0).sprite -- Replace grass by water sprite used in top tile
-            else sprite.sprite = layer:GetTile(24, 24).sprite end -- Replace water by grass sprite used in bottom tile
-        else sprite.sprite = nil end -- 'Remove' sprite
+            if tile.gid < 9 then -- First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
+                layer:SetTileSprite(x, y, layer:GetTile(0, 0).sprite) -- Replace grass by water sprite used in top tile
+            else layer:SetTileSprite(x, y, layer:GetTile(24, 24).sprite) end -- Replace water by grass sprite used in bottom tile
+        else layer:SetTileSprite(x, y, nil) end -- 'Remove' sprite
     end
 end
 
@@ -155,20 +155,19 @@ void HandleMouseButtonDown(StringHash eventType, VariantMap& eventData)
     int x, y;
     if (map.PositionToTileIndex(x, y, pos))
     {
-        // Get tile's sprite. Note that layer.GetTile(x, y).sprite is read-only, so we get the sprite through tile's node
-        Node@ n = layer.GetTileNode(x, y);
-        if (n is null)
+        // Note that layer.GetTile(x, y).sprite is read-only, so the sprite drawn for the tile is set through the layer
+        Tile2D@ tile = layer.GetTile(x, y);
+        if (tile is null)
             return;
-        StaticSprite2D@ sprite = n.GetComponent("StaticSprite2D");
 
         if (input.mouseButtonDown[MOUSEB_RIGHT])
         {
             // Swap grass and water
-            if (layer.GetTile(x, y).gid < 9) // First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
-                sprite.sprite = layer.GetTile(0, 0).sprite; // Replace grass by water sprite used in top tile
-            else sprite.sprite = layer.GetTile(24, 24).sprite; // Replace water by grass sprite used in bottom tile
+            if (tile.gid < 9) // First 8 sprites in the "isometric_grass_and_water.png" tileset are mostly grass and from 9 to 24 they are mostly water
+                layer.SetTileSprite(x, y, layer.GetTile(0, 0).sprite); // Replace grass by water sprite used in top tile
+            else layer.SetTileSprite(x, y, layer.GetTile(24, 24).sprite); // Replace water by grass sprite used in bottom tile
         }
-        else sprite.sprite = null; // 'Remove' sprite
+        else layer.SetTileSprite(x, y, null); // 'Remove' sprite
     }
 }
 